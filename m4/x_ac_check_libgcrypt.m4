@@ -0,0 +1,23 @@
+#******************************************************************************
+#  SYNOPSIS:
+#    X_AC_CHECK_LIBGCRYPT
+#
+#  DESCRIPTION:
+#    Check for Libgcrypt behavior.
+#******************************************************************************
+
+AC_DEFUN([X_AC_CHECK_LIBGCRYPT], [
+  AC_REQUIRE([X_AC_WITH_LIBGCRYPT])
+  ac_save_CFLAGS="${CFLAGS}"
+  ac_save_LIBS="${LIBS}"
+  CFLAGS="${CFLAGS} ${LIBGCRYPT_CFLAGS}"
+  LIBS="${LIBS} ${LIBGCRYPT_LIBS}"
+  AC_CHECK_DECLS(
+    [GCRY_CIPHER_MODE_GCM, GCRY_CIPHER_MODE_POLY1305,
+     GCRY_MD_BLAKE2B_512, GCRY_MD_BLAKE2S_256],
+    [], [], [#include <gcrypt.h>]
+  )
+  CFLAGS="${ac_save_CFLAGS}"
+  LIBS="${ac_save_LIBS}"
+  ]
+)
@@ -50,7 +50,12 @@ AC_DEFUN([X_AC_CHECK_OPENSSL], [
     EVP_MD_CTX_new \
     EVP_Q_mac \
     EVP_aes_128_cbc \
+    EVP_aes_128_gcm \
     EVP_aes_256_cbc \
+    EVP_aes_256_gcm \
+    EVP_blake2b512 \
+    EVP_blake2s256 \
+    EVP_chacha20_poly1305 \
     EVP_sha256 \
     EVP_sha512 \
     HMAC \
@@ -53,5 +53,7 @@ AC_DEFUN_ONCE([X_AC_SELECT_CRYPTO_LIB],
 
   if test "${CRYPTO_PKG}" = openssl; then
     X_AC_CHECK_OPENSSL
+  elif test "${CRYPTO_PKG}" = libgcrypt; then
+    X_AC_CHECK_LIBGCRYPT
   fi
 ])
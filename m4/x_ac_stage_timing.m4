@@ -0,0 +1,34 @@
+#******************************************************************************
+#  SYNOPSIS:
+#    X_AC_STAGE_TIMING
+#
+#  DESCRIPTION:
+#    Add support for the "--enable-stage-timing" configure script option.  If
+#    enabled, WITH_STAGE_TIMING will be defined to compile the per-stage timing
+#    hooks into the daemon's encode/decode pipelines.  Timing must still be
+#    enabled at runtime.
+#******************************************************************************
+
+AC_DEFUN([X_AC_STAGE_TIMING], [
+  AC_MSG_CHECKING([whether stage timing is enabled])
+  AC_ARG_ENABLE(
+    [stage-timing],
+    AS_HELP_STRING([--enable-stage-timing],
+      [enable per-stage timing of daemon requests]),
+    [ case "$enableval" in
+        yes) x_ac_stage_timing=yes ;;
+         no) x_ac_stage_timing=no ;;
+          *) AC_MSG_RESULT([failed])
+             AC_MSG_ERROR([bad value "$enableval" for --enable-stage-timing]) ;;
+      esac
+    ]
+  )
+  AS_IF(
+    [test "AS_VAR_GET(x_ac_stage_timing)" = yes],
+    AC_DEFINE([WITH_STAGE_TIMING], [1],
+      [Define to 1 if per-stage timing of daemon requests is enabled.]
+    )
+  )
+  AC_MSG_RESULT([${x_ac_stage_timing=no}])
+  ]
+)
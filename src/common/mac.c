@@ -35,14 +35,29 @@
 #include "md.h"
 
 
+/*****************************************************************************
+ *  Constants
+ *****************************************************************************/
+
+/*  Maximum key lengths (in bytes) of the keyed BLAKE2 message digests.
+ */
+#define MAC_BLAKE2B_KEY_LEN_MAX         64
+#define MAC_BLAKE2S_KEY_LEN_MAX         32
+
+
 /*****************************************************************************
  *  Private Prototypes
  *****************************************************************************/
 
+static int _mac_key_len_max (munge_mac_t md);
+static int _mac_prep_key (munge_mac_t md, const void **keyp, int *keylenp,
+    unsigned char *buf, int buflen);
+
 static int _mac_init (mac_ctx *x, munge_mac_t md, const void *key, int keylen);
 static int _mac_update (mac_ctx *x, const void *src, int srclen);
 static int _mac_final (mac_ctx *x, void *dst, int *dstlenp);
 static int _mac_cleanup (mac_ctx *x);
+static int _mac_reinit (mac_ctx *x);
 static int _mac_block (munge_mac_t md, const void *key, int keylen,
     void *dst, int *dstlenp, const void *src, int srclen);
 static int _mac_map_enum (munge_mac_t md, void *dst);
@@ -59,12 +74,17 @@ static int _mac_map_enum (munge_mac_t md, void *dst);
 int
 mac_init (mac_ctx *x, munge_mac_t md, const void *key, int keylen)
 {
-    int rc;
+    unsigned char keybuf [MAC_BLAKE2B_KEY_LEN_MAX];
+    int           rc;
 
     if (!x || !key || (keylen < 0)) {
         return (-1);
     }
+    if (_mac_prep_key (md, &key, &keylen, keybuf, sizeof (keybuf)) < 0) {
+        return (-1);
+    }
     rc = _mac_init (x, md, key, keylen);
+    memset (keybuf, 0, sizeof (keybuf));
     return (rc);
 }
 
@@ -123,6 +143,26 @@ mac_cleanup (mac_ctx *x)
 }
 
 
+/*  Reinitializes the MAC context [x] for a new message using the message
+ *    digest and key from mac_init().  This avoids reallocating the context
+ *    and rederiving its keyed state when the same key is used repeatedly.
+ *  The context can be reinitialized at any point after mac_init(), even if
+ *    a previous message was not finalized.
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+mac_reinit (mac_ctx *x)
+{
+    int rc;
+
+    if (!x) {
+        return (-1);
+    }
+    rc = _mac_reinit (x);
+    return (rc);
+}
+
+
 /*  Returns the size (in bytes) of the message digest [md], or -1 on error.
  */
 int
@@ -144,12 +184,17 @@ int
 mac_block (munge_mac_t md, const void *key, int keylen,
            void *dst, int *dstlenp, const void *src, int srclen)
 {
-    int rc;
+    unsigned char keybuf [MAC_BLAKE2B_KEY_LEN_MAX];
+    int           rc;
 
     if (!key || (keylen < 0) || !dst || !dstlenp || !src || (srclen < 0)) {
         return (-1);
     }
+    if (_mac_prep_key (md, &key, &keylen, keybuf, sizeof (keybuf)) < 0) {
+        return (-1);
+    }
     rc = _mac_block (md, key, keylen, dst, dstlenp, src, srclen);
+    memset (keybuf, 0, sizeof (keybuf));
     return (rc);
 }
 
@@ -171,6 +216,69 @@ mac_map_enum (munge_mac_t md, void *dst)
 }
 
 
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+/*  Returns the maximum key length (in bytes) if [md] is a keyed message
+ *    digest used natively as a MAC (ie, BLAKE2), or 0 if [md] is used within
+ *    an HMAC construction (which accepts keys of any length).
+ */
+static int
+_mac_key_len_max (munge_mac_t md)
+{
+    switch (md) {
+        case MUNGE_MAC_BLAKE2B:
+            return (MAC_BLAKE2B_KEY_LEN_MAX);
+        case MUNGE_MAC_BLAKE2S:
+            return (MAC_BLAKE2S_KEY_LEN_MAX);
+        default:
+            return (0);
+    }
+}
+
+
+/*  Prepares the key [keyp] of [keylenp] bytes for the message digest [md].
+ *  Unlike HMAC, a keyed BLAKE2 digest limits the length of its key.  So a key
+ *    that is either empty or exceeds this limit is replaced by its unkeyed
+ *    digest which is written to [buf] of length [buflen]; [keyp] and
+ *    [keylenp] are then updated to refer to it.
+ *  Returns 0 on success, or -1 on error.
+ */
+static int
+_mac_prep_key (munge_mac_t md, const void **keyp, int *keylenp,
+               unsigned char *buf, int buflen)
+{
+    md_ctx  x;
+    int     keylen_max;
+    int     n;
+
+    keylen_max = _mac_key_len_max (md);
+    if (keylen_max == 0) {
+        return (0);
+    }
+    if ((*keylenp > 0) && (*keylenp <= keylen_max)) {
+        return (0);
+    }
+    if (md_init (&x, md) < 0) {
+        return (-1);
+    }
+    n = buflen;
+    if ((md_update (&x, *keyp, *keylenp) < 0)
+            || (md_final (&x, buf, &n) < 0)) {
+        (void) md_cleanup (&x);
+        return (-1);
+    }
+    if (md_cleanup (&x) < 0) {
+        return (-1);
+    }
+    assert (n <= keylen_max);
+    *keyp = buf;
+    *keylenp = n;
+    return (0);
+}
+
+
 /*****************************************************************************
  *  Private Functions (Libgcrypt)
  *****************************************************************************/
@@ -185,11 +293,15 @@ _mac_init (mac_ctx *x, munge_mac_t md, const void *key, int keylen)
 {
     gcry_error_t e;
     int          algo;
+    unsigned int flags;
 
     if (_mac_map_enum (md, &algo) < 0) {
         return (-1);
     }
-    if ((e = gcry_md_open (&(x->ctx), algo, GCRY_MD_FLAG_HMAC)) != 0) {
+    /*  BLAKE2 is keyed natively instead of within an HMAC.
+     */
+    flags = (_mac_key_len_max (md) > 0) ? 0 : GCRY_MD_FLAG_HMAC;
+    if ((e = gcry_md_open (&(x->ctx), algo, flags)) != 0) {
         log_msg (LOG_DEBUG, "gcry_md_open failed for MAC=%d HMAC: %s",
             md, gcry_strerror (e));
         return (-1);
@@ -199,6 +311,17 @@ _mac_init (mac_ctx *x, munge_mac_t md, const void *key, int keylen)
             md, gcry_strerror (e));
         return (-1);
     }
+    /*  gcry_md_reset() retains an HMAC key but not a native BLAKE2 key,
+     *    so the latter is saved for _mac_reinit().
+     */
+    if (flags == 0) {
+        assert ((size_t) keylen <= sizeof (x->key));
+        memcpy (x->key, key, keylen);
+        x->keylen = keylen;
+    }
+    else {
+        x->keylen = 0;
+    }
     /*  Bypass mac_size() since md->algo mapping has already been computed.
      */
     x->diglen = gcry_md_get_algo_dlen (algo);
@@ -235,6 +358,26 @@ static int
 _mac_cleanup (mac_ctx *x)
 {
     gcry_md_close (x->ctx);
+    memset (x->key, 0, sizeof (x->key));
+    x->keylen = 0;
+    return (0);
+}
+
+
+static int
+_mac_reinit (mac_ctx *x)
+{
+    gcry_error_t e;
+
+    gcry_md_reset (x->ctx);
+
+    if (x->keylen > 0) {
+        if ((e = gcry_md_setkey (x->ctx, x->key, x->keylen)) != 0) {
+            log_msg (LOG_DEBUG, "gcry_md_setkey failed for MAC reinit: %s",
+                gcry_strerror (e));
+            return (-1);
+        }
+    }
     return (0);
 }
 
@@ -245,6 +388,7 @@ _mac_block (munge_mac_t md, const void *key, int keylen,
 {
     gcry_error_t   e;
     int            algo;
+    unsigned int   flags;
     int            len;
     gcry_md_hd_t   ctx;
     unsigned char *digest;
@@ -258,7 +402,8 @@ _mac_block (munge_mac_t md, const void *key, int keylen,
     if (*dstlenp < len) {
         return (-1);
     }
-    if ((e = gcry_md_open (&ctx, algo, GCRY_MD_FLAG_HMAC)) != 0) {
+    flags = (_mac_key_len_max (md) > 0) ? 0 : GCRY_MD_FLAG_HMAC;
+    if ((e = gcry_md_open (&ctx, algo, flags)) != 0) {
         log_msg (LOG_DEBUG, "gcry_md_open failed for MAC=%d HMAC: %s",
             md, gcry_strerror (e));
         return (-1);
@@ -313,6 +458,24 @@ _mac_map_enum (munge_mac_t md, void *dst)
 #include <openssl/hmac.h>
 #endif /* HAVE_OPENSSL_HMAC_H */
 
+#if HAVE_EVP_MAC_INIT
+/*  Returns the name of the OpenSSL >= 3.0 MAC algorithm for [md].
+ *  BLAKE2 is keyed natively instead of within an HMAC.
+ */
+static const char *
+_mac_name (munge_mac_t md)
+{
+    switch (md) {
+        case MUNGE_MAC_BLAKE2B:
+            return ("BLAKE2BMAC");
+        case MUNGE_MAC_BLAKE2S:
+            return ("BLAKE2SMAC");
+        default:
+            return ("HMAC");
+    }
+}
+#endif /* HAVE_EVP_MAC_INIT */
+
 static int
 _mac_init (mac_ctx *x, munge_mac_t md, const void *key, int keylen)
 {
@@ -331,7 +494,7 @@ _mac_init (mac_ctx *x, munge_mac_t md, const void *key, int keylen)
 
 #if HAVE_EVP_MAC_FETCH && HAVE_EVP_MAC_CTX_NEW
     /*  OpenSSL >= 3.0  */
-    mac = EVP_MAC_fetch (NULL, "HMAC", NULL);
+    mac = EVP_MAC_fetch (NULL, _mac_name (md), NULL);
     if (mac == NULL) {
         return (-1);
     }
@@ -460,6 +623,35 @@ _mac_cleanup (mac_ctx *x)
 }
 
 
+static int
+_mac_reinit (mac_ctx *x)
+{
+/*  Passing a NULL key and algorithm reuses those from the previous init.
+ */
+#if HAVE_EVP_MAC_INIT
+    /*  OpenSSL >= 3.0  */
+    if (EVP_MAC_init (x->ctx, NULL, 0, NULL) != 1) {
+        return (-1);
+    }
+#elif HAVE_HMAC_INIT_EX_RETURN_INT
+    /*  OpenSSL >= 1.0.0, Deprecated since OpenSSL 3.0  */
+    if (HMAC_Init_ex (x->ctx, NULL, 0, NULL, NULL) != 1) {
+        return (-1);
+    }
+#elif HAVE_HMAC_INIT_EX
+    /*  OpenSSL >= 0.9.7, < 1.0.0, Deprecated since OpenSSL 3.0  */
+    HMAC_Init_ex (x->ctx, NULL, 0, NULL, NULL);
+#elif HAVE_HMAC_INIT
+    /*  OpenSSL >= 0.9.0, Deprecated since OpenSSL 1.1.0  */
+    HMAC_Init (x->ctx, NULL, 0, NULL);
+#else  /* !HAVE_HMAC_INIT */
+#error "No OpenSSL HMAC_Init"
+#endif /* !HAVE_HMAC_INIT */
+
+    return (0);
+}
+
+
 static int
 _mac_block (munge_mac_t md, const void *key, int keylen,
             void *dst, int *dstlenp, const void *src, int srclen)
@@ -493,8 +685,9 @@ _mac_block (munge_mac_t md, const void *key, int keylen,
 #if HAVE_EVP_Q_MAC
     /*  OpenSSL >= 3.0  */
     size_t dstsize = (size_t) *dstlenp;
-    if (!EVP_Q_mac (NULL, "HMAC", NULL, NULL, algo, key, (size_t) keylen,
-                src, (size_t) srclen, dst, dstsize, &dstsize)) {
+    if (!EVP_Q_mac (NULL, _mac_name (md), NULL, NULL, algo,
+                key, (size_t) keylen, src, (size_t) srclen,
+                dst, dstsize, &dstsize)) {
         return (-1);
     }
     if (dstsize > INT_MAX) {
@@ -535,9 +728,16 @@ _mac_map_enum (munge_mac_t md, void *dst)
           OSSL_PARAM_END },             /* MUNGE_MAC_SHA256 */
         { OSSL_PARAM_utf8_string (OSSL_ALG_PARAM_DIGEST, "SHA2-512", 8),
           OSSL_PARAM_END },             /* MUNGE_MAC_SHA512 */
+        { OSSL_PARAM_END },             /* MUNGE_MAC_BLAKE2B */
+        { OSSL_PARAM_END },             /* MUNGE_MAC_BLAKE2S */
     };
 
-    if ((md < MUNGE_MAC_MD5) || (md > MUNGE_MAC_SHA512)) {
+    if ((md < MUNGE_MAC_MD5) || (md > MUNGE_MAC_BLAKE2S)) {
+        return (-1);
+    }
+    /*  The keyed BLAKE2 MACs also require the corresponding message digest.
+     */
+    if ((_mac_key_len_max (md) > 0) && (md_map_enum (md, NULL) < 0)) {
         return (-1);
     }
     if (dst != NULL) {
@@ -546,6 +746,11 @@ _mac_map_enum (munge_mac_t md, void *dst)
     return (0);
 
 #else  /* !HAVE_EVP_MAC_INIT */
+    /*  Keyed BLAKE2 MACs are not supported by the HMAC interface.
+     */
+    if (_mac_key_len_max (md) > 0) {
+        return (-1);
+    }
     return (md_map_enum (md, dst));
 #endif /* !HAVE_EVP_MAC_INIT */
 }
@@ -47,6 +47,8 @@
 typedef struct {
     gcry_md_hd_t        ctx;
     int                 diglen;
+    int                 keylen;         /* len of native MAC key, or 0       */
+    unsigned char       key [64];       /* native MAC key for mac_reinit()   */
 } mac_ctx;
 
 #endif /* HAVE_LIBGCRYPT */
@@ -98,6 +100,8 @@ int mac_final (mac_ctx *x, void *dst, int *dstlenp);
 
 int mac_cleanup (mac_ctx *x);
 
+int mac_reinit (mac_ctx *x);
+
 int mac_size (munge_mac_t md);
 
 int mac_block (munge_mac_t md, const void *key, int keylen,
@@ -87,6 +87,15 @@ check_mac (munge_mac_t m, const char *str, const char *key, int keylen,
     ok (!rv && !(rv = mac_final (&ctx, buf, &buflen)), "mac_final %s", str);
     ok (buflen == dstlen, "mac_final %s outlen", str);
     cmp_mem (buf, dst, dstlen, "mac_final %s output", str);
+
+    buflen = sizeof (buf);
+    memset (buf, 0, sizeof (buf));
+    ok (!rv && !(rv = mac_reinit (&ctx)), "mac_reinit %s", str);
+    ok (!rv && !(rv = mac_update (&ctx, src, srclen)),
+            "mac_update %s after reinit", str);
+    ok (!rv && !(rv = mac_final (&ctx, buf, &buflen)),
+            "mac_final %s after reinit", str);
+    cmp_mem (buf, dst, dstlen, "mac_final %s output after reinit", str);
     ok (!rv && !(rv = mac_cleanup (&ctx)), "mac_cleanup %s", str);
 
     return rv;
@@ -123,6 +132,19 @@ main (int argc, char *argv[])
         0xef, 0x39, 0x87, 0xac, 0xb3, 0xb9, 0x7e, 0x73, 0x10, 0x9b, 0xae, 0xde,
         0xce, 0x1b, 0xd4, 0x79
     };
+    const unsigned char out_blake2b[64] = {
+        0x80, 0x83, 0x2f, 0xfb, 0xd9, 0xf8, 0x30, 0x2f, 0x7a, 0x24, 0x0e, 0xa9,
+        0x21, 0x74, 0x8b, 0x76, 0x05, 0x3e, 0xce, 0xa3, 0x24, 0xa0, 0x8c, 0xa1,
+        0xad, 0xbf, 0x79, 0x69, 0xc4, 0x30, 0xcf, 0xf6, 0x9e, 0x55, 0x0c, 0xb5,
+        0x19, 0xb4, 0x71, 0x6d, 0xf2, 0xe8, 0x7c, 0x21, 0xa1, 0x8d, 0x4d, 0xaa,
+        0x6c, 0xa9, 0x86, 0x38, 0x8c, 0xe1, 0x14, 0x5d, 0x3b, 0x6f, 0x92, 0x75,
+        0x57, 0x57, 0x7c, 0x91
+    };
+    const unsigned char out_blake2s[32] = {
+        0xc5, 0x9b, 0xbc, 0x55, 0xf9, 0x5b, 0xd7, 0xca, 0xef, 0xdc, 0x9e, 0x63,
+        0x61, 0xdc, 0x3c, 0xe3, 0xcd, 0xe8, 0x0b, 0x76, 0x30, 0xb7, 0xed, 0x72,
+        0xac, 0xd3, 0x97, 0x0c, 0x16, 0xe8, 0xca, 0xa4
+    };
 
     crypto_init ();
     md_init_subsystem ();
@@ -144,6 +166,20 @@ main (int argc, char *argv[])
     check_mac (MUNGE_MAC_SHA512, "MUNGE_MAC_SHA512", key, strlen (key),
             in, strlen (in), out_sha512, sizeof (out_sha512));
 
+    /*  Keyed BLAKE2 depends on the crypto library version.
+     */
+    skip (mac_map_enum (MUNGE_MAC_BLAKE2B, NULL) < 0, 15,
+            "MUNGE_MAC_BLAKE2B not supported");
+    check_mac (MUNGE_MAC_BLAKE2B, "MUNGE_MAC_BLAKE2B", key, strlen (key),
+            in, strlen (in), out_blake2b, sizeof (out_blake2b));
+    end_skip;
+
+    skip (mac_map_enum (MUNGE_MAC_BLAKE2S, NULL) < 0, 15,
+            "MUNGE_MAC_BLAKE2S not supported");
+    check_mac (MUNGE_MAC_BLAKE2S, "MUNGE_MAC_BLAKE2S", key, strlen (key),
+            in, strlen (in), out_blake2s, sizeof (out_blake2s));
+    end_skip;
+
     done_testing ();
 
     crypto_fini ();
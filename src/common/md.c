@@ -229,6 +229,17 @@ _md_init_subsystem (void)
     _md_map [MUNGE_MAC_RIPEMD160] = GCRY_MD_RMD160;
     _md_map [MUNGE_MAC_SHA256] = GCRY_MD_SHA256;
     _md_map [MUNGE_MAC_SHA512] = GCRY_MD_SHA512;
+
+#if HAVE_DECL_GCRY_MD_BLAKE2B_512
+    /*  Libgcrypt >= 1.8.0  */
+    _md_map [MUNGE_MAC_BLAKE2B] = GCRY_MD_BLAKE2B_512;
+#endif /* HAVE_DECL_GCRY_MD_BLAKE2B_512 */
+
+#if HAVE_DECL_GCRY_MD_BLAKE2S_256
+    /*  Libgcrypt >= 1.8.0  */
+    _md_map [MUNGE_MAC_BLAKE2S] = GCRY_MD_BLAKE2S_256;
+#endif /* HAVE_DECL_GCRY_MD_BLAKE2S_256 */
+
     return;
 }
 
@@ -363,6 +374,16 @@ _md_init_subsystem (void)
     _md_map [MUNGE_MAC_SHA512] = EVP_sha512 ();
 #endif /* HAVE_EVP_SHA512 */
 
+#if HAVE_EVP_BLAKE2B512
+    /*  OpenSSL >= 1.1.0  */
+    _md_map [MUNGE_MAC_BLAKE2B] = EVP_blake2b512 ();
+#endif /* HAVE_EVP_BLAKE2B512 */
+
+#if HAVE_EVP_BLAKE2S256
+    /*  OpenSSL >= 1.1.0  */
+    _md_map [MUNGE_MAC_BLAKE2S] = EVP_blake2s256 ();
+#endif /* HAVE_EVP_BLAKE2S256 */
+
     return;
 }
 
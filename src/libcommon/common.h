@@ -49,6 +49,14 @@
 #  define HAVE_PKG_ZLIB 1
 #endif
 
+#if HAVE_LZ4_H && HAVE_LIBLZ4
+#  define HAVE_PKG_LZ4 1
+#endif
+
+#if HAVE_ZSTD_H && HAVE_LIBZSTD
+#  define HAVE_PKG_ZSTD 1
+#endif
+
 #ifndef MAX
 #  define MAX(a,b) ((a >= b) ? (a) : (b))
 #endif /* !MAX */
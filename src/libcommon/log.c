@@ -58,13 +58,15 @@
  *****************************************************************************/
 
 struct log_ctx {
-    FILE *fp;
-    int   got_init;
-    int   got_syslog;
-    int   got_fprintf_error;
-    int   priority;
-    int   options;
-    char  id [LOG_IDENTITY_MAXLEN];
+    FILE        *fp;
+    log_write_f  write_f;
+    log_flush_f  flush_f;
+    int          got_init;
+    int          got_syslog;
+    int          got_fprintf_error;
+    int          priority;
+    int          options;
+    char         id [LOG_IDENTITY_MAXLEN];
 };
 
 
@@ -72,7 +74,8 @@ struct log_ctx {
  *  Static Variables
  *****************************************************************************/
 
-static struct log_ctx log_ctx = { NULL, 0, 0, 0, 0, 0, { '\0' } };
+static struct log_ctx log_ctx =
+    { NULL, NULL, NULL, 0, 0, 0, 0, 0, { '\0' } };
 
 
 /*****************************************************************************
@@ -144,6 +147,37 @@ log_close_file (void)
 }
 
 
+/*  Returns the file descriptor of the logging file stream,
+ *    or -1 if no file stream is open.
+ */
+int
+log_get_file_fd (void)
+{
+    if (!log_ctx.fp) {
+        errno = EBADF;
+        return (-1);
+    }
+    return (fileno (log_ctx.fp));
+}
+
+
+/*  If [write_f] is non-NULL, messages for the logging file stream will be
+ *    passed to it instead of being written synchronously; this allows them
+ *    to be written asynchronously by another thread.
+ *  If [flush_f] is non-NULL, it will be invoked before exiting on a fatal
+ *    error so consumed messages are not lost.
+ *  The writer must be reset (with NULL args) before the file stream
+ *    is closed.
+ */
+void
+log_set_file_writer (log_write_f write_f, log_flush_f flush_f)
+{
+    log_ctx.write_f = write_f;
+    log_ctx.flush_f = flush_f;
+    return;
+}
+
+
 /*  If [identity] is non-NULL, log messages to syslog at the specified
  *    [facility] (cf, syslog(3)) prepending the trailing "filename" component
  *    of [identity] to each message.
@@ -418,7 +452,10 @@ _log_aux (int errnum, int priority, char *msgbuf, int msgbuflen,
     if (log_ctx.fp && (priority <= log_ctx.priority)) {
         int errno_save = errno;
         errno = 0;
-        if (fprintf (log_ctx.fp, "%s", buf) == EOF) {
+        if (log_ctx.write_f && (log_ctx.write_f (priority, buf, p - buf) == 0)) {
+            ;                           /* consumed by the file writer       */
+        }
+        else if (fprintf (log_ctx.fp, "%s", buf) == EOF) {
             if (!log_ctx.got_fprintf_error) {
                 syslog (LOG_ERR,
                     "Failed logfile write: %s: messages may have been dropped",
@@ -438,6 +475,12 @@ _log_aux (int errnum, int priority, char *msgbuf, int msgbuflen,
 static void
 _log_die (int status, int priority, const char *msg)
 {
+    /*  Flush messages that have been consumed by the file writer but not yet
+     *    written (including this one) before exiting.
+     */
+    if (log_ctx.flush_f) {
+        log_ctx.flush_f ();
+    }
     /*  If the daemonpipe is open between the (grand)child process and the
      *    parent process, relay the error message to the parent for output onto
      *    stderr.  But if the error message has already been written to stderr,
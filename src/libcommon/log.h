@@ -43,10 +43,30 @@
 #define LOG_OPT_TIMESTAMP       0x04    /* add timestamp to message          */
 
 
+typedef int (*log_write_f) (int priority, const char *buf, int len);
+/*
+ *  Function prototype for writing a formatted message [buf] of [len] bytes
+ *    at the specified [priority] level to the logging file stream in place
+ *    of fprintf().
+ *  Returns 0 if the message was consumed, or -1 to write it synchronously.
+ *  A message at LOG_ERR or higher must not be dropped since it may be the
+ *    fatal error preceding an exit.
+ */
+
+typedef void (*log_flush_f) (void);
+/*
+ *  Function prototype for flushing messages consumed by a log_write_f.
+ */
+
+
 int log_open_file (FILE *fp, const char *identity, int priority, int options);
 
 void log_close_file (void);
 
+int log_get_file_fd (void);
+
+void log_set_file_writer (log_write_f write_f, log_flush_f flush_f);
+
 int log_open_syslog (const char *identity, int facility);
 
 void log_close_syslog (void);
@@ -34,9 +34,11 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <munge.h>
+#include <poll.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <sys/time.h>                   /* gettimeofday */
 #include <sys/uio.h>
 #include <unistd.h>
@@ -400,6 +402,54 @@ m_msg_recv (m_msg_t m, m_msg_type_t type, size_t maxlen)
 }
 
 
+munge_err_t
+m_msg_peek_type (m_msg_t m, m_msg_type_t *ptype, int msecs)
+{
+/*  Peeks at the header of the message from the sender at the other end of
+ *    the already-specified socket without consuming it, waiting up to
+ *    [msecs] for it to arrive.
+ *    This allows a request to be rejected based on its type before the
+ *    message is received.
+ *  Returns EMUNGE_SUCCESS and sets [ptype] if a valid header is available;
+ *    o/w, returns EMUNGE_SOCKET.
+ */
+    uint8_t       hdr [MUNGE_MSG_HDR_SIZE];
+    struct m_msg  tmp;
+    struct pollfd pfd;
+    ssize_t       n;
+    munge_err_t   e;
+
+    assert (m != NULL);
+    assert (m->sd >= 0);
+    assert (ptype != NULL);
+
+    pfd.fd = m->sd;
+    pfd.events = POLLIN;
+    while (poll (&pfd, 1, msecs) < 0) {
+        if (errno != EINTR) {
+            return (EMUNGE_SOCKET);
+        }
+    }
+    do {
+        n = recv (m->sd, hdr, sizeof (hdr), MSG_PEEK | MSG_DONTWAIT);
+    } while ((n < 0) && (errno == EINTR));
+
+    if (n != sizeof (hdr)) {
+        return (EMUNGE_SOCKET);
+    }
+    memset (&tmp, 0, sizeof (tmp));
+    e = _msg_unpack (&tmp, MUNGE_MSG_HDR, hdr, sizeof (hdr));
+    if (tmp.error_str != NULL) {
+        free (tmp.error_str);
+    }
+    if (e != EMUNGE_SUCCESS) {
+        return (EMUNGE_SOCKET);
+    }
+    *ptype = tmp.type;
+    return (EMUNGE_SUCCESS);
+}
+
+
 int
 m_msg_set_err (m_msg_t m, munge_err_t e, char *s)
 {
@@ -474,6 +524,7 @@ _msg_length (m_msg_t m, m_msg_type_t type)
             n += sizeof (m->pkt_len);
             break;
         case MUNGE_MSG_ENC_REQ:
+        case MUNGE_MSG_ENC_BIN_REQ:
             n += sizeof (m->cipher);
             n += sizeof (m->mac);
             n += sizeof (m->zip);
@@ -486,6 +537,7 @@ _msg_length (m_msg_t m, m_msg_type_t type)
             n += m->data_len;
             break;
         case MUNGE_MSG_ENC_RSP:
+        case MUNGE_MSG_STATS_RSP:
             n += sizeof (m->error_num);
             n += sizeof (m->error_len);
             n += m->error_len;
@@ -493,6 +545,10 @@ _msg_length (m_msg_t m, m_msg_type_t type)
             n += m->data_len;
             break;
         case MUNGE_MSG_DEC_REQ:
+        case MUNGE_MSG_DEC_BIN_REQ:
+        case MUNGE_MSG_DEC_VAL_REQ:
+        case MUNGE_MSG_DEC_BIN_VAL_REQ:
+        case MUNGE_MSG_STATS_REQ:
             n += sizeof (m->data_len);
             n += m->data_len;
             break;
@@ -554,6 +610,7 @@ _msg_pack (m_msg_t m, m_msg_type_t type, void *dst, int dstlen)
             else break;
             goto err;
         case MUNGE_MSG_ENC_REQ:
+        case MUNGE_MSG_ENC_BIN_REQ:
             if      (!_pack (&p, &(m->cipher), sizeof (m->cipher), q)) ;
             else if (!_pack (&p, &(m->mac), sizeof (m->mac), q)) ;
             else if (!_pack (&p, &(m->zip), sizeof (m->zip), q)) ;
@@ -567,6 +624,7 @@ _msg_pack (m_msg_t m, m_msg_type_t type, void *dst, int dstlen)
             else break;
             goto err;
         case MUNGE_MSG_ENC_RSP:
+        case MUNGE_MSG_STATS_RSP:
             if      (!_pack (&p, &(m->error_num), sizeof (m->error_num), q)) ;
             else if (!_pack (&p, &(m->error_len), sizeof (m->error_len), q)) ;
             else if ( _copy (p, m->error_str, m->error_len, p, q, &p) < 0) ;
@@ -575,6 +633,10 @@ _msg_pack (m_msg_t m, m_msg_type_t type, void *dst, int dstlen)
             else break;
             goto err;
         case MUNGE_MSG_DEC_REQ:
+        case MUNGE_MSG_DEC_BIN_REQ:
+        case MUNGE_MSG_DEC_VAL_REQ:
+        case MUNGE_MSG_DEC_BIN_VAL_REQ:
+        case MUNGE_MSG_STATS_REQ:
             if      (!_pack (&p, &(m->data_len), sizeof (m->data_len), q)) ;
             else if ( _copy (p, m->data, m->data_len, p, q, &p) < 0) ;
             else break;
@@ -643,6 +705,7 @@ _msg_unpack (m_msg_t m, m_msg_type_t type, const void *src, int srclen)
             else break;
             goto err;
         case MUNGE_MSG_ENC_REQ:
+        case MUNGE_MSG_ENC_BIN_REQ:
             if      (!_unpack (&(m->cipher), &p, sizeof (m->cipher), q)) ;
             else if (!_unpack (&(m->mac), &p, sizeof (m->mac), q)) ;
             else if (!_unpack (&(m->zip), &p, sizeof (m->zip), q)) ;
@@ -658,6 +721,7 @@ _msg_unpack (m_msg_t m, m_msg_type_t type, const void *src, int srclen)
             else break;
             goto err;
         case MUNGE_MSG_ENC_RSP:
+        case MUNGE_MSG_STATS_RSP:
             if      (!_unpack (&(m->error_num), &p, sizeof (m->error_num), q));
             else if (!_unpack (&(m->error_len), &p, sizeof (m->error_len), q));
             else if (!_alloc ((vpp) &(m->error_str), m->error_len)) goto nomem;
@@ -668,6 +732,10 @@ _msg_unpack (m_msg_t m, m_msg_type_t type, const void *src, int srclen)
             else break;
             goto err;
         case MUNGE_MSG_DEC_REQ:
+        case MUNGE_MSG_DEC_BIN_REQ:
+        case MUNGE_MSG_DEC_VAL_REQ:
+        case MUNGE_MSG_DEC_BIN_VAL_REQ:
+        case MUNGE_MSG_STATS_REQ:
             if      (!_unpack (&(m->data_len), &p, sizeof (m->data_len), q)) ;
             else if (!_alloc (&(m->data), m->data_len)) goto nomem;
             else if ( _copy (m->data, p, m->data_len, p, q, &p) < 0) ;
@@ -71,7 +71,13 @@ enum m_msg_type {                       /* message type                      */
     MUNGE_MSG_ENC_RSP,                  /*  encode response message          */
     MUNGE_MSG_DEC_REQ,                  /*  decode request message           */
     MUNGE_MSG_DEC_RSP,                  /*  decode response message          */
-    MUNGE_MSG_AUTH_FD_REQ               /*  auth via fd request message      */
+    MUNGE_MSG_AUTH_FD_REQ,              /*  auth via fd request message      */
+    MUNGE_MSG_STATS_REQ,                /*  stats request message            */
+    MUNGE_MSG_STATS_RSP,                /*  stats response message           */
+    MUNGE_MSG_ENC_BIN_REQ,              /*  encode request for binary cred   */
+    MUNGE_MSG_DEC_BIN_REQ,              /*  decode request for binary cred   */
+    MUNGE_MSG_DEC_VAL_REQ,              /*  decode request w/o payload rsp   */
+    MUNGE_MSG_DEC_BIN_VAL_REQ           /*  binary decode w/o payload rsp    */
 };
 
 struct m_msg {
@@ -135,6 +141,8 @@ munge_err_t m_msg_send (m_msg_t m, m_msg_type_t type, size_t maxlen);
 
 munge_err_t m_msg_recv (m_msg_t m, m_msg_type_t type, size_t maxlen);
 
+munge_err_t m_msg_peek_type (m_msg_t m, m_msg_type_t *ptype, int msecs);
+
 int m_msg_set_err (m_msg_t m, munge_err_t e, char *s);
 
 
@@ -187,10 +187,30 @@
  */
 #define MUNGE_SOCKET_TIMEOUT_MSECS      2000
 
+/*  Number of milliseconds the server waits for a request's message header
+ *    when deciding at accept time whether to shed the request.
+ */
+#define MUNGE_SOCKET_PEEK_MSECS         1
+
+/*  Number of threads to create for accepting client connections.
+ */
+#define MUNGE_ACCEPT_THREADS            1
+
 /*  Number of threads to create for processing credential requests.
  */
 #define MUNGE_THREADS                   2
 
+/*  Number of milliseconds a request can wait in the work queue with no idle
+ *    thread before another thread is created (up to the maximum number of
+ *    threads) for processing credential requests.
+ */
+#define MUNGE_THREADS_GROW_MSECS        10
+
+/*  Number of seconds a thread can be idle before it is destroyed (down to
+ *    the minimum number of threads) for processing credential requests.
+ */
+#define MUNGE_THREADS_IDLE_SECS         60
+
 /*  Flag to allow root to decode any credential regardless of its
  *    UID/GID restrictions.
  */
@@ -214,6 +234,18 @@
  */
 #define MUNGE_AUTH_RND_BYTES            16
 
+/*  Integer for the default length (in bytes) of a compression dictionary.
+ */
+#define MUNGE_DICT_LEN_DFL_BYTES        16384
+
+/*  Integer for the maximum length (in bytes) of a compression dictionary.
+ */
+#define MUNGE_DICT_LEN_MAX_BYTES        1048576
+
+/*  String specifying the pathname of the compression dictionary file.
+ */
+#define MUNGE_DICTFILE_PATH             SYSCONFDIR "/munge/munge.dict"
+
 /*  Integer for the default length (in bytes) of a key.
  */
 #define MUNGE_KEY_LEN_DFL_BYTES         128
@@ -65,6 +65,7 @@ munge_ctx_create (void)
     ctx->socket_str = strdup (MUNGE_SOCKET_NAME);
     ctx->error_num = EMUNGE_SUCCESS;
     ctx->error_str = NULL;
+    ctx->cred_len = 0;
     ctx->flags = 0;
 
     if (!ctx->socket_str) {
@@ -227,6 +228,18 @@ munge_ctx_get (munge_ctx_t ctx, int opt, ...)
             p2int = va_arg (vargs, int *);
             *p2int = !!(ctx->flags & MUNGE_CTX_FLAG_IGNORE_REPLAY);
             break;
+        case MUNGE_OPT_BINARY:
+            p2int = va_arg (vargs, int *);
+            *p2int = !!(ctx->flags & MUNGE_CTX_FLAG_BINARY);
+            break;
+        case MUNGE_OPT_CRED_LENGTH:
+            p2int = va_arg (vargs, int *);
+            *p2int = ctx->cred_len;
+            break;
+        case MUNGE_OPT_VALIDATE_ONLY:
+            p2int = va_arg (vargs, int *);
+            *p2int = !!(ctx->flags & MUNGE_CTX_FLAG_VALIDATE_ONLY);
+            break;
         default:
             ctx->error_num = EMUNGE_BAD_ARG;
             break;
@@ -317,6 +330,26 @@ munge_ctx_set (munge_ctx_t ctx, int opt, ...)
             else
                 ctx->flags &= ~MUNGE_CTX_FLAG_IGNORE_REPLAY;
             break;
+        case MUNGE_OPT_BINARY:
+            if (va_arg (vargs, int))
+                ctx->flags |= MUNGE_CTX_FLAG_BINARY;
+            else
+                ctx->flags &= ~MUNGE_CTX_FLAG_BINARY;
+            break;
+        case MUNGE_OPT_CRED_LENGTH:
+            i = va_arg (vargs, int);
+            if (i < 0) {
+                ctx->error_num = EMUNGE_BAD_LENGTH;
+                break;
+            }
+            ctx->cred_len = i;
+            break;
+        case MUNGE_OPT_VALIDATE_ONLY:
+            if (va_arg (vargs, int))
+                ctx->flags |= MUNGE_CTX_FLAG_VALIDATE_ONLY;
+            else
+                ctx->flags &= ~MUNGE_CTX_FLAG_VALIDATE_ONLY;
+            break;
         case MUNGE_OPT_ADDR4:
             /* this option cannot be set; fall through to error case */
         case MUNGE_OPT_ENCODE_TIME:
@@ -50,6 +50,8 @@
 static void _decode_init (munge_ctx_t ctx, void **buf, int *len,
     uid_t *uid, gid_t *gid);
 
+static m_msg_type_t _decode_req_type (munge_ctx_t ctx);
+
 static munge_err_t _decode_req (m_msg_t m, munge_ctx_t ctx,
     const char *cred);
 
@@ -69,6 +71,7 @@ munge_decode (const char *cred, munge_ctx_t ctx,
 {
     munge_err_t  e;
     m_msg_t      m;
+    m_msg_type_t type;
 
     /*  Init output parms in case of early return.
      */
@@ -80,21 +83,27 @@ munge_decode (const char *cred, munge_ctx_t ctx,
         return (_munge_ctx_set_err (ctx, EMUNGE_BAD_ARG,
             strdup ("No credential specified")));
     }
+    if (ctx && (ctx->flags & MUNGE_CTX_FLAG_BINARY) && (ctx->cred_len <= 0)) {
+        return (_munge_ctx_set_err (ctx, EMUNGE_BAD_ARG,
+            strdup ("No binary credential length specified")));
+    }
     /*  Ask the daemon to decode a credential.
      */
+    type = _decode_req_type (ctx);
+
     if ((e = m_msg_create (&m)) != EMUNGE_SUCCESS)
         ;
     else if ((e = _decode_req (m, ctx, cred)) != EMUNGE_SUCCESS)
         ;
-    else if ((e = m_msg_client_xfer (&m, MUNGE_MSG_DEC_REQ, ctx))
-            != EMUNGE_SUCCESS)
+    else if ((e = m_msg_client_xfer (&m, type, ctx)) != EMUNGE_SUCCESS)
         ;
     else if ((e = _decode_rsp (m, ctx, buf, len, uid, gid)) != EMUNGE_SUCCESS)
         ;
     /*  Clean up and return.
      */
     if (ctx) {
-        if ((e != EMUNGE_SUCCESS) && ctx->flags) {
+        if ((e != EMUNGE_SUCCESS) && (ctx->flags &
+                (MUNGE_CTX_FLAG_IGNORE_TTL | MUNGE_CTX_FLAG_IGNORE_REPLAY))) {
             e = _decode_ignore (m, ctx);
         }
         _munge_ctx_set_err (ctx, e, m->error_str);
@@ -150,6 +159,23 @@ _decode_init (munge_ctx_t ctx, void **buf, int *len, uid_t *uid, gid_t *gid)
 }
 
 
+static m_msg_type_t
+_decode_req_type (munge_ctx_t ctx)
+{
+/*  Returns the Decode Request message type for the BINARY and VALIDATE_ONLY
+ *    flags of [ctx].
+ */
+    unsigned flags = (ctx) ? ctx->flags : 0;
+
+    if (flags & MUNGE_CTX_FLAG_BINARY) {
+        return ((flags & MUNGE_CTX_FLAG_VALIDATE_ONLY)
+            ? MUNGE_MSG_DEC_BIN_VAL_REQ : MUNGE_MSG_DEC_BIN_REQ);
+    }
+    return ((flags & MUNGE_CTX_FLAG_VALIDATE_ONLY)
+        ? MUNGE_MSG_DEC_VAL_REQ : MUNGE_MSG_DEC_REQ);
+}
+
+
 static munge_err_t
 _decode_req (m_msg_t m, munge_ctx_t ctx, const char *cred)
 {
@@ -161,9 +187,16 @@ _decode_req (m_msg_t m, munge_ctx_t ctx, const char *cred)
     assert (cred != NULL);
     assert (strlen (cred) > 0);
 
-    /*  Pass the null-terminated credential to be decoded.
+    /*  Pass the credential to be decoded.  A binary credential has an
+     *    explicit length since it may contain embedded null bytes;
+     *    o/w, pass the null-terminated credential.
      */
-    m->data_len = strlen (cred) + 1;
+    if (ctx && (ctx->flags & MUNGE_CTX_FLAG_BINARY)) {
+        m->data_len = ctx->cred_len;
+    }
+    else {
+        m->data_len = strlen (cred) + 1;
+    }
     m->data = (void *) cred;
     m->data_is_copy = 1;
 
@@ -51,7 +51,7 @@ static void _encode_init (char **cred, munge_ctx_t ctx);
 static munge_err_t _encode_req (m_msg_t m, munge_ctx_t ctx,
     const void *buf, int len);
 
-static munge_err_t _encode_rsp (m_msg_t m, char **cred);
+static munge_err_t _encode_rsp (m_msg_t m, munge_ctx_t ctx, char **cred);
 
 
 /*****************************************************************************
@@ -63,6 +63,7 @@ munge_encode (char **cred, munge_ctx_t ctx, const void *buf, int len)
 {
     munge_err_t  e;
     m_msg_t      m;
+    m_msg_type_t type;
 
     /*  Init output parms in case of early return.
      */
@@ -76,14 +77,16 @@ munge_encode (char **cred, munge_ctx_t ctx, const void *buf, int len)
     }
     /*  Ask the daemon to encode a credential.
      */
+    type = (ctx && (ctx->flags & MUNGE_CTX_FLAG_BINARY))
+        ? MUNGE_MSG_ENC_BIN_REQ : MUNGE_MSG_ENC_REQ;
+
     if ((e = m_msg_create (&m)) != EMUNGE_SUCCESS)
         ;
     else if ((e = _encode_req (m, ctx, buf, len)) != EMUNGE_SUCCESS)
         ;
-    else if ((e = m_msg_client_xfer (&m, MUNGE_MSG_ENC_REQ, ctx))
-            != EMUNGE_SUCCESS)
+    else if ((e = m_msg_client_xfer (&m, type, ctx)) != EMUNGE_SUCCESS)
         ;
-    else if ((e = _encode_rsp (m, cred)) != EMUNGE_SUCCESS)
+    else if ((e = _encode_rsp (m, ctx, cred)) != EMUNGE_SUCCESS)
         ;
     /*  Clean up and return.
      */
@@ -109,6 +112,7 @@ _encode_init (char **cred, munge_ctx_t ctx)
         *cred = NULL;
     }
     if (ctx) {
+        ctx->cred_len = 0;
         ctx->error_num = EMUNGE_SUCCESS;
         if (ctx->error_str) {
             free (ctx->error_str);
@@ -177,7 +181,7 @@ _encode_req (m_msg_t m, munge_ctx_t ctx, const void *buf, int len)
 
 
 static munge_err_t
-_encode_rsp (m_msg_t m, char **cred)
+_encode_rsp (m_msg_t m, munge_ctx_t ctx, char **cred)
 {
 /*  Extracts an Encode Response message received from the local munge daemon.
  *  The outputs from this message are as follows:
@@ -185,6 +189,8 @@ _encode_rsp (m_msg_t m, char **cred)
  *  Note that error_num and error_str are set by _munge_ctx_set_err()
  *    called from munge_encode() (ie, the parent of this stack frame).
  *  Note that the [cred] is null-terminated.
+ *  Note that a binary [cred] may contain embedded null bytes, so its length
+ *    is returned via the ctx's cred_len.
  */
     assert (m != NULL);
     assert (cred != NULL);
@@ -205,6 +211,9 @@ _encode_rsp (m_msg_t m, char **cred)
      */
     assert (* ((unsigned char *) m->data + m->data_len) == '\0');
     *cred = m->data;
+    if (ctx && (ctx->flags & MUNGE_CTX_FLAG_BINARY)) {
+        ctx->cred_len = m->data_len;
+    }
     m->data_is_copy = 1;
     return (m->error_num);
 }
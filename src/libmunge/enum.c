@@ -53,6 +53,25 @@
 #  define MUNGE_CIPHER_AES256_FLAG      0
 #endif
 
+#if HAVE_DECL_GCRY_CIPHER_MODE_GCM || HAVE_EVP_AES_128_GCM
+#  define MUNGE_CIPHER_AES128_GCM_FLAG  1
+#else
+#  define MUNGE_CIPHER_AES128_GCM_FLAG  0
+#endif
+
+#if HAVE_DECL_GCRY_CIPHER_MODE_GCM || (HAVE_EVP_AES_256_GCM && HAVE_EVP_SHA256)
+#  define MUNGE_CIPHER_AES256_GCM_FLAG  1
+#else
+#  define MUNGE_CIPHER_AES256_GCM_FLAG  0
+#endif
+
+#if HAVE_DECL_GCRY_CIPHER_MODE_POLY1305 \
+        || (HAVE_EVP_CHACHA20_POLY1305 && HAVE_EVP_SHA256)
+#  define MUNGE_CIPHER_CHACHA20_POLY1305_FLAG   1
+#else
+#  define MUNGE_CIPHER_CHACHA20_POLY1305_FLAG   0
+#endif
+
 #if HAVE_LIBGCRYPT || HAVE_EVP_SHA256
 #  define MUNGE_MAC_SHA256_FLAG         1
 #else
@@ -65,6 +84,20 @@
 #  define MUNGE_MAC_SHA512_FLAG         0
 #endif
 
+/*  Keyed BLAKE2 requires the EVP_MAC interface of OpenSSL >= 3.0.
+ */
+#if HAVE_DECL_GCRY_MD_BLAKE2B_512 || (HAVE_EVP_BLAKE2B512 && HAVE_EVP_MAC_INIT)
+#  define MUNGE_MAC_BLAKE2B_FLAG        1
+#else
+#  define MUNGE_MAC_BLAKE2B_FLAG        0
+#endif
+
+#if HAVE_DECL_GCRY_MD_BLAKE2S_256 || (HAVE_EVP_BLAKE2S256 && HAVE_EVP_MAC_INIT)
+#  define MUNGE_MAC_BLAKE2S_FLAG        1
+#else
+#  define MUNGE_MAC_BLAKE2S_FLAG        0
+#endif
+
 #if HAVE_PKG_BZLIB
 #  define MUNGE_ZIP_BZLIB_FLAG          1
 #else
@@ -77,6 +110,18 @@
 #  define MUNGE_ZIP_ZLIB_FLAG           0
 #endif
 
+#if HAVE_PKG_LZ4
+#  define MUNGE_ZIP_LZ4_FLAG            1
+#else
+#  define MUNGE_ZIP_LZ4_FLAG            0
+#endif
+
+#if HAVE_PKG_ZSTD
+#  define MUNGE_ZIP_ZSTD_FLAG           1
+#else
+#  define MUNGE_ZIP_ZSTD_FLAG           0
+#endif
+
 
 /*****************************************************************************
  *  Data Types
@@ -102,6 +147,10 @@ static struct munge_enum_table _munge_cipher_table[] = {
     { MUNGE_CIPHER_CAST5,       "cast5",        1                        },
     { MUNGE_CIPHER_AES128,      "aes128",       MUNGE_CIPHER_AES128_FLAG },
     { MUNGE_CIPHER_AES256,      "aes256",       MUNGE_CIPHER_AES256_FLAG },
+    { MUNGE_CIPHER_AES128_GCM,  "aes128-gcm",   MUNGE_CIPHER_AES128_GCM_FLAG },
+    { MUNGE_CIPHER_AES256_GCM,  "aes256-gcm",   MUNGE_CIPHER_AES256_GCM_FLAG },
+    { MUNGE_CIPHER_CHACHA20_POLY1305, "chacha20-poly1305",
+                                    MUNGE_CIPHER_CHACHA20_POLY1305_FLAG },
     { -1,                        NULL,         -1                        }
 };
 
@@ -113,6 +162,8 @@ static struct munge_enum_table _munge_mac_table[] = {
     { MUNGE_MAC_RIPEMD160,      "ripemd160",    1                        },
     { MUNGE_MAC_SHA256,         "sha256",       MUNGE_MAC_SHA256_FLAG    },
     { MUNGE_MAC_SHA512,         "sha512",       MUNGE_MAC_SHA512_FLAG    },
+    { MUNGE_MAC_BLAKE2B,        "blake2b",      MUNGE_MAC_BLAKE2B_FLAG   },
+    { MUNGE_MAC_BLAKE2S,        "blake2s",      MUNGE_MAC_BLAKE2S_FLAG   },
     { -1,                        NULL,         -1                        }
 };
 
@@ -121,6 +172,8 @@ static struct munge_enum_table _munge_zip_table[] = {
     { MUNGE_ZIP_DEFAULT,        "default",      1                        },
     { MUNGE_ZIP_BZLIB,          "bzlib",        MUNGE_ZIP_BZLIB_FLAG     },
     { MUNGE_ZIP_ZLIB,           "zlib",         MUNGE_ZIP_ZLIB_FLAG      },
+    { MUNGE_ZIP_LZ4,            "lz4",          MUNGE_ZIP_LZ4_FLAG       },
+    { MUNGE_ZIP_ZSTD,           "zstd",         MUNGE_ZIP_ZSTD_FLAG      },
     { -1,                        NULL,         -1                        }
 };
 
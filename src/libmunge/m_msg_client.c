@@ -40,6 +40,7 @@
 #include <unistd.h>
 #include <munge.h>
 #include "auth_send.h"
+#include "common.h"
 #include "ctx.h"
 #include "fd.h"
 #include "m_msg.h"
@@ -66,6 +67,7 @@ m_msg_client_xfer (m_msg_t *pm, m_msg_type_t mreq_type, munge_ctx_t ctx)
 {
     char         *socket;
     int           i;
+    unsigned long msecs;
     munge_err_t   e;
     m_msg_t       mreq, mrsp;
     m_msg_type_t  mrsp_type;
@@ -78,18 +80,26 @@ m_msg_client_xfer (m_msg_t *pm, m_msg_type_t mreq_type, munge_ctx_t ctx)
     }
     mreq = *pm;
     mrsp = NULL;
-    if (mreq_type == MUNGE_MSG_ENC_REQ) {
+    if ((mreq_type == MUNGE_MSG_ENC_REQ)
+            || (mreq_type == MUNGE_MSG_ENC_BIN_REQ)) {
         mrsp_type = MUNGE_MSG_ENC_RSP;
     }
-    else if (mreq_type == MUNGE_MSG_DEC_REQ) {
+    else if ((mreq_type == MUNGE_MSG_DEC_REQ)
+            || (mreq_type == MUNGE_MSG_DEC_BIN_REQ)
+            || (mreq_type == MUNGE_MSG_DEC_VAL_REQ)
+            || (mreq_type == MUNGE_MSG_DEC_BIN_VAL_REQ)) {
         mrsp_type = MUNGE_MSG_DEC_RSP;
     }
+    else if (mreq_type == MUNGE_MSG_STATS_REQ) {
+        mrsp_type = MUNGE_MSG_STATS_RSP;
+    }
     else {
         return (EMUNGE_SNAFU);
     }
 
     i = 1;
     while (1) {
+        msecs = i * MUNGE_SOCKET_RETRY_MSECS;
         if ((e = _m_msg_client_connect (mreq, socket)) != EMUNGE_SUCCESS) {
             break;
         }
@@ -112,9 +122,20 @@ m_msg_client_xfer (m_msg_t *pm, m_msg_type_t mreq_type, munge_ctx_t ctx)
         else if ((e = _m_msg_client_disconnect (mrsp)) != EMUNGE_SUCCESS) {
             break;
         }
-        else if (e == EMUNGE_SUCCESS) {
+        else if ((mrsp->error_num != EMUNGE_SOCKET) || (mrsp->retry == 0)) {
             break;
         }
+        else {
+            /*  The server shed the request due to overload.  Only a shed
+             *    response has a non-zero retry field; it suggests how long to
+             *    wait (in units of MUNGE_SOCKET_RETRY_MSECS) before retrying.
+             *  Other EMUNGE_SOCKET errors (e.g., exceeding the maximum number
+             *    of retry attempts) are returned to the caller.
+             */
+            mreq->sd = -1;              /* closed by disconnect() above */
+            e = EMUNGE_SOCKET;
+            msecs = MAX (msecs, mrsp->retry * MUNGE_SOCKET_RETRY_MSECS);
+        }
 
         if (i >= MUNGE_SOCKET_RETRY_ATTEMPTS) {
             break;
@@ -132,7 +153,7 @@ m_msg_client_xfer (m_msg_t *pm, m_msg_type_t mreq_type, munge_ctx_t ctx)
             mreq->sd = -1;
         }
         mreq->retry = i;
-        e = _m_msg_client_millisleep (mreq, i * MUNGE_SOCKET_RETRY_MSECS);
+        e = _m_msg_client_millisleep (mreq, msecs);
         if (e != EMUNGE_SUCCESS) {
             break;
         }
@@ -69,7 +69,10 @@ typedef enum munge_opt {
     MUNGE_OPT_UID_RESTRICTION   =  9,   /* UID able to decode cred (uid_t)   */
     MUNGE_OPT_GID_RESTRICTION   = 10,   /* GID able to decode cred (gid_t)   */
     MUNGE_OPT_IGNORE_TTL        = 11,   /* ignore ttl/replay errors (int)    */
-    MUNGE_OPT_IGNORE_REPLAY     = 12    /* ignore replay errors (int)        */
+    MUNGE_OPT_IGNORE_REPLAY     = 12,   /* ignore replay errors (int)        */
+    MUNGE_OPT_BINARY            = 13,   /* unarmored binary cred (int)       */
+    MUNGE_OPT_CRED_LENGTH       = 14,   /* binary cred length (int)          */
+    MUNGE_OPT_VALIDATE_ONLY     = 15    /* decode w/o returning payload (int)*/
 } munge_opt_t;
 
 /*  MUNGE symmetric cipher types
@@ -81,6 +84,9 @@ typedef enum munge_cipher {
     MUNGE_CIPHER_CAST5          =  3,   /* CAST5 CBC w/ 64b-blk/128b-key     */
     MUNGE_CIPHER_AES128         =  4,   /* AES CBC w/ 128b-blk/128b-key      */
     MUNGE_CIPHER_AES256         =  5,   /* AES CBC w/ 128b-blk/256b-key      */
+    MUNGE_CIPHER_AES128_GCM     =  6,   /* AES GCM w/ 128b-key/128b-tag      */
+    MUNGE_CIPHER_AES256_GCM     =  7,   /* AES GCM w/ 256b-key/128b-tag      */
+    MUNGE_CIPHER_CHACHA20_POLY1305 = 8, /* ChaCha20-Poly1305 w/ 256b-key     */
     MUNGE_CIPHER_LAST_ITEM
 } munge_cipher_t;
 
@@ -94,6 +100,8 @@ typedef enum munge_mac {
     MUNGE_MAC_RIPEMD160         =  4,   /* RIPEMD-160 w/ 160b-digest         */
     MUNGE_MAC_SHA256            =  5,   /* SHA-256 w/ 256b-digest            */
     MUNGE_MAC_SHA512            =  6,   /* SHA-512 w/ 512b-digest            */
+    MUNGE_MAC_BLAKE2B           =  7,   /* keyed BLAKE2b w/ 512b-digest      */
+    MUNGE_MAC_BLAKE2S           =  8,   /* keyed BLAKE2s w/ 256b-digest      */
     MUNGE_MAC_LAST_ITEM
 } munge_mac_t;
 
@@ -104,6 +112,8 @@ typedef enum munge_zip {
     MUNGE_ZIP_DEFAULT           =  1,   /* default zip specified by daemon   */
     MUNGE_ZIP_BZLIB             =  2,   /* bzip2 by Julian Seward            */
     MUNGE_ZIP_ZLIB              =  3,   /* zlib "deflate" by Gailly & Adler  */
+    MUNGE_ZIP_LZ4               =  4,   /* lz4 by Yann Collet                */
+    MUNGE_ZIP_ZSTD              =  5,   /* zstd "Zstandard" by Yann Collet   */
     MUNGE_ZIP_LAST_ITEM
 } munge_zip_t;
 
@@ -208,6 +218,19 @@ munge_err_t munge_decode (const char *cred, munge_ctx_t ctx,
  *    more detailed error message accessible via munge_ctx_strerror().
  */
 
+munge_err_t munge_stats (char **stats, munge_ctx_t ctx);
+/*
+ *  Queries the local munge daemon for its runtime statistics.
+ *  If the munge context [ctx] is NULL, the default context will be used.
+ *  A pointer to a null-terminated string of newline-separated "name value"
+ *    pairs is returned via [stats]; the caller is responsible for freeing
+ *    this memory.  Only root and the user running the daemon are authorized.
+ *  Returns EMUNGE_SUCCESS if the stats are successfully retrieved;
+ *    o/w, sets [stats] to NULL and returns the munge error number.
+ *    If a [ctx] was specified, it may contain a more detailed error
+ *    message accessible via munge_ctx_strerror().
+ */
+
 const char * munge_strerror (munge_err_t e);
 /*
  *  Returns a descriptive string describing the munge errno [e].
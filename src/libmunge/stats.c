@@ -0,0 +1,135 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <munge.h>
+#include "ctx.h"
+#include "m_msg.h"
+#include "m_msg_client.h"
+#include "str.h"
+
+
+/*****************************************************************************
+ *  Static Prototypes
+ *****************************************************************************/
+
+static munge_err_t _stats_rsp (m_msg_t m, char **stats);
+
+
+/*****************************************************************************
+ *  Public Functions
+ *****************************************************************************/
+
+munge_err_t
+munge_stats (char **stats, munge_ctx_t ctx)
+{
+    munge_err_t  e;
+    m_msg_t      m;
+
+    /*  Init output parms in case of early return.
+     */
+    if (stats) {
+        *stats = NULL;
+    }
+    if (ctx) {
+        ctx->error_num = EMUNGE_SUCCESS;
+        if (ctx->error_str) {
+            free (ctx->error_str);
+            ctx->error_str = NULL;
+        }
+    }
+    /*  Ensure a stats ptr was specified.
+     */
+    if (!stats) {
+        return (_munge_ctx_set_err (ctx, EMUNGE_BAD_ARG,
+            strdup ("No address specified for returning the stats")));
+    }
+    /*  Ask the daemon for its stats.
+     *  The request contains no data (ie, data_len is 0).
+     */
+    if ((e = m_msg_create (&m)) != EMUNGE_SUCCESS)
+        ;
+    else if ((e = m_msg_client_xfer (&m, MUNGE_MSG_STATS_REQ, ctx))
+            != EMUNGE_SUCCESS)
+        ;
+    else if ((e = _stats_rsp (m, stats)) != EMUNGE_SUCCESS)
+        ;
+    /*  Clean up and return.
+     */
+    if (ctx) {
+        _munge_ctx_set_err (ctx, e, m->error_str);
+        m->error_is_copy = 1;
+    }
+    m_msg_destroy (m);
+    return (e);
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+static munge_err_t
+_stats_rsp (m_msg_t m, char **stats)
+{
+/*  Extracts a Stats Response message received from the local munge daemon.
+ *  The outputs from this message are as follows:
+ *    data_len, data, error_num, error_len, error_str.
+ *  Note that error_num and error_str are set by _munge_ctx_set_err()
+ *    called from munge_stats() (ie, the parent of this stack frame).
+ */
+    assert (m != NULL);
+    assert (stats != NULL);
+
+    /*  Perform sanity checks.
+     */
+    if (m->type != MUNGE_MSG_STATS_RSP) {
+        m_msg_set_err (m, EMUNGE_SNAFU,
+            strdupf ("Client received invalid message type %d", m->type));
+        return (EMUNGE_SNAFU);
+    }
+    if ((m->error_num == EMUNGE_SUCCESS)
+            && ((m->data_len == 0) || (m->data == NULL))) {
+        m_msg_set_err (m, EMUNGE_SNAFU,
+            strdup ("Client received invalid stats data"));
+        return (EMUNGE_SNAFU);
+    }
+    /*  Return the result.
+     */
+    if (m->error_num == EMUNGE_SUCCESS) {
+        *stats = m->data;
+        m->data_is_copy = 1;
+    }
+    return (m->error_num);
+}
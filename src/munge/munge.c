@@ -54,6 +54,9 @@
  *  Command-Line Options
  *****************************************************************************/
 
+#define OPT_STATS               256
+#define OPT_BINARY              257
+
 const char * const short_opts = ":hLVns:i:o:c:Cm:Mz:Zu:U:g:G:t:S:";
 
 #include <getopt.h>
@@ -77,6 +80,8 @@ struct option long_opts[] = {
     { "gid",          required_argument, NULL, 'G' },
     { "ttl",          required_argument, NULL, 't' },
     { "socket",       required_argument, NULL, 'S' },
+    { "stats",        no_argument,       NULL, OPT_STATS },
+    { "binary",       no_argument,       NULL, OPT_BINARY },
     {  NULL,          0,                 NULL,  0  }
 };
 
@@ -99,6 +104,8 @@ struct conf {
     void        *data;                  /* payload data                      */
     int          clen;                  /* munged credential length          */
     char        *cred;                  /* munged credential null-terminated */
+    int          got_stats;             /* flag for querying munged stats    */
+    int          got_binary;            /* flag for binary (unarmored) cred  */
 };
 
 typedef struct conf * conf_t;
@@ -116,6 +123,7 @@ void   display_strings (const char *header, munge_enum_t type);
 void   open_files (conf_t conf);
 int    encode_cred (conf_t conf);
 void   display_cred (conf_t conf);
+void   display_stats (conf_t conf);
 
 
 /*****************************************************************************
@@ -133,6 +141,13 @@ main (int argc, char *argv[])
     log_open_file (stderr, argv[0], LOG_INFO, LOG_OPT_PRIORITY);
     conf = create_conf ();
     parse_cmdline (conf, argc, argv);
+
+    if (conf->got_stats) {
+        display_stats (conf);
+        destroy_conf (conf);
+        log_close_file ();
+        exit (EMUNGE_SUCCESS);
+    }
     open_files (conf);
 
     if (conf->string) {
@@ -149,8 +164,15 @@ main (int argc, char *argv[])
         }
         log_err (conf->status, LOG_ERR, "%s", p);
     }
-    conf->clen = strlen (conf->cred);
-
+    if (!conf->got_binary) {
+        conf->clen = strlen (conf->cred);
+    }
+    else if (munge_ctx_get (conf->ctx, MUNGE_OPT_CRED_LENGTH, &conf->clen)
+            != EMUNGE_SUCCESS) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to get binary credential length: %s",
+            munge_ctx_strerror (conf->ctx));
+    }
     display_cred (conf);
 
     destroy_conf (conf);
@@ -182,6 +204,8 @@ create_conf (void)
     conf->data = NULL;
     conf->clen = 0;
     conf->cred = NULL;
+    conf->got_stats = 0;
+    conf->got_binary = 0;
     return (conf);
 }
 
@@ -395,6 +419,18 @@ parse_cmdline (conf_t conf, int argc, char **argv)
                         munge_ctx_strerror (conf->ctx));
                 }
                 break;
+            case OPT_STATS:
+                conf->got_stats = 1;
+                break;
+            case OPT_BINARY:
+                conf->got_binary = 1;
+                e = munge_ctx_set (conf->ctx, MUNGE_OPT_BINARY, 1);
+                if (e != EMUNGE_SUCCESS) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Failed to set binary credential: %s",
+                        munge_ctx_strerror (conf->ctx));
+                }
+                break;
             case '?':
                 if (optopt > 0) {
                     log_err (EMUNGE_SNAFU, LOG_ERR,
@@ -521,6 +557,12 @@ display_help (char *prog)
     printf ("  %*s %s\n", w, "-S, --socket=PATH",
             "Specify local socket for munged");
 
+    printf ("  %*s %s\n", w, "--stats",
+            "Display runtime statistics of munged");
+
+    printf ("  %*s %s\n", w, "--binary",
+            "Write credential in binary without armor");
+
     printf ("\n");
     printf ("By default, payload read from stdin, "
             "credential written to stdout.\n\n");
@@ -621,8 +663,40 @@ display_cred (conf_t conf)
     if (!conf->fp_out) {
         return;
     }
-    if (fprintf (conf->fp_out, "%s\n", conf->cred) < 0) {
+    /*  A binary credential may contain null bytes, so write its exact length
+     *    without a trailing newline.
+     */
+    if (conf->got_binary) {
+        if (fwrite (conf->cred, 1, conf->clen, conf->fp_out) != conf->clen) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Write error");
+        }
+    }
+    else if (fprintf (conf->fp_out, "%s\n", conf->cred) < 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Write error");
     }
     return;
 }
+
+
+void
+display_stats (conf_t conf)
+{
+/*  Queries munged for its runtime statistics and writes them to stdout.
+ */
+    munge_err_t  e;
+    char        *stats;
+    const char  *p;
+
+    e = munge_stats (&stats, conf->ctx);
+    if (e != EMUNGE_SUCCESS) {
+        if (!(p = munge_ctx_strerror (conf->ctx))) {
+            p = munge_strerror (e);
+        }
+        log_err (e, LOG_ERR, "%s", p);
+    }
+    if (fputs (stats, stdout) == EOF) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to write stats");
+    }
+    free (stats);
+    return;
+}
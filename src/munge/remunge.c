@@ -32,6 +32,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <limits.h>
+#include <math.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdarg.h>
@@ -46,6 +47,7 @@
 #include "license.h"
 #include "log.h"
 #include "query.h"
+#include "scenario.h"
 #include "version.h"
 #include "xsignal.h"
 
@@ -57,15 +59,30 @@
 #define DEF_DO_DECODE           0
 #define DEF_NUM_THREADS         1
 #define DEF_PAYLOAD_LENGTH      0
+#define DEF_RAMP_STEPS          10
 #define DEF_WARNING_TIME        5
+#define MAX_RAMP_STEPS          1000
 #define MIN_DURATION            0.5
 
+/*  Latency histogram buckets are log-linear in microseconds: each power-of-two
+ *    range is split into 2^HIST_SUB_BITS linear sub-buckets, bounding the
+ *    relative error of a reported percentile to 1/2^HIST_SUB_BITS.
+ */
+#define HIST_SUB_BITS           4
+#define HIST_SUB_COUNT          (1 << HIST_SUB_BITS)
+#define HIST_MAG_COUNT          40
+#define HIST_SIZE               ((HIST_MAG_COUNT + 1) * HIST_SUB_COUNT)
+
 
 /*****************************************************************************
  *  Command-Line Options
  *****************************************************************************/
 
-const char * const short_opts = ":hLVqc:Cm:Mz:Zedl:u:g:t:S:D:N:T:W:";
+#define OPT_RAMP                256
+#define OPT_RAMP_STEPS          257
+#define OPT_RATE_MAX            258
+
+const char * const short_opts = ":hLVqc:Cm:Mz:Zedl:u:g:t:S:f:D:N:T:W:R:";
 
 #include <getopt.h>
 struct option long_opts[] = {
@@ -86,10 +103,15 @@ struct option long_opts[] = {
     { "restrict-gid", required_argument, NULL, 'g' },
     { "ttl",          required_argument, NULL, 't' },
     { "socket",       required_argument, NULL, 'S' },
+    { "scenario",     required_argument, NULL, 'f' },
     { "duration",     required_argument, NULL, 'D' },
     { "num-creds",    required_argument, NULL, 'N' },
     { "num-threads",  required_argument, NULL, 'T' },
     { "warn-time",    required_argument, NULL, 'W' },
+    { "rate",         required_argument, NULL, 'R' },
+    { "rate-max",     required_argument, NULL, OPT_RATE_MAX   },
+    { "ramp",         required_argument, NULL, OPT_RAMP       },
+    { "ramp-steps",   required_argument, NULL, OPT_RAMP_STEPS },
     {  NULL,          0,                 NULL,  0  }
 };
 
@@ -98,9 +120,30 @@ struct option long_opts[] = {
  *  Data Types
  *****************************************************************************/
 
+typedef enum {
+    RAMP_NONE,                          /* fixed rate for entire duration    */
+    RAMP_STEP,                          /* rate increases in discrete steps  */
+    RAMP_LINEAR                         /* rate increases continuously       */
+} ramp_t;
+
+struct hist {
+    unsigned long   num;                /* number of samples recorded        */
+    double          max;                /* maximum sample (in seconds)       */
+    unsigned long   count[HIST_SIZE];   /* sample counts by latency bucket   */
+};
+typedef struct hist * hist_t;
+
+struct step {
+    unsigned long   num_creds_done;     /* number of creds completed in step */
+    unsigned long   num_errs;           /* number of errors in step          */
+    struct hist     latency;            /* latency from intended send time   */
+};
+typedef struct step * step_t;
+
 /*  LOCKING PROTOCOL:
  *    The mutex must be locked when accessing the following fields:
- *      num_creds_done, num_encode_errs, num_decode_errs.
+ *      num_creds_sched, num_creds_done, num_encode_errs, num_decode_errs,
+ *      the steps array, and the scenario operation counts.
  *    The remaining fields are either not shared between threads or
  *      are constant while processing credentials.
  */
@@ -109,19 +152,28 @@ struct conf {
     int             do_decode;          /* true to decode/validate all creds */
     char           *payload;            /* payload to be encoded into cred   */
     int             num_payload;        /* number of bytes for cred payload  */
+    char           *scenario_name;      /* pathname of scenario file         */
+    scenario_t      scenario;           /* weighted mix of cred operations   */
     int             max_threads;        /* max number of threads available   */
     int             num_threads;        /* number of threads to spawn        */
     int             num_running;        /* number of threads now running     */
     int             num_seconds;        /* number of seconds to run          */
     unsigned long   num_creds;          /* number of credentials to process  */
     int             warn_time;          /* number of seconds to allow for op */
+    unsigned long   rate;               /* open-loop creds/sec (0=closed)    */
+    unsigned long   rate_max;           /* creds/sec at end of ramp          */
+    ramp_t          ramp;               /* schedule for ramping up the rate  */
+    int             num_steps;          /* number of ramp steps/intervals    */
+    step_t          steps;              /* ptr to array of per-step results  */
     struct timeval  t_main_start;       /* time when cred processing started */
     struct timeval  t_main_stop;        /* time when cred processing stopped */
     pthread_t      *tids;               /* ptr to array of thread IDs        */
     pthread_mutex_t mutex;              /* mutex for accessing shared data   */
     pthread_cond_t  cond_done;          /* cond for when last thread is done */
+    pthread_cond_t  cond_sched;         /* cond for awaiting intended time   */
 
     struct {                            /* thread-modified data; mutex req'd */
+      unsigned long num_creds_sched;    /*   number of credentials scheduled */
       unsigned long num_creds_done;     /*   number of credentials processed */
       unsigned long num_encode_errs;    /*   number of errors encoding creds */
       unsigned long num_decode_errs;    /*   number of errors decoding creds */
@@ -133,6 +185,13 @@ struct thread_data {
     conf_t          conf;               /* reference to global configuration */
     munge_ctx_t     ectx;               /* local munge context for encodes   */
     munge_ctx_t     dctx;               /* local munge context for decodes   */
+    unsigned int    seed;               /* rand_r() state for scenario       */
+    char           *payload;            /* scenario payload buffer           */
+    munge_ctx_t    *op_ectx;            /* scenario op contexts for encodes  */
+    munge_ctx_t    *op_dctx;            /* scenario op contexts for decodes  */
+    char          **op_cred;            /* scenario op creds for replaying   */
+    unsigned long  *op_done;            /* scenario op creds processed       */
+    unsigned long  *op_errs;            /* scenario op errors                */
 };
 typedef struct thread_data * tdata_t;
 
@@ -154,16 +213,33 @@ int g_got_quiet = 0;
 conf_t  create_conf (void);
 void    destroy_conf (conf_t conf);
 tdata_t create_tdata (conf_t conf);
+void    create_tdata_scenario (tdata_t tdata);
 void    destroy_tdata (tdata_t tdata);
 void    parse_cmdline (conf_t conf, int argc, char **argv);
 void    display_help (char *prog);
 void    display_strings (const char *header, munge_enum_t type);
 int     get_si_multiple (char c);
 int     get_time_multiple (char c);
+unsigned long get_rate (const char *s);
+int     get_sched_time (conf_t conf, unsigned long i, double *t, int *step);
+double  get_step_rate (conf_t conf, int step);
+void    hist_insert (hist_t h, double secs);
+double  hist_percentile (hist_t h, double pct);
 void    start_threads (conf_t conf);
 void    process_creds (conf_t conf);
 void    stop_threads (conf_t conf);
+void    output_latency (conf_t conf, double delta);
+void    output_scenario (conf_t conf);
 void *  remunge (conf_t conf);
+void *  remunge_rate (conf_t conf);
+void    remunge_cred (tdata_t tdata, unsigned long n,
+            unsigned long *got_encode_err, unsigned long *got_decode_err);
+void    remunge_op (tdata_t tdata, unsigned long n,
+            unsigned long *got_encode_err, unsigned long *got_decode_err);
+munge_err_t remunge_encode (tdata_t tdata, munge_ctx_t ctx, unsigned long n,
+            char **cred, const void *buf, int len);
+munge_err_t remunge_decode (tdata_t tdata, munge_ctx_t ctx, unsigned long n,
+            const char *cred);
 void    remunge_cleanup (tdata_t tdata);
 void    output_msg (const char *format, ...);
 
@@ -243,13 +319,24 @@ create_conf (void)
     if ((errno = pthread_cond_init (&conf->cond_done, NULL)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to init condition");
     }
+    if ((errno = pthread_cond_init (&conf->cond_sched, NULL)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to init condition");
+    }
     conf->do_decode = DEF_DO_DECODE;
     conf->payload = NULL;
+    conf->scenario_name = NULL;
+    conf->scenario = NULL;
     conf->num_payload = DEF_PAYLOAD_LENGTH;;
     conf->num_threads = DEF_NUM_THREADS;
     conf->num_running = 0;
     conf->num_seconds = 0;
     conf->num_creds = 0;
+    conf->rate = 0;
+    conf->rate_max = 0;
+    conf->ramp = RAMP_NONE;
+    conf->num_steps = 0;
+    conf->steps = NULL;
+    conf->shared.num_creds_sched = 0;
     conf->shared.num_creds_done = 0;
     conf->shared.num_encode_errs = 0;
     conf->shared.num_decode_errs = 0;
@@ -285,13 +372,19 @@ destroy_conf (conf_t conf)
         assert (conf->num_payload > 0);
         free (conf->payload);
     }
+    if ((errno = pthread_cond_destroy (&conf->cond_sched)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to destroy condition");
+    }
     if ((errno = pthread_cond_destroy (&conf->cond_done)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to destroy condition");
     }
     if ((errno = pthread_mutex_destroy (&conf->mutex)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to destroy mutex");
     }
+    scenario_destroy (conf->scenario);
+    free (conf->scenario_name);
     munge_ctx_destroy (conf->ctx);
+    free (conf->steps);
     free (conf->tids);
     free (conf);
     return;
@@ -330,17 +423,97 @@ create_tdata (conf_t conf)
     if ((conf->do_decode) && !(tdata->dctx = munge_ctx_copy (conf->ctx))) {
         log_err (EMUNGE_SNAFU, LOG_ERR, "Failed to copy munge decode context");
     }
+    tdata->payload = NULL;
+    tdata->op_ectx = NULL;
+    tdata->op_dctx = NULL;
+    tdata->op_cred = NULL;
+    tdata->op_done = NULL;
+    tdata->op_errs = NULL;
+
+    if (conf->scenario) {
+        create_tdata_scenario (tdata);
+    }
     return (tdata);
 }
 
 
+void
+create_tdata_scenario (tdata_t tdata)
+{
+/*  Create the scenario-specific portion of the thread-specific data [tdata].
+ *    Each scenario operation is given its own local encode and decode ctx
+ *    copied from the operation's ctx for the same reasons given above.
+ *  The payload buffer is sized for the largest payload in the scenario,
+ *    and the rand_r() seed is made unique to each thread.
+ */
+    scenario_t s = tdata->conf->scenario;
+    int        i;
+    int        c;
+
+    tdata->seed = (unsigned int) time (NULL) ^ (unsigned int) getpid ()
+        ^ (unsigned int) (unsigned long) tdata;
+
+    if (!(tdata->payload = malloc (s->max_len + 1))) {
+        log_err (EMUNGE_NO_MEMORY, LOG_ERR,
+            "Failed to allocate scenario payload of %d byte%s",
+            s->max_len, (s->max_len == 1 ? "" : "s"));
+    }
+    for (i = 0, c = 'A'; i < s->max_len; i++) {
+        if ((tdata->payload[i] = c++) == 'Z') {
+            c = 'A';
+        }
+    }
+    tdata->payload[s->max_len] = '\0';
+
+    tdata->op_ectx = calloc (s->num_ops, sizeof (*tdata->op_ectx));
+    tdata->op_dctx = calloc (s->num_ops, sizeof (*tdata->op_dctx));
+    tdata->op_cred = calloc (s->num_ops, sizeof (*tdata->op_cred));
+    tdata->op_done = calloc (s->num_ops, sizeof (*tdata->op_done));
+    tdata->op_errs = calloc (s->num_ops, sizeof (*tdata->op_errs));
+    if (!tdata->op_ectx || !tdata->op_dctx || !tdata->op_cred
+            || !tdata->op_done || !tdata->op_errs) {
+        log_err (EMUNGE_NO_MEMORY, LOG_ERR,
+            "Failed to allocate scenario thread data");
+    }
+    for (i = 0; i < s->num_ops; i++) {
+        if (!(tdata->op_ectx[i] = munge_ctx_copy (s->ops[i].ctx))) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to copy munge encode context for \"%s\"",
+                s->ops[i].name);
+        }
+        if (!(tdata->op_dctx[i] = munge_ctx_copy (s->ops[i].ctx))) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to copy munge decode context for \"%s\"",
+                s->ops[i].name);
+        }
+    }
+    return;
+}
+
+
 void
 destroy_tdata (tdata_t tdata)
 {
 /*  Destroy the thread-specific data [tdata].
  */
+    int i;
+
     assert (tdata != NULL);
 
+    if (tdata->conf->scenario) {
+        for (i = 0; i < tdata->conf->scenario->num_ops; i++) {
+            munge_ctx_destroy (tdata->op_ectx[i]);
+            munge_ctx_destroy (tdata->op_dctx[i]);
+            free (tdata->op_cred[i]);
+        }
+        free (tdata->op_ectx);
+        free (tdata->op_dctx);
+        free (tdata->op_cred);
+        free (tdata->op_done);
+        free (tdata->op_errs);
+        free (tdata->payload);
+    }
+
     if (tdata->conf->do_decode) {
         munge_ctx_destroy (tdata->dctx);
     }
@@ -529,6 +702,13 @@ parse_cmdline (conf_t conf, int argc, char **argv)
                         munge_ctx_strerror (conf->ctx));
                 }
                 break;
+            case 'f':
+                free (conf->scenario_name);
+                if (!(conf->scenario_name = strdup (optarg))) {
+                    log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+                        "Failed to copy scenario name");
+                }
+                break;
             case 'D':
                 errno = 0;
                 l = strtol (optarg, &p, 10);
@@ -604,6 +784,42 @@ parse_cmdline (conf_t conf, int argc, char **argv)
                 }
                 conf->warn_time = (int) l;
                 break;
+            case 'R':
+                conf->rate = get_rate (optarg);
+                break;
+            case OPT_RATE_MAX:
+                conf->rate_max = get_rate (optarg);
+                break;
+            case OPT_RAMP:
+                if (!strcmp (optarg, "none")) {
+                    conf->ramp = RAMP_NONE;
+                }
+                else if (!strcmp (optarg, "step")) {
+                    conf->ramp = RAMP_STEP;
+                }
+                else if (!strcmp (optarg, "linear")) {
+                    conf->ramp = RAMP_LINEAR;
+                }
+                else {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid ramp schedule \"%s\"", optarg);
+                }
+                break;
+            case OPT_RAMP_STEPS:
+                errno = 0;
+                l = strtol (optarg, &p, 10);
+                if ((optarg == p) || (*p != '\0') || (l <= 0)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid number of ramp steps '%s'", optarg);
+                }
+                if (((errno == ERANGE) && (l == LONG_MAX))
+                        || (l > MAX_RAMP_STEPS)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Exceeded maximum number of %d ramp steps",
+                        MAX_RAMP_STEPS);
+                }
+                conf->num_steps = (int) l;
+                break;
             case '?':
                 if (optopt > 0) {
                     log_err (EMUNGE_SNAFU, LOG_ERR,
@@ -666,6 +882,48 @@ parse_cmdline (conf_t conf, int argc, char **argv)
         }
         conf->payload[conf->num_payload] = '\0';
     }
+    /*  Load the scenario after the command-line has been parsed so its
+     *    operations inherit the settings of the command-line ctx.
+     */
+    if (conf->scenario_name) {
+        conf->scenario = scenario_create (conf->scenario_name, conf->ctx,
+            conf->do_decode, conf->num_payload);
+    }
+    /*  Validate the open-loop schedule and allocate its per-step results.
+     *    A ramp spans the test duration, so the duration must be known.
+     */
+    if (conf->ramp != RAMP_NONE) {
+        if (!conf->rate) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Ramp schedule requires a starting rate");
+        }
+        if (!conf->rate_max) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Ramp schedule requires a maximum rate");
+        }
+        if (!conf->num_seconds) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Ramp schedule requires a duration");
+        }
+        if (!conf->num_steps) {
+            conf->num_steps = DEF_RAMP_STEPS;
+        }
+    }
+    else if (conf->rate) {
+        conf->num_steps = 1;
+    }
+    else if (conf->rate_max || conf->num_steps) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "Ramp options require a ramp schedule");
+    }
+    if (conf->rate) {
+        conf->steps = calloc (conf->num_steps, sizeof (*conf->steps));
+        if (!conf->steps) {
+            log_err (EMUNGE_NO_MEMORY, LOG_ERR,
+                "Failed to allocate %d ramp step%s",
+                conf->num_steps, (conf->num_steps == 1 ? "" : "s"));
+        }
+    }
     return;
 }
 
@@ -737,6 +995,9 @@ display_help (char *prog)
     printf ("  %*s %s\n", w, "-S, --socket=PATH",
             "Specify local socket for munged");
 
+    printf ("  %*s %s\n", w, "-f, --scenario=PATH",
+            "Specify scenario file of weighted operations");
+
     printf ("\n");
 
     printf ("  %*s %s\n", w, "-D, --duration=SECS",
@@ -751,6 +1012,20 @@ display_help (char *prog)
     printf ("  %*s %s\n", w, "-W, --warn-time=SECS",
             "Specify max seconds for munge op before warning");
 
+    printf ("\n");
+
+    printf ("  %*s %s\n", w, "-R, --rate=INT",
+            "Specify open-loop rate (in creds/sec)");
+
+    printf ("  %*s %s\n", w, "--rate-max=INT",
+            "Specify rate at end of ramp (in creds/sec)");
+
+    printf ("  %*s %s\n", w, "--ramp=STR",
+            "Specify ramp schedule (none, step, linear)");
+
+    printf ("  %*s %s [%d]\n", w, "--ramp-steps=INT",
+            "Specify number of ramp steps", DEF_RAMP_STEPS);
+
     printf ("\n");
     return;
 }
@@ -848,6 +1123,205 @@ get_time_multiple (char c)
 }
 
 
+unsigned long
+get_rate (const char *s)
+{
+/*  Converts the string [s] into a rate (in creds/sec).  The integer may be
+ *    followed by an SI-suffix.
+ *  Returns the rate, or dies trying.
+ */
+    char          *p;
+    unsigned long  u;
+    int            multiplier;
+
+    errno = 0;
+    u = strtoul (s, &p, 10);
+    if ((s == p) || ((*p != '\0') && (*(p+1) != '\0')) || (u == 0)) {
+        log_err (EMUNGE_SNAFU, LOG_ERR, "Invalid rate '%s'", s);
+    }
+    if ((errno == ERANGE) && (u == ULONG_MAX)) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "Exceeded maximum rate of %lu creds/sec", ULONG_MAX);
+    }
+    if (!(multiplier = get_si_multiple (*p))) {
+        log_err (EMUNGE_SNAFU, LOG_ERR, "Invalid number specifier '%c'", *p);
+    }
+    if (u > (ULONG_MAX / multiplier)) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "Exceeded maximum rate of %lu creds/sec", ULONG_MAX);
+    }
+    return (u * multiplier);
+}
+
+
+int
+get_sched_time (conf_t conf, unsigned long i, double *t, int *step)
+{
+/*  Computes the intended send time of the [i]th credential (counting from 0)
+ *    according to the open-loop schedule in [conf].  The time is returned
+ *    in [t] as the number of seconds since the start of processing, and the
+ *    step (or interval) of the ramp in which it falls is returned in [step].
+ *  Returns 0 on success, or -1 if the credential falls beyond the schedule.
+ */
+    double r0 = conf->rate;
+    double r1 = conf->rate_max;
+    double d = conf->num_seconds;
+    double a;
+    double n;
+    double r;
+    int    k;
+
+    assert (conf->rate > 0);
+    assert (conf->num_steps > 0);
+
+    switch (conf->ramp) {
+        case RAMP_NONE:
+            *t = i / r0;
+            break;
+        case RAMP_LINEAR:
+            /*
+             *  The rate r(t) = r0 + (r1-r0)t/d yields (r0)t + (r1-r0)t^2/2d
+             *    creds by time t.  Solving for the time at which i creds have
+             *    been sent gives 2i / (r0 + sqrt (r0^2 + 2(r1-r0)i/d)), a form
+             *    which remains stable as r1 approaches r0.
+             */
+            a = (r0 * r0) + (2.0 * (r1 - r0) * i / d);
+            if (a < 0) {
+                return (-1);
+            }
+            *t = (2.0 * i) / (r0 + sqrt (a));
+            break;
+        case RAMP_STEP:
+            /*
+             *  Each step lasts d/num_steps seconds at a constant rate.
+             */
+            for (k = 0, n = 0; k < conf->num_steps; k++) {
+                r = get_step_rate (conf, k);
+                a = r * d / conf->num_steps;
+                if (i < n + a) {
+                    break;
+                }
+                n += a;
+            }
+            if (k >= conf->num_steps) {
+                return (-1);
+            }
+            *t = (k * d / conf->num_steps) + ((i - n) / r);
+            break;
+        default:
+            return (-1);
+    }
+    if (*t >= d) {
+        return (-1);
+    }
+    *step = (int) (*t * conf->num_steps / d);
+    if (*step >= conf->num_steps) {
+        *step = conf->num_steps - 1;
+    }
+    return (0);
+}
+
+
+double
+get_step_rate (conf_t conf, int step)
+{
+/*  Returns the target rate (in creds/sec) for the given ramp [step].
+ *    For a linear ramp, this is the mean rate over the step's interval.
+ */
+    double r0 = conf->rate;
+    double r1 = conf->rate_max;
+
+    switch (conf->ramp) {
+        case RAMP_STEP:
+            if (conf->num_steps == 1) {
+                return (r0);
+            }
+            return (r0 + ((r1 - r0) * step / (conf->num_steps - 1)));
+        case RAMP_LINEAR:
+            return (r0 + ((r1 - r0) * (step + 0.5) / conf->num_steps));
+        default:
+            return (r0);
+    }
+}
+
+
+void
+hist_insert (hist_t h, double secs)
+{
+/*  Records a latency sample of [secs] seconds into the histogram [h].
+ */
+    unsigned long usec;
+    int           mag;
+    int           i;
+
+    assert (h != NULL);
+
+    usec = (secs > 0) ? (unsigned long) (secs * 1e6) : 0;
+
+    for (mag = 0; (usec >> mag) >= (2 * HIST_SUB_COUNT); mag++) {;}
+
+    if (mag >= HIST_MAG_COUNT) {
+        i = HIST_SIZE - 1;
+    }
+    else if (mag == 0) {
+        i = usec;
+    }
+    else {
+        i = (mag + 1) * HIST_SUB_COUNT + ((usec >> mag) - HIST_SUB_COUNT);
+    }
+    h->count[i]++;
+    h->num++;
+    if (secs > h->max) {
+        h->max = secs;
+    }
+    return;
+}
+
+
+double
+hist_percentile (hist_t h, double pct)
+{
+/*  Returns the latency (in seconds) at or below which [pct] percent of the
+ *    samples in the histogram [h] fall.  The midpoint of the matching bucket
+ *    is returned, capped at the maximum sample.
+ */
+    unsigned long target;
+    unsigned long n;
+    int           i;
+    int           mag;
+    double        lo;
+    double        width;
+    double        v;
+
+    assert (h != NULL);
+
+    if (h->num == 0) {
+        return (0);
+    }
+    target = (unsigned long) ceil (h->num * pct / 100.0);
+    if (target < 1) {
+        target = 1;
+    }
+    for (i = 0, n = 0; i < HIST_SIZE - 1; i++) {
+        n += h->count[i];
+        if (n >= target) {
+            break;
+        }
+    }
+    if (i < 2 * HIST_SUB_COUNT) {
+        lo = i;
+        width = 1;
+    }
+    else {
+        mag = (i / HIST_SUB_COUNT) - 1;
+        lo = (double) ((i % HIST_SUB_COUNT) + HIST_SUB_COUNT) * (1UL << mag);
+        width = (double) (1UL << mag);
+    }
+    v = (lo + (width / 2)) / 1e6;
+    return ((v < h->max) ? v : h->max);
+}
+
+
 void
 start_threads (conf_t conf)
 {
@@ -855,6 +1329,7 @@ start_threads (conf_t conf)
  */
     pthread_attr_t tattr;
     size_t         stacksize = 256 * 1024;
+    thread_f       f;
     int            i;
 
     if (!(conf->tids = malloc (sizeof (*conf->tids) * conf->num_threads))) {
@@ -889,13 +1364,34 @@ start_threads (conf_t conf)
     assert (conf->num_threads > 0);
     conf->num_running = conf->num_threads;
 
-    output_msg ("Spawning %d thread%s for %s",
-        conf->num_threads, ((conf->num_threads == 1) ? "" : "s"),
-        (conf->do_decode ? "encoding/decoding" : "encoding"));
+    if (conf->scenario) {
+        output_msg ("Spawning %d thread%s for scenario \"%s\" "
+            "(%d operation%s)",
+            conf->num_threads, ((conf->num_threads == 1) ? "" : "s"),
+            conf->scenario->path, conf->scenario->num_ops,
+            ((conf->scenario->num_ops == 1) ? "" : "s"));
+    }
+    else {
+        output_msg ("Spawning %d thread%s for %s",
+            conf->num_threads, ((conf->num_threads == 1) ? "" : "s"),
+            (conf->do_decode ? "encoding/decoding" : "encoding"));
+    }
+
+    if (conf->ramp != RAMP_NONE) {
+        output_msg ("Ramping %s rate from %lu to %lu creds/sec in %d %s%s",
+            (conf->ramp == RAMP_STEP ? "step" : "linear"),
+            conf->rate, conf->rate_max, conf->num_steps,
+            (conf->ramp == RAMP_STEP ? "step" : "interval"),
+            ((conf->num_steps == 1) ? "" : "s"));
+    }
+    else if (conf->rate) {
+        output_msg ("Scheduling credentials at %lu creds/sec", conf->rate);
+    }
+    f = (conf->rate) ? (thread_f) remunge_rate : (thread_f) remunge;
 
     for (i = 0; i < conf->num_threads; i++) {
         if ((errno = pthread_create
-                    (&conf->tids[i], &tattr, (thread_f) remunge, conf)) != 0) {
+                    (&conf->tids[i], &tattr, f, conf)) != 0) {
             log_errno (EMUNGE_SNAFU, LOG_ERR,
                 "Failed to create thread #%d", i+1);
         }
@@ -1058,6 +1554,12 @@ stop_threads (conf_t conf)
     if (g_got_quiet) {
         printf ("%0.0f\n", rate);
     }
+    if (conf->scenario) {
+        output_scenario (conf);
+    }
+    if (conf->rate) {
+        output_latency (conf, delta);
+    }
     /*  Check for minimum duration time interval.
      */
     if (delta < MIN_DURATION) {
@@ -1068,6 +1570,87 @@ stop_threads (conf_t conf)
 }
 
 
+void
+output_scenario (conf_t conf)
+{
+/*  Outputs the results for each operation of the scenario.
+ */
+    scenario_t    s = conf->scenario;
+    unsigned long total;
+    int           i;
+
+    for (i = 0, total = 0; i < s->num_ops; i++) {
+        total += s->ops[i].num_creds_done;
+    }
+    for (i = 0; i < s->num_ops; i++) {
+        scenario_op_t op = &s->ops[i];
+
+        output_msg ("Operation \"%s\": %lu credential%s (%0.1f%%), "
+            "%lu error%s", op->name,
+            op->num_creds_done, ((op->num_creds_done == 1) ? "" : "s"),
+            (total ? (100.0 * op->num_creds_done / total) : 0.0),
+            op->num_errs, ((op->num_errs == 1) ? "" : "s"));
+    }
+    return;
+}
+
+
+void
+output_latency (conf_t conf, double delta)
+{
+/*  Outputs the open-loop latency results measured from each credential's
+ *    intended send time.  A ramp outputs one line per step (or interval)
+ *    so the knee of the throughput curve can be located.
+ */
+    struct step *all;
+    double       d;
+    double       r;
+    int          i;
+    int          j;
+
+    assert (conf->steps != NULL);
+
+    if (!(all = calloc (1, sizeof (*all)))) {
+        log_err (EMUNGE_NO_MEMORY, LOG_ERR, "Failed to allocate step");
+    }
+    d = (conf->ramp == RAMP_NONE)
+        ? delta : (double) conf->num_seconds / conf->num_steps;
+
+    for (i = 0; i < conf->num_steps; i++) {
+        step_t s = &conf->steps[i];
+
+        if (conf->ramp != RAMP_NONE) {
+            r = (s->num_creds_done - s->num_errs) / d;
+            output_msg ("Step %d/%d: %0.0f creds/sec target, "
+                "%0.0f creds/sec achieved, latency p50=%0.3fms p99=%0.3fms "
+                "max=%0.3fms", i+1, conf->num_steps,
+                get_step_rate (conf, i), r,
+                hist_percentile (&s->latency, 50) * 1e3,
+                hist_percentile (&s->latency, 99) * 1e3,
+                s->latency.max * 1e3);
+        }
+        all->num_creds_done += s->num_creds_done;
+        all->num_errs += s->num_errs;
+        for (j = 0; j < HIST_SIZE; j++) {
+            all->latency.count[j] += s->latency.count[j];
+        }
+        all->latency.num += s->latency.num;
+        if (s->latency.max > all->latency.max) {
+            all->latency.max = s->latency.max;
+        }
+    }
+    output_msg ("Latency from intended send time: p50=%0.3fms p90=%0.3fms "
+        "p99=%0.3fms p99.9=%0.3fms max=%0.3fms",
+        hist_percentile (&all->latency, 50) * 1e3,
+        hist_percentile (&all->latency, 90) * 1e3,
+        hist_percentile (&all->latency, 99) * 1e3,
+        hist_percentile (&all->latency, 99.9) * 1e3,
+        all->latency.max * 1e3);
+    free (all);
+    return;
+}
+
+
 void *
 remunge (conf_t conf)
 {
@@ -1078,15 +1661,6 @@ remunge (conf_t conf)
     unsigned long   n;
     unsigned long   got_encode_err;
     unsigned long   got_decode_err;
-    struct timeval  t_start;
-    struct timeval  t_stop;
-    double          delta;
-    munge_err_t     e;
-    char           *cred;
-    void           *data;
-    int             dlen;
-    uid_t           uid;
-    gid_t           gid;
 
     tdata = create_tdata (conf);
 
@@ -1109,40 +1683,181 @@ remunge (conf_t conf)
         if ((errno = pthread_mutex_unlock (&conf->mutex)) != 0) {
             log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock mutex");
         }
-        got_encode_err = 0;
-        got_decode_err = 0;
-        data = NULL;
+        remunge_cred (tdata, n, &got_encode_err, &got_decode_err);
+
+        if ((errno = pthread_setcancelstate
+                    (cancel_state, &cancel_state)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to enable thread cancellation");
+        }
+        if ((errno = pthread_mutex_lock (&conf->mutex)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock mutex");
+        }
+        conf->shared.num_encode_errs += got_encode_err;
+        conf->shared.num_decode_errs += got_decode_err;
+    }
+    pthread_cleanup_pop (1);
+    return (NULL);
+}
+
+
+void *
+remunge_rate (conf_t conf)
+{
+/*  Worker thread responsible for processing credentials on an open-loop
+ *    schedule.  Each credential is sent at its intended time regardless of
+ *    how long previous credentials took, and its latency is measured from
+ *    that intended time so queueing delay is not hidden.  Enough threads
+ *    must be spawned to keep up with the target rate; once they are all
+ *    busy, credentials fall behind schedule and their latencies grow.
+ */
+    tdata_t         tdata;
+    int             cancel_state;
+    unsigned long   i;
+    unsigned long   n;
+    unsigned long   got_encode_err;
+    unsigned long   got_decode_err;
+    double          t_sched;
+    int             step;
+    struct timeval  t_now;
+    struct timespec to;
+    double          delta;
+    step_t          s;
+
+    tdata = create_tdata (conf);
+
+    pthread_cleanup_push ((thread_cleanup_f) remunge_cleanup, tdata);
+
+    if ((errno = pthread_mutex_lock (&conf->mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock mutex");
+    }
+    while (conf->num_creds - conf->shared.num_creds_sched > 0) {
+
+        pthread_testcancel ();
+
+        i = conf->shared.num_creds_sched;
+        if (get_sched_time (conf, i, &t_sched, &step) < 0) {
+            break;
+        }
+        conf->shared.num_creds_sched++;
+        /*
+         *  Wait until the intended send time.  The wait is a cancellation
+         *    point which reacquires the mutex as required by the cleanup
+         *    handler.  The condition is never signaled.
+         */
+        delta = t_sched + conf->t_main_start.tv_usec / 1e6;
+        to.tv_sec = conf->t_main_start.tv_sec + (time_t) delta;
+        to.tv_nsec = (delta - (time_t) delta) * 1e9;
+        GET_TIMEVAL (t_now);
+
+        if (DIFF_TIMEVAL (t_now, conf->t_main_start) < t_sched) {
+            for (;;) {
+                errno = pthread_cond_timedwait
+                    (&conf->cond_sched, &conf->mutex, &to);
+                if (errno == ETIMEDOUT) {
+                    break;
+                }
+                else if (!errno || (errno == EINTR)) {
+                    continue;
+                }
+                else {
+                    log_errno (EMUNGE_SNAFU, LOG_ERR,
+                        "Failed to wait on condition");
+                }
+            }
+        }
+        if ((errno = pthread_setcancelstate
+                    (PTHREAD_CANCEL_DISABLE, &cancel_state)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to disable thread cancellation");
+        }
+        n = ++conf->shared.num_creds_done;
+
+        if ((errno = pthread_mutex_unlock (&conf->mutex)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock mutex");
+        }
+        remunge_cred (tdata, n, &got_encode_err, &got_decode_err);
+
+        GET_TIMEVAL (t_now);
+        delta = DIFF_TIMEVAL (t_now, conf->t_main_start) - t_sched;
+
+        if ((errno = pthread_setcancelstate
+                    (cancel_state, &cancel_state)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to enable thread cancellation");
+        }
+        if ((errno = pthread_mutex_lock (&conf->mutex)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock mutex");
+        }
+        conf->shared.num_encode_errs += got_encode_err;
+        conf->shared.num_decode_errs += got_decode_err;
+
+        s = &conf->steps[step];
+        s->num_creds_done++;
+        s->num_errs += got_encode_err + got_decode_err;
+        hist_insert (&s->latency, delta);
+    }
+    pthread_cleanup_pop (1);
+    return (NULL);
+}
+
+
+void
+remunge_cred (tdata_t tdata, unsigned long n,
+              unsigned long *got_encode_err, unsigned long *got_decode_err)
+{
+/*  Processes the [n]th credential using the thread-specific data [tdata].
+ *  Errors are counted in [got_encode_err] and [got_decode_err].
+ */
+    conf_t          conf = tdata->conf;
+    struct timeval  t_start;
+    struct timeval  t_stop;
+    double          delta;
+    munge_err_t     e;
+    char           *cred;
+    void           *data;
+    int             dlen;
+    uid_t           uid;
+    gid_t           gid;
+
+    if (conf->scenario) {
+        remunge_op (tdata, n, got_encode_err, got_decode_err);
+        return;
+    }
+    *got_encode_err = 0;
+    *got_decode_err = 0;
+    data = NULL;
+
+    GET_TIMEVAL (t_start);
+    e = munge_encode(&cred, tdata->ectx, conf->payload, conf->num_payload);
+    GET_TIMEVAL (t_stop);
+
+    delta = DIFF_TIMEVAL (t_stop, t_start);
+    if (delta > conf->warn_time) {
+        output_msg ("Credential #%lu encoding took %0.3f seconds",
+            n, delta);
+    }
+    if (e != EMUNGE_SUCCESS) {
+        output_msg ("Credential #%lu encoding failed: %s (err=%d)",
+            n, munge_ctx_strerror (tdata->ectx), e);
+        ++*got_encode_err;
+    }
+    else if (conf->do_decode) {
 
         GET_TIMEVAL (t_start);
-        e = munge_encode(&cred, tdata->ectx, conf->payload, conf->num_payload);
+        e = munge_decode (cred, tdata->dctx, &data, &dlen, &uid, &gid);
         GET_TIMEVAL (t_stop);
 
         delta = DIFF_TIMEVAL (t_stop, t_start);
         if (delta > conf->warn_time) {
-            output_msg ("Credential #%lu encoding took %0.3f seconds",
+            output_msg ("Credential #%lu decoding took %0.3f seconds",
                 n, delta);
         }
         if (e != EMUNGE_SUCCESS) {
-            output_msg ("Credential #%lu encoding failed: %s (err=%d)",
-                n, munge_ctx_strerror (tdata->ectx), e);
-            ++got_encode_err;
+            output_msg ("Credential #%lu decoding failed: %s (err=%d)",
+                n, munge_ctx_strerror (tdata->dctx), e);
+            ++*got_decode_err;
         }
-        else if (conf->do_decode) {
-
-            GET_TIMEVAL (t_start);
-            e = munge_decode (cred, tdata->dctx, &data, &dlen, &uid, &gid);
-            GET_TIMEVAL (t_stop);
-
-            delta = DIFF_TIMEVAL (t_stop, t_start);
-            if (delta > conf->warn_time) {
-                output_msg ("Credential #%lu decoding took %0.3f seconds",
-                    n, delta);
-            }
-            if (e != EMUNGE_SUCCESS) {
-                output_msg ("Credential #%lu decoding failed: %s (err=%d)",
-                    n, munge_ctx_strerror (tdata->dctx), e);
-                ++got_decode_err;
-            }
 
 /*  FIXME:
  *    The following block does some validating of the decoded credential.
@@ -1156,50 +1871,168 @@ remunge (conf_t conf)
  *    into the tdata struct to facilitate parameter passing.
  */
 #if 0
-            else if (conf->do_validate) {
-                if (getuid () != uid) {
+        else if (conf->do_validate) {
+            if (getuid () != uid) {
+            output_msg (
+                "Credential #%lu UID %d does not match process UID %d",
+                n, uid, getuid ());
+            }
+            if (getgid () != gid) {
                 output_msg (
-                    "Credential #%lu UID %d does not match process UID %d",
-                    n, uid, getuid ());
-                }
-                if (getgid () != gid) {
-                    output_msg (
-                        "Credential #%lu GID %d does not match process GID %d",
-                        n, gid, getgid ());
-                }
-                if (conf->num_payload != dlen) {
-                    output_msg (
-                        "Credential #%lu payload length mismatch (%d/%d)",
-                        n, conf->num_payload, dlen);
-                }
-                else if (data && memcmp (conf->payload, data, dlen) != 0) {
-                    output_msg ("Credential #%lu payload mismatch", n);
-                }
+                    "Credential #%lu GID %d does not match process GID %d",
+                    n, gid, getgid ());
             }
+            if (conf->num_payload != dlen) {
+                output_msg (
+                    "Credential #%lu payload length mismatch (%d/%d)",
+                    n, conf->num_payload, dlen);
+            }
+            else if (data && memcmp (conf->payload, data, dlen) != 0) {
+                output_msg ("Credential #%lu payload mismatch", n);
+            }
+        }
 #endif /* 0 */
 
-            /*  The 'data' parm can still be set on certain munge errors.
-             */
-            if (data != NULL) {
-                free (data);
-            }
+        /*  The 'data' parm can still be set on certain munge errors.
+         */
+        if (data != NULL) {
+            free (data);
+        }
+    }
+    if (cred != NULL) {
+        free (cred);
+    }
+    return;
+}
+
+
+void
+remunge_op (tdata_t tdata, unsigned long n,
+            unsigned long *got_encode_err, unsigned long *got_decode_err)
+{
+/*  Processes the [n]th credential using an operation selected at random
+ *    from the scenario according to its weight.
+ *  A replay operation encodes and decodes a credential the first time it
+ *    is selected by a given thread; thereafter, that credential is decoded
+ *    again and is expected to be rejected as a replay.  Once the credential
+ *    has expired (and thus left the daemon's replay cache), a new one is
+ *    encoded in its place.
+ *  Errors are counted in [got_encode_err] and [got_decode_err].
+ */
+    scenario_t     s = tdata->conf->scenario;
+    scenario_op_t  op;
+    int            i;
+    int            len;
+    char          *cred = NULL;
+    munge_err_t    e;
+
+    *got_encode_err = 0;
+    *got_decode_err = 0;
+
+    i = scenario_select (s, &tdata->seed);
+    op = &s->ops[i];
+
+    if ((op->mode == SCENARIO_REPLAY) && (tdata->op_cred[i] != NULL)) {
+        e = remunge_decode (tdata, tdata->op_dctx[i], n, tdata->op_cred[i]);
+        if (e == EMUNGE_CRED_EXPIRED) {
+            free (tdata->op_cred[i]);
+            tdata->op_cred[i] = NULL;
         }
-        if (cred != NULL) {
-            free (cred);
+        else if (e != EMUNGE_CRED_REPLAYED) {
+            output_msg ("Credential #%lu was not rejected as a replay: "
+                "%s (err=%d)", n, munge_strerror (e), e);
+            ++*got_decode_err;
         }
-        if ((errno = pthread_setcancelstate
-                    (cancel_state, &cancel_state)) != 0) {
-            log_errno (EMUNGE_SNAFU, LOG_ERR,
-                "Failed to enable thread cancellation");
+    }
+    if ((op->mode != SCENARIO_REPLAY) || (tdata->op_cred[i] == NULL)) {
+        len = scenario_length (op, &tdata->seed);
+        e = remunge_encode (tdata, tdata->op_ectx[i], n, &cred,
+            tdata->payload, len);
+        if (e != EMUNGE_SUCCESS) {
+            ++*got_encode_err;
         }
-        if ((errno = pthread_mutex_lock (&conf->mutex)) != 0) {
-            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock mutex");
+        else if (op->mode != SCENARIO_ENCODE) {
+            e = remunge_decode (tdata, tdata->op_dctx[i], n, cred);
+            if (e != EMUNGE_SUCCESS) {
+                ++*got_decode_err;
+            }
+            else if (op->mode == SCENARIO_REPLAY) {
+                tdata->op_cred[i] = cred;
+                cred = NULL;
+            }
         }
-        conf->shared.num_encode_errs += got_encode_err;
-        conf->shared.num_decode_errs += got_decode_err;
+        free (cred);
     }
-    pthread_cleanup_pop (1);
-    return (NULL);
+    tdata->op_done[i]++;
+    tdata->op_errs[i] += *got_encode_err + *got_decode_err;
+    return;
+}
+
+
+munge_err_t
+remunge_encode (tdata_t tdata, munge_ctx_t ctx, unsigned long n,
+                char **cred, const void *buf, int len)
+{
+/*  Encodes the [n]th credential into [cred] using the munge context [ctx].
+ *  Returns the munge error number.
+ */
+    struct timeval t_start;
+    struct timeval t_stop;
+    double         delta;
+    munge_err_t    e;
+
+    GET_TIMEVAL (t_start);
+    e = munge_encode (cred, ctx, buf, len);
+    GET_TIMEVAL (t_stop);
+
+    delta = DIFF_TIMEVAL (t_stop, t_start);
+    if (delta > tdata->conf->warn_time) {
+        output_msg ("Credential #%lu encoding took %0.3f seconds",
+            n, delta);
+    }
+    if (e != EMUNGE_SUCCESS) {
+        output_msg ("Credential #%lu encoding failed: %s (err=%d)",
+            n, munge_ctx_strerror (ctx), e);
+    }
+    return (e);
+}
+
+
+munge_err_t
+remunge_decode (tdata_t tdata, munge_ctx_t ctx, unsigned long n,
+                const char *cred)
+{
+/*  Decodes the [n]th credential [cred] using the munge context [ctx].
+ *    Replayed and expired credentials are not reported as errors since
+ *    the caller may be expecting them.
+ *  Returns the munge error number.
+ */
+    struct timeval t_start;
+    struct timeval t_stop;
+    double         delta;
+    munge_err_t    e;
+    void          *data = NULL;
+
+    GET_TIMEVAL (t_start);
+    e = munge_decode (cred, ctx, &data, NULL, NULL, NULL);
+    GET_TIMEVAL (t_stop);
+
+    delta = DIFF_TIMEVAL (t_stop, t_start);
+    if (delta > tdata->conf->warn_time) {
+        output_msg ("Credential #%lu decoding took %0.3f seconds",
+            n, delta);
+    }
+    if ((e != EMUNGE_SUCCESS) && (e != EMUNGE_CRED_REPLAYED)
+            && (e != EMUNGE_CRED_EXPIRED)) {
+        output_msg ("Credential #%lu decoding failed: %s (err=%d)",
+            n, munge_ctx_strerror (ctx), e);
+    }
+    /*  The 'data' parm can still be set on certain munge errors.
+     */
+    if (data != NULL) {
+        free (data);
+    }
+    return (e);
 }
 
 
@@ -1207,8 +2040,16 @@ void
 remunge_cleanup (tdata_t tdata)
 {
 /*  Signal the main thread when the last worker thread is exiting.
+ *  Accumulate the thread's scenario results while the mutex is held.
  *  Clean up resources held by the thread.
  */
+    scenario_t s = tdata->conf->scenario;
+    int        i;
+
+    for (i = 0; (s != NULL) && (i < s->num_ops); i++) {
+        s->ops[i].num_creds_done += tdata->op_done[i];
+        s->ops[i].num_errs += tdata->op_errs[i];
+    }
     if (--tdata->conf->num_running == 0) {
         if ((errno = pthread_cond_signal (&tdata->conf->cond_done)) != 0) {
             log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to signal condition");
@@ -0,0 +1,466 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <munge.h>
+#include "log.h"
+#include "query.h"
+#include "scenario.h"
+
+
+/*****************************************************************************
+ *  Constants
+ *****************************************************************************/
+
+#define SCENARIO_LINE_MAX       1024
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static void _scenario_parse_line (scenario_t s, char *buf, int line,
+        munge_ctx_t ctx, int do_decode, int len);
+
+static void _scenario_parse_field (scenario_t s, scenario_op_t op,
+        const char *key, const char *val);
+
+static int _scenario_parse_int (const char *val, int *dst);
+
+static void _scenario_set_ctx (scenario_t s, scenario_op_t op,
+        munge_opt_t opt, int i, const char *desc);
+
+
+/*****************************************************************************
+ *  Public Functions
+ *****************************************************************************/
+
+/*****************************************************************************
+ *  Create a scenario from the file at [path].
+ *
+ *  Each non-blank line of the file (after stripping '#' comments) describes
+ *  one operation as a whitespace-separated list of key=value fields:
+ *
+ *    name=STR      label used when reporting results
+ *    weight=INT    relative frequency of the operation (default 1)
+ *    mode=STR      encode, decode, or replay (default from -e/-d)
+ *    cipher=STR    cipher type
+ *    mac=STR       MAC type
+ *    zip=STR       compression type
+ *    ttl=INT       time-to-live (in seconds; 0=dfl -1=max)
+ *    uid=STR       user name or UID allowed to decode
+ *    gid=STR       group name or GID allowed to decode
+ *    length=N[-M]  payload length, or uniform range of lengths (in bytes)
+ *
+ *  Each operation's munge context is copied from [ctx] so settings given on
+ *  the command-line (such as the socket) serve as defaults.  [do_decode]
+ *  specifies the default mode, and [len] the default payload length.
+ *
+ *  Returns a new scenario; the program terminates on error.
+ *****************************************************************************/
+scenario_t
+scenario_create (const char *path, munge_ctx_t ctx, int do_decode, int len)
+{
+    scenario_t  s;
+    FILE       *fp;
+    char        buf[SCENARIO_LINE_MAX];
+    int         line;
+    size_t      n;
+    int         i;
+
+    assert (path != NULL);
+    assert (ctx != NULL);
+
+    if (!(s = calloc (1, sizeof (*s)))) {
+        log_errno (EMUNGE_NO_MEMORY, LOG_ERR, "Failed to allocate scenario");
+    }
+    if (!(s->path = strdup (path))) {
+        log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+            "Failed to copy scenario pathname");
+    }
+    if (!(fp = fopen (path, "r"))) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to open scenario \"%s\"", path);
+    }
+    for (line = 1; fgets (buf, sizeof (buf), fp) != NULL; line++) {
+        n = strlen (buf);
+        if ((n == sizeof (buf) - 1) && (buf[n - 1] != '\n') && !feof (fp)) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Exceeded maximum line length of %d bytes",
+                path, line, SCENARIO_LINE_MAX - 2);
+        }
+        _scenario_parse_line (s, buf, line, ctx, do_decode, len);
+    }
+    if (ferror (fp)) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to read scenario \"%s\"", path);
+    }
+    if (fclose (fp) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to close scenario \"%s\"", path);
+    }
+    if (s->num_ops == 0) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "Scenario \"%s\" does not contain any operations", path);
+    }
+    for (i = 0; i < s->num_ops; i++) {
+        if (s->ops[i].len_max > s->max_len) {
+            s->max_len = s->ops[i].len_max;
+        }
+    }
+    return (s);
+}
+
+
+/*****************************************************************************
+ *  Destroy the scenario [s].
+ *****************************************************************************/
+void
+scenario_destroy (scenario_t s)
+{
+    int i;
+
+    if (!s) {
+        return;
+    }
+    for (i = 0; i < s->num_ops; i++) {
+        munge_ctx_destroy (s->ops[i].ctx);
+        free (s->ops[i].name);
+    }
+    free (s->ops);
+    free (s->path);
+    free (s);
+}
+
+
+/*****************************************************************************
+ *  Select an operation from the scenario [s] according to its weight.
+ *
+ *  [seed] is the thread-specific state for rand_r().
+ *
+ *  Returns the index of the selected operation.
+ *****************************************************************************/
+int
+scenario_select (scenario_t s, unsigned int *seed)
+{
+    long r;
+    int  i;
+
+    assert (s != NULL);
+    assert (s->num_ops > 0);
+    assert (seed != NULL);
+
+    if (s->num_ops == 1) {
+        return (0);
+    }
+    r = (long) ((double) rand_r (seed) / ((double) RAND_MAX + 1)
+            * s->total_weight);
+
+    for (i = 0; i < s->num_ops - 1; i++) {
+        r -= s->ops[i].weight;
+        if (r < 0) {
+            break;
+        }
+    }
+    return (i);
+}
+
+
+/*****************************************************************************
+ *  Select a payload length for the operation [op].
+ *
+ *  The length is drawn uniformly from the operation's range of lengths.
+ *  [seed] is the thread-specific state for rand_r().
+ *
+ *  Returns the payload length (in bytes).
+ *****************************************************************************/
+int
+scenario_length (scenario_op_t op, unsigned int *seed)
+{
+    double range;
+
+    assert (op != NULL);
+    assert (seed != NULL);
+
+    if (op->len_min == op->len_max) {
+        return (op->len_min);
+    }
+    range = (double) op->len_max - op->len_min + 1;
+    return (op->len_min
+            + (int) ((double) rand_r (seed) / ((double) RAND_MAX + 1) * range));
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+/*  Parse the scenario line in [buf] at line number [line], appending the
+ *    resulting operation (if any) to the scenario [s].
+ */
+static void
+_scenario_parse_line (scenario_t s, char *buf, int line,
+                      munge_ctx_t ctx, int do_decode, int len)
+{
+    const char    *separators = " \t\r\n";
+    char          *p;
+    char          *tok;
+    char          *val;
+    char          *saveptr;
+    scenario_op_t  ops;
+    scenario_op_t  op;
+
+    if ((p = strchr (buf, '#'))) {
+        *p = '\0';
+    }
+    if (!(tok = strtok_r (buf, separators, &saveptr))) {
+        return;
+    }
+    ops = realloc (s->ops, (s->num_ops + 1) * sizeof (*s->ops));
+    if (!ops) {
+        log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+            "Failed to allocate scenario operation");
+    }
+    s->ops = ops;
+    op = &s->ops[s->num_ops++];
+    memset (op, 0, sizeof (*op));
+    op->line = line;
+    op->weight = 1;
+    op->mode = do_decode ? SCENARIO_DECODE : SCENARIO_ENCODE;
+    op->len_min = len;
+    op->len_max = len;
+
+    if (!(op->ctx = munge_ctx_copy (ctx))) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "%s:%d: Failed to copy munge context", s->path, line);
+    }
+    for (; tok != NULL; tok = strtok_r (NULL, separators, &saveptr)) {
+        if (!(val = strchr (tok, '=')) || (val == tok) || (val[1] == '\0')) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Invalid field \"%s\"", s->path, line, tok);
+        }
+        *val++ = '\0';
+        _scenario_parse_field (s, op, tok, val);
+    }
+    if (!op->name) {
+        char name[32];
+
+        (void) snprintf (name, sizeof (name), "line%d", line);
+        if (!(op->name = strdup (name))) {
+            log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+                "Failed to copy scenario operation name");
+        }
+    }
+    if (s->total_weight > INT_MAX - op->weight) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "%s:%d: Exceeded maximum total weight of %d",
+            s->path, line, INT_MAX);
+    }
+    s->total_weight += op->weight;
+}
+
+
+/*  Parse the [key] field with value [val] into the operation [op] of the
+ *    scenario [s].
+ */
+static void
+_scenario_parse_field (scenario_t s, scenario_op_t op,
+                       const char *key, const char *val)
+{
+    char *p;
+    int   i;
+
+    if (!strcmp (key, "name")) {
+        free (op->name);
+        if (!(op->name = strdup (val))) {
+            log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+                "Failed to copy scenario operation name");
+        }
+    }
+    else if (!strcmp (key, "weight")) {
+        if ((_scenario_parse_int (val, &i) < 0) || (i <= 0)) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Invalid weight \"%s\"", s->path, op->line, val);
+        }
+        op->weight = i;
+    }
+    else if (!strcmp (key, "mode")) {
+        if (!strcmp (val, "encode")) {
+            op->mode = SCENARIO_ENCODE;
+        }
+        else if (!strcmp (val, "decode")) {
+            op->mode = SCENARIO_DECODE;
+        }
+        else if (!strcmp (val, "replay")) {
+            op->mode = SCENARIO_REPLAY;
+        }
+        else {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Invalid mode \"%s\"", s->path, op->line, val);
+        }
+    }
+    else if (!strcmp (key, "cipher")) {
+        i = munge_enum_str_to_int (MUNGE_ENUM_CIPHER, val);
+        if ((i < 0) || !munge_enum_is_valid (MUNGE_ENUM_CIPHER, i)) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Invalid cipher type \"%s\"", s->path, op->line, val);
+        }
+        _scenario_set_ctx (s, op, MUNGE_OPT_CIPHER_TYPE, i, "cipher type");
+    }
+    else if (!strcmp (key, "mac")) {
+        i = munge_enum_str_to_int (MUNGE_ENUM_MAC, val);
+        if ((i < 0) || !munge_enum_is_valid (MUNGE_ENUM_MAC, i)) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Invalid MAC type \"%s\"", s->path, op->line, val);
+        }
+        _scenario_set_ctx (s, op, MUNGE_OPT_MAC_TYPE, i, "MAC type");
+    }
+    else if (!strcmp (key, "zip")) {
+        i = munge_enum_str_to_int (MUNGE_ENUM_ZIP, val);
+        if ((i < 0) || !munge_enum_is_valid (MUNGE_ENUM_ZIP, i)) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Invalid compression type \"%s\"",
+                s->path, op->line, val);
+        }
+        _scenario_set_ctx (s, op, MUNGE_OPT_ZIP_TYPE, i, "compression type");
+    }
+    else if (!strcmp (key, "ttl")) {
+        if ((_scenario_parse_int (val, &i) < 0) || (i < -1)) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Invalid time-to-live \"%s\"", s->path, op->line, val);
+        }
+        if (i == -1) {
+            i = MUNGE_TTL_MAXIMUM;
+        }
+        _scenario_set_ctx (s, op, MUNGE_OPT_TTL, i, "time-to-live");
+    }
+    else if (!strcmp (key, "uid")) {
+        if (query_uid (val, (uid_t *) &i) < 0) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Unrecognized user \"%s\"", s->path, op->line, val);
+        }
+        _scenario_set_ctx (s, op, MUNGE_OPT_UID_RESTRICTION, i,
+            "UID restriction");
+    }
+    else if (!strcmp (key, "gid")) {
+        if (query_gid (val, (gid_t *) &i) < 0) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Unrecognized group \"%s\"", s->path, op->line, val);
+        }
+        _scenario_set_ctx (s, op, MUNGE_OPT_GID_RESTRICTION, i,
+            "GID restriction");
+    }
+    else if (!strcmp (key, "length")) {
+        char buf[SCENARIO_LINE_MAX];
+
+        strncpy (buf, val, sizeof (buf) - 1);
+        buf[sizeof (buf) - 1] = '\0';
+        if ((p = strchr (buf, '-'))) {
+            *p++ = '\0';
+        }
+        if ((_scenario_parse_int (buf, &op->len_min) < 0)
+                || (op->len_min < 0)) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Invalid length \"%s\"", s->path, op->line, val);
+        }
+        op->len_max = op->len_min;
+        if (p && ((_scenario_parse_int (p, &op->len_max) < 0)
+                    || (op->len_max < op->len_min))) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                "%s:%d: Invalid length range \"%s\"", s->path, op->line, val);
+        }
+    }
+    else {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "%s:%d: Unrecognized field \"%s\"", s->path, op->line, key);
+    }
+}
+
+
+/*  Parse the integer string [val] into [dst].  The integer may be followed
+ *    by a single-character SI-suffix (k, K, m, M, g, G).
+ *  Returns 0 on success, or -1 on error.
+ */
+static int
+_scenario_parse_int (const char *val, int *dst)
+{
+    char     *p;
+    long int  l;
+    long int  multiplier;
+
+    errno = 0;
+    l = strtol (val, &p, 10);
+    if ((val == p) || ((*p != '\0') && (*(p+1) != '\0'))) {
+        return (-1);
+    }
+    if ((errno == ERANGE) || (l > INT_MAX) || (l < INT_MIN)) {
+        return (-1);
+    }
+    switch (*p) {
+        case '\0': multiplier = 1;          break;
+        case 'k':  multiplier = 1000;       break;
+        case 'K':  multiplier = 1 << 10;    break;
+        case 'm':  multiplier = 1000000;    break;
+        case 'M':  multiplier = 1 << 20;    break;
+        case 'g':  multiplier = 1000000000; break;
+        case 'G':  multiplier = 1 << 30;    break;
+        default:   return (-1);
+    }
+    if ((l > INT_MAX / multiplier) || (l < INT_MIN / multiplier)) {
+        return (-1);
+    }
+    *dst = (int) (l * multiplier);
+    return (0);
+}
+
+
+/*  Set the munge context option [opt] to [i] for the operation [op] of the
+ *    scenario [s].  [desc] describes the option for error messages.
+ */
+static void
+_scenario_set_ctx (scenario_t s, scenario_op_t op,
+                   munge_opt_t opt, int i, const char *desc)
+{
+    munge_err_t e;
+
+    e = munge_ctx_set (op->ctx, opt, i);
+    if (e != EMUNGE_SUCCESS) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "%s:%d: Failed to set %s: %s",
+            s->path, op->line, desc, munge_ctx_strerror (op->ctx));
+    }
+}
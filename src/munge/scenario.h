@@ -0,0 +1,81 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#ifndef MUNGE_SCENARIO_H
+#define MUNGE_SCENARIO_H
+
+#include <munge.h>
+
+
+/*****************************************************************************
+ *  Data Types
+ *****************************************************************************/
+
+typedef enum {
+    SCENARIO_ENCODE,                    /* encode only                       */
+    SCENARIO_DECODE,                    /* encode and decode                 */
+    SCENARIO_REPLAY                     /* decode a previously decoded cred  */
+} scenario_mode_t;
+
+struct scenario_op {
+    char           *name;               /* label for reporting results       */
+    int             line;               /* line number within scenario file  */
+    int             weight;             /* relative frequency of operation   */
+    scenario_mode_t mode;               /* type of operation                 */
+    munge_ctx_t     ctx;                /* munge context for this operation  */
+    int             len_min;            /* minimum payload length (bytes)    */
+    int             len_max;            /* maximum payload length (bytes)    */
+    unsigned long   num_creds_done;     /* number of creds processed         */
+    unsigned long   num_errs;           /* number of errors processing creds */
+};
+typedef struct scenario_op * scenario_op_t;
+
+struct scenario {
+    char           *path;               /* pathname of scenario file         */
+    scenario_op_t   ops;                /* ptr to array of operations        */
+    int             num_ops;            /* number of operations in array     */
+    int             total_weight;       /* sum of all operation weights      */
+    int             max_len;            /* maximum payload length (bytes)    */
+};
+typedef struct scenario * scenario_t;
+
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+scenario_t scenario_create (const char *path, munge_ctx_t ctx, int do_decode,
+        int len);
+
+void scenario_destroy (scenario_t s);
+
+int scenario_select (scenario_t s, unsigned int *seed);
+
+int scenario_length (scenario_op_t op, unsigned int *seed);
+
+
+#endif /* !MUNGE_SCENARIO_H */
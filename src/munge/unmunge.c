@@ -157,6 +157,8 @@ display_key_t munge_keys[] = {
  */
 #define OPT_IGNORE_TTL          256
 #define OPT_IGNORE_REPLAY       257
+#define OPT_BINARY              258
+#define OPT_VALIDATE_ONLY       259
 
 const char * const short_opts = ":hLVi:nm:o:k:KNS:";
 
@@ -175,6 +177,8 @@ struct option long_opts[] = {
     { "socket", required_argument, NULL, 'S' },
     { "ignore-ttl", no_argument, NULL, OPT_IGNORE_TTL },
     { "ignore-replay", no_argument, NULL, OPT_IGNORE_REPLAY },
+    { "binary", no_argument, NULL, OPT_BINARY },
+    { "validate-only", no_argument, NULL, OPT_VALIDATE_ONLY },
     { NULL, 0, NULL, 0 }
 };
 
@@ -203,6 +207,8 @@ struct conf {
     unsigned     got_numeric:1;         /* flag for NUMERIC option           */
     unsigned     is_ttl_ignored:1;
     unsigned     is_replay_ignored:1;
+    unsigned     is_binary:1;           /* flag for binary (unarmored) cred  */
+    unsigned     is_validate_only:1;    /* flag for not returning payload    */
 };
 
 
@@ -230,6 +236,15 @@ main (int argc, char *argv[])
     read_data_from_file (conf->fp_in, (void **) &conf->cred, &conf->clen,
         MUNGE_MAXIMUM_REQ_LEN);
 
+    /*  A binary credential may contain null bytes, so pass its exact length.
+     */
+    if (conf->is_binary
+            && (munge_ctx_set (conf->ctx, MUNGE_OPT_CRED_LENGTH, conf->clen)
+                != EMUNGE_SUCCESS)) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to set binary credential length");
+    }
+
     conf->status = munge_decode (conf->cred, conf->ctx,
             &conf->data, &conf->dlen, &conf->uid, &conf->gid);
 
@@ -295,6 +310,8 @@ create_conf (void)
     conf->got_numeric = 0;
     conf->is_ttl_ignored = 0;
     conf->is_replay_ignored = 0;
+    conf->is_binary = 0;
+    conf->is_validate_only = 0;
 
     return (conf);
 }
@@ -422,6 +439,12 @@ parse_cmdline (conf_t conf, int argc, char **argv)
             case OPT_IGNORE_REPLAY:
                 conf->is_replay_ignored = 1;
                 break;
+            case OPT_BINARY:
+                conf->is_binary = 1;
+                break;
+            case OPT_VALIDATE_ONLY:
+                conf->is_validate_only = 1;
+                break;
             case '?':
                 if (optopt > 0) {
                     log_err (EMUNGE_SNAFU, LOG_ERR,
@@ -489,6 +512,25 @@ parse_cmdline (conf_t conf, int argc, char **argv)
                     "Failed to ignore replay errors");
         }
     }
+    if (conf->is_binary) {
+        munge_err_t e;
+        e = munge_ctx_set (conf->ctx, MUNGE_OPT_BINARY, 1);
+        if (e != EMUNGE_SUCCESS) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to set binary credential");
+        }
+    }
+    /*  The payload length is unknown since the payload is not returned.
+     */
+    if (conf->is_validate_only) {
+        munge_err_t e;
+        e = munge_ctx_set (conf->ctx, MUNGE_OPT_VALIDATE_ONLY, 1);
+        if (e != EMUNGE_SUCCESS) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to set validate-only decode");
+        }
+        conf->key[MUNGE_KEY_LENGTH] = 0;
+    }
     return;
 }
 
@@ -547,6 +589,12 @@ display_help (char *prog)
 
     printf ("  %*s %s\n", w, "--ignore-replay", "Ignore replayed errors");
 
+    printf ("  %*s %s\n", w, "--binary",
+            "Read credential in binary without armor");
+
+    printf ("  %*s %s\n", w, "--validate-only",
+            "Validate credential without returning payload");
+
     printf ("\n");
     printf ("By default, credential read from stdin, "
             "metadata & payload written to stdout.\n\n");
@@ -0,0 +1,165 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <pthread.h>
+#include "atom.h"
+
+
+/*****************************************************************************
+ *  Notes
+ *****************************************************************************/
+/*
+ *  Atomic operations on counters shared between threads (eg, by the work
+ *    crew and the log queue, and by the ring positions and sequence numbers
+ *    underlying both).
+ *  These are sequentially-consistent so "increment my counter, then test the
+ *    other side's" handshakes (eg, between a producer and a parked consumer)
+ *    cannot both miss each other.
+ *  Compilers lacking the __atomic builtins fall back to serializing every
+ *    operation with a mutex.  Its errors are ignored since logging them could
+ *    recurse into the log queue, which itself relies on these operations.
+ */
+
+
+#ifdef __ATOMIC_SEQ_CST
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+/*  Returns the value at [p].
+ */
+unsigned long
+atom_load (unsigned long *p)
+{
+    return (__atomic_load_n (p, __ATOMIC_SEQ_CST));
+}
+
+
+/*  Stores the value [v] at [p].
+ */
+void
+atom_store (unsigned long *p, unsigned long v)
+{
+    __atomic_store_n (p, v, __ATOMIC_SEQ_CST);
+    return;
+}
+
+
+/*  Adds [v] (which may be negative) to the value at [p].
+ *  Returns the resulting value.
+ */
+unsigned long
+atom_add (unsigned long *p, long v)
+{
+    return (__atomic_add_fetch (p, (unsigned long) v, __ATOMIC_SEQ_CST));
+}
+
+
+/*  Stores [desired] at [p] if the value there equals [expected].
+ *  Returns 1 on success; o/w, returns 0 and stores the current value in
+ *    [expected].  This can fail spuriously, so it must be retried in a loop.
+ */
+int
+atom_cas (unsigned long *p, unsigned long *expected, unsigned long desired)
+{
+    return (__atomic_compare_exchange_n (p, expected, desired, 1,
+            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+}
+
+
+#else  /* !__ATOMIC_SEQ_CST */
+
+/*****************************************************************************
+ *  Private Variables
+ *****************************************************************************/
+
+static pthread_mutex_t _atom_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+unsigned long
+atom_load (unsigned long *p)
+{
+    unsigned long v;
+
+    (void) pthread_mutex_lock (&_atom_lock);
+    v = *p;
+    (void) pthread_mutex_unlock (&_atom_lock);
+    return (v);
+}
+
+
+void
+atom_store (unsigned long *p, unsigned long v)
+{
+    (void) pthread_mutex_lock (&_atom_lock);
+    *p = v;
+    (void) pthread_mutex_unlock (&_atom_lock);
+    return;
+}
+
+
+unsigned long
+atom_add (unsigned long *p, long v)
+{
+    unsigned long n;
+
+    (void) pthread_mutex_lock (&_atom_lock);
+    *p += (unsigned long) v;
+    n = *p;
+    (void) pthread_mutex_unlock (&_atom_lock);
+    return (n);
+}
+
+
+int
+atom_cas (unsigned long *p, unsigned long *expected, unsigned long desired)
+{
+    int rc;
+
+    (void) pthread_mutex_lock (&_atom_lock);
+    if (*p == *expected) {
+        *p = desired;
+        rc = 1;
+    }
+    else {
+        *expected = *p;
+        rc = 0;
+    }
+    (void) pthread_mutex_unlock (&_atom_lock);
+    return (rc);
+}
+
+#endif /* !__ATOMIC_SEQ_CST */
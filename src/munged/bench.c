@@ -0,0 +1,768 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+/*****************************************************************************
+ *  In-process benchmark of the munged credential pipeline.
+ *
+ *  Each thread drives enc_process_msg() and dec_process_msg() directly with
+ *    in-memory request messages, bypassing the listening socket, accept(),
+ *    the work crew, and the libmunge client.  A socketpair connects each
+ *    thread to itself so the daemon can authenticate the "client" and send
+ *    its response as usual; the response is read back to obtain the
+ *    credential for the subsequent decode.
+ *
+ *  The daemon objects are compiled with WITH_STAGE_TIMING so the time spent
+ *    in each stage of the encode and decode pipelines can be reported.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <munge.h>
+#include "auth_recv.h"
+#include "cipher.h"
+#include "conf.h"
+#include "cred.h"
+#include "crypto.h"
+#include "dec.h"
+#include "enc.h"
+#include "gids.h"
+#include "hash.h"
+#include "keyctx.h"
+#include "log.h"
+#include "m_msg.h"
+#include "md.h"
+#include "munge_defs.h"
+#include "random.h"
+#include "replay.h"
+#include "stage.h"
+#include "timer.h"
+#include "version.h"
+#include "zip.h"
+
+
+/*****************************************************************************
+ *  Constants
+ *****************************************************************************/
+
+#define BENCH_DEF_SECONDS       1
+#define BENCH_DEF_THREADS       1
+
+
+/*****************************************************************************
+ *  Command-Line Options
+ *****************************************************************************/
+
+static const char * const short_opts = ":hVc:m:z:l:bek:D:N:T:";
+
+#include <getopt.h>
+static struct option long_opts[] = {
+    { "help",        no_argument,       NULL, 'h' },
+    { "version",     no_argument,       NULL, 'V' },
+    { "cipher",      required_argument, NULL, 'c' },
+    { "mac",         required_argument, NULL, 'm' },
+    { "zip",         required_argument, NULL, 'z' },
+    { "length",      required_argument, NULL, 'l' },
+    { "binary",      no_argument,       NULL, 'b' },
+    { "encode",      no_argument,       NULL, 'e' },
+    { "key-file",    required_argument, NULL, 'k' },
+    { "duration",    required_argument, NULL, 'D' },
+    { "num-creds",   required_argument, NULL, 'N' },
+    { "num-threads", required_argument, NULL, 'T' },
+    { "no-replay",   no_argument,       NULL, 'R' },
+    {  NULL,         0,                 NULL,  0  }
+};
+
+
+/*****************************************************************************
+ *  Data Types
+ *****************************************************************************/
+
+/*  LOCKING PROTOCOL:
+ *    The mutex must be locked when accessing num_creds_done and num_errs.
+ *    The remaining fields are constant while processing credentials
+ *      (except got_stop which is only set by the main thread).
+ */
+struct bench {
+    munge_cipher_t  cipher;             /* cipher type                       */
+    munge_mac_t     mac;                /* message auth code type            */
+    munge_zip_t     zip;                /* compression type                  */
+    int             do_binary;          /* true for binary (unarmored) creds */
+    int             do_decode;          /* true to decode each cred          */
+    char           *payload;            /* payload to be encoded into cred   */
+    int             num_payload;        /* number of bytes for cred payload  */
+    int             num_seconds;        /* number of seconds to run          */
+    unsigned long   num_creds;          /* number of credentials to process  */
+    int             num_threads;        /* number of threads to spawn        */
+    volatile int    got_stop;           /* true when duration has elapsed    */
+    pthread_mutex_t mutex;              /* mutex for accessing shared data   */
+    unsigned long   num_creds_done;     /* number of credentials processed   */
+    unsigned long   num_errs;           /* number of errors processing creds */
+};
+
+typedef struct bench * bench_t;
+
+
+/*****************************************************************************
+ *  Prototypes
+ *****************************************************************************/
+
+static void bench_parse_cmdline (bench_t b, int argc, char **argv);
+static void bench_display_help (char *prog);
+static void create_keys (void);
+static void * bench_thread (bench_t b);
+static int bench_encode (bench_t b, int sd_srv, int sd_cli,
+    char **cred, int *cred_len);
+static int bench_decode (bench_t b, int sd_srv, int sd_cli,
+    char *cred, int cred_len);
+static int bench_recv_rsp (int sd, m_msg_type_t type,
+    char **cred, int *cred_len);
+static void output_stages (double delta, unsigned long n);
+
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+int
+main (int argc, char *argv[])
+{
+    struct bench    bench;
+    bench_t         b = &bench;
+    pthread_t      *tids;
+    struct timeval  t_start;
+    struct timeval  t_stop;
+    double          delta;
+    int             i;
+
+    log_open_file (stderr, argv[0], LOG_WARNING, LOG_OPT_PRIORITY);
+
+    memset (b, 0, sizeof (*b));
+    b->cipher = MUNGE_CIPHER_DEFAULT;
+    b->mac = MUNGE_MAC_DEFAULT;
+    b->zip = MUNGE_ZIP_DEFAULT;
+    b->do_decode = 1;
+    b->num_threads = BENCH_DEF_THREADS;
+
+    conf = create_conf ();
+    if (conf->key_name) {
+        free (conf->key_name);
+        conf->key_name = NULL;
+    }
+    conf->got_force = 1;
+    bench_parse_cmdline (b, argc, argv);
+
+    if (!b->num_creds && !b->num_seconds) {
+        b->num_seconds = BENCH_DEF_SECONDS;
+    }
+    if (!b->num_creds) {
+        b->num_creds = ULONG_MAX;
+    }
+    if ((errno = pthread_mutex_init (&b->mutex, NULL)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to init mutex");
+    }
+    auth_recv_init (conf->auth_server_dir, conf->auth_client_dir,
+        conf->got_force);
+    crypto_init ();
+    cipher_init_subsystem ();
+    md_init_subsystem ();
+    cred_params_init ();
+    (void) random_init (NULL);
+    create_keys ();
+    zip_init ();
+    keyctx_init ();
+    conf->gids = gids_create (0, conf->got_group_stat);
+    timer_init ();
+    replay_init ();
+    stage_init ();
+    stage_set_enabled (1);
+
+    if (!(tids = malloc (sizeof (*tids) * b->num_threads))) {
+        log_err (EMUNGE_NO_MEMORY, LOG_ERR, "Failed to allocate tid array");
+    }
+    printf ("Processing credentials with %d thread%s for %s\n",
+        b->num_threads, ((b->num_threads == 1) ? "" : "s"),
+        (b->do_decode ? "encoding/decoding" : "encoding"));
+
+    if (gettimeofday (&t_start, NULL) < 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to query current time");
+    }
+    for (i = 0; i < b->num_threads; i++) {
+        if ((errno = pthread_create (&tids[i], NULL,
+                        (void * (*) (void *)) bench_thread, b)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to create thread #%d", i+1);
+        }
+    }
+    if (b->num_seconds) {
+        struct timeval tv;
+
+        for (;;) {
+            if (gettimeofday (&tv, NULL) < 0) {
+                log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to query current time");
+            }
+            if ((tv.tv_sec - t_start.tv_sec)
+                    + ((tv.tv_usec - t_start.tv_usec) / 1e6)
+                    >= b->num_seconds) {
+                break;
+            }
+            if ((errno = pthread_mutex_lock (&b->mutex)) != 0) {
+                log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock mutex");
+            }
+            i = (b->num_creds_done >= b->num_creds);
+            if ((errno = pthread_mutex_unlock (&b->mutex)) != 0) {
+                log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock mutex");
+            }
+            if (i) {
+                break;
+            }
+            (void) usleep (10000);
+        }
+        b->got_stop = 1;
+    }
+    for (i = 0; i < b->num_threads; i++) {
+        if ((errno = pthread_join (tids[i], NULL)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to join thread #%d", i+1);
+        }
+    }
+    if (gettimeofday (&t_stop, NULL) < 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to query current time");
+    }
+    delta = (t_stop.tv_sec - t_start.tv_sec)
+        + ((t_stop.tv_usec - t_start.tv_usec) / 1e6);
+
+    if (b->num_errs) {
+        printf ("Generated %lu error%s\n",
+            b->num_errs, ((b->num_errs == 1) ? "" : "s"));
+    }
+    printf ("Processed %lu credential%s in %0.3fs (%0.0f creds/sec)\n",
+        b->num_creds_done, ((b->num_creds_done == 1) ? "" : "s"), delta,
+        (b->num_creds_done - b->num_errs) / delta);
+
+    output_stages (delta, b->num_creds_done);
+
+    free (tids);
+    stage_fini ();
+    replay_fini ();
+    timer_fini ();
+    gids_destroy (conf->gids);
+    hash_drop_memory ();
+    keyctx_fini ();
+    zip_fini ();
+    random_fini (NULL);
+    crypto_fini ();
+    destroy_conf (conf, 0);
+    free (b->payload);
+    if ((errno = pthread_mutex_destroy (&b->mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to destroy mutex");
+    }
+    log_close_file ();
+    exit (EMUNGE_SUCCESS);
+}
+
+
+static void
+bench_parse_cmdline (bench_t b, int argc, char **argv)
+{
+/*  Parses the command-line, altering the benchmark [b] as specified.
+ */
+    char     *prog;
+    int       c;
+    char     *p;
+    long int  l;
+    int       i;
+
+    opterr = 0;                         /* suppress default getopt err msgs */
+
+    prog = (prog = strrchr (argv[0], '/')) ? prog + 1 : argv[0];
+
+    for (;;) {
+
+        c = getopt_long (argc, argv, short_opts, long_opts, NULL);
+
+        if (c == -1) {                  /* reached end of option list */
+            break;
+        }
+        switch (c) {
+            case 'h':
+                bench_display_help (prog);
+                exit (EMUNGE_SUCCESS);
+                break;
+            case 'V':
+                display_version ();
+                exit (EMUNGE_SUCCESS);
+                break;
+            case 'c':
+                i = munge_enum_str_to_int (MUNGE_ENUM_CIPHER, optarg);
+                if ((i < 0) || !munge_enum_is_valid (MUNGE_ENUM_CIPHER, i)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid cipher type \"%s\"", optarg);
+                }
+                b->cipher = i;
+                break;
+            case 'm':
+                i = munge_enum_str_to_int (MUNGE_ENUM_MAC, optarg);
+                if ((i < 0) || !munge_enum_is_valid (MUNGE_ENUM_MAC, i)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid MAC type \"%s\"", optarg);
+                }
+                b->mac = i;
+                break;
+            case 'z':
+                i = munge_enum_str_to_int (MUNGE_ENUM_ZIP, optarg);
+                if ((i < 0) || !munge_enum_is_valid (MUNGE_ENUM_ZIP, i)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid compression type \"%s\"", optarg);
+                }
+                b->zip = i;
+                break;
+            case 'l':
+                errno = 0;
+                l = strtol (optarg, &p, 10);
+                if ((optarg == p) || (*p != '\0') || (l < 0)
+                        || (l > MUNGE_MAXIMUM_PAYLOAD_LEN)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid number of bytes '%s'", optarg);
+                }
+                b->num_payload = (int) l;
+                break;
+            case 'b':
+                b->do_binary = 1;
+                break;
+            case 'e':
+                b->do_decode = 0;
+                break;
+            case 'k':
+                free (conf->key_name);
+                if (!(conf->key_name = strdup (optarg))) {
+                    log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+                        "Failed to copy key-file name");
+                }
+                break;
+            case 'D':
+                errno = 0;
+                l = strtol (optarg, &p, 10);
+                if ((optarg == p) || (*p != '\0') || (l <= 0)
+                        || (l > INT_MAX)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid duration '%s'", optarg);
+                }
+                b->num_seconds = (int) l;
+                break;
+            case 'N':
+                errno = 0;
+                l = strtol (optarg, &p, 10);
+                if ((optarg == p) || (*p != '\0') || (l <= 0)
+                        || ((errno == ERANGE) && (l == LONG_MAX))) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid number of credentials '%s'", optarg);
+                }
+                b->num_creds = (unsigned long) l;
+                break;
+            case 'T':
+                errno = 0;
+                l = strtol (optarg, &p, 10);
+                if ((optarg == p) || (*p != '\0') || (l <= 0)
+                        || (l > INT_MAX)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid number of threads '%s'", optarg);
+                }
+                b->num_threads = (int) l;
+                break;
+            case 'R':
+                conf->got_benchmark = 1;
+                break;
+            case '?':
+                if (optopt > 0) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid option \"-%c\"", optopt);
+                }
+                else if (optind > 1) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid option \"%s\"", argv[optind - 1]);
+                }
+                else {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Failed to process command-line");
+                }
+                break;
+            case ':':
+                if ((optind > 1)
+                        && (strncmp (argv[optind - 1], "--", 2) == 0)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Missing argument for option \"%s\"",
+                        argv[optind - 1]);
+                }
+                else if (optopt > 0) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Missing argument for option \"-%c\"", optopt);
+                }
+                else {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Failed to process command-line");
+                }
+                break;
+            default:
+                log_err (EMUNGE_SNAFU, LOG_ERR,
+                    "Unimplemented option \"%s\"", argv[optind - 1]);
+                break;
+        }
+    }
+    if (argv[optind]) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "Unrecognized parameter \"%s\"", argv[optind]);
+    }
+    /*  Create arbitrary payload of the specified length.
+     */
+    if (b->num_payload > 0) {
+        if (!(b->payload = malloc (b->num_payload))) {
+            log_err (EMUNGE_NO_MEMORY, LOG_ERR,
+                "Failed to allocate credential payload of %d byte%s",
+                b->num_payload, (b->num_payload == 1 ? "" : "s"));
+        }
+        for (i = 0, c = 'A'; i < b->num_payload; i++) {
+            if ((b->payload[i] = c++) == 'Z') {
+                c = 'A';
+            }
+        }
+    }
+    return;
+}
+
+
+static void
+bench_display_help (char *prog)
+{
+/*  Displays a help message describing the command-line options.
+ */
+    const int w = -25;                  /* pad for width of option string */
+
+    assert (prog != NULL);
+
+    printf ("Usage: %s [OPTIONS]\n", prog);
+    printf ("\n");
+
+    printf ("  %*s %s\n", w, "-h, --help",
+            "Display this help message");
+
+    printf ("  %*s %s\n", w, "-V, --version",
+            "Display version information");
+
+    printf ("\n");
+
+    printf ("  %*s %s\n", w, "-c, --cipher=STR",
+            "Specify cipher type");
+
+    printf ("  %*s %s\n", w, "-m, --mac=STR",
+            "Specify MAC type");
+
+    printf ("  %*s %s\n", w, "-z, --zip=STR",
+            "Specify compression type");
+
+    printf ("  %*s %s\n", w, "-l, --length=BYTES",
+            "Specify payload length (in bytes)");
+
+    printf ("  %*s %s\n", w, "-b, --binary",
+            "Encode binary credentials without armor");
+
+    printf ("  %*s %s\n", w, "-e, --encode",
+            "Encode (but do not decode) each credential");
+
+    printf ("  %*s %s\n", w, "-k, --key-file=PATH",
+            "Specify key file [random key]");
+
+    printf ("  %*s %s\n", w, "--no-replay",
+            "Disable the replay cache");
+
+    printf ("\n");
+
+    printf ("  %*s %s [%d]\n", w, "-D, --duration=SECS",
+            "Specify test duration (in seconds)", BENCH_DEF_SECONDS);
+
+    printf ("  %*s %s\n", w, "-N, --num-creds=INT",
+            "Specify number of credentials to generate");
+
+    printf ("  %*s %s [%d]\n", w, "-T, --num-threads=INT",
+            "Specify number of threads to spawn", BENCH_DEF_THREADS);
+
+    printf ("\n");
+    return;
+}
+
+
+static void
+create_keys (void)
+{
+/*  Creates the cipher and MAC subkeys, either from the specified key file
+ *    or from random data.
+ */
+    if (conf->key_name) {
+        create_subkeys (conf);
+        return;
+    }
+    conf->dek_key_len = md_size (MUNGE_MAC_SHA1);
+    conf->mac_key_len = md_size (MUNGE_MAC_SHA1);
+    if ((conf->dek_key_len <= 0) || (conf->mac_key_len <= 0)) {
+        log_err (EMUNGE_SNAFU, LOG_ERR, "Failed to determine subkey length");
+    }
+    conf->dek_key = malloc (conf->dek_key_len);
+    conf->mac_key = malloc (conf->mac_key_len);
+    if (!conf->dek_key || !conf->mac_key) {
+        log_err (EMUNGE_NO_MEMORY, LOG_ERR, "Failed to allocate subkeys");
+    }
+    random_bytes (conf->dek_key, conf->dek_key_len);
+    random_bytes (conf->mac_key, conf->mac_key_len);
+    return;
+}
+
+
+static void *
+bench_thread (bench_t b)
+{
+/*  Worker thread responsible for encoding/decoding credentials.
+ *  The server end of the socketpair is passed to the daemon's pipeline,
+ *    and the client end is used to read back each response.
+ */
+    int   sd[2];
+    int   n;
+    int   got_err;
+    char *cred;
+    int   cred_len;
+
+    if (socketpair (AF_UNIX, SOCK_STREAM, 0, sd) < 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to create socketpair");
+    }
+    /*  The response is written before it is read back by the same thread,
+     *    so the socket buffer must hold an entire response.
+     */
+    n = MUNGE_MAXIMUM_REQ_LEN;
+    (void) setsockopt (sd[0], SOL_SOCKET, SO_SNDBUF, &n, sizeof (n));
+    (void) setsockopt (sd[1], SOL_SOCKET, SO_RCVBUF, &n, sizeof (n));
+
+    while (!b->got_stop) {
+
+        if ((errno = pthread_mutex_lock (&b->mutex)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock mutex");
+        }
+        n = (b->num_creds_done < b->num_creds);
+        if (n) {
+            b->num_creds_done++;
+        }
+        if ((errno = pthread_mutex_unlock (&b->mutex)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock mutex");
+        }
+        if (!n) {
+            break;
+        }
+        cred = NULL;
+        got_err = (bench_encode (b, sd[0], sd[1], &cred, &cred_len) < 0);
+        if (!got_err && b->do_decode) {
+            got_err = (bench_decode (b, sd[0], sd[1], cred, cred_len) < 0);
+        }
+        else {
+            free (cred);
+        }
+
+        if (got_err) {
+            if ((errno = pthread_mutex_lock (&b->mutex)) != 0) {
+                log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock mutex");
+            }
+            b->num_errs++;
+            if ((errno = pthread_mutex_unlock (&b->mutex)) != 0) {
+                log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock mutex");
+            }
+        }
+    }
+    (void) close (sd[0]);
+    (void) close (sd[1]);
+    return (NULL);
+}
+
+
+static int
+bench_encode (bench_t b, int sd_srv, int sd_cli, char **cred, int *cred_len)
+{
+/*  Encodes a credential via enc_process_msg(), returning it in [cred]
+ *    of length [cred_len].
+ *  Returns 0 on success, or -1 on error.
+ */
+    m_msg_t m;
+
+    if (m_msg_create (&m) != EMUNGE_SUCCESS) {
+        log_err (EMUNGE_NO_MEMORY, LOG_ERR, "Failed to create message");
+    }
+    m->sd = sd_srv;
+    m->type = b->do_binary ? MUNGE_MSG_ENC_BIN_REQ : MUNGE_MSG_ENC_REQ;
+    m->cipher = b->cipher;
+    m->mac = b->mac;
+    m->zip = b->zip;
+    m->ttl = MUNGE_TTL_DEFAULT;
+    m->auth_uid = MUNGE_UID_ANY;
+    m->auth_gid = MUNGE_GID_ANY;
+    /*  The daemon takes ownership of the request data, free()ing it once
+     *    the payload has been packed into the credential.
+     */
+    if (b->num_payload > 0) {
+        if (!(m->data = malloc (b->num_payload))) {
+            log_err (EMUNGE_NO_MEMORY, LOG_ERR,
+                "Failed to allocate credential payload");
+        }
+        memcpy (m->data, b->payload, b->num_payload);
+        m->data_len = b->num_payload;
+    }
+
+    (void) enc_process_msg (m);
+
+    m->sd = -1;                         /* socket is reused by next request */
+    m_msg_destroy (m);
+
+    return (bench_recv_rsp (sd_cli, MUNGE_MSG_ENC_RSP, cred, cred_len));
+}
+
+
+static int
+bench_decode (bench_t b, int sd_srv, int sd_cli, char *cred, int cred_len)
+{
+/*  Decodes the credential [cred] of length [cred_len] via dec_process_msg().
+ *  The credential is consumed.
+ *  Returns 0 on success, or -1 on error.
+ */
+    m_msg_t m;
+
+    assert (cred != NULL);
+
+    if (m_msg_create (&m) != EMUNGE_SUCCESS) {
+        log_err (EMUNGE_NO_MEMORY, LOG_ERR, "Failed to create message");
+    }
+    m->sd = sd_srv;
+    m->type = b->do_binary ? MUNGE_MSG_DEC_BIN_REQ : MUNGE_MSG_DEC_REQ;
+    m->data = cred;                     /* daemon takes ownership of cred */
+    m->data_len = cred_len;
+
+    (void) dec_process_msg (m);
+
+    m->sd = -1;                         /* socket is reused by next request */
+    m_msg_destroy (m);
+
+    return (bench_recv_rsp (sd_cli, MUNGE_MSG_DEC_RSP, NULL, NULL));
+}
+
+
+static int
+bench_recv_rsp (int sd, m_msg_type_t type, char **cred, int *cred_len)
+{
+/*  Receives the response of the given [type] from the socket [sd].
+ *  If [cred] is non-NULL, the credential is returned in a new string
+ *    of length [cred_len].
+ *  Returns 0 on success, or -1 on error.
+ */
+    m_msg_t m;
+    int     rc = 0;
+
+    if (m_msg_create (&m) != EMUNGE_SUCCESS) {
+        log_err (EMUNGE_NO_MEMORY, LOG_ERR, "Failed to create message");
+    }
+    m->sd = sd;
+
+    if (m_msg_recv (m, type, 0) != EMUNGE_SUCCESS) {
+        log_msg (LOG_WARNING, "%s", (m->error_str != NULL)
+            ? m->error_str : "Failed to receive response");
+        rc = -1;
+    }
+    else if (m->error_num != EMUNGE_SUCCESS) {
+        log_msg (LOG_WARNING, "%s", (m->error_str != NULL)
+            ? m->error_str : munge_strerror (m->error_num));
+        rc = -1;
+    }
+    else if (cred != NULL) {
+        if (!m->data || (m->data_len == 0)) {
+            log_msg (LOG_WARNING, "Received empty credential");
+            rc = -1;
+        }
+        else {
+            *cred = m->data;
+            *cred_len = m->data_len;
+            m->data = NULL;
+            m->data_len = 0;
+        }
+    }
+    m->sd = -1;
+    m_msg_destroy (m);
+    return (rc);
+}
+
+
+static void
+output_stages (double delta, unsigned long n)
+{
+/*  Outputs the time spent in each stage of the encode/decode pipelines.
+ *    Percentages are relative to the total time across all stages.
+ */
+    struct stage_stats stats;
+    uint64_t           total = 0;
+    int                i;
+
+    stage_get_stats (&stats);
+
+    for (i = 0; i < STAGE_LAST; i++) {
+        total += stats.nsecs[i];
+    }
+    if ((total == 0) || (n == 0)) {
+        return;
+    }
+    printf ("\n");
+    printf ("%-18s %12s %12s %10s %7s\n",
+        "Stage", "Count", "Total(ms)", "Avg(us)", "Pct");
+
+    for (i = 0; i < STAGE_LAST; i++) {
+        if (stats.count[i] == 0) {
+            continue;
+        }
+        printf ("%-18s %12" PRIu64 " %12.3f %10.3f %6.2f%%\n",
+            stage_name (i), stats.count[i],
+            stats.nsecs[i] / 1e6,
+            stats.nsecs[i] / 1e3 / stats.count[i],
+            100.0 * stats.nsecs[i] / total);
+    }
+    printf ("%-18s %12lu %12.3f %10.3f\n", "total", n,
+        total / 1e6, total / 1e3 / n);
+    return;
+}
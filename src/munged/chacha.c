@@ -0,0 +1,144 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+/*****************************************************************************
+ *  Refer to RFC 8439 (ChaCha20 and Poly1305 for IETF Protocols),
+ *    Section 2.3 (The ChaCha20 Block Function).
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <stdint.h>
+#include "chacha.h"
+
+
+/*****************************************************************************
+ *  Macros
+ *****************************************************************************/
+
+#define CHACHA_ROTL32(v, n)     (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define CHACHA_QUARTER_ROUND(a, b, c, d)                                      \
+    do {                                                                      \
+        a += b; d ^= a; d = CHACHA_ROTL32 (d, 16);                            \
+        c += d; b ^= c; b = CHACHA_ROTL32 (b, 12);                            \
+        a += b; d ^= a; d = CHACHA_ROTL32 (d,  8);                            \
+        c += d; b ^= c; b = CHACHA_ROTL32 (b,  7);                            \
+    } while (0)
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static uint32_t _chacha_load32 (const unsigned char *p);
+
+static void _chacha_store32 (unsigned char *p, uint32_t v);
+
+
+/*****************************************************************************
+ *  Public Functions
+ *****************************************************************************/
+
+/*  Computes the ChaCha20 block for the 256-bit [key], 32-bit block [counter],
+ *    and 96-bit [nonce], placing the 64-byte serialized keystream block
+ *    into [out].
+ */
+void
+chacha20_block (unsigned char *out, const unsigned char *key,
+        uint32_t counter, const unsigned char *nonce)
+{
+    uint32_t s [16];
+    uint32_t x [16];
+    int      i;
+
+    assert (out != NULL);
+    assert (key != NULL);
+    assert (nonce != NULL);
+
+    s[0] = 0x61707865;                  /* "expand 32-byte k"                */
+    s[1] = 0x3320646e;
+    s[2] = 0x79622d32;
+    s[3] = 0x6b206574;
+    for (i = 0; i < 8; i++) {
+        s[4 + i] = _chacha_load32 (key + (4 * i));
+    }
+    s[12] = counter;
+    for (i = 0; i < 3; i++) {
+        s[13 + i] = _chacha_load32 (nonce + (4 * i));
+    }
+    for (i = 0; i < 16; i++) {
+        x[i] = s[i];
+    }
+    /*  20 rounds as 10 iterations of a column round and a diagonal round.
+     */
+    for (i = 0; i < 10; i++) {
+        CHACHA_QUARTER_ROUND (x[0], x[4], x[ 8], x[12]);
+        CHACHA_QUARTER_ROUND (x[1], x[5], x[ 9], x[13]);
+        CHACHA_QUARTER_ROUND (x[2], x[6], x[10], x[14]);
+        CHACHA_QUARTER_ROUND (x[3], x[7], x[11], x[15]);
+        CHACHA_QUARTER_ROUND (x[0], x[5], x[10], x[15]);
+        CHACHA_QUARTER_ROUND (x[1], x[6], x[11], x[12]);
+        CHACHA_QUARTER_ROUND (x[2], x[7], x[ 8], x[13]);
+        CHACHA_QUARTER_ROUND (x[3], x[4], x[ 9], x[14]);
+    }
+    for (i = 0; i < 16; i++) {
+        _chacha_store32 (out + (4 * i), x[i] + s[i]);
+    }
+    return;
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+static uint32_t
+_chacha_load32 (const unsigned char *p)
+{
+/*  Returns the little-endian 32-bit word at [p].
+ */
+    return (((uint32_t) p[0])       | ((uint32_t) p[1] <<  8)
+          | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24));
+}
+
+
+static void
+_chacha_store32 (unsigned char *p, uint32_t v)
+{
+/*  Stores the 32-bit word [v] at [p] in little-endian byte order.
+ */
+    p[0] = (unsigned char) (v);
+    p[1] = (unsigned char) (v >>  8);
+    p[2] = (unsigned char) (v >> 16);
+    p[3] = (unsigned char) (v >> 24);
+    return;
+}
@@ -0,0 +1,89 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "chacha.h"
+#include "tap.h"
+
+
+/*****************************************************************************
+ *  Test vectors from RFC 8439 (ChaCha20 and Poly1305 for IETF Protocols)
+ *    Section 2.3.2 (Test Vector for the ChaCha20 Block Function) and
+ *    Appendix A.1 (The ChaCha20 Block Functions), Test Vector #2.
+ *****************************************************************************/
+
+
+int
+main (int argc, char *argv[])
+{
+    unsigned char key [CHACHA_KEY_LEN];
+    unsigned char nonce [CHACHA_NONCE_LEN];
+    unsigned char out [CHACHA_BLOCK_LEN];
+    int           i;
+
+    const unsigned char nonce1[] = {
+        0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x4a,
+        0x00, 0x00, 0x00, 0x00 };
+    const unsigned char block1[] = {
+        0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15,
+        0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4,
+        0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0, 0x68, 0x03,
+        0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e,
+        0xd2, 0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09,
+        0x14, 0xc2, 0xd7, 0x05, 0xd9, 0x8b, 0x02, 0xa2,
+        0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e, 0xb9,
+        0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e };
+    const unsigned char block2[] = {
+        0x9f, 0x07, 0xe7, 0xbe, 0x55, 0x51, 0x38, 0x7a,
+        0x98, 0xba, 0x97, 0x7c, 0x73, 0x2d, 0x08, 0x0d,
+        0xcb, 0x0f, 0x29, 0xa0, 0x48, 0xe3, 0x65, 0x69,
+        0x12, 0xc6, 0x53, 0x3e, 0x32, 0xee, 0x7a, 0xed,
+        0x29, 0xb7, 0x21, 0x76, 0x9c, 0xe6, 0x4e, 0x43,
+        0xd5, 0x71, 0x33, 0xb0, 0x74, 0xd8, 0x39, 0xd5,
+        0x31, 0xed, 0x1f, 0x28, 0x51, 0x0a, 0xfb, 0x45,
+        0xac, 0xe1, 0x0a, 0x1f, 0x4b, 0x79, 0x4d, 0x6f };
+
+    plan (2);
+
+    for (i = 0; i < CHACHA_KEY_LEN; i++) {
+        key[i] = (unsigned char) i;
+    }
+    chacha20_block (out, key, 1, nonce1);
+    ok (memcmp (out, block1, sizeof (block1)) == 0,
+            "RFC 8439 2.3.2 block function");
+
+    memset (key, 0, sizeof (key));
+    memset (nonce, 0, sizeof (nonce));
+    chacha20_block (out, key, 1, nonce);
+    ok (memcmp (out, block2, sizeof (block2)) == 0,
+            "RFC 8439 A.1 block function test vector #2");
+
+    done_testing ();
+
+    exit (EXIT_SUCCESS);
+}
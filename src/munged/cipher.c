@@ -53,6 +53,12 @@ static int _cipher_update (cipher_ctx *x, void *dst, int *dstlenp,
     const void *src, int srclen);
 static int _cipher_final (cipher_ctx *x, void *dst, int *dstlenp);
 static int _cipher_cleanup (cipher_ctx *x);
+static int _cipher_reinit (cipher_ctx *x, unsigned char *key,
+    unsigned char *iv, int enc);
+static int _cipher_aead_init (cipher_ctx *x, munge_cipher_t cipher);
+static int _cipher_aead (cipher_ctx *x, const unsigned char *key,
+    const unsigned char *iv, const void *aad, int aadlen,
+    void *dst, const void *src, int srclen, void *tag, int taglen, int enc);
 static int _cipher_block_size (munge_cipher_t cipher);
 static int _cipher_iv_size (munge_cipher_t cipher);
 static int _cipher_key_size (munge_cipher_t cipher);
@@ -96,6 +102,11 @@ cipher_init (cipher_ctx *x, munge_cipher_t cipher,
             || !((enc == CIPHER_DECRYPT) || (enc == CIPHER_ENCRYPT))) {
         return (-1);
     }
+    /*  AEAD ciphers are only supported by cipher_aead_init().
+     */
+    if (cipher_is_aead (cipher)) {
+        return (-1);
+    }
     rc = _cipher_init (x, cipher, key, iv, enc);
     return (rc);
 }
@@ -168,6 +179,144 @@ cipher_cleanup (cipher_ctx *x)
 }
 
 
+/*  Reinitializes the cipher context [x] from a previous cipher_init() with
+ *    symmetric key [key] and initialization vector [iv], keeping the same
+ *    cipher.  This avoids reallocating the context and, for OpenSSL 3.0,
+ *    refetching the cipher implementation for each message.
+ *  The [enc] parm is set to 1 for encryption, and 0 for decryption.
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+cipher_reinit (cipher_ctx *x, unsigned char *key, unsigned char *iv, int enc)
+{
+    int rc;
+
+    assert (_cipher_is_initialized);
+
+    if (!x || !key || !iv
+            || !((enc == CIPHER_DECRYPT) || (enc == CIPHER_ENCRYPT))) {
+        return (-1);
+    }
+    rc = _cipher_reinit (x, key, iv, enc);
+    return (rc);
+}
+
+
+/*  Initializes the cipher context [x] with the AEAD cipher [cipher].
+ *  The key and nonce are set for each message by cipher_aead_encrypt() or
+ *    cipher_aead_decrypt(), so the context can be reused across messages
+ *    without reallocating it or refetching the cipher implementation.
+ *  The context must be released by cipher_cleanup().
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+cipher_aead_init (cipher_ctx *x, munge_cipher_t cipher)
+{
+    int rc;
+
+    assert (_cipher_is_initialized);
+
+    if (!x) {
+        return (-1);
+    }
+    if (!cipher_is_aead (cipher)) {
+        return (-1);
+    }
+    rc = _cipher_aead_init (x, cipher);
+    return (rc);
+}
+
+
+/*  Encrypts [srclen] bytes from [src] into [dst] with the AEAD cipher
+ *    context [x] using symmetric key [key] and nonce [iv], authenticating
+ *    both the plaintext and the [aadlen] bytes of additional data at [aad].
+ *  The [dst] buffer must be at least [srclen] bytes since the ciphertext
+ *    is the same length as the plaintext.
+ *  The authentication tag is written into [tag] of length [taglen].
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+cipher_aead_encrypt (cipher_ctx *x, const unsigned char *key,
+                     const unsigned char *iv, const void *aad, int aadlen,
+                     void *dst, const void *src, int srclen,
+                     void *tag, int taglen)
+{
+    int rc;
+
+    assert (_cipher_is_initialized);
+
+    if (!x || !key || !iv || (!aad && (aadlen != 0)) || (aadlen < 0)
+            || !dst || !src || (srclen < 0)
+            || !tag || (taglen != CIPHER_AEAD_TAG_LEN)) {
+        return (-1);
+    }
+    rc = _cipher_aead (x, key, iv, aad, aadlen, dst, src, srclen,
+            tag, taglen, CIPHER_ENCRYPT);
+    return (rc);
+}
+
+
+/*  Decrypts [srclen] bytes from [src] into [dst] with the AEAD cipher
+ *    context [x] using symmetric key [key] and nonce [iv], verifying the
+ *    authentication tag [tag] of length [taglen] over both the ciphertext
+ *    and the [aadlen] bytes of additional data at [aad].
+ *  The [dst] buffer must be at least [srclen] bytes.
+ *  Returns 0 on success, or -1 on error (including authentication failure);
+ *    on error, the contents of [dst] must not be used.
+ */
+int
+cipher_aead_decrypt (cipher_ctx *x, const unsigned char *key,
+                     const unsigned char *iv, const void *aad, int aadlen,
+                     void *dst, const void *src, int srclen,
+                     const void *tag, int taglen)
+{
+    int rc;
+
+    assert (_cipher_is_initialized);
+
+    if (!x || !key || !iv || (!aad && (aadlen != 0)) || (aadlen < 0)
+            || !dst || !src || (srclen < 0)
+            || !tag || (taglen != CIPHER_AEAD_TAG_LEN)) {
+        return (-1);
+    }
+    rc = _cipher_aead (x, key, iv, aad, aadlen, dst, src, srclen,
+            (void *) tag, taglen, CIPHER_DECRYPT);
+    return (rc);
+}
+
+
+/*  Returns 1 if [cipher] is an Authenticated Encryption with Associated Data
+ *    (AEAD) cipher, or 0 if not.
+ */
+int
+cipher_is_aead (munge_cipher_t cipher)
+{
+    switch (cipher) {
+        case MUNGE_CIPHER_AES128_GCM:
+        case MUNGE_CIPHER_AES256_GCM:
+        case MUNGE_CIPHER_CHACHA20_POLY1305:
+            return (1);
+        default:
+            return (0);
+    }
+}
+
+
+/*  Returns the authentication tag length (in bytes) of the cipher [cipher],
+ *    0 if the cipher is not an AEAD cipher, or -1 on error.
+ */
+int
+cipher_tag_size (munge_cipher_t cipher)
+{
+    assert (_cipher_is_initialized);
+
+    if (_cipher_map_enum (cipher, NULL) < 0) {
+        return (-1);
+    }
+    return (cipher_is_aead (cipher) ? CIPHER_AEAD_TAG_LEN : 0);
+}
+
+
 /*  Returns the block size (in bytes) of the cipher [cipher], or -1 on error.
  */
 int
@@ -226,6 +375,7 @@ cipher_map_enum (munge_cipher_t cipher, void *dst)
 #include "log.h"
 
 static int _cipher_map [MUNGE_CIPHER_LAST_ITEM];
+static int _cipher_mode [MUNGE_CIPHER_LAST_ITEM];
 
 static int _cipher_update_aux (cipher_ctx *x, void *dst, int *dstlenp,
     const void *src, int srclen);
@@ -238,11 +388,27 @@ _cipher_init_subsystem (void)
 
     for (i = 0; i < MUNGE_CIPHER_LAST_ITEM; i++) {
         _cipher_map [i] = -1;
+        _cipher_mode [i] = GCRY_CIPHER_MODE_CBC;
     }
     _cipher_map [MUNGE_CIPHER_BLOWFISH] = GCRY_CIPHER_BLOWFISH;
     _cipher_map [MUNGE_CIPHER_CAST5] = GCRY_CIPHER_CAST5;
     _cipher_map [MUNGE_CIPHER_AES128] = GCRY_CIPHER_AES128;
     _cipher_map [MUNGE_CIPHER_AES256] = GCRY_CIPHER_AES256;
+
+#if HAVE_DECL_GCRY_CIPHER_MODE_GCM
+    /*  Libgcrypt >= 1.6.0  */
+    _cipher_map [MUNGE_CIPHER_AES128_GCM] = GCRY_CIPHER_AES128;
+    _cipher_mode [MUNGE_CIPHER_AES128_GCM] = GCRY_CIPHER_MODE_GCM;
+    _cipher_map [MUNGE_CIPHER_AES256_GCM] = GCRY_CIPHER_AES256;
+    _cipher_mode [MUNGE_CIPHER_AES256_GCM] = GCRY_CIPHER_MODE_GCM;
+#endif /* HAVE_DECL_GCRY_CIPHER_MODE_GCM */
+
+#if HAVE_DECL_GCRY_CIPHER_MODE_POLY1305
+    /*  Libgcrypt >= 1.7.0  */
+    _cipher_map [MUNGE_CIPHER_CHACHA20_POLY1305] = GCRY_CIPHER_CHACHA20;
+    _cipher_mode [MUNGE_CIPHER_CHACHA20_POLY1305] = GCRY_CIPHER_MODE_POLY1305;
+#endif /* HAVE_DECL_GCRY_CIPHER_MODE_POLY1305 */
+
     return;
 }
 
@@ -277,6 +443,7 @@ _cipher_init (cipher_ctx *x, munge_cipher_t cipher,
             cipher, gcry_strerror (e));
         return (-1);
     }
+    x->keylen = (int) nbytes;
     e = gcry_cipher_algo_info (algo, GCRYCTL_GET_BLKLEN, NULL, &nbytes);
     if (e != 0) {
         log_msg (LOG_DEBUG,
@@ -493,6 +660,118 @@ _cipher_cleanup (cipher_ctx *x)
 }
 
 
+static int
+_cipher_reinit (cipher_ctx *x, unsigned char *key, unsigned char *iv, int enc)
+{
+    gcry_error_t e;
+
+    if ((e = gcry_cipher_reset (x->ctx)) != 0) {
+        log_msg (LOG_DEBUG, "gcry_cipher_reset failed: %s",
+            gcry_strerror (e));
+        return (-1);
+    }
+    if ((e = gcry_cipher_setkey (x->ctx, key, x->keylen)) != 0) {
+        log_msg (LOG_DEBUG, "gcry_cipher_setkey failed for reinit: %s",
+            gcry_strerror (e));
+        return (-1);
+    }
+    if ((e = gcry_cipher_setiv (x->ctx, iv, x->blklen)) != 0) {
+        log_msg (LOG_DEBUG, "gcry_cipher_setiv failed for reinit: %s",
+            gcry_strerror (e));
+        return (-1);
+    }
+    x->do_encrypt = enc;
+    x->len = 0;
+    return (0);
+}
+
+
+static int
+_cipher_aead_init (cipher_ctx *x, munge_cipher_t cipher)
+{
+    gcry_error_t  e;
+    int           algo;
+    size_t        nbytes;
+
+    if (_cipher_map_enum (cipher, &algo) < 0) {
+        return (-1);
+    }
+    e = gcry_cipher_open (&(x->ctx), algo, _cipher_mode [cipher], 0);
+    if (e != 0) {
+        log_msg (LOG_DEBUG, "gcry_cipher_open failed for cipher=%d: %s",
+            cipher, gcry_strerror (e));
+        return (-1);
+    }
+    e = gcry_cipher_algo_info (algo, GCRYCTL_GET_KEYLEN, NULL, &nbytes);
+    if (e != 0) {
+        log_msg (LOG_DEBUG,
+            "gcry_cipher_algo_info failed for cipher=%d key length: %s",
+            cipher, gcry_strerror (e));
+        gcry_cipher_close (x->ctx);
+        return (-1);
+    }
+    x->keylen = (int) nbytes;
+    return (0);
+}
+
+
+static int
+_cipher_aead (cipher_ctx *x, const unsigned char *key,
+              const unsigned char *iv, const void *aad, int aadlen,
+              void *dst, const void *src, int srclen,
+              void *tag, int taglen, int enc)
+{
+    gcry_error_t  e;
+    const char   *fn;
+
+    if ((e = gcry_cipher_reset (x->ctx)) != 0) {
+        fn = "gcry_cipher_reset";
+        goto err;
+    }
+    if ((e = gcry_cipher_setkey (x->ctx, key, x->keylen)) != 0) {
+        fn = "gcry_cipher_setkey";
+        goto err;
+    }
+    if ((e = gcry_cipher_setiv (x->ctx, iv, CIPHER_AEAD_IV_LEN)) != 0) {
+        fn = "gcry_cipher_setiv";
+        goto err;
+    }
+    if ((aadlen > 0)
+            && ((e = gcry_cipher_authenticate (x->ctx, aad, aadlen)) != 0)) {
+        fn = "gcry_cipher_authenticate";
+        goto err;
+    }
+    if (enc) {
+        if ((e = gcry_cipher_encrypt (x->ctx, dst, srclen, src, srclen))
+                != 0) {
+            fn = "gcry_cipher_encrypt";
+            goto err;
+        }
+        if ((e = gcry_cipher_gettag (x->ctx, tag, taglen)) != 0) {
+            fn = "gcry_cipher_gettag";
+            goto err;
+        }
+    }
+    else {
+        if ((e = gcry_cipher_decrypt (x->ctx, dst, srclen, src, srclen))
+                != 0) {
+            fn = "gcry_cipher_decrypt";
+            goto err;
+        }
+        if ((e = gcry_cipher_checktag (x->ctx, tag, taglen)) != 0) {
+            fn = "gcry_cipher_checktag";
+            goto err;
+        }
+    }
+    return (0);
+
+err:
+    log_msg (LOG_DEBUG, "%s failed for AEAD cipher: %s",
+        fn, gcry_strerror (e));
+    return (-1);
+}
+
+
 static int
 _cipher_block_size (munge_cipher_t cipher)
 {
@@ -517,6 +796,12 @@ _cipher_block_size (munge_cipher_t cipher)
 static int
 _cipher_iv_size (munge_cipher_t cipher)
 {
+    if (cipher_is_aead (cipher)) {
+        if (_cipher_map_enum (cipher, NULL) < 0) {
+            return (-1);
+        }
+        return (CIPHER_AEAD_IV_LEN);
+    }
     return (_cipher_block_size (cipher));
 }
 
@@ -571,6 +856,12 @@ _cipher_map_enum (munge_cipher_t cipher, void *dst)
 #include <openssl/crypto.h>
 #include <openssl/evp.h>
 
+#ifndef EVP_CTRL_AEAD_SET_TAG
+/*  OpenSSL < 1.1.0  */
+#  define EVP_CTRL_AEAD_GET_TAG EVP_CTRL_GCM_GET_TAG
+#  define EVP_CTRL_AEAD_SET_TAG EVP_CTRL_GCM_SET_TAG
+#endif /* !EVP_CTRL_AEAD_SET_TAG */
+
 static const EVP_CIPHER *_cipher_map [MUNGE_CIPHER_LAST_ITEM];
 
 
@@ -593,6 +884,21 @@ _cipher_init_subsystem (void)
     _cipher_map [MUNGE_CIPHER_AES256] = EVP_aes_256_cbc ();
 #endif /* HAVE_EVP_AES_256_CBC && HAVE_EVP_SHA256 */
 
+#if HAVE_EVP_AES_128_GCM
+    /*  OpenSSL >= 1.0.1  */
+    _cipher_map [MUNGE_CIPHER_AES128_GCM] = EVP_aes_128_gcm ();
+#endif /* HAVE_EVP_AES_128_GCM */
+
+#if HAVE_EVP_AES_256_GCM && HAVE_EVP_SHA256
+    /*  OpenSSL >= 1.0.1  */
+    _cipher_map [MUNGE_CIPHER_AES256_GCM] = EVP_aes_256_gcm ();
+#endif /* HAVE_EVP_AES_256_GCM && HAVE_EVP_SHA256 */
+
+#if HAVE_EVP_CHACHA20_POLY1305 && HAVE_EVP_SHA256
+    /*  OpenSSL >= 1.1.0  */
+    _cipher_map [MUNGE_CIPHER_CHACHA20_POLY1305] = EVP_chacha20_poly1305 ();
+#endif /* HAVE_EVP_CHACHA20_POLY1305 && HAVE_EVP_SHA256 */
+
     return;
 }
 
@@ -709,6 +1015,107 @@ _cipher_cleanup (cipher_ctx *x)
 }
 
 
+static int
+_cipher_reinit (cipher_ctx *x, unsigned char *key, unsigned char *iv, int enc)
+{
+/*  Passing a NULL cipher reuses the one from the previous init.
+ */
+#if HAVE_EVP_CIPHERINIT_EX
+    /*  OpenSSL >= 0.9.7  */
+    if (EVP_CipherInit_ex (x->ctx, NULL, NULL, key, iv, enc) != 1) {
+        return (-1);
+    }
+#elif HAVE_EVP_CIPHERINIT_RETURN_INT
+    /*  OpenSSL > 0.9.5a  */
+    if (EVP_CipherInit (x->ctx, NULL, key, iv, enc) != 1) {
+        return (-1);
+    }
+#elif HAVE_EVP_CIPHERINIT
+    /*  OpenSSL <= 0.9.5a  */
+    EVP_CipherInit (x->ctx, NULL, key, iv, enc);
+#else  /* !HAVE_EVP_CIPHERINIT */
+#error "No OpenSSL EVP_CipherInit"
+#endif /* !HAVE_EVP_CIPHERINIT */
+
+    return (0);
+}
+
+
+static int
+_cipher_aead_init (cipher_ctx *x, munge_cipher_t cipher)
+{
+#if HAVE_EVP_AES_128_GCM
+    /*  OpenSSL >= 1.0.1  */
+    EVP_CIPHER *algo;
+
+    if (_cipher_map_enum (cipher, &algo) < 0) {
+        return (-1);
+    }
+    if (!(x->ctx = EVP_CIPHER_CTX_new ())) {
+        return (-1);
+    }
+    /*  The key and nonce are set for each message by _cipher_aead().
+     */
+    if (EVP_CipherInit_ex (x->ctx, algo, NULL, NULL, NULL, -1) != 1) {
+        EVP_CIPHER_CTX_free (x->ctx);
+        x->ctx = NULL;
+        return (-1);
+    }
+    return (0);
+
+#else  /* !HAVE_EVP_AES_128_GCM */
+    return (-1);
+#endif /* !HAVE_EVP_AES_128_GCM */
+}
+
+
+static int
+_cipher_aead (cipher_ctx *x, const unsigned char *key,
+              const unsigned char *iv, const void *aad, int aadlen,
+              void *dst, const void *src, int srclen,
+              void *tag, int taglen, int enc)
+{
+#if HAVE_EVP_AES_128_GCM
+    /*  OpenSSL >= 1.0.1  */
+    int n;
+
+    /*  Passing a NULL cipher reuses the one from _cipher_aead_init().
+     */
+    if (EVP_CipherInit_ex (x->ctx, NULL, NULL, key, iv, enc) != 1) {
+        return (-1);
+    }
+    /*  The expected tag must be set before decryption is finalized.
+     */
+    if (!enc && (EVP_CIPHER_CTX_ctrl (x->ctx, EVP_CTRL_AEAD_SET_TAG,
+            taglen, tag) != 1)) {
+        return (-1);
+    }
+    if ((aadlen > 0)
+            && (EVP_CipherUpdate (x->ctx, NULL, &n, aad, aadlen) != 1)) {
+        return (-1);
+    }
+    if (EVP_CipherUpdate (x->ctx, dst, &n, src, srclen) != 1) {
+        return (-1);
+    }
+    assert (n == srclen);
+    /*
+     *  For decryption, finalization fails if the tag does not verify.
+     */
+    if (EVP_CipherFinal_ex (x->ctx, (unsigned char *) dst + n, &n) != 1) {
+        return (-1);
+    }
+    if (enc && (EVP_CIPHER_CTX_ctrl (x->ctx, EVP_CTRL_AEAD_GET_TAG,
+            taglen, tag) != 1)) {
+        return (-1);
+    }
+    return (0);
+
+#else  /* !HAVE_EVP_AES_128_GCM */
+    return (-1);
+#endif /* !HAVE_EVP_AES_128_GCM */
+}
+
+
 static int
 _cipher_block_size (munge_cipher_t cipher)
 {
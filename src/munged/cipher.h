@@ -37,6 +37,17 @@
 #include "munge_defs.h"
 
 
+/*****************************************************************************
+ *  Constants
+ *****************************************************************************/
+
+/*  Length (in bytes) of the nonce and authentication tag for the
+ *    Authenticated Encryption with Associated Data (AEAD) ciphers.
+ */
+#define CIPHER_AEAD_IV_LEN              12
+#define CIPHER_AEAD_TAG_LEN             16
+
+
 /*****************************************************************************
  *  Data Types
  *****************************************************************************/
@@ -50,6 +61,7 @@ typedef struct {
     int                 do_encrypt;
     int                 len;
     int                 blklen;
+    int                 keylen;
     unsigned char       buf [MUNGE_MAXIMUM_BLK_LEN];
 } cipher_ctx;
 
@@ -89,6 +101,25 @@ int cipher_final (cipher_ctx *x, void *dst, int *dstlenp);
 
 int cipher_cleanup (cipher_ctx *x);
 
+int cipher_reinit (cipher_ctx *x, unsigned char *key, unsigned char *iv,
+                   int enc);
+
+int cipher_aead_init (cipher_ctx *x, munge_cipher_t cipher);
+
+int cipher_aead_encrypt (cipher_ctx *x, const unsigned char *key,
+                         const unsigned char *iv, const void *aad, int aadlen,
+                         void *dst, const void *src, int srclen,
+                         void *tag, int taglen);
+
+int cipher_aead_decrypt (cipher_ctx *x, const unsigned char *key,
+                         const unsigned char *iv, const void *aad, int aadlen,
+                         void *dst, const void *src, int srclen,
+                         const void *tag, int taglen);
+
+int cipher_is_aead (munge_cipher_t cipher);
+
+int cipher_tag_size (munge_cipher_t cipher);
+
 int cipher_block_size (munge_cipher_t cipher);
 
 int cipher_iv_size (munge_cipher_t cipher);
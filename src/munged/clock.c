@@ -35,6 +35,9 @@
 #include "clock.h"
 
 
+static void _clock_add_msecs (struct timespec *tsp, long msecs);
+
+
 /*  Set timespec [tsp] to the current time adjusted forward by
  *    [msecs] milliseconds.
  *  Return 0 on success, or -1 on error (with errno set).
@@ -63,14 +66,37 @@ clock_get_timespec (struct timespec *tsp, long msecs)
     tsp->tv_nsec = tv.tv_usec * 1000;
 #endif /* !HAVE_CLOCK_GETTIME */
 
-    if (msecs > 0) {
-        tsp->tv_sec += msecs / 1000;
-        tsp->tv_nsec += (msecs % 1000) * 1000 * 1000;
-        if (tsp->tv_nsec >= 1000 * 1000 * 1000) {
-            tsp->tv_sec += tsp->tv_nsec / (1000 * 1000 * 1000);
-            tsp->tv_nsec %= 1000 * 1000 * 1000;
-        }
+    _clock_add_msecs (tsp, msecs);
+    return 0;
+}
+
+
+/*  Set timespec [tsp] to the current time of the monotonic clock adjusted
+ *    forward by [msecs] milliseconds.  Unlike clock_get_timespec(), this
+ *    time is unaffected by changes to the system (wall-clock) time.
+ *  Return 0 on success, or -1 on error (with errno set).
+ */
+int
+clock_get_monotonic_timespec (struct timespec *tsp, long msecs)
+{
+    int rv;
+
+    if (tsp == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+    rv = clock_gettime (CLOCK_MONOTONIC, tsp);
+    if (rv < 0) {
+        return -1;
     }
+#else  /* !HAVE_CLOCK_GETTIME || !CLOCK_MONOTONIC */
+    rv = -1;
+    errno = ENOSYS;
+    return rv;
+#endif /* !HAVE_CLOCK_GETTIME || !CLOCK_MONOTONIC */
+
+    _clock_add_msecs (tsp, msecs);
     return 0;
 }
 
@@ -112,3 +138,19 @@ clock_is_timespec_expired (const struct timespec *tsp)
     rv = clock_is_timespec_le (tsp, &now);
     return rv;
 }
+
+
+/*  Adjust timespec [tsp] forward by [msecs] milliseconds.
+ */
+static void
+_clock_add_msecs (struct timespec *tsp, long msecs)
+{
+    if (msecs > 0) {
+        tsp->tv_sec += msecs / 1000;
+        tsp->tv_nsec += (msecs % 1000) * 1000 * 1000;
+        if (tsp->tv_nsec >= 1000 * 1000 * 1000) {
+            tsp->tv_sec += tsp->tv_nsec / (1000 * 1000 * 1000);
+            tsp->tv_nsec %= 1000 * 1000 * 1000;
+        }
+    }
+}
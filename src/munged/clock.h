@@ -38,6 +38,8 @@
 
 int clock_get_timespec (struct timespec *tsp, long msecs);
 
+int clock_get_monotonic_timespec (struct timespec *tsp, long msecs);
+
 int clock_is_timespec_le (
         const struct timespec *tsp0, const struct timespec *tsp1);
 
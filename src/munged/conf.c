@@ -78,7 +78,18 @@
 #define OPT_TRUSTED_GROUP       269
 #define OPT_ORIGIN              270
 #define OPT_LISTEN_BACKLOG      271
-#define OPT_LAST                272
+#define OPT_STAGE_TIMING        272
+#define OPT_MAX_THREADS         273
+#define OPT_CPU_AFFINITY        274
+#define OPT_ACCEPT_THREADS      275
+#define OPT_ENC_QUEUE_LIMIT     276
+#define OPT_DEC_QUEUE_LIMIT     277
+#define OPT_TIMERFD             278
+#define OPT_LOG_ASYNC           279
+#define OPT_LOG_AGGREGATE       280
+#define OPT_DICT_FILE           281
+#define OPT_EARLY_REPLAY        282
+#define OPT_LAST                283
 
 const char * const short_opts = ":hLVfFMsS:v";
 
@@ -93,23 +104,36 @@ struct option long_opts[] = {
     { "stop",              no_argument,       NULL, 's'               },
     { "socket",            required_argument, NULL, 'S'               },
     { "verbose",           no_argument,       NULL, 'v'               },
+    { "accept-threads",    required_argument, NULL, OPT_ACCEPT_THREADS},
     { "advice",            no_argument,       NULL, OPT_ADVICE        },
 #if defined(AUTH_METHOD_RECVFD_MKFIFO) || defined(AUTH_METHOD_RECVFD_MKNOD)
     { "auth-server-dir",   required_argument, NULL, OPT_AUTH_SERVER   },
     { "auth-client-dir",   required_argument, NULL, OPT_AUTH_CLIENT   },
 #endif /* AUTH_METHOD_RECVFD_MKFIFO || AUTH_METHOD_RECVFD_MKNOD */
     { "benchmark",         no_argument,       NULL, OPT_BENCHMARK     },
+    { "cpu-affinity",      required_argument, NULL, OPT_CPU_AFFINITY  },
+    { "dec-queue-limit",   required_argument, NULL, OPT_DEC_QUEUE_LIMIT},
+    { "dict-file",         required_argument, NULL, OPT_DICT_FILE     },
+    { "early-replay-reject", no_argument,     NULL, OPT_EARLY_REPLAY  },
+    { "enc-queue-limit",   required_argument, NULL, OPT_ENC_QUEUE_LIMIT},
     { "group-check-mtime", required_argument, NULL, OPT_GROUP_CHECK   },
     { "group-update-time", required_argument, NULL, OPT_GROUP_UPDATE  },
     { "key-file",          required_argument, NULL, OPT_KEY_FILE      },
     { "listen-backlog",    required_argument, NULL, OPT_LISTEN_BACKLOG},
+    { "log-aggregate",     required_argument, NULL, OPT_LOG_AGGREGATE },
+    { "log-async",         no_argument,       NULL, OPT_LOG_ASYNC     },
     { "log-file",          required_argument, NULL, OPT_LOG_FILE      },
+    { "max-threads",       required_argument, NULL, OPT_MAX_THREADS   },
     { "max-ttl",           required_argument, NULL, OPT_MAX_TTL       },
     { "num-threads",       required_argument, NULL, OPT_NUM_THREADS   },
     { "origin",            required_argument, NULL, OPT_ORIGIN        },
     { "pid-file",          required_argument, NULL, OPT_PID_FILE      },
     { "seed-file",         required_argument, NULL, OPT_SEED_FILE     },
+#ifdef WITH_STAGE_TIMING
+    { "stage-timing",      no_argument,       NULL, OPT_STAGE_TIMING  },
+#endif /* WITH_STAGE_TIMING */
     { "syslog",            no_argument,       NULL, OPT_SYSLOG        },
+    { "timerfd",           no_argument,       NULL, OPT_TIMERFD       },
     { "trusted-group",     required_argument, NULL, OPT_TRUSTED_GROUP },
     {  NULL,               0,                 NULL, 0                 }
 };
@@ -159,14 +183,18 @@ create_conf (void)
     conf->ld = -1;
     conf->got_benchmark = 0;
     conf->got_clock_skew = 1;
+    conf->got_early_replay = 0;
     conf->got_force = 0;
     conf->got_foreground = 0;
     conf->got_group_stat = !! MUNGE_GROUP_STAT_FLAG;
+    conf->got_log_async = 0;
     conf->got_stop = 0;
     conf->got_mlockall = 0;
     conf->got_root_auth = !! MUNGE_AUTH_ROOT_ALLOW_FLAG;
     conf->got_socket_retry = !! MUNGE_SOCKET_RETRY_FLAG;
+    conf->got_stage_timing = 0;
     conf->got_syslog = 0;
+    conf->got_timerfd = 0;
     conf->got_verbose = 0;
     conf->def_cipher = MUNGE_DEFAULT_CIPHER;
     conf->def_zip = zip_select_default_type (MUNGE_DEFAULT_ZIP);
@@ -180,6 +208,10 @@ create_conf (void)
     conf->lockfile_fd = -1;
     conf->lockfile_name = NULL;
     conf->listen_backlog = MUNGE_SOCKET_BACKLOG;
+    conf->accept_threads = MUNGE_ACCEPT_THREADS;
+    conf->enc_queue_limit = 0;
+    conf->dec_queue_limit = 0;
+    conf->log_aggregate_secs = 0;
 
     _conf_set_cwd (conf);
 
@@ -213,6 +245,8 @@ create_conf (void)
     conf->gids = NULL;
     conf->gids_update_secs = MUNGE_GROUP_UPDATE_SECS;
     conf->nthreads = MUNGE_THREADS;
+    conf->nthreads_max = 0;
+    conf->cpu_list = NULL;
     conf->auth_server_dir = NULL;
     conf->auth_client_dir = NULL;
     conf->auth_rnd_bytes = MUNGE_AUTH_RND_BYTES;
@@ -283,6 +317,10 @@ destroy_conf (conf_t conf, int do_unlink)
         free (conf->key_name);
         conf->key_name = NULL;
     }
+    if (conf->dict_name) {
+        free (conf->dict_name);
+        conf->dict_name = NULL;
+    }
     if (conf->dek_key) {
         memburn (conf->dek_key, 0, conf->dek_key_len);
         free (conf->dek_key);
@@ -301,6 +339,10 @@ destroy_conf (conf_t conf, int do_unlink)
         free (conf->origin_ifname);
         conf->origin_ifname = NULL;
     }
+    if (conf->cpu_list) {
+        free (conf->cpu_list);
+        conf->cpu_list = NULL;
+    }
     if (conf->auth_server_dir) {
         free (conf->auth_server_dir);
         conf->auth_server_dir = NULL;
@@ -368,6 +410,17 @@ parse_cmdline (conf_t conf, int argc, char **argv)
             case 'v':
                 conf->got_verbose = 1;
                 break;
+            case OPT_ACCEPT_THREADS:
+                errno = 0;
+                l = strtol (optarg, &p, 10);
+                if (((errno == ERANGE) && ((l == LONG_MIN) || (l == LONG_MAX)))
+                        || (optarg == p) || (*p != '\0')
+                        || (l <= 0) || (l > INT_MAX)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid value \"%s\" for accept-threads", optarg);
+                }
+                conf->accept_threads = l;
+                break;
             case OPT_ADVICE:
                 printf ("Don't Panic!\n");
                 exit (42);
@@ -384,6 +437,39 @@ parse_cmdline (conf_t conf, int argc, char **argv)
             case OPT_BENCHMARK:
                 conf->got_benchmark = 1;
                 break;
+            case OPT_DEC_QUEUE_LIMIT:
+                errno = 0;
+                l = strtol (optarg, &p, 10);
+                if (((errno == ERANGE) && ((l == LONG_MIN) || (l == LONG_MAX)))
+                        || (optarg == p) || (*p != '\0')
+                        || (l < 0) || (l > INT_MAX)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid value \"%s\" for dec-queue-limit", optarg);
+                }
+                conf->dec_queue_limit = l;
+                break;
+            case OPT_DICT_FILE:
+                _conf_set_string (&conf->dict_name, optarg, conf->cwd,
+                        "dict-file name");
+                break;
+            case OPT_EARLY_REPLAY:
+                conf->got_early_replay = 1;
+                break;
+            case OPT_ENC_QUEUE_LIMIT:
+                errno = 0;
+                l = strtol (optarg, &p, 10);
+                if (((errno == ERANGE) && ((l == LONG_MIN) || (l == LONG_MAX)))
+                        || (optarg == p) || (*p != '\0')
+                        || (l < 0) || (l > INT_MAX)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid value \"%s\" for enc-queue-limit", optarg);
+                }
+                conf->enc_queue_limit = l;
+                break;
+            case OPT_CPU_AFFINITY:
+                _conf_set_string (&conf->cpu_list, optarg, NULL,
+                        "cpu-affinity");
+                break;
             case OPT_GROUP_CHECK:
                 errno = 0;
                 l = strtol (optarg, &p, 10);
@@ -428,10 +514,35 @@ parse_cmdline (conf_t conf, int argc, char **argv)
                     conf->listen_backlog = l;
                 }
                 break;
+            case OPT_LOG_AGGREGATE:
+                errno = 0;
+                l = strtol (optarg, &p, 10);
+                if (((errno == ERANGE) && ((l == LONG_MIN) || (l == LONG_MAX)))
+                        || (optarg == p) || (*p != '\0')
+                        || (l < 0) || (l > INT_MAX / 1000)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid value \"%s\" for log-aggregate", optarg);
+                }
+                conf->log_aggregate_secs = l;
+                break;
+            case OPT_LOG_ASYNC:
+                conf->got_log_async = 1;
+                break;
             case OPT_LOG_FILE:
                 _conf_set_string (&conf->logfile_name, optarg, conf->cwd,
                         "log-file name");
                 break;
+            case OPT_MAX_THREADS:
+                errno = 0;
+                l = strtol (optarg, &p, 10);
+                if (((errno == ERANGE) && ((l == LONG_MIN) || (l == LONG_MAX)))
+                        || (optarg == p) || (*p != '\0')
+                        || (l <= 0) || (l > INT_MAX)) {
+                    log_err (EMUNGE_SNAFU, LOG_ERR,
+                        "Invalid value \"%s\" for max-threads", optarg);
+                }
+                conf->nthreads_max = l;
+                break;
             case OPT_MAX_TTL:
                 l = strtol (optarg, &p, 10);
                 if (((errno == ERANGE) && ((l == LONG_MIN) || (l == LONG_MAX)))
@@ -464,9 +575,17 @@ parse_cmdline (conf_t conf, int argc, char **argv)
                 _conf_set_string (&conf->seed_name, optarg, conf->cwd,
                         "seed-file name");
                 break;
+#ifdef WITH_STAGE_TIMING
+            case OPT_STAGE_TIMING:
+                conf->got_stage_timing = 1;
+                break;
+#endif /* WITH_STAGE_TIMING */
             case OPT_SYSLOG:
                 conf->got_syslog = 1;
                 break;
+            case OPT_TIMERFD:
+                conf->got_timerfd = 1;
+                break;
             case OPT_TRUSTED_GROUP:
                 if (path_set_trusted_group (optarg) < 0) {
                     log_err (EMUNGE_SNAFU, LOG_ERR,
@@ -520,6 +639,14 @@ parse_cmdline (conf_t conf, int argc, char **argv)
         log_err (EMUNGE_SNAFU, LOG_ERR,
             "Unrecognized parameter \"%s\"", argv[optind]);
     }
+    if (conf->nthreads_max == 0) {
+        conf->nthreads_max = conf->nthreads;
+    }
+    else if (conf->nthreads_max < conf->nthreads) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+            "Invalid value %d for max-threads: less than num-threads %d",
+            conf->nthreads_max, conf->nthreads);
+    }
 }
 
 
@@ -787,6 +914,10 @@ _conf_display_help (char *prog)
 
     printf ("\n");
 
+    printf ("  %*s %s [%d]\n", w, "--accept-threads=INT",
+            "Specify number of threads accepting connections",
+            MUNGE_ACCEPT_THREADS);
+
 #if defined(AUTH_METHOD_RECVFD_MKFIFO) || defined(AUTH_METHOD_RECVFD_MKNOD)
     printf ("  %*s %s [%s]\n", w, "--auth-server-dir=DIR",
             "Specify auth-server directory", MUNGE_AUTH_SERVER_DIR);
@@ -798,6 +929,21 @@ _conf_display_help (char *prog)
     printf ("  %*s %s\n", w, "--benchmark",
             "Disable timers to reduce noise while benchmarking");
 
+    printf ("  %*s %s\n", w, "--cpu-affinity=LIST",
+            "Bind daemon threads to CPU list (e.g., 0-3,8)");
+
+    printf ("  %*s %s\n", w, "--dec-queue-limit=INT",
+            "Specify queue depth at which decodes are shed");
+
+    printf ("  %*s %s\n", w, "--dict-file=PATH",
+            "Specify zstd compression dictionary file");
+
+    printf ("  %*s %s\n", w, "--early-replay-reject",
+            "Reject replayed creds before decrypting them");
+
+    printf ("  %*s %s\n", w, "--enc-queue-limit=INT",
+            "Specify queue depth at which encodes are shed");
+
     printf ("  %*s Specify whether to check \"%s\" mtime [%d]\n",
             w, "--group-check-mtime=BOOL", GIDS_GROUP_FILE,
             MUNGE_GROUP_STAT_FLAG);
@@ -812,9 +958,18 @@ _conf_display_help (char *prog)
     printf ("  %*s %s [%d]\n", w, "--listen-backlog=INT",
             "Specify listen backlog limit of socket", MUNGE_SOCKET_BACKLOG);
 
+    printf ("  %*s %s\n", w, "--log-aggregate=SECS",
+            "Summarize repeated request errors every SECS seconds");
+
+    printf ("  %*s %s\n", w, "--log-async",
+            "Write log file messages from a separate thread");
+
     printf ("  %*s %s [%s]\n", w, "--log-file=PATH",
             "Specify log file", MUNGE_LOGFILE_PATH);
 
+    printf ("  %*s %s [%s]\n", w, "--max-threads=INT",
+            "Specify maximum number of threads to spawn", "num-threads");
+
     printf ("  %*s %s [%d]\n", w, "--max-ttl=SECS",
             "Specify maximum time-to-live (in seconds)", MUNGE_MAXIMUM_TTL);
 
@@ -830,9 +985,17 @@ _conf_display_help (char *prog)
     printf ("  %*s %s [%s]\n", w, "--seed-file=PATH",
             "Specify PRNG seed file", MUNGE_SEEDFILE_PATH);
 
+#ifdef WITH_STAGE_TIMING
+    printf ("  %*s %s\n", w, "--stage-timing",
+            "Enable per-stage timing of requests");
+
+#endif /* WITH_STAGE_TIMING */
     printf ("  %*s %s\n", w, "--syslog",
             "Redirect log messages to syslog");
 
+    printf ("  %*s %s\n", w, "--timerfd",
+            "Dispatch timers from a timerfd in the accept loop");
+
     printf ("  %*s %s\n", w, "--trusted-group=GID",
             "Specify trusted group/GID for directory checks");
 
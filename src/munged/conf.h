@@ -43,14 +43,18 @@ struct conf {
     int             ld;                 /* listening socket descriptor       */
     unsigned        got_benchmark:1;    /* flag for BENCHMARK option         */
     unsigned        got_clock_skew:1;   /* flag for allowing clock skew      */
+    unsigned        got_early_replay:1; /* flag for rejecting replays early  */
     unsigned        got_force:1;        /* flag for FORCE option             */
     unsigned        got_foreground:1;   /* flag for FOREGROUND option        */
     unsigned        got_group_stat:1;   /* flag for gids stat'ing /etc/group */
+    unsigned        got_log_async:1;    /* flag for async logfile writes     */
     unsigned        got_stop:1;         /* flag for stopping daemon          */
     unsigned        got_mlockall:1;     /* flag for locking all memory pages */
     unsigned        got_root_auth:1;    /* flag if root can decode any cred  */
     unsigned        got_socket_retry:1; /* flag for allowing decode retries  */
+    unsigned        got_stage_timing:1; /* flag for enabling stage timing    */
     unsigned        got_syslog:1;       /* flag if logging to syslog instead */
+    unsigned        got_timerfd:1;      /* flag for dispatching via timerfd  */
     unsigned        got_verbose:1;      /* flag for being verbose            */
     munge_cipher_t  def_cipher;         /* default cipher type               */
     munge_zip_t     def_zip;            /* default compression type          */
@@ -65,8 +69,13 @@ struct conf {
     char           *pidfile_name;       /* daemon pidfile name               */
     char           *socket_name;        /* unix domain socket filename       */
     int             listen_backlog;     /* unix domain socket listen backlog */
+    int             accept_threads;     /* num threads for accepting conns   */
+    int             enc_queue_limit;    /* queue depth for shedding encodes  */
+    int             dec_queue_limit;    /* queue depth for shedding decodes  */
+    int             log_aggregate_secs; /* secs between error log summaries  */
     char           *seed_name;          /* random seed filename              */
     char           *key_name;           /* symmetric key filename            */
+    char           *dict_name;          /* zstd compression dict filename    */
     unsigned char  *dek_key;            /* subkey for cipher ops             */
     int             dek_key_len;        /* length of cipher subkey           */
     unsigned char  *mac_key;            /* subkey for mac ops                */
@@ -77,6 +86,8 @@ struct conf {
     gids_t          gids;               /* supplementary group information   */
     int             gids_update_secs;   /* gids update interval in seconds   */
     int             nthreads;           /* num threads for processing creds  */
+    int             nthreads_max;       /* max threads for processing creds  */
+    char           *cpu_list;           /* CPUs to which daemon is bound     */
     char           *auth_server_dir;    /* dir in which to create auth pipe  */
     char           *auth_client_dir;    /* dir in which to create auth file  */
     int             auth_rnd_bytes;     /* num rnd bytes in auth pipe name   */
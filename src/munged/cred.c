@@ -32,12 +32,39 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include "cipher.h"
 #include "cred.h"
 #include "m_msg.h"
+#include "mac.h"
 #include "munge_defs.h"
 #include "str.h"
 
 
+/*****************************************************************************
+ *  Private Data
+ *****************************************************************************/
+
+static int _cred_params_is_init = 0;
+
+static struct cred_params
+    _cred_params [MUNGE_CIPHER_LAST_ITEM] [MUNGE_MAC_LAST_ITEM];
+
+static unsigned char
+    _cred_params_is_valid [MUNGE_CIPHER_LAST_ITEM] [MUNGE_MAC_LAST_ITEM];
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static int _cred_params_compute (struct cred_params *p,
+    munge_cipher_t cipher, munge_mac_t mac);
+
+
+/*****************************************************************************
+ *  Extern Functions
+ *****************************************************************************/
+
 munge_cred_t
 cred_create (m_msg_t m)
 {
@@ -80,3 +107,123 @@ cred_destroy (munge_cred_t c)
     free (c);
     return;
 }
+
+
+/*  Precomputes the parameters for every valid combination of cipher and mac
+ *    types supported by the crypto library.
+ *  This must be called after the cipher and message digest subsystems have
+ *    been initialized, and before any threads are spawned.
+ */
+void
+cred_params_init (void)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < MUNGE_CIPHER_LAST_ITEM; i++) {
+        for (j = 0; j < MUNGE_MAC_LAST_ITEM; j++) {
+            _cred_params_is_valid[i][j] = (_cred_params_compute
+                (&_cred_params[i][j], (munge_cipher_t) i, (munge_mac_t) j)
+                == 0);
+        }
+    }
+    _cred_params_is_init = 1;
+    return;
+}
+
+
+/*  Returns the precomputed parameters for the combination of [cipher] and
+ *    [mac], or NULL if the combination is not valid.
+ *  A NULL return does not indicate which type is invalid; callers must check
+ *    the types individually to report an appropriate error.
+ */
+cred_params_t
+cred_params_get (munge_cipher_t cipher, munge_mac_t mac)
+{
+    if (!_cred_params_is_init) {
+        return (NULL);
+    }
+    if (((int) cipher < 0) || ((int) cipher >= MUNGE_CIPHER_LAST_ITEM)) {
+        return (NULL);
+    }
+    if (((int) mac < 0) || ((int) mac >= MUNGE_MAC_LAST_ITEM)) {
+        return (NULL);
+    }
+    if (!_cred_params_is_valid[cipher][mac]) {
+        return (NULL);
+    }
+    return (&_cred_params[cipher][mac]);
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+static int
+_cred_params_compute (struct cred_params *p,
+                      munge_cipher_t cipher, munge_mac_t mac)
+{
+/*  Computes the parameters [p] for the combination of [cipher] and [mac],
+ *    applying the same validation as the encode and decode paths.
+ *  Returns 0 if the combination is valid, or -1 if not.
+ */
+    int is_aead;
+
+    memset (p, 0, sizeof (*p));
+
+    if ((cipher == MUNGE_CIPHER_DEFAULT) || (mac == MUNGE_MAC_DEFAULT)) {
+        return (-1);
+    }
+    if ((cipher != MUNGE_CIPHER_NONE)
+            && (cipher_map_enum (cipher, NULL) < 0)) {
+        return (-1);
+    }
+    if ((mac == MUNGE_MAC_NONE) || (mac_map_enum (mac, NULL) < 0)) {
+        return (-1);
+    }
+    p->dek_len = mac_size (mac);
+    if ((p->dek_len <= 0) || (p->dek_len > MAX_DEK)) {
+        return (-1);
+    }
+    if (p->dek_len < cipher_key_size (cipher)) {
+        return (-1);
+    }
+    is_aead = cipher_is_aead (cipher);
+    p->version = is_aead ? MUNGE_CRED_VERSION_AEAD : MUNGE_CRED_VERSION;
+
+    if (cipher == MUNGE_CIPHER_NONE) {
+        p->iv_len = 0;
+        p->blk_len = 0;
+    }
+    else {
+        p->iv_len = cipher_iv_size (cipher);
+        if ((p->iv_len < 0) || (p->iv_len > MAX_IV)) {
+            return (-1);
+        }
+        p->blk_len = cipher_block_size (cipher);
+        if (p->blk_len <= 0) {
+            return (-1);
+        }
+    }
+    p->mac_len = is_aead ? cipher_tag_size (cipher) : p->dek_len;
+    if ((p->mac_len <= 0) || (p->mac_len > MAX_MAC)) {
+        return (-1);
+    }
+    /*  The fixed-size "outer" data excludes the compression dictionary ID
+     *    and the realm string since their lengths vary per cred.
+     */
+    assert (CRED_PARAMS_HDR_LEN == 3);
+    p->hdr[0] = p->version;
+    p->hdr[1] = (unsigned char) cipher;
+    p->hdr[2] = (unsigned char) mac;
+
+    p->outer_len = CRED_PARAMS_HDR_LEN;
+    p->outer_len += 1;                  /* zip type */
+    p->outer_len += 1;                  /* realm length */
+    if (is_aead) {
+        p->outer_len += MUNGE_CRED_SALT_LEN;
+    }
+    p->outer_len += p->iv_len;
+    return (0);
+}
@@ -40,22 +40,47 @@
  *****************************************************************************/
 
 /*  Current version of the munge credential format.
+ *  Credentials encrypted with an AEAD cipher use the AEAD version instead;
+ *    these are authenticated by the cipher's tag instead of a separate MAC.
  */
 #define MUNGE_CRED_VERSION              3
+#define MUNGE_CRED_VERSION_AEAD         4
 
 #define MAX_DEK                         MUNGE_MAXIMUM_MD_LEN
 #define MAX_IV                          MUNGE_MAXIMUM_BLK_LEN
 #define MAX_MAC                         MUNGE_MAXIMUM_MD_LEN
 #define MAX_SALT                        MUNGE_CRED_SALT_LEN
 
+/*  Length of the packed "outer" prefix of cred version, cipher type, and
+ *    mac type.
+ */
+#define CRED_PARAMS_HDR_LEN             3
+
 
 /*****************************************************************************
  *  Data Types
  *****************************************************************************/
 
+/*  Validated parameters for a combination of cipher and mac types.
+ *  These are precomputed by cred_params_init() so that encoding and decoding
+ *    need not pack, validate, and look up each type's properties per cred.
+ */
+struct cred_params {
+    uint8_t             version;        /* version of the munge cred format  */
+    unsigned char       hdr[CRED_PARAMS_HDR_LEN];   /* packed outer prefix   */
+    int                 outer_len;      /* length of fixed-size outer data   */
+    int                 iv_len;         /* length of iv data                 */
+    int                 mac_len;        /* length of mac data (or AEAD tag)  */
+    int                 dek_len;        /* length of dek data                */
+    int                 blk_len;        /* length of cipher block, or 0      */
+};
+
+typedef const struct cred_params * cred_params_t;
+
 struct munge_cred {
     uint8_t             version;        /* version of the munge cred format  */
     m_msg_t             msg;            /* ptr to corresponding munge msg    */
+    cred_params_t       params;         /* validated cipher & mac parameters */
     int                 outer_mem_len;  /* length of outer credential memory */
     unsigned char      *outer_mem;      /* outer cred memory allocation      */
     int                 outer_len;      /* length of outer credential data   */
@@ -68,13 +93,13 @@ struct munge_cred {
     unsigned char      *realm_mem;      /* realm string memory allocation    */
     int                 salt_len;       /* length of salt data               */
     unsigned char       salt[MAX_SALT]; /* cryptographic seasoning salt      */
-    int                 mac_len;        /* length of mac data                */
+    int                 mac_len;        /* length of mac data (or AEAD tag)  */
     unsigned char       mac[MAX_MAC];   /* message authentication code       */
     int                 dek_len;        /* length of dek data                */
     unsigned char       dek[MAX_DEK];   /* symmetric data encryption key     */
     int                 iv_len;         /* length of iv data                 */
     unsigned char       iv[MAX_IV];     /* initialization vector             */
-    unsigned char      *outer_zip_ref;  /* ref to zip_t in outer cred memory */
+    uint32_t            zip_dict_id;    /* compression dictionary ID, or 0   */
 };
 
 typedef struct munge_cred * munge_cred_t;
@@ -88,5 +113,9 @@ munge_cred_t cred_create (m_msg_t m);
 
 void cred_destroy (munge_cred_t c);
 
+void cred_params_init (void);
+
+cred_params_t cred_params_get (munge_cipher_t cipher, munge_mac_t mac);
+
 
 #endif /* !CRED_H */
@@ -45,12 +45,15 @@
 #include "crypto.h"
 #include "dec.h"
 #include "gids.h"
+#include "keyctx.h"
 #include "log.h"
 #include "m_msg.h"
 #include "mac.h"
 #include "munge_defs.h"
 #include "random.h"
 #include "replay.h"
+#include "stage.h"
+#include "stats.h"
 #include "str.h"
 #include "zip.h"
 
@@ -64,14 +67,19 @@ static int dec_timestamp (munge_cred_t c);
 static int dec_authenticate (munge_cred_t c);
 static int dec_check_retry (munge_cred_t c);
 static int dec_unarmor (munge_cred_t c);
+static int dec_binary (munge_cred_t c);
 static int dec_unpack_outer (munge_cred_t c);
+static int dec_unpack_outer_types (munge_cred_t c, unsigned char **pp,
+    int *lenp);
 static int dec_decrypt (munge_cred_t c);
+static int dec_decrypt_aead (munge_cred_t c);
 static int dec_validate_mac (munge_cred_t c);
 static int dec_decompress (munge_cred_t c);
 static int dec_unpack_inner (munge_cred_t c);
 static int dec_validate_time (munge_cred_t c);
 static int dec_validate_auth (munge_cred_t c);
 static int dec_validate_replay (munge_cred_t c);
+static int dec_probe_replay (munge_cred_t c);
 
 
 /*****************************************************************************
@@ -84,33 +92,40 @@ dec_process_msg (m_msg_t m)
     munge_cred_t c = NULL;              /* aux data for processing this cred */
     int          rc = -1;               /* return code                       */
 
-    if (dec_validate_msg (m) < 0)
+    STAGE_BEGIN ();
+
+    if (STAGE_TIMED (STAGE_DEC_VALIDATE, dec_validate_msg (m)) < 0)
         ;
     else if (!(c = cred_create (m)))
         ;
-    else if (dec_timestamp (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_TIMESTAMP, dec_timestamp (c)) < 0)
+        ;
+    else if (STAGE_TIMED (STAGE_DEC_AUTH, dec_authenticate (c)) < 0)
         ;
-    else if (dec_authenticate (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_RETRY, dec_check_retry (c)) < 0)
         ;
-    else if (dec_check_retry (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_UNARMOR,
+                ((m->type == MUNGE_MSG_DEC_BIN_REQ)
+                    || (m->type == MUNGE_MSG_DEC_BIN_VAL_REQ))
+                ? dec_binary (c) : dec_unarmor (c)) < 0)
         ;
-    else if (dec_unarmor (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_UNPACK_OUTER, dec_unpack_outer (c)) < 0)
         ;
-    else if (dec_unpack_outer (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_REPLAY_PROBE, dec_probe_replay (c)) < 0)
         ;
-    else if (dec_decrypt (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_DECRYPT, dec_decrypt (c)) < 0)
         ;
-    else if (dec_validate_mac (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_MAC, dec_validate_mac (c)) < 0)
         ;
-    else if (dec_decompress (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_DECOMPRESS, dec_decompress (c)) < 0)
         ;
-    else if (dec_unpack_inner (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_UNPACK_INNER, dec_unpack_inner (c)) < 0)
         ;
-    else if (dec_validate_auth (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_CHECK_AUTH, dec_validate_auth (c)) < 0)
         ;
-    else if (dec_validate_time (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_CHECK_TIME, dec_validate_time (c)) < 0)
         ;
-    else if (dec_validate_replay (c) < 0)
+    else if (STAGE_TIMED (STAGE_DEC_REPLAY, dec_validate_replay (c)) < 0)
         ;
     else /* success */
         rc = 0;
@@ -135,13 +150,17 @@ dec_process_msg (m_msg_t m)
      *    "first" client fails, that credential will then be marked as
      *    "unplayed", and the replayed reponse to the "second" client will now
      *    be in error.
+     *
+     *  A non-zero retry field in a response marks a shed request.
      */
+    m->retry = 0;
     if (m_msg_send (m, MUNGE_MSG_DEC_RSP, 0) != EMUNGE_SUCCESS) {
         if (rc == 0) {
             replay_remove (c);
         }
         rc = -1;
     }
+    STAGE_MARK (STAGE_DEC_SEND);
     cred_destroy (c);
     return (rc);
 }
@@ -160,7 +179,10 @@ dec_validate_msg (m_msg_t m)
  *    so no additional size check is needed here.
  */
     assert (m != NULL);
-    assert (m->type == MUNGE_MSG_DEC_REQ);
+    assert ((m->type == MUNGE_MSG_DEC_REQ)
+        || (m->type == MUNGE_MSG_DEC_BIN_REQ)
+        || (m->type == MUNGE_MSG_DEC_VAL_REQ)
+        || (m->type == MUNGE_MSG_DEC_BIN_VAL_REQ));
 
     if ((m->data_len == 0) || (m->data == NULL)) {
         return (m_msg_set_err (m, EMUNGE_SNAFU,
@@ -328,26 +350,56 @@ dec_unarmor (munge_cred_t c)
 }
 
 
+static int
+dec_binary (munge_cred_t c)
+{
+/*  Takes ownership of a binary credential from the "request data",
+ *    thereby avoiding a copy since it is already a packed byte array.
+ *  The binary credential consists of OUTER + MAC + INNER.
+ */
+    m_msg_t m = c->msg;
+
+    assert (m->data != NULL);
+    assert (m->data_len > 0);
+    assert (m->data_is_copy == 0);
+
+    c->outer_mem = m->data;
+    c->outer_mem_len = m->data_len;
+
+    m->data = NULL;
+    m->data_len = 0;
+
+    /*  Note outer_len is an upper bound which will be refined when unpacked.
+     *  It currently includes OUTER + MAC + INNER.
+     */
+    c->outer = c->outer_mem;
+    c->outer_len = c->outer_mem_len;
+    return (0);
+}
+
+
 static int
 dec_unpack_outer (munge_cred_t c)
 {
 /*  Unpacks the "outer" credential data from MSBF (ie, big endian) format.
  *  The "outer" part of the credential does not undergo cryptographic
  *    transformations (ie, compression and encryption).  It includes:
- *    cred version, cipher type, mac type, compression type, realm length,
- *    unterminated realm string (if realm_len > 0), and the cipher's
+ *    cred version, cipher type, mac type, compression type, compression
+ *    dictionary ID (if zstd compressed), realm length, unterminated realm
+ *    string (if realm_len > 0), salt (if AEAD encrypted), and the cipher's
  *    initialization vector (if encrypted).
  *  Validation of the "outer" credential occurs here as well since unpacking
  *    may not be able to continue if an invalid field is found.
- *  While the MAC is not technically part of the "outer" credential data,
- *    it is unpacked here since it resides in outer_mem and its location
- *    (along with the location of the "inner" data) is determined as a
- *    result of unpacking the "outer" data.
+ *  While the MAC (or AEAD tag) is not technically part of the "outer"
+ *    credential data, it is unpacked here since it resides in outer_mem
+ *    and its location (along with the location of the "inner" data) is
+ *    determined as a result of unpacking the "outer" data.
  */
     m_msg_t           m = c->msg;
     unsigned char    *p;                /* ptr into packed data              */
     int               len;              /* length of packed data remaining   */
     int               n;                /* all-purpose int                   */
+    uint32_t          u;                /* all-purpose uint32                */
 
     assert (c->outer != NULL);
 
@@ -356,86 +408,27 @@ dec_unpack_outer (munge_cred_t c)
     p = c->outer;
     len = c->outer_len;
     /*
-     *  Unpack the credential version.
-     *  Note that only one version (ie, the latest) of the credential format
-     *    is currently supported.  Support for multiple versions would
-     *    require a switch on the version number to invoke the appropriate
-     *    unpack routine, but it doesn't really seem worth the effort.
-     */
-    n = sizeof (c->version);
-    assert (n == 1);
-    if (n > len) {
-        return (m_msg_set_err (m, EMUNGE_BAD_CRED,
-            strdup ("Truncated credential version")));
-    }
-    c->version = *p;
-    if (c->version != MUNGE_CRED_VERSION) {
-        return (m_msg_set_err (m, EMUNGE_BAD_VERSION,
-            strdupf ("Invalid credential version %d", c->version)));
-    }
-    p += n;
-    len -= n;
-    /*
-     *  Unpack the cipher type.
+     *  Unpack the credential version, cipher type, and mac type.
+     *  A valid combination matches the packed prefix of its precomputed
+     *    params, which supply the lengths derived from these types.
+     *    Otherwise, each type is unpacked and validated individually.
      */
-    n = sizeof (m->cipher);
-    assert (n == 1);
-    if (n > len) {
-        return (m_msg_set_err (m, EMUNGE_BAD_CRED,
-            strdup ("Truncated cipher type")));
-    }
-    m->cipher = *p;
-    if (m->cipher == MUNGE_CIPHER_NONE) {
-        c->iv_len = 0;
-    }
-    else {
-        if (cipher_map_enum (m->cipher, NULL) < 0) {
-            return (m_msg_set_err (m, EMUNGE_BAD_CIPHER,
-                strdupf ("Invalid cipher type %d", m->cipher)));
-        }
-        c->iv_len = cipher_iv_size (m->cipher);
-        if (c->iv_len < 0) {
-            return (m_msg_set_err (m, EMUNGE_SNAFU,
-                strdupf ("Failed to determine IV length for cipher type %d",
-                m->cipher)));
-        }
-        assert (c->iv_len <= sizeof (c->iv));
-    }
-    p += n;
-    len -= n;
-    /*
-     *  Unpack the message authentication code type.
-     */
-    n = sizeof (m->mac);
-    assert (n == 1);
-    if (n > len) {
-        return (m_msg_set_err (m, EMUNGE_BAD_CRED,
-            strdup ("Truncated MAC type")));
-    }
-    m->mac = *p;
-    if (mac_map_enum (m->mac, NULL) < 0) {
-        return (m_msg_set_err (m, EMUNGE_BAD_MAC,
-            strdupf ("Invalid MAC type %d", m->mac)));
-    }
-    c->mac_len = mac_size (m->mac);
-    if (c->mac_len <= 0) {
-        return (m_msg_set_err (m, EMUNGE_SNAFU,
-            strdupf ("Failed to determine digest length for MAC type %d",
-            m->mac)));
+    if ((len >= CRED_PARAMS_HDR_LEN)
+            && (c->params = cred_params_get (p[1], p[2]))
+            && (memcmp (p, c->params->hdr, CRED_PARAMS_HDR_LEN) == 0)) {
+        c->version = c->params->version;
+        m->cipher = p[1];
+        m->mac = p[2];
+        c->iv_len = c->params->iv_len;
+        c->mac_len = c->params->mac_len;
+        p += CRED_PARAMS_HDR_LEN;
+        len -= CRED_PARAMS_HDR_LEN;
+    }
+    else if (dec_unpack_outer_types (c, &p, &len) < 0) {
+        return (-1);
     }
+    assert (c->iv_len <= sizeof (c->iv));
     assert (c->mac_len <= sizeof (c->mac));
-    p += n;
-    len -= n;
-    /*
-     *  Validate the message authentication code type against the cipher type
-     *    to ensure the HMAC will generate a DEK of sufficient length for the
-     *    cipher.
-     */
-    if (mac_size (m->mac) < cipher_key_size (m->cipher)) {
-        return (m_msg_set_err (m, EMUNGE_BAD_MAC,
-            strdupf ("Invalid MAC type %d with cipher type %d",
-            m->mac, m->cipher)));
-    }
     /*
      *  Unpack the compression type.
      */
@@ -457,6 +450,27 @@ dec_unpack_outer (munge_cred_t c)
     }
     p += n;
     len -= n;
+    /*
+     *  Unpack the compression dictionary ID.
+     */
+    if (m->zip == MUNGE_ZIP_ZSTD) {
+        n = sizeof (c->zip_dict_id);
+        assert (n == 4);
+        if (n > len) {
+            return (m_msg_set_err (m, EMUNGE_BAD_CRED,
+                strdup ("Truncated compression dictionary ID")));
+        }
+        memcpy (&u, p, n);              /* ensure proper byte-alignment */
+        c->zip_dict_id = ntohl (u);
+        if ((c->zip_dict_id != 0)
+                && (c->zip_dict_id != zip_dict_get_id (m->zip))) {
+            return (m_msg_set_err (m, EMUNGE_BAD_ZIP,
+                strdupf ("Invalid compression dictionary ID %u",
+                (unsigned) c->zip_dict_id)));
+        }
+        p += n;
+        len -= n;
+    }
     /*
      *  Unpack the length of realm string.
      */
@@ -497,6 +511,19 @@ dec_unpack_outer (munge_cred_t c)
         m->realm_len = c->realm_mem_len;
         m->realm_is_copy = 1;
     }
+    /*  Unpack the salt (if AEAD encrypted).
+     */
+    if (c->version == MUNGE_CRED_VERSION_AEAD) {
+        c->salt_len = MUNGE_CRED_SALT_LEN;
+        assert (c->salt_len <= sizeof (c->salt));
+        if (c->salt_len > len) {
+            return (m_msg_set_err (m, EMUNGE_BAD_CRED,
+                strdup ("Truncated salt")));
+        }
+        memcpy (c->salt, p, c->salt_len);
+        p += c->salt_len;
+        len -= c->salt_len;
+    }
     /*  Unpack the cipher initialization vector (if needed).
      *    The length of the IV was derived from the cipher type.
      */
@@ -531,6 +558,133 @@ dec_unpack_outer (munge_cred_t c)
 }
 
 
+static int
+dec_unpack_outer_types (munge_cred_t c, unsigned char **pp, int *lenp)
+{
+/*  Unpacks the cred version, cipher type, and mac type from the "outer"
+ *    credential data at [*pp] of length [*lenp], validating each type
+ *    individually in order to report which one is invalid.
+ *  On success, [*pp] and [*lenp] are advanced past these fields.
+ */
+    m_msg_t           m = c->msg;
+    unsigned char    *p = *pp;          /* ptr into packed data              */
+    int               len = *lenp;      /* length of packed data remaining   */
+    int               n;                /* all-purpose int                   */
+
+    /*  Unpack the credential version.
+     *  Note that only the latest version of the credential format and its
+     *    AEAD counterpart are supported.  These share the same layout except
+     *    for the location of the salt and the absence of a separate MAC.
+     */
+    n = sizeof (c->version);
+    assert (n == 1);
+    if (n > len) {
+        return (m_msg_set_err (m, EMUNGE_BAD_CRED,
+            strdup ("Truncated credential version")));
+    }
+    c->version = *p;
+    if ((c->version != MUNGE_CRED_VERSION)
+            && (c->version != MUNGE_CRED_VERSION_AEAD)) {
+        return (m_msg_set_err (m, EMUNGE_BAD_VERSION,
+            strdupf ("Invalid credential version %d", c->version)));
+    }
+    p += n;
+    len -= n;
+    /*
+     *  Unpack the cipher type.
+     */
+    n = sizeof (m->cipher);
+    assert (n == 1);
+    if (n > len) {
+        return (m_msg_set_err (m, EMUNGE_BAD_CRED,
+            strdup ("Truncated cipher type")));
+    }
+    m->cipher = *p;
+    if (m->cipher == MUNGE_CIPHER_NONE) {
+        c->iv_len = 0;
+    }
+    else {
+        if (cipher_map_enum (m->cipher, NULL) < 0) {
+            return (m_msg_set_err (m, EMUNGE_BAD_CIPHER,
+                strdupf ("Invalid cipher type %d", m->cipher)));
+        }
+        c->iv_len = cipher_iv_size (m->cipher);
+        if (c->iv_len < 0) {
+            return (m_msg_set_err (m, EMUNGE_SNAFU,
+                strdupf ("Failed to determine IV length for cipher type %d",
+                m->cipher)));
+        }
+        assert (c->iv_len <= sizeof (c->iv));
+    }
+    /*  AEAD ciphers are used by (and only by) the AEAD credential version.
+     */
+    if (cipher_is_aead (m->cipher)
+            != (c->version == MUNGE_CRED_VERSION_AEAD)) {
+        return (m_msg_set_err (m, EMUNGE_BAD_CIPHER,
+            strdupf ("Invalid cipher type %d for credential version %d",
+            m->cipher, c->version)));
+    }
+    p += n;
+    len -= n;
+    /*
+     *  Unpack the message authentication code type.
+     *  For the AEAD credential version, the MAC type is only used for
+     *    deriving the DEK; the AEAD tag takes the place of the MAC.
+     */
+    n = sizeof (m->mac);
+    assert (n == 1);
+    if (n > len) {
+        return (m_msg_set_err (m, EMUNGE_BAD_CRED,
+            strdup ("Truncated MAC type")));
+    }
+    m->mac = *p;
+    if (mac_map_enum (m->mac, NULL) < 0) {
+        return (m_msg_set_err (m, EMUNGE_BAD_MAC,
+            strdupf ("Invalid MAC type %d", m->mac)));
+    }
+    if (c->version == MUNGE_CRED_VERSION_AEAD) {
+        c->mac_len = cipher_tag_size (m->cipher);
+        if (c->mac_len <= 0) {
+            return (m_msg_set_err (m, EMUNGE_SNAFU,
+                strdupf ("Failed to determine tag length for cipher type %d",
+                m->cipher)));
+        }
+    }
+    else {
+        c->mac_len = mac_size (m->mac);
+        if (c->mac_len <= 0) {
+            return (m_msg_set_err (m, EMUNGE_SNAFU,
+                strdupf ("Failed to determine digest length for MAC type %d",
+                m->mac)));
+        }
+    }
+    assert (c->mac_len <= sizeof (c->mac));
+    p += n;
+    len -= n;
+    /*
+     *  Validate the message authentication code type against the cipher type
+     *    to ensure the HMAC will generate a DEK of sufficient length for the
+     *    cipher.
+     */
+    if (mac_size (m->mac) < cipher_key_size (m->cipher)) {
+        return (m_msg_set_err (m, EMUNGE_BAD_MAC,
+            strdupf ("Invalid MAC type %d with cipher type %d",
+            m->mac, m->cipher)));
+    }
+    /*  Look up the params for the types that were individually validated.
+     */
+    c->params = cred_params_get (m->cipher, m->mac);
+    if (c->params == NULL) {
+        return (m_msg_set_err (m, EMUNGE_SNAFU,
+            strdupf ("Failed to determine parameters for cipher type %d "
+            "with MAC type %d", m->cipher, m->mac)));
+    }
+    *pp = p;
+    *lenp = len;
+    return (0);
+}
+
+
 static int
 dec_decrypt (munge_cred_t c)
 {
@@ -563,19 +717,18 @@ dec_decrypt (munge_cred_t c)
     if (m->cipher == MUNGE_CIPHER_NONE) {
         return (0);
     }
+    if (c->version == MUNGE_CRED_VERSION_AEAD) {
+        return (dec_decrypt_aead (c));
+    }
     /*  Compute DEK.
      *  msg-dek = MAC (msg-mac) using DEK subkey
      */
-    c->dek_len = mac_size (m->mac);
-    if (c->dek_len <= 0) {
-        return (m_msg_set_err (m, EMUNGE_SNAFU,
-            strdupf ("Failed to determine DEK key length for MAC type %d",
-                m->mac)));
-    }
+    c->dek_len = c->params->dek_len;
+    assert (c->dek_len > 0);
     assert (c->dek_len <= sizeof (c->dek));
 
     n = c->dek_len;
-    if (mac_block (m->mac, conf->dek_key, conf->dek_key_len,
+    if (keyctx_mac_block (m->mac, conf->dek_key, conf->dek_key_len,
             c->dek, &n, c->mac, c->mac_len) < 0) {
         return (m_msg_set_err (m, EMUNGE_SNAFU,
             strdup ("Failed to compute DEK")));
@@ -586,19 +739,16 @@ dec_decrypt (munge_cred_t c)
     /*  Allocate memory for plaintext.
      *  Ensure enough space by allocating an additional cipher block.
      */
-    n = cipher_block_size (m->cipher);
-    if (n <= 0) {
-        return (m_msg_set_err (m, EMUNGE_SNAFU,
-            strdupf ("Failed to determine block size for cipher type %d",
-                m->cipher)));
-    }
+    n = c->params->blk_len;
+    assert (n > 0);
     buf_len = c->inner_len + n;
     if (!(buf = malloc (buf_len))) {
         return (m_msg_set_err (m, EMUNGE_NO_MEMORY, NULL));
     }
     /*  Decrypt "inner" data.
      */
-    if (cipher_init (&x, m->cipher, c->dek, c->iv, CIPHER_DECRYPT) < 0) {
+    if (keyctx_cipher_init (&x, m->cipher, c->dek, c->iv, CIPHER_DECRYPT)
+            < 0) {
         goto err;
     }
     buf_ptr = buf;
@@ -616,7 +766,7 @@ dec_decrypt (munge_cred_t c)
     }
     buf_ptr += n;
     n_written += n;
-    if (cipher_cleanup (&x) < 0) {
+    if (keyctx_cipher_cleanup (&x) < 0) {
         goto err;
     }
     assert (n_written <= buf_len);
@@ -632,7 +782,82 @@ dec_decrypt (munge_cred_t c)
     return (0);
 
 err_cleanup:
-    cipher_cleanup (&x);
+    keyctx_cipher_cleanup (&x);
+err:
+    memset (buf, 0, buf_len);
+    free (buf);
+    return (m_msg_set_err (m, EMUNGE_SNAFU,
+        strdup ("Failed to decrypt credential")));
+}
+
+
+static int
+dec_decrypt_aead (munge_cred_t c)
+{
+/*  Decrypts the "inner" credential data with an AEAD cipher in a single pass,
+ *    verifying the tag over both the "outer" and "inner" data.
+ *  Since the tag is verified before any plaintext is released, a credential
+ *    failing verification is rejected here instead of in dec_validate_mac().
+ */
+    m_msg_t           m = c->msg;
+    cipher_ctx        x;                /* AEAD cipher context               */
+    int               buf_len;          /* length of plaintext buffer        */
+    unsigned char    *buf;              /* plaintext buffer                  */
+    int               n;                /* all-purpose int                   */
+
+    /*  Compute DEK.
+     *  msg-dek = MAC (msg-salt) using DEK subkey
+     */
+    c->dek_len = c->params->dek_len;
+    assert (c->dek_len > 0);
+    assert (c->dek_len <= sizeof (c->dek));
+
+    n = c->dek_len;
+    if (keyctx_mac_block (m->mac, conf->dek_key, conf->dek_key_len,
+            c->dek, &n, c->salt, c->salt_len) < 0) {
+        return (m_msg_set_err (m, EMUNGE_SNAFU,
+            strdup ("Failed to compute DEK")));
+    }
+    assert (n <= c->dek_len);
+    assert (n >= cipher_key_size (m->cipher));
+
+    /*  Allocate memory for plaintext.
+     *  The plaintext is the same length as the ciphertext.
+     *  An empty ciphertext cannot be valid since the "inner" data is never
+     *    empty, but one byte is allocated regardless to avoid malloc(0).
+     */
+    buf_len = (c->inner_len > 0) ? c->inner_len : 1;
+    if (!(buf = malloc (buf_len))) {
+        return (m_msg_set_err (m, EMUNGE_NO_MEMORY, NULL));
+    }
+    /*  Decrypt "inner" data.
+     */
+    if (keyctx_aead_init (&x, m->cipher) < 0) {
+        goto err;
+    }
+    if (cipher_aead_decrypt (&x, c->dek, c->iv,
+            c->outer, c->outer_len, buf, c->inner, c->inner_len,
+            c->mac, c->mac_len) < 0) {
+        /*  The tag failed verification (or decryption failed outright).
+         *  This error takes precedence over the one set below.
+         */
+        m_msg_set_err (m, EMUNGE_CRED_INVALID, NULL);
+        goto err_cleanup;
+    }
+    if (keyctx_cipher_cleanup (&x) < 0) {
+        goto err;
+    }
+    /*  Replace "inner" ciphertext with plaintext.
+     */
+    assert (c->inner_mem == NULL);
+    assert (c->inner_mem_len == 0);
+    c->inner_mem = buf;
+    c->inner_mem_len = buf_len;
+    c->inner = buf;
+    return (0);
+
+err_cleanup:
+    keyctx_cipher_cleanup (&x);
 err:
     memset (buf, 0, buf_len);
     free (buf);
@@ -652,9 +877,15 @@ dec_validate_mac (munge_cred_t c)
     unsigned char  mac[MAX_MAC];        /* message authentication code       */
     int            n;                   /* all-purpose int                   */
 
+    /*  Was this credential already authenticated by its AEAD cipher?
+     */
+    if (c->version == MUNGE_CRED_VERSION_AEAD) {
+        return (0);
+    }
     /*  Compute MAC.
      */
-    if (mac_init (&x, m->mac, conf->mac_key, conf->mac_key_len) < 0) {
+    if (keyctx_mac_init (&x, m->mac, conf->mac_key, conf->mac_key_len)
+            < 0) {
         goto err;
     }
     if (mac_update (&x, c->outer, c->outer_len) < 0) {
@@ -667,7 +898,7 @@ dec_validate_mac (munge_cred_t c)
     if (mac_final (&x, mac, &n) < 0) {
         goto err_cleanup;
     }
-    if (mac_cleanup (&x) < 0) {
+    if (keyctx_mac_cleanup (&x) < 0) {
         goto err;
     }
     assert (n <= sizeof (mac));
@@ -686,7 +917,7 @@ dec_validate_mac (munge_cred_t c)
     return (0);
 
 err_cleanup:
-    mac_cleanup (&x);
+    keyctx_mac_cleanup (&x);
 err:
     return (m_msg_set_err (m, EMUNGE_SNAFU,
         strdup ("Failed to MAC credential")));
@@ -726,7 +957,8 @@ dec_decompress (munge_cred_t c)
     /*  Decompress "inner" data.
      */
     n = buf_len;
-    if (zip_decompress_block (m->zip, buf, &n, c->inner, c->inner_len) < 0) {
+    if (zip_decompress_block (m->zip, c->zip_dict_id,
+            buf, &n, c->inner, c->inner_len) < 0) {
         return (m_msg_set_err (m, EMUNGE_CRED_INVALID, NULL));
     }
     assert (n == buf_len);
@@ -756,8 +988,8 @@ dec_unpack_inner (munge_cred_t c)
 /*  Unpacks the "inner" credential data from MSBF (ie, big endian) format.
  *  The "inner" part of the credential may have been subjected to cryptographic
  *    transformations (ie, compression and encryption).  It includes:
- *    salt, ip addr len, origin ip addr, encode time, ttl, uid, gid,
- *    data length, and data (if present).
+ *    salt (if not AEAD encrypted), ip addr len, origin ip addr, encode time,
+ *    ttl, uid, gid, data length, and data (if present).
  *  Validation of the "inner" credential occurs here as well since unpacking
  *    may not be able to continue if an invalid field is found.
  *
@@ -779,21 +1011,25 @@ dec_unpack_inner (munge_cred_t c)
     p = c->inner;
     len = c->inner_len;
     /*
-     *  Unpack the salt.
+     *  Unpack the salt (if not AEAD encrypted).
      *  Add it to the PRNG entropy pool if it's encrypted.
+     *  The salt of an AEAD-encrypted credential was unpacked with the
+     *    "outer" data in the clear, so it is not added to the entropy pool.
      */
-    c->salt_len = MUNGE_CRED_SALT_LEN;
-    assert (c->salt_len <= sizeof (c->salt));
-    if (c->salt_len > len) {
-        return (m_msg_set_err (m, EMUNGE_BAD_CRED,
-            strdup ("Truncated salt")));
-    }
-    memcpy (c->salt, p, c->salt_len);
-    if (m->cipher != MUNGE_CIPHER_NONE) {
-        random_add (c->salt, c->salt_len);
+    if (c->version != MUNGE_CRED_VERSION_AEAD) {
+        c->salt_len = MUNGE_CRED_SALT_LEN;
+        assert (c->salt_len <= sizeof (c->salt));
+        if (c->salt_len > len) {
+            return (m_msg_set_err (m, EMUNGE_BAD_CRED,
+                strdup ("Truncated salt")));
+        }
+        memcpy (c->salt, p, c->salt_len);
+        if (m->cipher != MUNGE_CIPHER_NONE) {
+            random_add (c->salt, c->salt_len);
+        }
+        p += c->salt_len;
+        len -= c->salt_len;
     }
-    p += c->salt_len;
-    len -= c->salt_len;
     /*
      *  Unpack the length of the origin IP address.
      */
@@ -941,6 +1177,17 @@ dec_unpack_inner (munge_cred_t c)
         m->data = NULL;
     }
     assert (len == 0);
+    /*
+     *  Omit the payload from the response if the client only requested
+     *    the credential be validated.  The payload is still covered by the
+     *    MAC, and it cannot be left compressed since the compressed "inner"
+     *    data also contains the metadata above.
+     */
+    if ((m->type == MUNGE_MSG_DEC_VAL_REQ)
+            || (m->type == MUNGE_MSG_DEC_BIN_VAL_REQ)) {
+        m->data = NULL;
+        m->data_len = 0;
+    }
     return (0);
 }
 
@@ -964,7 +1211,8 @@ dec_validate_auth (munge_cred_t c)
     else if (m->auth_gid == m->client_gid) {
         return (0);
     }
-    else if (gids_is_member (conf->gids, m->client_uid, m->auth_gid)) {
+    else if (STAGE_TIMED (STAGE_DEC_GIDS,
+                gids_is_member (conf->gids, m->client_uid, m->auth_gid))) {
         return (0);
     }
 
@@ -1047,3 +1295,35 @@ dec_validate_replay (munge_cred_t c)
      */
     return (m_msg_set_err (m, EMUNGE_SNAFU, NULL));
 }
+
+
+static int
+dec_probe_replay (munge_cred_t c)
+{
+/*  Rejects a replayed credential before it is decrypted, MAC-validated, and
+ *    decompressed if early replay rejection is enabled.
+ *  This is only a lookup; the credential is inserted into the replay hash by
+ *    dec_validate_replay() after it has been fully validated.
+ *  Since the credential is not decoded, the response to an early-rejected
+ *    replay lacks the credential's metadata and payload.
+ */
+    m_msg_t  m = c->msg;
+
+    if (!conf->got_early_replay) {
+        return (0);
+    }
+    if ((conf->got_socket_retry)
+            && (m->retry > 0)
+            && (m->retry <= MUNGE_SOCKET_RETRY_ATTEMPTS)) {
+        return (0);
+    }
+    if (!replay_probe (c)) {
+        return (0);
+    }
+    stats_incr (STATS_REPLAY_EARLY);
+    /*  Reset the partially-unpacked message now since the response is not
+     *    sanitized for a replayed credential.
+     */
+    m_msg_reset (m);
+    return (m_msg_set_err (m, EMUNGE_CRED_REPLAYED, NULL));
+}
@@ -41,13 +41,17 @@
 #include "conf.h"
 #include "cred.h"
 #include "enc.h"
+#include "keyctx.h"
 #include "log.h"
 #include "m_msg.h"
 #include "mac.h"
 #include "munge_defs.h"
 #include "random.h"
+#include "stage.h"
+#include "stats.h"
 #include "str.h"
 #include "zip.h"
+#include "zipadapt.h"
 
 
 /*****************************************************************************
@@ -64,7 +68,9 @@ static int enc_pack_inner (munge_cred_t c);
 static int enc_compress (munge_cred_t c);
 static int enc_mac (munge_cred_t c);
 static int enc_encrypt (munge_cred_t c);
+static int enc_encrypt_aead (munge_cred_t c);
 static int enc_armor (munge_cred_t c);
+static int enc_binary (munge_cred_t c);
 static int enc_fini (munge_cred_t c);
 
 
@@ -78,31 +84,35 @@ enc_process_msg (m_msg_t m)
     munge_cred_t c = NULL;              /* aux data for processing this cred */
     int          rc = -1;               /* return code                       */
 
-    if (enc_validate_msg (m) < 0)
+    STAGE_BEGIN ();
+
+    if (STAGE_TIMED (STAGE_ENC_VALIDATE, enc_validate_msg (m)) < 0)
         ;
     else if (!(c = cred_create (m)))
         ;
-    else if (enc_init (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_INIT, enc_init (c)) < 0)
         ;
-    else if (enc_authenticate (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_AUTH, enc_authenticate (c)) < 0)
         ;
-    else if (enc_check_retry (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_RETRY, enc_check_retry (c)) < 0)
         ;
-    else if (enc_timestamp (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_TIMESTAMP, enc_timestamp (c)) < 0)
         ;
-    else if (enc_pack_outer (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_PACK_INNER, enc_pack_inner (c)) < 0)
         ;
-    else if (enc_pack_inner (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_COMPRESS, enc_compress (c)) < 0)
         ;
-    else if (enc_compress (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_PACK_OUTER, enc_pack_outer (c)) < 0)
         ;
-    else if (enc_mac (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_MAC, enc_mac (c)) < 0)
         ;
-    else if (enc_encrypt (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_ENCRYPT, enc_encrypt (c)) < 0)
         ;
-    else if (enc_armor (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_ARMOR,
+                (m->type == MUNGE_MSG_ENC_BIN_REQ)
+                ? enc_binary (c) : enc_armor (c)) < 0)
         ;
-    else if (enc_fini (c) < 0)
+    else if (STAGE_TIMED (STAGE_ENC_FINI, enc_fini (c)) < 0)
         ;
     else /* success */
         rc = 0;
@@ -113,9 +123,13 @@ enc_process_msg (m_msg_t m)
     if (rc != 0) {
         m_msg_reset (m);
     }
+    /*  A non-zero retry field in a response marks a shed request.
+     */
+    m->retry = 0;
     if (m_msg_send (m, MUNGE_MSG_ENC_RSP, 0) != EMUNGE_SUCCESS) {
         rc = -1;
     }
+    STAGE_MARK (STAGE_ENC_SEND);
     cred_destroy (c);
     return (rc);
 }
@@ -131,37 +145,37 @@ enc_validate_msg (m_msg_t m)
 /*  Validates message types, setting defaults and limits as needed.
  */
     assert (m != NULL);
-    assert (m->type == MUNGE_MSG_ENC_REQ);
+    assert ((m->type == MUNGE_MSG_ENC_REQ)
+        || (m->type == MUNGE_MSG_ENC_BIN_REQ));
 
-    /*  Validate cipher type.
-     */
     if (m->cipher == MUNGE_CIPHER_DEFAULT) {
         m->cipher = conf->def_cipher;
     }
-    else if (m->cipher == MUNGE_CIPHER_NONE) {
-        ; /* disable encryption */
+    if (m->mac == MUNGE_MAC_DEFAULT) {
+        m->mac = conf->def_mac;
     }
-    else if (cipher_map_enum (m->cipher, NULL) < 0) {
+    /*  A valid combination of cipher and MAC types has precomputed params.
+     *    Otherwise, check each type to determine which one is invalid.
+     */
+    if (cred_params_get (m->cipher, m->mac) != NULL) {
+        ; /* valid cipher & mac types */
+    }
+    else if ((m->cipher != MUNGE_CIPHER_NONE)
+            && (cipher_map_enum (m->cipher, NULL) < 0)) {
         return (m_msg_set_err (m, EMUNGE_BAD_CIPHER,
             strdupf ("Invalid cipher type %d", m->cipher)));
     }
-    /*  Validate message authentication code type.
-     *  Note that MUNGE_MAC_NONE is not valid -- MACs are REQUIRED!
+    /*  Note that MUNGE_MAC_NONE is not valid -- MACs are REQUIRED!
      */
-    if (m->mac == MUNGE_MAC_DEFAULT) {
-        m->mac = conf->def_mac;
-    }
-    else if (mac_map_enum (m->mac, NULL) < 0) {
+    else if ((m->mac == MUNGE_MAC_NONE) || (mac_map_enum (m->mac, NULL) < 0)) {
         return (m_msg_set_err (m, EMUNGE_BAD_MAC,
             strdupf ("Invalid MAC type %d", m->mac)));
     }
-    assert (m->mac != MUNGE_MAC_NONE);
-    /*
-     *  Validate the message authentication code type against the cipher type
+    /*  Validate the message authentication code type against the cipher type
      *    to ensure the HMAC will generate a DEK of sufficient length for the
      *    cipher.
      */
-    if (mac_size (m->mac) < cipher_key_size (m->cipher)) {
+    else {
         return (m_msg_set_err (m, EMUNGE_BAD_MAC,
             strdupf ("Invalid MAC type %d with cipher type %d",
             m->mac, m->cipher)));
@@ -214,6 +228,17 @@ enc_init (munge_cred_t c)
  */
     m_msg_t  m = c->msg;
 
+    /*  Look up the parameters for the cipher and MAC types.
+     *    These determine the credential format version and field lengths.
+     */
+    c->params = cred_params_get (m->cipher, m->mac);
+    if (c->params == NULL) {
+        return (m_msg_set_err (m, EMUNGE_SNAFU,
+            strdupf ("Failed to determine parameters for cipher type %d "
+            "with MAC type %d", m->cipher, m->mac)));
+    }
+    c->version = c->params->version;
+
     /*  Generate salt.
      */
     c->salt_len = MUNGE_CRED_SALT_LEN;
@@ -221,20 +246,10 @@ enc_init (munge_cred_t c)
 
     /*  Generate cipher initialization vector (if needed).
      */
-    if (m->cipher == MUNGE_CIPHER_NONE) {
-        c->iv_len = 0;
-    }
-    else {
-        c->iv_len = cipher_iv_size (m->cipher);
-        if (c->iv_len < 0) {
-            return (m_msg_set_err (m, EMUNGE_SNAFU,
-                strdupf ("Failed to determine IV length for cipher type %d",
-                m->cipher)));
-        }
-        if (c->iv_len > 0) {
-            assert (c->iv_len <= sizeof (c->iv));
-            random_pseudo_bytes (c->iv, c->iv_len);
-        }
+    c->iv_len = c->params->iv_len;
+    if (c->iv_len > 0) {
+        assert (c->iv_len <= sizeof (c->iv));
+        random_pseudo_bytes (c->iv, c->iv_len);
     }
     return (0);
 }
@@ -308,45 +323,50 @@ enc_pack_outer (munge_cred_t c)
 /*  Packs the "outer" credential data into MSBF (ie, big endian) format.
  *  The "outer" part of the credential does not undergo cryptographic
  *    transformations (ie, compression and encryption).  It includes:
- *    cred version, cipher type, mac type, compression type, realm length,
- *    unterminated realm string (if realm_len > 0), and the cipher's
+ *    cred version, cipher type, mac type, compression type, compression
+ *    dictionary ID (if zstd compressed), realm length, unterminated realm
+ *    string (if realm_len > 0), salt (if AEAD encrypted), and the cipher's
  *    initialization vector (if encrypted).
+ *  The salt of an AEAD-encrypted credential resides in the "outer" data
+ *    since it is needed to derive the DEK before decryption.
+ *  Since the compression type is reset if compression does not reduce the
+ *    size of the "inner" data, the "outer" data is packed afterwards.
  */
     m_msg_t        m = c->msg;
     unsigned char *p;                   /* ptr into packed data              */
+    uint32_t       u32;                 /* tmp for packing into MSBF         */
 
     assert (c->outer_mem == NULL);
+    assert (c->params != NULL);
 
-    c->outer_mem_len += sizeof (c->version);
-    c->outer_mem_len += sizeof (m->cipher);
-    c->outer_mem_len += sizeof (m->mac);
-    c->outer_mem_len += sizeof (m->zip);
-    c->outer_mem_len += sizeof (m->realm_len);
+    /*  The fixed-size portion of the "outer" data was precomputed along with
+     *    its packed prefix of cred version, cipher type, and mac type.
+     */
+    c->outer_mem_len = c->params->outer_len;
+    if (m->zip == MUNGE_ZIP_ZSTD) {
+        c->outer_mem_len += sizeof (c->zip_dict_id);
+    }
     c->outer_mem_len += m->realm_len;
-    c->outer_mem_len += c->iv_len;
     if (!(c->outer_mem = malloc (c->outer_mem_len))) {
         return (m_msg_set_err (m, EMUNGE_NO_MEMORY, NULL));
     }
     p = c->outer = c->outer_mem;
     c->outer_len = c->outer_mem_len;
 
-    assert (sizeof (c->version) == 1);
-    *p = c->version;
-    p += sizeof (c->version);
-
-    assert (sizeof (m->cipher) == 1);
-    *p = m->cipher;
-    p += sizeof (m->cipher);
-
-    assert (sizeof (m->mac) == 1);
-    *p = m->mac;
-    p += sizeof (m->mac);
+    memcpy (p, c->params->hdr, CRED_PARAMS_HDR_LEN);
+    p += CRED_PARAMS_HDR_LEN;
 
     assert (sizeof (m->zip) == 1);
-    c->outer_zip_ref = p;
     *p = m->zip;
     p += sizeof (m->zip);
 
+    if (m->zip == MUNGE_ZIP_ZSTD) {
+        assert (sizeof (c->zip_dict_id) == 4);
+        u32 = htonl (c->zip_dict_id);
+        memcpy (p, &u32, sizeof (c->zip_dict_id));
+        p += sizeof (c->zip_dict_id);
+    }
+
     assert (sizeof (m->realm_len) == 1);
     *p = m->realm_len;
     p += sizeof (m->realm_len);
@@ -355,6 +375,11 @@ enc_pack_outer (munge_cred_t c)
         memcpy (p, m->realm_str, m->realm_len);
         p += m->realm_len;
     }
+    if (c->version == MUNGE_CRED_VERSION_AEAD) {
+        assert (c->salt_len > 0);
+        memcpy (p, c->salt, c->salt_len);
+        p += c->salt_len;
+    }
     if (c->iv_len > 0) {
         memcpy (p, c->iv, c->iv_len);
         p += c->iv_len;
@@ -370,8 +395,8 @@ enc_pack_inner (munge_cred_t c)
 /*  Packs the "inner" credential data into MSBF (ie, big endian) format.
  *  The "inner" part of the credential may be subjected to cryptographic
  *    transformations (ie, compression and encryption).  It includes:
- *    salt, ip addr len, origin ip addr, encode time, ttl, uid, gid,
- *    data length, and data (if present).
+ *    salt (if not AEAD encrypted), ip addr len, origin ip addr, encode time,
+ *    ttl, uid, gid, data length, and data (if present).
  */
     m_msg_t        m = c->msg;
     unsigned char *p;                   /* ptr into packed data              */
@@ -379,7 +404,9 @@ enc_pack_inner (munge_cred_t c)
 
     assert (c->inner_mem == NULL);
 
-    c->inner_mem_len += c->salt_len;
+    if (c->version != MUNGE_CRED_VERSION_AEAD) {
+        c->inner_mem_len += c->salt_len;
+    }
     c->inner_mem_len += sizeof (m->addr_len);
     c->inner_mem_len += sizeof (m->addr);
     c->inner_mem_len += sizeof (m->time0);
@@ -396,10 +423,11 @@ enc_pack_inner (munge_cred_t c)
     p = c->inner = c->inner_mem;
     c->inner_len = c->inner_mem_len;
 
-    assert (c->salt_len > 0);
-    memcpy (p, c->salt, c->salt_len);
-    p += c->salt_len;
-
+    if (c->version != MUNGE_CRED_VERSION_AEAD) {
+        assert (c->salt_len > 0);
+        memcpy (p, c->salt, c->salt_len);
+        p += c->salt_len;
+    }
     assert (sizeof (m->addr_len) == 1);
     assert (sizeof (conf->addr) == sizeof (m->addr));
     assert (sizeof (conf->addr) < 256);
@@ -458,9 +486,10 @@ enc_compress (munge_cred_t c)
 /*  Compresses the "inner" credential data.
  *  If the compressed data is larger than the original data, the
  *    compressed buffer is discarded and compression is disabled.
- *    This requires resetting the compression type in the credential's
- *    "outer" data header.  And since that field is included in the MAC,
- *    compression must be attempted before the MAC is computed.
+ *    This requires resetting the compression type before it is packed into
+ *    the credential's "outer" data header.
+ *  Compression is not attempted if the payload appears incompressible, or if
+ *    recent payloads from the same client have failed to compress.
  */
     m_msg_t        m = c->msg;
     unsigned char *buf;                 /* compression buffer                */
@@ -472,6 +501,23 @@ enc_compress (munge_cred_t c)
     if (m->zip == MUNGE_ZIP_NONE) {
         return (0);
     }
+    /*  Should compression be skipped?  The payload is at the end of the
+     *    "inner" data.
+     */
+    assert (m->data_len <= c->inner_len);
+    if (zipadapt_is_skipped (m->client_uid, m->data_len)) {
+        stats_incr (STATS_ZIP_SKIP_CLIENT);
+        m->zip = MUNGE_ZIP_NONE;
+        return (0);
+    }
+    if (!zip_is_compressible (c->inner + c->inner_len - m->data_len,
+            m->data_len)) {
+        stats_incr (STATS_ZIP_SKIP_EST);
+        m->zip = MUNGE_ZIP_NONE;
+        return (0);
+    }
+    stats_incr (STATS_ZIP_ATTEMPT);
+
     /*  Allocate memory for compressed "inner" data.
      */
     buf = NULL;
@@ -485,16 +531,21 @@ enc_compress (munge_cred_t c)
     }
     /*  Compress "inner" data.
      */
+    c->zip_dict_id = zip_dict_get_id (m->zip);
     n = buf_len;
-    if (zip_compress_block (m->zip, buf, &n, c->inner, c->inner_len) < 0) {
+    if (zip_compress_block (m->zip, c->zip_dict_id,
+            buf, &n, c->inner, c->inner_len) < 0) {
         goto err;
     }
     /*  Disable compression and discard compressed data if it's larger.
      *    Replace "inner" data with compressed data if it's not.
      */
+    zipadapt_update (m->client_uid, m->data_len, (n < c->inner_len));
+
     if (n >= c->inner_len) {
+        stats_incr (STATS_ZIP_DISCARD);
         m->zip = MUNGE_ZIP_NONE;
-        *c->outer_zip_ref = m->zip;
+        c->zip_dict_id = 0;
         memset (buf, 0, buf_len);
         free (buf);
     }
@@ -530,20 +581,23 @@ enc_mac (munge_cred_t c)
     mac_ctx       x;                    /* message auth code context         */
     int           n;                    /* all-purpose int                   */
 
-    /*  Init MAC.
+    /*  Is this credential authenticated by its AEAD cipher instead?
+     *    If so, the tag is computed by enc_encrypt_aead().
      */
-    c->mac_len = mac_size (m->mac);
-    if (c->mac_len <= 0) {
-        return (m_msg_set_err (m, EMUNGE_SNAFU,
-            strdupf ("Failed to determine digest length for MAC type %d",
-                m->mac)));
+    if (c->version == MUNGE_CRED_VERSION_AEAD) {
+        return (0);
     }
+    /*  Init MAC.
+     */
+    c->mac_len = c->params->mac_len;
+    assert (c->mac_len > 0);
     assert (c->mac_len <= sizeof (c->mac));
     memset (c->mac, 0, c->mac_len);
 
     /*  Compute MAC.
      */
-    if (mac_init (&x, m->mac, conf->mac_key, conf->mac_key_len) < 0) {
+    if (keyctx_mac_init (&x, m->mac, conf->mac_key, conf->mac_key_len)
+            < 0) {
         goto err;
     }
     if (mac_update (&x, c->outer, c->outer_len) < 0) {
@@ -556,14 +610,14 @@ enc_mac (munge_cred_t c)
     if (mac_final (&x, c->mac, &n) < 0) {
         goto err_cleanup;
     }
-    if (mac_cleanup (&x) < 0) {
+    if (keyctx_mac_cleanup (&x) < 0) {
         goto err;
     }
     assert (n == c->mac_len);
     return (0);
 
 err_cleanup:
-    mac_cleanup (&x);
+    keyctx_mac_cleanup (&x);
 err:
     return (m_msg_set_err (m, EMUNGE_SNAFU,
         strdup ("Failed to MAC credential")));
@@ -588,19 +642,18 @@ enc_encrypt (munge_cred_t c)
     if (m->cipher == MUNGE_CIPHER_NONE) {
         return (0);
     }
+    if (c->version == MUNGE_CRED_VERSION_AEAD) {
+        return (enc_encrypt_aead (c));
+    }
     /*  Compute DEK.
      *  msg-dek = MAC (msg-mac) using DEK subkey
      */
-    c->dek_len = mac_size (m->mac);
-    if (c->dek_len <= 0) {
-        return (m_msg_set_err (m, EMUNGE_SNAFU,
-            strdupf ("Failed to determine DEK key length for MAC type %d",
-                m->mac)));
-    }
+    c->dek_len = c->params->dek_len;
+    assert (c->dek_len > 0);
     assert (c->dek_len <= sizeof (c->dek));
 
     n = c->dek_len;
-    if (mac_block (m->mac, conf->dek_key, conf->dek_key_len,
+    if (keyctx_mac_block (m->mac, conf->dek_key, conf->dek_key_len,
             c->dek, &n, c->mac, c->mac_len) < 0) {
         return (m_msg_set_err (m, EMUNGE_SNAFU,
             strdup ("Failed to compute DEK")));
@@ -611,19 +664,16 @@ enc_encrypt (munge_cred_t c)
     /*  Allocate memory for ciphertext.
      *  Ensure enough space by allocating an additional cipher block.
      */
-    n = cipher_block_size (m->cipher);
-    if (n <= 0) {
-        return (m_msg_set_err (m, EMUNGE_SNAFU,
-            strdupf ("Failed to determine block size for cipher type %d",
-                m->cipher)));
-    }
+    n = c->params->blk_len;
+    assert (n > 0);
     buf_len = c->inner_len + n;
     if (!(buf = malloc (buf_len))) {
         return (m_msg_set_err (m, EMUNGE_NO_MEMORY, NULL));
     }
     /*  Encrypt "inner" data.
      */
-    if (cipher_init (&x, m->cipher, c->dek, c->iv, CIPHER_ENCRYPT) < 0) {
+    if (keyctx_cipher_init (&x, m->cipher, c->dek, c->iv, CIPHER_ENCRYPT)
+            < 0) {
         goto err;
     }
     buf_ptr = buf;
@@ -640,7 +690,7 @@ enc_encrypt (munge_cred_t c)
     }
     buf_ptr += n;
     n_written += n;
-    if (cipher_cleanup (&x) < 0) {
+    if (keyctx_cipher_cleanup (&x) < 0) {
         goto err;
     }
     assert (n_written <= buf_len);
@@ -658,7 +708,85 @@ enc_encrypt (munge_cred_t c)
     return (0);
 
 err_cleanup:
-    cipher_cleanup (&x);
+    keyctx_cipher_cleanup (&x);
+err:
+    memset (buf, 0, buf_len);
+    free (buf);
+    return (m_msg_set_err (m, EMUNGE_SNAFU,
+        strdup ("Failed to encrypt credential")));
+}
+
+
+static int
+enc_encrypt_aead (munge_cred_t c)
+{
+/*  Encrypts the "inner" credential data with an AEAD cipher in a single pass.
+ *  The "outer" data is authenticated as additional data, and the resulting
+ *    tag takes the place of the MAC computed by enc_mac() for other ciphers.
+ */
+    m_msg_t           m = c->msg;
+    cipher_ctx        x;                /* AEAD cipher context               */
+    int               buf_len;          /* length of ciphertext buffer       */
+    unsigned char    *buf;              /* ciphertext buffer                 */
+    int               n;                /* all-purpose int                   */
+
+    /*  Compute DEK.
+     *  msg-dek = MAC (msg-salt) using DEK subkey
+     */
+    c->dek_len = c->params->dek_len;
+    assert (c->dek_len > 0);
+    assert (c->dek_len <= sizeof (c->dek));
+
+    n = c->dek_len;
+    if (keyctx_mac_block (m->mac, conf->dek_key, conf->dek_key_len,
+            c->dek, &n, c->salt, c->salt_len) < 0) {
+        return (m_msg_set_err (m, EMUNGE_SNAFU,
+            strdup ("Failed to compute DEK")));
+    }
+    assert (n <= c->dek_len);
+    assert (n >= cipher_key_size (m->cipher));
+
+    /*  Init tag.
+     */
+    c->mac_len = c->params->mac_len;
+    assert (c->mac_len > 0);
+    assert (c->mac_len <= sizeof (c->mac));
+
+    /*  Allocate memory for ciphertext.
+     *  The ciphertext is the same length as the plaintext.
+     */
+    assert (c->inner_len > 0);
+    buf_len = c->inner_len;
+    if (!(buf = malloc (buf_len))) {
+        return (m_msg_set_err (m, EMUNGE_NO_MEMORY, NULL));
+    }
+    /*  Encrypt "inner" data.
+     */
+    if (keyctx_aead_init (&x, m->cipher) < 0) {
+        goto err;
+    }
+    if (cipher_aead_encrypt (&x, c->dek, c->iv,
+            c->outer, c->outer_len, buf, c->inner, c->inner_len,
+            c->mac, c->mac_len) < 0) {
+        goto err_cleanup;
+    }
+    if (keyctx_cipher_cleanup (&x) < 0) {
+        goto err;
+    }
+    /*  Replace "inner" plaintext with ciphertext.
+     */
+    assert (c->inner_mem_len > 0);
+    memset (c->inner_mem, 0, c->inner_mem_len);
+    free (c->inner_mem);
+
+    c->inner_mem = buf;
+    c->inner_mem_len = buf_len;
+    c->inner = buf;
+    c->inner_len = buf_len;
+    return (0);
+
+err_cleanup:
+    keyctx_cipher_cleanup (&x);
 err:
     memset (buf, 0, buf_len);
     free (buf);
@@ -761,6 +889,53 @@ err:
 }
 
 
+static int
+enc_binary (munge_cred_t c)
+{
+/*  Packs the credential into a contiguous byte array without armor for
+ *    clients that requested a binary credential.
+ *  The binary credential consists of OUTER + MAC + INNER.
+ */
+    m_msg_t        m = c->msg;
+    int            buf_len;             /* length of binary data buffer      */
+    unsigned char *buf;                 /* binary data buffer                */
+    unsigned char *buf_ptr;             /* ptr into binary data buffer       */
+
+    buf_len = c->outer_len + c->mac_len + c->inner_len;
+
+    if (!(buf = malloc (buf_len))) {
+        return (m_msg_set_err (m, EMUNGE_NO_MEMORY, NULL));
+    }
+    buf_ptr = buf;
+    memcpy (buf_ptr, c->outer, c->outer_len);
+    buf_ptr += c->outer_len;
+    memcpy (buf_ptr, c->mac, c->mac_len);
+    buf_ptr += c->mac_len;
+    memcpy (buf_ptr, c->inner, c->inner_len);
+    buf_ptr += c->inner_len;
+    assert ((buf_ptr - buf) == buf_len);
+
+    /*  Replace "outer+inner" data with binary data.
+     */
+    assert (c->outer_mem_len > 0);
+    memset (c->outer_mem, 0, c->outer_mem_len);
+    free (c->outer_mem);
+
+    c->outer_mem = buf;
+    c->outer_mem_len = buf_len;
+    c->outer = buf;
+    c->outer_len = buf_len;
+
+    assert (c->inner_mem_len > 0);
+    memset (c->inner_mem, 0, c->inner_mem_len);
+    free (c->inner_mem);
+
+    c->inner_mem = NULL;
+    c->inner_mem_len = 0;
+    return (0);
+}
+
+
 static int
 enc_fini (munge_cred_t c)
 {
@@ -0,0 +1,352 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <arpa/inet.h>                  /* inet_ntop() */
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "errlog.h"
+#include "hash.h"
+#include "log.h"
+#include "timer.h"
+
+
+/*****************************************************************************
+ *  Private Constants
+ *****************************************************************************/
+
+#define ERRLOG_HASH_SIZE        257
+
+/*  Maximum number of distinct errors tracked per interval.  Errors beyond
+ *    this are logged individually.
+ */
+#define ERRLOG_MAX_ENTRIES      1024
+
+
+/*****************************************************************************
+ *  Private Data Types
+ *****************************************************************************/
+
+struct errlog_key {
+    munge_err_t         e;              /* error number                      */
+    uint32_t            uid;            /* UID of connecting client process  */
+    struct in_addr      addr;           /* IP addr where cred was encoded    */
+    unsigned int        msg_hash;       /* hash of message text              */
+    const char         *msg;            /* message text                      */
+};
+
+struct errlog_entry {
+    struct errlog_key   key;            /* hash key                          */
+    int                 priority;       /* priority at which error is logged */
+    int                 got_addr;       /* true if [key.addr] is known       */
+    unsigned long       n;              /* num repeats since last summary    */
+    char               *msg;            /* message text (owned by entry)     */
+};
+
+typedef struct errlog_entry * errlog_t;
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static void errlog_summarize (void *arg);
+
+static int errlog_summarize_entry (errlog_t x, void *key, void *arg);
+
+static void errlog_log (int priority, const char *msg, int got_addr,
+        const struct in_addr *addr, uint32_t uid, unsigned long n);
+
+static unsigned int errlog_key_f (const struct errlog_key *k);
+
+static int errlog_cmp_f (const struct errlog_key *k1,
+        const struct errlog_key *k2);
+
+static void errlog_free (errlog_t x);
+
+
+/*****************************************************************************
+ *  Private Variables
+ *****************************************************************************/
+
+static hash_t          errlog_hash = NULL;
+static int             errlog_secs = 0;
+static pthread_mutex_t errlog_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*****************************************************************************
+ *  Public Functions
+ *****************************************************************************/
+
+void
+errlog_init (int secs)
+{
+/*  Initializes aggregation of repeated request errors over intervals of
+ *    [secs] seconds.  If [secs] is 0, each error is logged individually.
+ *  Errors are keyed by (error number, client UID, origin IP address,
+ *    message text).  The first occurrence of an error is logged as usual;
+ *    repeats within the interval are counted and logged in a single summary
+ *    line at the end of the interval.  An error that does not recur within
+ *    an interval is forgotten so its next occurrence is again logged
+ *    individually.
+ */
+    hash_key_f keyf = (hash_key_f) errlog_key_f;
+    hash_cmp_f cmpf = (hash_cmp_f) errlog_cmp_f;
+    hash_del_f delf = (hash_del_f) errlog_free;
+
+    if ((secs <= 0) || (errlog_hash != NULL)) {
+        return;
+    }
+    if (!(errlog_hash = hash_create (ERRLOG_HASH_SIZE, keyf, cmpf, delf))) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to allocate error log hash");
+    }
+    errlog_secs = secs;
+
+    if (timer_set_relative (
+      (callback_f) errlog_summarize, NULL, errlog_secs * 1000) < 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to set error log summary timer");
+    }
+    log_msg (LOG_INFO, "Aggregating repeated request errors every %d second%s",
+        errlog_secs, ((errlog_secs == 1) ? "" : "s"));
+    return;
+}
+
+
+void
+errlog_fini (void)
+{
+/*  Terminates aggregation of request errors, logging a final summary.
+ *  As with replay_fini(), this must be invoked after timer_fini().
+ */
+    if (!errlog_hash) {
+        return;
+    }
+    errlog_secs = 0;
+    errlog_summarize (NULL);
+    hash_destroy (errlog_hash);
+    errlog_hash = NULL;
+    return;
+}
+
+
+void
+errlog_msg (int priority, munge_err_t e, uint32_t uid,
+        const struct in_addr *addr, const char *msg)
+{
+/*  Logs the error message [msg] at the specified [priority] level for
+ *    error [e] of a request from the client [uid].
+ *  If [addr] is non-NULL, it specifies the origin IP address of the
+ *    decoded credential, and is appended to the message.
+ */
+    struct errlog_key k;
+    errlog_t          x;
+    int               do_log = 1;
+
+    assert (msg != NULL);
+
+    if (errlog_hash) {
+        memset (&k, 0, sizeof (k));
+        k.e = e;
+        k.uid = uid;
+        if (addr) {
+            k.addr = *addr;
+        }
+        k.msg_hash = hash_key_string (msg);
+        k.msg = msg;
+        if ((errno = pthread_mutex_lock (&errlog_mutex)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to lock error log mutex");
+        }
+        if ((x = hash_find (errlog_hash, &k))) {
+            x->n++;
+            do_log = 0;
+        }
+        else if ((hash_count (errlog_hash) < ERRLOG_MAX_ENTRIES)
+                && (x = malloc (sizeof (*x)))) {
+            x->key = k;
+            x->priority = priority;
+            x->got_addr = (addr != NULL);
+            x->n = 0;
+            x->msg = strdup (msg);
+            x->key.msg = x->msg;
+            if (!x->msg || !hash_insert (errlog_hash, &x->key, x)) {
+                errlog_free (x);
+            }
+        }
+        if ((errno = pthread_mutex_unlock (&errlog_mutex)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to unlock error log mutex");
+        }
+    }
+    if (do_log) {
+        errlog_log (priority, msg, (addr != NULL), addr, uid, 0);
+    }
+    return;
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+static void
+errlog_summarize (void *arg)
+{
+/*  Logs a summary line for each error that recurred during the interval,
+ *    and forgets those that did not.
+ *  The timer is reset for the next interval unless aggregation is being
+ *    terminated.
+ */
+    if (!errlog_hash) {
+        return;
+    }
+    if ((errno = pthread_mutex_lock (&errlog_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock error log mutex");
+    }
+    (void) hash_delete_if (errlog_hash,
+            (hash_arg_f) errlog_summarize_entry, NULL);
+
+    if ((errno = pthread_mutex_unlock (&errlog_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock error log mutex");
+    }
+    if (errlog_secs > 0) {
+        if (timer_set_relative (
+          (callback_f) errlog_summarize, NULL, errlog_secs * 1000) < 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to set error log summary timer");
+        }
+    }
+    return;
+}
+
+
+static int
+errlog_summarize_entry (errlog_t x, void *key, void *arg)
+{
+/*  Logs a summary for the error entry [x] if it has repeated since the
+ *    last summary.
+ *  Returns non-zero if [x] should be removed from the hash (ie, it did not
+ *    repeat).
+ */
+    if (x->n == 0) {
+        return (1);
+    }
+    errlog_log (x->priority, x->msg, x->got_addr, &x->key.addr, x->key.uid,
+            x->n);
+    x->n = 0;
+    return (0);
+}
+
+
+static void
+errlog_log (int priority, const char *msg, int got_addr,
+        const struct in_addr *addr, uint32_t uid, unsigned long n)
+{
+/*  Logs the error message [msg] at the specified [priority] level, appending
+ *    the origin IP address [addr] if [got_addr] is set.
+ *  If [n] is non-zero, the message is a summary of [n] repeats by [uid].
+ */
+    char        buf [INET_ADDRSTRLEN];
+    const char *ip_addr_str = NULL;
+
+    if (got_addr) {
+        ip_addr_str = inet_ntop (AF_INET, addr, buf, sizeof (buf));
+    }
+    if (n == 0) {
+        if (ip_addr_str != NULL) {
+            log_msg (priority, "%s from %s", msg, ip_addr_str);
+        }
+        else {
+            log_msg (priority, "%s", msg);
+        }
+    }
+    else if (ip_addr_str != NULL) {
+        log_msg (priority, "%s from %s: repeated %lu time%s for UID %u",
+            msg, ip_addr_str, n, ((n == 1) ? "" : "s"), (unsigned int) uid);
+    }
+    else {
+        log_msg (priority, "%s: repeated %lu time%s for UID %u",
+            msg, n, ((n == 1) ? "" : "s"), (unsigned int) uid);
+    }
+    return;
+}
+
+
+static unsigned int
+errlog_key_f (const struct errlog_key *k)
+{
+/*  Combines the error number, UID, IP address, and message hash into a
+ *    hash value.
+ */
+    return ((unsigned int) k->e * 31U * 31U * 31U
+            + (unsigned int) k->uid * 31U * 31U
+            + (unsigned int) k->addr.s_addr * 31U
+            + k->msg_hash);
+}
+
+
+static int
+errlog_cmp_f (const struct errlog_key *k1, const struct errlog_key *k2)
+{
+/*  Returns an integer that is less than zero if [k1] is less than [k2],
+ *    equal to zero if [k1] is equal to [k2], and greater than zero
+ *    if [k1] is greater than [k2].
+ */
+    if (k1->e != k2->e) {
+        return ((k1->e < k2->e) ? -1 : 1);
+    }
+    if (k1->uid != k2->uid) {
+        return ((k1->uid < k2->uid) ? -1 : 1);
+    }
+    if (k1->addr.s_addr != k2->addr.s_addr) {
+        return ((k1->addr.s_addr < k2->addr.s_addr) ? -1 : 1);
+    }
+    if (k1->msg_hash != k2->msg_hash) {
+        return ((k1->msg_hash < k2->msg_hash) ? -1 : 1);
+    }
+    return (strcmp (k1->msg, k2->msg));
+}
+
+
+static void
+errlog_free (errlog_t x)
+{
+/*  De-allocates the error entry [x].
+ */
+    if (x) {
+        free (x->msg);
+        free (x);
+    }
+    return;
+}
@@ -320,6 +320,32 @@ gids_is_member (gids_t gids, uid_t uid, gid_t gid)
 }
 
 
+/*  Gets the number of UIDs with supplementary groups in the GIDs mapping
+ *    [gids] in [n_uids], and the time of its last update in [t_update].
+ *  Returns 0 on success, or -1 if the mapping is disabled.
+ */
+int
+gids_get_stats (gids_t gids, int *n_uids, time_t *t_update)
+{
+    if (!gids) {
+        return (-1);
+    }
+    if ((errno = pthread_mutex_lock (&gids->mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock gids mutex");
+    }
+    if (n_uids) {
+        *n_uids = (gids->gid_hash) ? hash_count (gids->gid_hash) : 0;
+    }
+    if (t_update) {
+        *t_update = gids->t_last_update;
+    }
+    if ((errno = pthread_mutex_unlock (&gids->mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock gids mutex");
+    }
+    return (0);
+}
+
+
 /*****************************************************************************
  *  Private Functions
  *****************************************************************************/
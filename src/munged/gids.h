@@ -29,6 +29,9 @@
 #define GIDS_H
 
 
+#include <sys/types.h>
+
+
 /*****************************************************************************
  *  Constants
  *****************************************************************************/
@@ -58,5 +61,7 @@ void gids_update (gids_t gids);
 
 int gids_is_member (gids_t gids, uid_t uid, gid_t gid);
 
+int gids_get_stats (gids_t gids, int *n_uids, time_t *t_update);
+
 
 #endif /* !GIDS_H */
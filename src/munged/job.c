@@ -29,24 +29,31 @@
 #  include "config.h"
 #endif /* HAVE_CONFIG_H */
 
-#include <arpa/inet.h>                  /* inet_ntop() */
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <munge.h>
-#include <netinet/in.h>                 /* INET_ADDRSTRLEN */
+#include <poll.h>
+#include <pthread.h>
 #include <signal.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include "common.h"
 #include "conf.h"
 #include "dec.h"
 #include "enc.h"
+#include "errlog.h"
 #include "fd.h"
 #include "job.h"
 #include "log.h"
 #include "m_msg.h"
 #include "munge_defs.h"
+#include "stage.h"
+#include "stats.h"
 #include "str.h"
+#include "timer.h"
 #include "work.h"
 
 
@@ -56,6 +63,41 @@
 
 extern volatile sig_atomic_t got_reconfig;      /* defined in munged.c       */
 extern volatile sig_atomic_t got_terminate;     /* defined in munged.c       */
+#ifdef WITH_STAGE_TIMING
+extern volatile sig_atomic_t got_stage_toggle;  /* defined in munged.c       */
+#endif /* WITH_STAGE_TIMING */
+
+
+/*****************************************************************************
+ *  Private Data Types
+ *****************************************************************************/
+
+typedef struct job_accept_arg {
+    conf_t              conf;           /* configuration                     */
+    work_p              workers;        /* work crew for processing requests */
+    int                 do_poll;        /* flag to poll before accepting     */
+} job_accept_arg_t;
+
+typedef struct job_accept_state {
+    int                 last_log_errno; /* errno of last logged accept error */
+    time_t              last_log_time;  /* time of last logged accept error  */
+    int                 spare_fd;       /* fd reserved for rejecting conns   */
+} job_accept_state_t;
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static void * _job_accept_thread (void *arg);
+static void   _job_accept_poll (conf_t conf, work_p workers,
+                  job_accept_state_t *state, int tfd);
+static void   _job_accept_conn (conf_t conf, work_p workers,
+                  job_accept_state_t *state);
+static void   _job_accept_reject (conf_t conf, job_accept_state_t *state,
+                  int errnum);
+static void   _job_queue (conf_t conf, work_p workers, m_msg_t m);
+static void   _job_shed (m_msg_t m, m_msg_type_t type, work_p workers);
 
 
 /*****************************************************************************
@@ -64,22 +106,59 @@ extern volatile sig_atomic_t got_terminate;     /* defined in munged.c       */
 
 /*  Accept client connections and queue requests to the workers.
  *  Handle SIGHUP (for configuration reloads) and exit on SIGINT/SIGTERM.
+ *  If stage timing support is compiled in, SIGUSR1 toggles stage timing;
+ *    the accumulated stage times are logged when it is disabled.
+ *  If more than one accept thread is configured, the additional threads
+ *    accept connections on the same listening socket; only the calling
+ *    thread handles signals.
+ *  If timers are driven by a timerfd, the calling thread polls it alongside
+ *    the listening socket and dispatches expired timers itself.  The socket
+ *    is then set non-blocking so a connection taken by another accept thread
+ *    cannot leave this thread blocked in accept() past a timer expiration.
  */
 void
 job_accept (conf_t conf, work_p workers)
 {
-    m_msg_t m;
-    int sd;
-    int curr_errno;
-    time_t curr_time;
-    int last_log_errno = 0;
-    time_t last_log_time = 0;
-    const int log_limit_secs = 300;
+    job_accept_arg_t   arg;
+    job_accept_state_t state;
+    pthread_t         *tids = NULL;
+    int                n_tids = 0;
+    int                tfd;
+    int                i;
 
     assert (conf != NULL);
     assert (conf->ld >= 0);
+    assert (conf->accept_threads > 0);
     assert (workers != NULL);
 
+    tfd = timer_get_fd ();
+    arg.conf = conf;
+    arg.workers = workers;
+    arg.do_poll = (tfd >= 0);
+    state.last_log_errno = 0;
+    state.last_log_time = 0;
+    state.spare_fd = open ("/dev/null", O_RDONLY);
+
+    if ((tfd >= 0) && (fd_set_nonblocking (conf->ld) < 0)) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to set nonblocking listening socket");
+    }
+    if (conf->accept_threads > 1) {
+        n_tids = conf->accept_threads - 1;
+        if (!(tids = malloc (sizeof (*tids) * n_tids))) {
+            log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+                "Failed to allocate tid array for accept threads");
+        }
+        for (i = 0; i < n_tids; i++) {
+            if ((errno = pthread_create
+                        (&tids[i], NULL, _job_accept_thread, &arg)) != 0) {
+                log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to create accept thread #%d", i+1);
+            }
+        }
+        log_msg (LOG_INFO, "Created %d accept threads",
+                conf->accept_threads);
+    }
     while (!got_terminate) {
         if (got_reconfig) {
             log_msg (LOG_NOTICE, "Processing signal %d (%s)",
@@ -87,84 +166,48 @@ job_accept (conf_t conf, work_p workers)
             got_reconfig = 0;
             gids_update (conf->gids);
         }
-        sd = accept (conf->ld, NULL, NULL);
-        if (sd < 0) {
-            /*  Handle accept() failure.
-             *  Transient errors are ignored and retried.
-             *  Resource exhaustion errors trigger throttled logging and
-             *    backlog processing to prevent log flooding while allowing
-             *    the system to recover.
-             *  ENOMEM here often indicates socket buffer exhaustion rather
-             *    than general memory depletion, and processing the backlog
-             *    may free socket resources.  This differs from its typical
-             *    handling where memory exhaustion is treated as fatal.
-             *  All other errors are considered fatal.
-             */
-            switch (errno) {
-                case ECONNABORTED:
-                case EINTR:
-                    continue;
-                case EMFILE:
-                case ENFILE:
-                case ENOBUFS:
-                case ENOMEM:
-                    /*  Preserve errno before calling time().
-                     */
-                    curr_errno = errno;
-                    curr_time = time (NULL);
-                    if (curr_time == (time_t) -1) {
-                        log_errno (EMUNGE_SNAFU, LOG_ERR,
-                                "Failed to query current time");
-                    }
-                    /*  Log if sufficient time has elapsed since last log, or
-                     *    if errno has changed (different resource exhausted).
-                     */
-                    if ((curr_time - last_log_time > log_limit_secs) ||
-                            (curr_errno != last_log_errno)) {
-                        log_msg (LOG_WARNING,
-                                "Failed to accept connection: %s",
-                                strerror (curr_errno));
-                        last_log_errno = curr_errno;
-                        last_log_time = curr_time;
-                    }
-                    /*  Process backlog before accepting new connections.
-                    */
-                    work_wait (workers);
-                    continue;
-                default:
-                    log_errno (EMUNGE_SNAFU, LOG_ERR,
-                            "Failed to accept connection");
-                    break;
+#ifdef WITH_STAGE_TIMING
+        if (got_stage_toggle) {
+            got_stage_toggle = 0;
+            if (stage_is_enabled ()) {
+                stage_set_enabled (0);
+                stage_log (LOG_NOTICE);
+                stage_reset ();
+                log_msg (LOG_NOTICE, "Disabled stage timing");
+            }
+            else {
+                stage_set_enabled (1);
+                log_msg (LOG_NOTICE, "Enabled stage timing");
             }
         }
-        /*  Handle successful accept().
-         *  Set the client socket non-blocking to guard against spurious
-         *    readiness notifications that could cause functions to block.
-         *  Create, bind, and queue message to the workers for processing.
-         *
-         *  Note: Throttle state is not reset here to avoid excessive logging
-         *    during oscillating resource exhaustion.  The errno change
-         *    detection handles transitions between different resource types.
-         */
-        if (fd_set_nonblocking (sd) < 0) {
-            close (sd);
-            log_msg (LOG_WARNING,
-                    "Failed to set nonblocking client socket: %s",
-                    strerror (errno));
+#endif /* WITH_STAGE_TIMING */
+        if (tfd >= 0) {
+            _job_accept_poll (conf, workers, &state, tfd);
         }
-        else if (m_msg_create (&m) != EMUNGE_SUCCESS) {
-            close (sd);
-            log_msg (LOG_WARNING, "Failed to create client request");
+        else {
+            _job_accept_conn (conf, workers, &state);
         }
-        else if (m_msg_bind (m, sd) != EMUNGE_SUCCESS) {
-            m_msg_destroy (m);
-            log_msg (LOG_WARNING, "Failed to bind socket for client request");
+    }
+    /*  Stop the additional accept thread(s).
+     *  These are canceled since they are likely blocked in accept().
+     */
+    for (i = 0; i < n_tids; i++) {
+        if ((errno = pthread_cancel (tids[i])) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to cancel accept thread #%d", i+1);
         }
-        else if (work_queue (workers, m) < 0) {
-            m_msg_destroy (m);
-            log_msg (LOG_WARNING, "Failed to queue client request");
+    }
+    for (i = 0; i < n_tids; i++) {
+        if ((errno = pthread_join (tids[i], NULL)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to join accept thread #%d", i+1);
         }
     }
+    free (tids);
+    if (state.spare_fd >= 0) {
+        (void) close (state.spare_fd);
+    }
+
     log_msg (LOG_NOTICE, "Exiting on signal %d (%s)",
             got_terminate, strsignal (got_terminate));
 }
@@ -177,25 +220,41 @@ job_exec (m_msg_t m)
 {
     munge_err_t e;
     const char *err_msg;
-    const char *ip_addr_str;
+    uint64_t    t_start;
 
     assert (m != NULL);
 
+    t_start = stats_time ();
+    STAGE_BEGIN ();
     e = m_msg_recv (m, MUNGE_MSG_UNDEF, MUNGE_MAXIMUM_REQ_LEN);
+    STAGE_MARK (STAGE_RECV);
     if (e == EMUNGE_SUCCESS) {
         switch (m->type) {
             case MUNGE_MSG_ENC_REQ:
+            case MUNGE_MSG_ENC_BIN_REQ:
                 enc_process_msg (m);
+                stats_request (STATS_REQ_ENC, m->error_num, t_start);
                 break;
             case MUNGE_MSG_DEC_REQ:
+            case MUNGE_MSG_DEC_BIN_REQ:
+            case MUNGE_MSG_DEC_VAL_REQ:
+            case MUNGE_MSG_DEC_BIN_VAL_REQ:
                 dec_process_msg (m);
+                stats_request (STATS_REQ_DEC, m->error_num, t_start);
+                break;
+            case MUNGE_MSG_STATS_REQ:
+                stats_process_msg (m);
                 break;
             default:
                 m_msg_set_err (m, EMUNGE_SNAFU,
                         strdupf ("Invalid message type %d", m->type));
+                stats_incr (STATS_BAD_REQ);
                 break;
         }
     }
+    else {
+        stats_incr (STATS_RECV_ERR);
+    }
     /*  Some errors indicate the credential was successfully decoded but
      *    rejected for policy reasons.  In these cases, the origin IP address
      *    is available from the decoded credential and logged to identify the
@@ -204,32 +263,379 @@ job_exec (m_msg_t m)
      *    perspective.  This is a temporary mitigation until this error
      *    handling can be moved into munged itself.  Other errors are logged
      *    at the typical LOG_INFO.
+     *  Repeats of the same error for the same client UID and origin IP
+     *    address may be aggregated into periodic summaries (see errlog.c).
      */
     if (m->error_num != EMUNGE_SUCCESS) {
         err_msg = (m->error_str != NULL)
                 ? m->error_str
                 : munge_strerror (m->error_num);
-        ip_addr_str = NULL;
         switch (m->error_num) {
             case EMUNGE_CRED_EXPIRED:
             case EMUNGE_CRED_REWOUND:
             case EMUNGE_CRED_REPLAYED:
-                if (m->addr_len == 4) {
-                    char buf[INET_ADDRSTRLEN];
-                    ip_addr_str = inet_ntop (AF_INET, &m->addr,
-                            buf, sizeof buf);
-                }
-                if (ip_addr_str != NULL) {
-                    log_msg (LOG_DEBUG, "%s from %s", err_msg, ip_addr_str);
+                errlog_msg (LOG_DEBUG, m->error_num, m->client_uid,
+                        ((m->addr_len == 4) ? &m->addr : NULL), err_msg);
+                break;
+            default:
+                errlog_msg (LOG_INFO, m->error_num, m->client_uid,
+                        NULL, err_msg);
+                break;
+        }
+    }
+    m_msg_destroy (m);
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+static void *
+_job_accept_thread (void *arg)
+{
+/*  An additional accept thread.  It continually accepts client connections
+ *    on the shared listening socket -- until it's canceled.
+ *  All signals are blocked so they will be delivered to the main thread.
+ */
+    job_accept_arg_t   *argp;
+    job_accept_state_t  state;
+    sigset_t            sigset;
+    int                 cancel_state;
+
+    assert (arg != NULL);
+    argp = arg;
+    state.last_log_errno = 0;
+    state.last_log_time = 0;
+    state.spare_fd = open ("/dev/null", O_RDONLY);
+
+    if (sigfillset (&sigset)) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to init accept thread sigset");
+    }
+    if (pthread_sigmask (SIG_SETMASK, &sigset, NULL) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to set accept thread sigset");
+    }
+    /*  Cancellation is only enabled while blocked in accept().
+     */
+    if ((errno = pthread_setcancelstate
+                (PTHREAD_CANCEL_DISABLE, &cancel_state)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to disable accept thread cancellation");
+    }
+    for (;;) {
+        if (argp->do_poll) {
+            _job_accept_poll (argp->conf, argp->workers, &state, -1);
+        }
+        else {
+            _job_accept_conn (argp->conf, argp->workers, &state);
+        }
+    }
+    return (NULL);
+}
+
+
+static void
+_job_accept_poll (conf_t conf, work_p workers, job_accept_state_t *state,
+        int tfd)
+{
+/*  Wait for a client connection on the non-blocking listening socket or the
+ *    expiration of a timer on the timerfd [tfd] (if >= 0), then accept the
+ *    connection and/or dispatch the expired timers.
+ *  As with accept(), cancellation is enabled for the duration of poll().
+ */
+    struct pollfd pfd[2];
+    int           n;
+    int           cancel_state;
+    int           curr_errno;
+
+    assert (conf != NULL);
+    assert (workers != NULL);
+    assert (state != NULL);
+
+    pfd[0].fd = conf->ld;
+    pfd[0].events = POLLIN;
+    pfd[0].revents = 0;
+    pfd[1].fd = tfd;                    /* ignored by poll() if negative     */
+    pfd[1].events = POLLIN;
+    pfd[1].revents = 0;
+
+    (void) pthread_setcancelstate (PTHREAD_CANCEL_ENABLE, &cancel_state);
+    n = poll (pfd, 2, -1);
+    curr_errno = errno;
+    (void) pthread_setcancelstate (cancel_state, &cancel_state);
+    errno = curr_errno;
+
+    if (n < 0) {
+        if (errno == EINTR) {
+            return;
+        }
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to poll listening socket");
+    }
+    if (pfd[1].revents & POLLIN) {
+        timer_dispatch ();
+    }
+    if (pfd[0].revents & (POLLIN | POLLERR | POLLHUP)) {
+        _job_accept_conn (conf, workers, state);
+    }
+}
+
+
+static void
+_job_accept_conn (conf_t conf, work_p workers, job_accept_state_t *state)
+{
+/*  Accept a single client connection and queue its request to the workers.
+ *  The throttled-logging [state] is maintained separately by each
+ *    accept thread.
+ *  Cancellation is enabled for the duration of accept() so additional
+ *    accept threads can be stopped; it is restored to its previous state
+ *    (disabled for additional accept threads) once accept() returns.
+ */
+    m_msg_t m;
+    int sd;
+    int cancel_state;
+    int curr_errno;
+    time_t curr_time;
+    const int log_limit_secs = 300;
+
+    assert (conf != NULL);
+    assert (workers != NULL);
+    assert (state != NULL);
+
+    (void) pthread_setcancelstate (PTHREAD_CANCEL_ENABLE, &cancel_state);
+    sd = accept (conf->ld, NULL, NULL);
+    curr_errno = errno;
+    (void) pthread_setcancelstate (cancel_state, &cancel_state);
+    errno = curr_errno;
+
+    if (sd < 0) {
+        /*  Handle accept() failure.
+         *  Transient errors are ignored and retried.  EAGAIN occurs when
+         *    the listening socket is non-blocking and another accept thread
+         *    took the pending connection.
+         *  Resource exhaustion errors trigger throttled logging and
+         *    backlog processing to prevent log flooding while allowing
+         *    the system to recover.
+         *  ENOMEM here often indicates socket buffer exhaustion rather
+         *    than general memory depletion, and processing the backlog
+         *    may free socket resources.  This differs from its typical
+         *    handling where memory exhaustion is treated as fatal.
+         *  All other errors are considered fatal.
+         */
+        switch (errno) {
+            case EAGAIN:
+            case ECONNABORTED:
+            case EINTR:
+                return;
+            case EMFILE:
+            case ENFILE:
+            case ENOBUFS:
+            case ENOMEM:
+                /*  Preserve errno before calling time().
+                 */
+                curr_errno = errno;
+                stats_incr (STATS_ACCEPT_ERR);
+                curr_time = time (NULL);
+                if (curr_time == (time_t) -1) {
+                    log_errno (EMUNGE_SNAFU, LOG_ERR,
+                            "Failed to query current time");
                 }
-                else {
-                    log_msg (LOG_DEBUG, "%s", err_msg);
+                /*  Log if sufficient time has elapsed since last log, or
+                 *    if errno has changed (different resource exhausted).
+                 */
+                if ((curr_time - state->last_log_time > log_limit_secs) ||
+                        (curr_errno != state->last_log_errno)) {
+                    log_msg (LOG_WARNING,
+                            "Failed to accept connection: %s",
+                            strerror (curr_errno));
+                    state->last_log_errno = curr_errno;
+                    state->last_log_time = curr_time;
                 }
+                /*  Reject the pending connection rather than stalling
+                 *    until the backlog has been processed.
+                 */
+                _job_accept_reject (conf, state, curr_errno);
+                return;
+            default:
+                log_errno (EMUNGE_SNAFU, LOG_ERR,
+                        "Failed to accept connection");
+                break;
+        }
+    }
+    /*  Handle successful accept().
+     *  Set the client socket non-blocking to guard against spurious
+     *    readiness notifications that could cause functions to block.
+     *  Create, bind, and queue message to the workers for processing.
+     *
+     *  Note: Throttle state is not reset here to avoid excessive logging
+     *    during oscillating resource exhaustion.  The errno change
+     *    detection handles transitions between different resource types.
+     */
+    stats_incr (STATS_ACCEPT);
+
+    if (fd_set_nonblocking (sd) < 0) {
+        close (sd);
+        log_msg (LOG_WARNING,
+                "Failed to set nonblocking client socket: %s",
+                strerror (errno));
+    }
+    else if (m_msg_create (&m) != EMUNGE_SUCCESS) {
+        close (sd);
+        log_msg (LOG_WARNING, "Failed to create client request");
+    }
+    else if (m_msg_bind (m, sd) != EMUNGE_SUCCESS) {
+        m_msg_destroy (m);
+        log_msg (LOG_WARNING, "Failed to bind socket for client request");
+    }
+    else {
+        _job_queue (conf, workers, m);
+    }
+}
+
+
+static void
+_job_accept_reject (conf_t conf, job_accept_state_t *state,
+        int errnum)
+{
+/*  Rejects a pending client connection after accept() has failed with
+ *    [errnum] due to resource exhaustion, so the client fails fast and can
+ *    retry.
+ *  If out of file descriptors, the spare fd reserved by this accept thread
+ *    is released in order to accept the connection and immediately close it.
+ *    The client will see the connection closed and retry.
+ *  O/w, pause briefly to avoid spinning on accept() while the resource is
+ *    unavailable.
+ */
+    int sd;
+
+    assert (conf != NULL);
+    assert (state != NULL);
+
+    if (((errnum == EMFILE) || (errnum == ENFILE))
+            && (state->spare_fd >= 0)) {
+        (void) close (state->spare_fd);
+        if ((sd = accept (conf->ld, NULL, NULL)) >= 0) {
+            (void) close (sd);
+        }
+        state->spare_fd = open ("/dev/null", O_RDONLY);
+    }
+    else {
+        (void) poll (NULL, 0, MUNGE_SOCKET_RETRY_MSECS);
+    }
+}
+
+
+static void
+_job_queue (conf_t conf, work_p workers, m_msg_t m)
+{
+/*  Queues the client request [m] to the [workers], or rejects it if the work
+ *    queue is backlogged to the configured limit for its type or is full.
+ *  This admission decision is made by the accept thread before the request
+ *    is received, so a rejected client fails fast instead of first waiting
+ *    behind the backlog.  When a request could be shed, its type is peeked
+ *    from the message header, waiting briefly for the header to arrive.
+ *    If it does not arrive in time, the request is only rejected when the
+ *    queue is full.
+ *  Encode requests can be given a lower limit than decode requests so
+ *    decodes continue to be serviced while encodes are shed.
+ */
+    m_msg_type_t type = MUNGE_MSG_UNDEF;
+    int          queue_limit = 0;
+    int          n_queued = 0;
+
+    assert (conf != NULL);
+    assert (workers != NULL);
+    assert (m != NULL);
+
+    if ((conf->enc_queue_limit > 0) || (conf->dec_queue_limit > 0)) {
+        work_get_stats (workers, &n_queued, NULL, NULL);
+    }
+    if (((conf->enc_queue_limit > 0) && (n_queued >= conf->enc_queue_limit))
+            || ((conf->dec_queue_limit > 0)
+                && (n_queued >= conf->dec_queue_limit))) {
+        (void) m_msg_peek_type (m, &type, MUNGE_SOCKET_PEEK_MSECS);
+        switch (type) {
+            case MUNGE_MSG_ENC_REQ:
+            case MUNGE_MSG_ENC_BIN_REQ:
+                queue_limit = conf->enc_queue_limit;
+                break;
+            case MUNGE_MSG_DEC_REQ:
+            case MUNGE_MSG_DEC_BIN_REQ:
+            case MUNGE_MSG_DEC_VAL_REQ:
+            case MUNGE_MSG_DEC_BIN_VAL_REQ:
+                queue_limit = conf->dec_queue_limit;
                 break;
             default:
-                log_msg (LOG_INFO, "%s", err_msg);
                 break;
         }
+        if ((queue_limit > 0) && (n_queued >= queue_limit)) {
+            _job_shed (m, type, workers);
+            return;
+        }
+    }
+    if (work_queue (workers, m) == 0) {
+        return;
     }
+    if (errno == EAGAIN) {
+        if (type == MUNGE_MSG_UNDEF) {
+            (void) m_msg_peek_type (m, &type, MUNGE_SOCKET_PEEK_MSECS);
+        }
+        _job_shed (m, type, workers);
+        return;
+    }
+    m_msg_destroy (m);
+    log_msg (LOG_WARNING, "Failed to queue client request");
+}
+
+
+static void
+_job_shed (m_msg_t m, m_msg_type_t type, work_p workers)
+{
+/*  Sheds the client request [m] of type [type] without receiving it.
+ *  An EMUNGE_SOCKET error response is sent so the client will retry.
+ *    The header's retry field carries a hint for how long the client
+ *    should wait before retrying (in units of MUNGE_SOCKET_RETRY_MSECS),
+ *    estimated from the per-worker backlog of the [workers].  A non-zero
+ *    retry field distinguishes this response from other socket errors.
+ *  If the request type is unknown, the response type expected by the client
+ *    is unknown as well, so the connection is just closed.
+ *  Shed requests are counted but not logged.
+ */
+    m_msg_type_t rsp_type;
+    int          n_queued;
+    int          n_workers;
+    int          n_units;
+
+    assert (m != NULL);
+    assert (workers != NULL);
+
+    switch (type) {
+        case MUNGE_MSG_ENC_REQ:
+        case MUNGE_MSG_ENC_BIN_REQ:
+            rsp_type = MUNGE_MSG_ENC_RSP;
+            stats_incr (STATS_ENC_SHED);
+            break;
+        case MUNGE_MSG_DEC_REQ:
+        case MUNGE_MSG_DEC_BIN_REQ:
+        case MUNGE_MSG_DEC_VAL_REQ:
+        case MUNGE_MSG_DEC_BIN_VAL_REQ:
+            rsp_type = MUNGE_MSG_DEC_RSP;
+            stats_incr (STATS_DEC_SHED);
+            break;
+        default:
+            m_msg_destroy (m);
+            return;
+    }
+    work_get_stats (workers, &n_queued, NULL, &n_workers);
+    n_units = 1 + (n_queued / MAX (n_workers, 1));
+    n_units = MIN (n_units, UINT8_MAX);
+
+    (void) m_msg_set_err (m, EMUNGE_SOCKET,
+            strdupf ("Server busy: retry after %d ms",
+                n_units * MUNGE_SOCKET_RETRY_MSECS));
+    m->retry = (uint8_t) n_units;
+    (void) m_msg_send (m, rsp_type, 0);
     m_msg_destroy (m);
 }
@@ -0,0 +1,459 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <munge.h>
+#include "cipher.h"
+#include "keyctx.h"
+#include "log.h"
+#include "mac.h"
+
+
+/*****************************************************************************
+ *  Notes
+ *****************************************************************************/
+/*
+ *  Each credential is MAC'd and its DEK derived using one of the daemon's
+ *    fixed subkeys, so a worker processing consecutive credentials of the
+ *    same MAC and cipher types would otherwise repeat the same context
+ *    allocation, algorithm lookup, and keyed setup for each one.
+ *  These contexts are instead kept per-thread and reinitialized between
+ *    credentials.  When a worker drains a run of queued requests using the
+ *    same types, this setup is paid once for the batch rather than once per
+ *    credential.  A change of type re-creates the affected context.
+ *
+ *  A MAC key is identified by its address and length rather than by its
+ *    contents, so its memory must remain allocated and unchanged from
+ *    keyctx_init() until keyctx_fini(); otherwise, a different key at a
+ *    reused address would be mistaken for it.  This holds for the subkeys
+ *    in the daemon's configuration, which are created before keyctx_init()
+ *    and destroyed after keyctx_fini().  A cipher key is set for each
+ *    credential, for both block and AEAD ciphers.
+ *
+ *  A context is lent to the caller by copying its handle into the caller's
+ *    context, and returned by the corresponding cleanup routine.  If the
+ *    per-thread context is unavailable (eg, per-thread state is not in use,
+ *    or the context is already lent), a temporary context is created and
+ *    destroyed instead.
+ */
+
+
+/*****************************************************************************
+ *  Constants
+ *****************************************************************************/
+
+/*  Number of per-thread MAC contexts: one each for the MAC and DEK subkeys.
+ */
+#define KEYCTX_MAC_SLOTS                2
+
+
+/*****************************************************************************
+ *  Data Types
+ *****************************************************************************/
+
+struct keyctx_mac {
+    mac_ctx             ctx;            /* keyed MAC context                 */
+    munge_mac_t         md;             /* message digest of MAC context     */
+    const void         *key;            /* addr of key for MAC context       */
+    int                 keylen;         /* length of key for MAC context     */
+    unsigned            got_ctx:1;      /* true if MAC context is init       */
+    unsigned            is_lent:1;      /* true if MAC context is in use     */
+};
+
+struct keyctx_cipher {
+    cipher_ctx          ctx;            /* cipher context                    */
+    munge_cipher_t      cipher;         /* cipher type of cipher context     */
+    unsigned            got_ctx:1;      /* true if cipher context is init    */
+    unsigned            is_lent:1;      /* true if cipher context is in use  */
+};
+
+/*  Per-thread crypto state.
+ */
+struct keyctx {
+    struct keyctx_mac       mac [KEYCTX_MAC_SLOTS];
+    struct keyctx_cipher    cipher;
+};
+
+typedef struct keyctx * keyctx_p;
+
+
+/*****************************************************************************
+ *  Private Data
+ *****************************************************************************/
+
+static int _keyctx_is_init = 0;         /* true if per-thread state in use   */
+
+static pthread_key_t _keyctx_key;       /* key for per-thread crypto state   */
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static keyctx_p _keyctx_get (void);
+static struct keyctx_mac * _keyctx_mac_slot (keyctx_p k,
+    const void *key, int keylen);
+static void _keyctx_destroy (void *arg);
+
+
+/*****************************************************************************
+ *  Public Functions
+ *****************************************************************************/
+
+/*  Initializes per-thread crypto state for reuse across credentials.
+ *  Without this, contexts are created and destroyed for each call.
+ */
+void
+keyctx_init (void)
+{
+    if (_keyctx_is_init) {
+        return;
+    }
+    if ((errno = pthread_key_create (&_keyctx_key, _keyctx_destroy)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to create crypto state key");
+    }
+    _keyctx_is_init = 1;
+    return;
+}
+
+
+/*  Shuts down per-thread crypto state.
+ *  The calling thread's state is destroyed here since key destructors are
+ *    only invoked at thread exit.
+ */
+void
+keyctx_fini (void)
+{
+    keyctx_p k;
+
+    if (!_keyctx_is_init) {
+        return;
+    }
+    _keyctx_is_init = 0;
+
+    if ((k = pthread_getspecific (_keyctx_key)) != NULL) {
+        (void) pthread_setspecific (_keyctx_key, NULL);
+        _keyctx_destroy (k);
+    }
+    (void) pthread_key_delete (_keyctx_key);
+    return;
+}
+
+
+/*  Initializes the MAC context [x] as mac_init() would, but using the calling
+ *    thread's context for message digest [md] and key [key] of length
+ *    [keylen] if available.
+ *  The [key] memory must remain allocated and unchanged until keyctx_fini().
+ *  The context must be released by keyctx_mac_cleanup().
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+keyctx_mac_init (mac_ctx *x, munge_mac_t md, const void *key, int keylen)
+{
+    keyctx_p           k;
+    struct keyctx_mac *s;
+
+    if (!x || !key || (keylen < 0)) {
+        return (-1);
+    }
+    if (!(k = _keyctx_get ()) || !(s = _keyctx_mac_slot (k, key, keylen))) {
+        return (mac_init (x, md, key, keylen));
+    }
+    /*  The slot may be keyed with a different key if it was the one chosen
+     *    for not being lent, so it is only reused if both match.
+     */
+    if (s->got_ctx && (s->md == md)
+            && (s->key == key) && (s->keylen == keylen)) {
+        if (mac_reinit (&s->ctx) < 0) {
+            (void) mac_cleanup (&s->ctx);
+            s->got_ctx = 0;
+            return (-1);
+        }
+    }
+    else {
+        if (s->got_ctx) {
+            (void) mac_cleanup (&s->ctx);
+            s->got_ctx = 0;
+        }
+        if (mac_init (&s->ctx, md, key, keylen) < 0) {
+            return (-1);
+        }
+        s->md = md;
+        s->key = key;
+        s->keylen = keylen;
+        s->got_ctx = 1;
+    }
+    s->is_lent = 1;
+    *x = s->ctx;
+    return (0);
+}
+
+
+/*  Releases the MAC context [x] obtained from keyctx_mac_init().
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+keyctx_mac_cleanup (mac_ctx *x)
+{
+    keyctx_p k;
+    int      i;
+
+    if (!x) {
+        return (-1);
+    }
+    if ((k = _keyctx_get ()) != NULL) {
+        for (i = 0; i < KEYCTX_MAC_SLOTS; i++) {
+            if (k->mac[i].is_lent && (k->mac[i].ctx.ctx == x->ctx)) {
+                k->mac[i].is_lent = 0;
+                memset (x, 0, sizeof (*x));
+                return (0);
+            }
+        }
+    }
+    return (mac_cleanup (x));
+}
+
+
+/*  Computes the MAC as mac_block() would, but using the calling thread's
+ *    context for message digest [md] and key [key] of length [keylen].
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+keyctx_mac_block (munge_mac_t md, const void *key, int keylen,
+                  void *dst, int *dstlenp, const void *src, int srclen)
+{
+    mac_ctx x;
+    int     rc;
+
+    if (!key || (keylen < 0) || !dst || !dstlenp || !src || (srclen < 0)) {
+        return (-1);
+    }
+    if (keyctx_mac_init (&x, md, key, keylen) < 0) {
+        return (-1);
+    }
+    rc = mac_update (&x, src, srclen);
+    if (rc == 0) {
+        rc = mac_final (&x, dst, dstlenp);
+    }
+    if (keyctx_mac_cleanup (&x) < 0) {
+        rc = -1;
+    }
+    return (rc);
+}
+
+
+/*  Initializes the cipher context [x] as cipher_init() would, but using the
+ *    calling thread's context for cipher [cipher] if available.
+ *  The context must be released by keyctx_cipher_cleanup().
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+keyctx_cipher_init (cipher_ctx *x, munge_cipher_t cipher,
+                    unsigned char *key, unsigned char *iv, int enc)
+{
+    keyctx_p              k;
+    struct keyctx_cipher *s;
+
+    if (!x) {
+        return (-1);
+    }
+    if (!(k = _keyctx_get ()) || k->cipher.is_lent) {
+        return (cipher_init (x, cipher, key, iv, enc));
+    }
+    s = &k->cipher;
+    if (s->got_ctx && (s->cipher == cipher)) {
+        if (cipher_reinit (&s->ctx, key, iv, enc) < 0) {
+            (void) cipher_cleanup (&s->ctx);
+            s->got_ctx = 0;
+            return (-1);
+        }
+    }
+    else {
+        if (s->got_ctx) {
+            (void) cipher_cleanup (&s->ctx);
+            s->got_ctx = 0;
+        }
+        if (cipher_init (&s->ctx, cipher, key, iv, enc) < 0) {
+            return (-1);
+        }
+        s->cipher = cipher;
+        s->got_ctx = 1;
+    }
+    s->is_lent = 1;
+    *x = s->ctx;
+    return (0);
+}
+
+
+/*  Initializes the cipher context [x] as cipher_aead_init() would, but using
+ *    the calling thread's context for AEAD cipher [cipher] if available.
+ *    The key and nonce are set for each message by cipher_aead_encrypt()
+ *    or cipher_aead_decrypt().
+ *  The context must be released by keyctx_cipher_cleanup().
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+keyctx_aead_init (cipher_ctx *x, munge_cipher_t cipher)
+{
+    keyctx_p              k;
+    struct keyctx_cipher *s;
+
+    if (!x) {
+        return (-1);
+    }
+    if (!(k = _keyctx_get ()) || k->cipher.is_lent) {
+        return (cipher_aead_init (x, cipher));
+    }
+    s = &k->cipher;
+    if (!s->got_ctx || (s->cipher != cipher)) {
+        if (s->got_ctx) {
+            (void) cipher_cleanup (&s->ctx);
+            s->got_ctx = 0;
+        }
+        if (cipher_aead_init (&s->ctx, cipher) < 0) {
+            return (-1);
+        }
+        s->cipher = cipher;
+        s->got_ctx = 1;
+    }
+    s->is_lent = 1;
+    *x = s->ctx;
+    return (0);
+}
+
+
+/*  Releases the cipher context [x] obtained from keyctx_cipher_init() or
+ *    keyctx_aead_init().
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+keyctx_cipher_cleanup (cipher_ctx *x)
+{
+    keyctx_p k;
+
+    if (!x) {
+        return (-1);
+    }
+    if (((k = _keyctx_get ()) != NULL)
+            && k->cipher.is_lent && (k->cipher.ctx.ctx == x->ctx)) {
+        k->cipher.is_lent = 0;
+        memset (x, 0, sizeof (*x));
+        return (0);
+    }
+    return (cipher_cleanup (x));
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+static keyctx_p
+_keyctx_get (void)
+{
+/*  Returns the calling thread's crypto state, creating it on first use.
+ *  Returns NULL if per-thread state is not in use, or on error.
+ */
+    keyctx_p k;
+
+    if (!_keyctx_is_init) {
+        return (NULL);
+    }
+    if ((k = pthread_getspecific (_keyctx_key)) != NULL) {
+        return (k);
+    }
+    if (!(k = calloc (1, sizeof (*k)))) {
+        return (NULL);
+    }
+    if (pthread_setspecific (_keyctx_key, k) != 0) {
+        free (k);
+        return (NULL);
+    }
+    return (k);
+}
+
+
+static struct keyctx_mac *
+_keyctx_mac_slot (keyctx_p k, const void *key, int keylen)
+{
+/*  Returns the MAC context in [k] to use for key [key] of length [keylen]:
+ *    the one already keyed with it, else an unused one, else one not lent.
+ *  Returns NULL if every MAC context is lent.
+ */
+    struct keyctx_mac *s = NULL;
+    int                i;
+
+    for (i = 0; i < KEYCTX_MAC_SLOTS; i++) {
+        if (k->mac[i].got_ctx
+                && (k->mac[i].key == key) && (k->mac[i].keylen == keylen)) {
+            return (k->mac[i].is_lent ? NULL : &k->mac[i]);
+        }
+    }
+    for (i = 0; i < KEYCTX_MAC_SLOTS; i++) {
+        if (!k->mac[i].got_ctx) {
+            return (&k->mac[i]);
+        }
+        if (!s && !k->mac[i].is_lent) {
+            s = &k->mac[i];
+        }
+    }
+    return (s);
+}
+
+
+static void
+_keyctx_destroy (void *arg)
+{
+/*  De-allocates the crypto state [arg] when its thread exits.
+ */
+    keyctx_p k = arg;
+    int      i;
+
+    if (k == NULL) {
+        return;
+    }
+    for (i = 0; i < KEYCTX_MAC_SLOTS; i++) {
+        if (k->mac[i].got_ctx) {
+            (void) mac_cleanup (&k->mac[i].ctx);
+        }
+    }
+    if (k->cipher.got_ctx) {
+        (void) cipher_cleanup (&k->cipher.ctx);
+    }
+    memset (k, 0, sizeof (*k));
+    free (k);
+    return;
+}
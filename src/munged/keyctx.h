@@ -0,0 +1,60 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#ifndef KEYCTX_H
+#define KEYCTX_H
+
+
+#include <munge.h>
+#include "cipher.h"
+#include "mac.h"
+
+
+/*****************************************************************************
+ *  Prototypes
+ *****************************************************************************/
+
+void keyctx_init (void);
+
+void keyctx_fini (void);
+
+int keyctx_mac_init (mac_ctx *x, munge_mac_t md, const void *key, int keylen);
+
+int keyctx_mac_cleanup (mac_ctx *x);
+
+int keyctx_mac_block (munge_mac_t md, const void *key, int keylen,
+    void *dst, int *dstlenp, const void *src, int srclen);
+
+int keyctx_cipher_init (cipher_ctx *x, munge_cipher_t cipher,
+    unsigned char *key, unsigned char *iv, int enc);
+
+int keyctx_aead_init (cipher_ctx *x, munge_cipher_t cipher);
+
+int keyctx_cipher_cleanup (cipher_ctx *x);
+
+
+#endif /* !KEYCTX_H */
@@ -0,0 +1,456 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <syslog.h>
+#include <munge.h>
+#include "atom.h"
+#include "log.h"
+#include "logq.h"
+#include "ring.h"
+#include "stats.h"
+
+
+/*****************************************************************************
+ *  Constants
+ *****************************************************************************/
+
+/*  Number of slots in the log record ring (must be a power of 2).
+ *    When the ring is full, new records are dropped (and counted).
+ */
+#define LOGQ_SIZE               512
+
+/*  Maximum length of a log record (including the trailing newline).
+ *    This matches the message buffer length in log.c; longer records are
+ *    truncated.
+ */
+#define LOGQ_RECORD_MAXLEN      1024
+
+/*  Maximum number of records gathered into a single writev().
+ */
+#if defined(IOV_MAX) && (IOV_MAX < 64)
+#  define LOGQ_BATCH_MAX        IOV_MAX
+#else  /* !IOV_MAX || IOV_MAX >= 64 */
+#  define LOGQ_BATCH_MAX        64
+#endif /* !IOV_MAX || IOV_MAX >= 64 */
+
+
+/*****************************************************************************
+ *  Private Data Types
+ *****************************************************************************/
+
+typedef struct logq_rec {
+    int                 len;            /* length of record in buf           */
+    char                buf [LOGQ_RECORD_MAXLEN];   /* formatted log record  */
+} logq_rec_t, *logq_rec_p;
+
+typedef struct logq {
+    pthread_t           tid;            /* log writer thread ID              */
+    pthread_mutex_t     lock;           /* mutex for parking/waking writer   */
+    pthread_cond_t      received_rec;   /* cond for when new record is recv'd*/
+    ring_p              ring;           /* bounded ring of log records       */
+    unsigned long       n_idle;         /* true if writer thread is parked   */
+    unsigned long       n_dropped;      /* number of records dropped         */
+    unsigned long       n_reported;     /* number of drops already reported  */
+    unsigned long       got_exit;       /* true directs writer thread exit   */
+    int                 fd;             /* log file descriptor               */
+    int                 got_write_error;/* true if last writev() failed      */
+} logq_t;
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static void * _logq_thread (void *arg);
+static int    _logq_write (int priority, const char *buf, int len);
+static void   _logq_flush (void);
+static int    _logq_drain (void);
+static int    _logq_is_empty (void);
+static void   _logq_writev (struct iovec *iov, int n);
+
+
+/*****************************************************************************
+ *  Private Variables
+ *****************************************************************************/
+
+static logq_t *_logq = NULL;
+
+
+/*****************************************************************************
+ *  Public Functions
+ *****************************************************************************/
+
+/*  Starts a log writer thread for the logging file stream.
+ *  Messages logged to the file stream are then copied into a bounded ring
+ *    by the logging thread, and written in batches (via writev) by the
+ *    log writer thread so threads do not block on file I/O.  Records are
+ *    dropped (and counted) when the ring is full; the number of dropped
+ *    records is logged once the ring has drained.
+ *  Messages logged to syslog are unaffected.
+ *  Returns 0 on success, or -1 if no file stream is open.
+ */
+int
+logq_init (void)
+{
+    logq_t *lq;
+    int     fd;
+
+    if (_logq != NULL) {
+        return (0);
+    }
+    if ((fd = log_get_file_fd ()) < 0) {
+        return (-1);
+    }
+    if (!(lq = malloc (sizeof (logq_t)))) {
+        log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+            "Failed to allocate log queue struct");
+    }
+    if (!(lq->ring = ring_create (LOGQ_SIZE, sizeof (logq_rec_t)))) {
+        log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+            "Failed to allocate ring for log queue struct");
+    }
+    if ((errno = pthread_mutex_init (&lq->lock, NULL)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to init log queue mutex");
+    }
+    if ((errno = pthread_cond_init (&lq->received_rec, NULL)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to init log queue condition for received record");
+    }
+    lq->n_idle = 0;
+    lq->n_dropped = 0;
+    lq->n_reported = 0;
+    lq->got_exit = 0;
+    lq->fd = fd;
+    lq->got_write_error = 0;
+
+    if ((errno = pthread_create (&lq->tid, NULL, _logq_thread, lq)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to create log writer thread");
+    }
+    _logq = lq;
+    log_set_file_writer (_logq_write, _logq_flush);
+
+    log_msg (LOG_INFO, "Enabled asynchronous logging");
+    return (0);
+}
+
+
+/*  Stops the log writer thread after writing any queued records.
+ *  Subsequent messages are written synchronously.
+ */
+void
+logq_fini (void)
+{
+    logq_t *lq = _logq;
+
+    if (lq == NULL) {
+        return;
+    }
+    if ((errno = pthread_mutex_lock (&lq->lock)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock log queue mutex");
+    }
+    atom_store (&lq->got_exit, 1);
+
+    if ((errno = pthread_cond_signal (&lq->received_rec)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to signal log writer for exit");
+    }
+    if ((errno = pthread_mutex_unlock (&lq->lock)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock log queue mutex");
+    }
+    if ((errno = pthread_join (lq->tid, NULL)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to join log writer thread");
+    }
+    /*  Records logged after the writer thread exited are flushed here.
+     */
+    log_set_file_writer (NULL, NULL);
+    (void) _logq_drain ();
+    _logq = NULL;
+
+    if ((errno = pthread_cond_destroy (&lq->received_rec)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to destroy log queue condition for received record");
+    }
+    if ((errno = pthread_mutex_destroy (&lq->lock)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to destroy log queue mutex");
+    }
+    ring_destroy (lq->ring);
+    free (lq);
+    return;
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+static void *
+_logq_thread (void *arg)
+{
+/*  The log writer thread.  It writes queued records in batches, parking
+ *    while the ring is empty.  Dropped records are reported once the ring
+ *    has drained so the report is not itself dropped.
+ *  All signals are blocked so they will be delivered to the main thread.
+ */
+    logq_t       *lq = arg;
+    sigset_t      sigset;
+    unsigned long n_dropped;
+
+    assert (lq != NULL);
+
+    if (sigfillset (&sigset)) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to init log writer thread sigset");
+    }
+    if (pthread_sigmask (SIG_SETMASK, &sigset, NULL) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to set log writer thread sigset");
+    }
+    for (;;) {
+        while (_logq_drain () > 0) {
+            ;
+        }
+        n_dropped = atom_load (&lq->n_dropped);
+        if (n_dropped != lq->n_reported) {
+            log_msg (LOG_WARNING, "Dropped %lu log message%s",
+                    n_dropped - lq->n_reported,
+                    ((n_dropped - lq->n_reported) == 1) ? "" : "s");
+            lq->n_reported = n_dropped;
+            continue;
+        }
+        /*  Park until a record is queued.
+         *  [n_idle] is set before re-testing the ring so a producer
+         *    enqueueing concurrently will see it and signal.
+         */
+        if ((errno = pthread_mutex_lock (&lq->lock)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to lock log queue mutex");
+        }
+        atom_store (&lq->n_idle, 1);
+
+        while (_logq_is_empty () && !atom_load (&lq->got_exit)) {
+            if ((errno = pthread_cond_wait
+                        (&lq->received_rec, &lq->lock)) != 0) {
+                log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to wait on log queue for received record");
+            }
+        }
+        atom_store (&lq->n_idle, 0);
+
+        if ((errno = pthread_mutex_unlock (&lq->lock)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to unlock log queue mutex");
+        }
+        if (atom_load (&lq->got_exit) && _logq_is_empty ()) {
+            break;
+        }
+    }
+    return (NULL);
+}
+
+
+static int
+_logq_write (int priority, const char *buf, int len)
+{
+/*  Copies the log record [buf] of [len] bytes at the specified [priority]
+ *    level into the ring.
+ *  Producers never block.  If the ring is full, the record is dropped
+ *    unless its priority is LOG_ERR or higher; such a record may be the
+ *    fatal error logged before exiting, so it is refused instead and
+ *    written synchronously by the caller.
+ *  Returns 0 if the record was consumed (queued or dropped), or -1 if it
+ *    must be written synchronously.
+ */
+    logq_t       *lq = _logq;
+    logq_rec_p    rec;
+    unsigned long pos;
+
+    if ((lq == NULL) || (buf == NULL) || (len <= 0)) {
+        return (-1);
+    }
+    if (!(rec = ring_enqueue_claim (lq->ring, &pos))) {
+        if (priority <= LOG_ERR) {
+            return (-1);
+        }
+        (void) atom_add (&lq->n_dropped, 1);
+        stats_incr (STATS_LOG_DROP);
+        return (0);
+    }
+    if (len > LOGQ_RECORD_MAXLEN) {
+        len = LOGQ_RECORD_MAXLEN;
+        memcpy (rec->buf, buf, len - 1);
+        rec->buf[len - 1] = '\n';
+    }
+    else {
+        memcpy (rec->buf, buf, len);
+    }
+    rec->len = len;
+    ring_enqueue_commit (lq->ring, pos);
+
+    /*  Awaken the writer thread if it is parked.
+     */
+    if (atom_load (&lq->n_idle)) {
+        if ((errno = pthread_mutex_lock (&lq->lock)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to lock log queue mutex");
+        }
+        if ((errno = pthread_cond_signal (&lq->received_rec)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to signal log writer for received record");
+        }
+        if ((errno = pthread_mutex_unlock (&lq->lock)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to unlock log queue mutex");
+        }
+    }
+    return (0);
+}
+
+
+static void
+_logq_flush (void)
+{
+/*  Writes all queued records from the calling thread.
+ *  This is invoked before exiting on a fatal error.
+ */
+    if (_logq == NULL) {
+        return;
+    }
+    while (_logq_drain () > 0) {
+        ;
+    }
+    return;
+}
+
+
+static int
+_logq_drain (void)
+{
+/*  Dequeues up to LOGQ_BATCH_MAX consecutive records from the ring and
+ *    writes them with a single writev().  Slots are released once written.
+ *  This is safe to call concurrently with the writer thread (e.g., when
+ *    flushing before a fatal exit) since each consumer claims its own
+ *    slots from the ring.
+ *  Returns the number of records written.
+ */
+    logq_t       *lq = _logq;
+    struct iovec  iov [LOGQ_BATCH_MAX];
+    unsigned long posv [LOGQ_BATCH_MAX];
+    logq_rec_p    rec;
+    int           n = 0;
+    int           i;
+
+    assert (lq != NULL);
+
+    while (n < LOGQ_BATCH_MAX) {
+        if (!(rec = ring_dequeue_claim (lq->ring, &posv[n]))) {
+            break;
+        }
+        iov[n].iov_base = rec->buf;
+        iov[n].iov_len = rec->len;
+        n++;
+    }
+    if (n == 0) {
+        return (0);
+    }
+    _logq_writev (iov, n);
+
+    for (i = 0; i < n; i++) {
+        ring_dequeue_release (lq->ring, posv[i]);
+    }
+    return (n);
+}
+
+
+static int
+_logq_is_empty (void)
+{
+/*  Returns non-zero if no record is ready to be dequeued.
+ */
+    logq_t *lq = _logq;
+
+    assert (lq != NULL);
+
+    return (ring_is_empty (lq->ring));
+}
+
+
+static void
+_logq_writev (struct iovec *iov, int n)
+{
+/*  Writes the [n] records described by [iov] to the log file descriptor,
+ *    resuming after partial writes.
+ *  As with the synchronous logging path, a write failure is reported to
+ *    syslog once until a subsequent write succeeds.
+ */
+    logq_t  *lq = _logq;
+    ssize_t  nwritten;
+
+    assert (lq != NULL);
+
+    while (n > 0) {
+        nwritten = writev (lq->fd, iov, n);
+        if (nwritten < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (!lq->got_write_error) {
+                syslog (LOG_ERR,
+                    "Failed logfile write: %s: messages may have been dropped",
+                    strerror (errno));
+                lq->got_write_error = 1;
+            }
+            return;
+        }
+        lq->got_write_error = 0;
+        while ((n > 0) && ((size_t) nwritten >= iov->iov_len)) {
+            nwritten -= iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n > 0) {
+            iov->iov_base = (char *) iov->iov_base + nwritten;
+            iov->iov_len -= nwritten;
+        }
+    }
+    return;
+}
+
@@ -30,9 +30,13 @@
 #endif /* HAVE_CONFIG_H */
 
 #include <assert.h>
+#include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <munge.h>
+#if HAVE_SCHED_SETAFFINITY
+#include <sched.h>
+#endif /* HAVE_SCHED_SETAFFINITY */
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
@@ -50,22 +54,30 @@
 #include "cipher.h"
 #include "common.h"
 #include "conf.h"
+#include "cred.h"
 #include "crypto.h"
 #include "daemonpipe.h"
+#include "errlog.h"
 #include "gids.h"
 #include "hash.h"
 #include "job.h"
+#include "keyctx.h"
 #include "lock.h"
 #include "log.h"
+#include "logq.h"
 #include "md.h"
 #include "munge_defs.h"
 #include "path.h"
 #include "random.h"
 #include "replay.h"
+#include "stage.h"
+#include "stats.h"
 #include "str.h"
 #include "timer.h"
 #include "work.h"
 #include "xsignal.h"
+#include "zip.h"
+#include "zipadapt.h"
 
 
 /*****************************************************************************
@@ -80,6 +92,10 @@ static void handle_signals (void);
 static void sig_handler (int sig);
 static void write_pidfile (const char *pidfile, int got_force);
 static void lock_memory (void);
+static void set_cpu_affinity (const char *cpu_list);
+#if HAVE_SCHED_SETAFFINITY
+static int parse_cpu_list (const char *cpu_list, cpu_set_t *cpus);
+#endif /* HAVE_SCHED_SETAFFINITY */
 static void sock_create (conf_t conf);
 static void sock_destroy (conf_t conf);
 
@@ -90,6 +106,9 @@ static void sock_destroy (conf_t conf);
 
 volatile sig_atomic_t got_reconfig = 0;     /* signum if HUP received        */
 volatile sig_atomic_t got_terminate = 0;    /* signum if INT/TERM received   */
+#ifdef WITH_STAGE_TIMING
+volatile sig_atomic_t got_stage_toggle = 0; /* signum if USR1 received       */
+#endif /* WITH_STAGE_TIMING */
 
 
 /*****************************************************************************
@@ -130,10 +149,19 @@ main (int argc, char *argv[])
     log_msg (LOG_NOTICE, "Starting %s-%s daemon (pid %d)",
         PACKAGE, VERSION, (int) getpid ());
     handle_signals ();
+    if (conf->cpu_list) {
+        set_cpu_affinity (conf->cpu_list);
+    }
+    if (conf->got_log_async && !conf->got_syslog) {
+        if (logq_init () < 0) {
+            log_msg (LOG_WARNING, "Failed to enable asynchronous logging");
+        }
+    }
     log_origin_addr (conf);
     crypto_init ();
     cipher_init_subsystem ();
     md_init_subsystem ();
+    cred_params_init ();
     if (random_init (conf->seed_name) < 0) {
         if (conf->seed_name) {
             free (conf->seed_name);
@@ -141,12 +169,37 @@ main (int argc, char *argv[])
         }
     }
     create_subkeys (conf);
+    zip_init ();
+    keyctx_init ();
+    zipadapt_init ();
+    if (conf->dict_name) {
+        if (zip_dict_init (conf->dict_name) < 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to load compression dictionary \"%s\"",
+                    conf->dict_name);
+        }
+        log_msg (LOG_INFO, "Loaded compression dictionary \"%s\" (id=%u)",
+                conf->dict_name,
+                (unsigned) zip_dict_get_id (MUNGE_ZIP_ZSTD));
+    }
     conf->gids = gids_create (conf->gids_update_secs, conf->got_group_stat);
     replay_init ();
-    timer_init ();
+    errlog_init (conf->log_aggregate_secs);
+    if (!conf->got_timerfd) {
+        timer_init ();
+    }
+    else if (timer_init_fd () < 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to create timerfd");
+    }
+#ifdef WITH_STAGE_TIMING
+    stage_init ();
+    stage_set_enabled (conf->got_stage_timing);
+#endif /* WITH_STAGE_TIMING */
     sock_create (conf);
     write_pidfile (conf->pidfile_name, conf->got_force);
-    workers = work_init ((work_func_t) job_exec, conf->nthreads);
+    workers = work_init ((work_func_t) job_exec, conf->nthreads,
+            conf->nthreads_max);
+    stats_init (workers);
     if (conf->got_mlockall) {
         lock_memory ();
     }
@@ -156,14 +209,27 @@ main (int argc, char *argv[])
     job_accept (conf, workers);
 
     work_fini (workers, 1);
+    stats_fini ();
+#ifdef WITH_STAGE_TIMING
+    if (stage_is_enabled ()) {
+        stage_log (LOG_NOTICE);
+    }
+    stage_fini ();
+#endif /* WITH_STAGE_TIMING */
     sock_destroy (conf);
     timer_fini ();
+    errlog_fini ();
     replay_fini ();
     gids_destroy (conf->gids);
     hash_drop_memory ();
+    zipadapt_fini ();
+    zip_dict_fini ();
+    keyctx_fini ();
+    zip_fini ();
     random_fini (conf->seed_name);
     crypto_fini ();
     destroy_conf (conf, 1);
+    logq_fini ();
 
     log_msg (LOG_NOTICE, "Stopping %s-%s daemon (pid %d)",
         PACKAGE, VERSION, (int) getpid ());
@@ -449,6 +515,15 @@ handle_signals (void)
                 "Failed to set handler for signal %d (%s)", sig,
                 strsignal (sig));
     }
+#ifdef WITH_STAGE_TIMING
+    sig = SIGUSR1;
+    rv = sigaction (sig, &sa, NULL);
+    if (rv == -1) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to set handler for signal %d (%s)", sig,
+                strsignal (sig));
+    }
+#endif /* WITH_STAGE_TIMING */
     xsignal_ignore (SIGPIPE);
     return;
 }
@@ -463,6 +538,11 @@ sig_handler (int sig)
     else if ((sig == SIGINT) || (sig == SIGTERM)) {
         got_terminate = sig;
     }
+#ifdef WITH_STAGE_TIMING
+    else if (sig == SIGUSR1) {
+        got_stage_toggle = sig;
+    }
+#endif /* WITH_STAGE_TIMING */
     return;
 }
 
@@ -593,6 +673,104 @@ lock_memory (void)
 }
 
 
+static void
+set_cpu_affinity (const char *cpu_list)
+{
+/*  Bind the daemon to the CPUs specified by [cpu_list].
+ *  Threads inherit the CPU affinity of their creator, so this must be called
+ *    before the timer and work threads are created in order to bind every
+ *    thread in the daemon (thereby keeping it off CPUs reserved for jobs).
+ *  Since pages are allocated on the NUMA node of the CPU that first touches
+ *    them, binding to the CPUs of a single node also keeps the replay cache,
+ *    group mapping, and subkeys in node-local memory.
+ */
+#if ! HAVE_SCHED_SETAFFINITY
+    errno = ENOSYS;
+    log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to set CPU affinity");
+#else /* HAVE_SCHED_SETAFFINITY */
+    cpu_set_t cpus;
+    int       n;
+
+    assert (cpu_list != NULL);
+
+    if (parse_cpu_list (cpu_list, &cpus) < 0) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Invalid value \"%s\" for cpu-affinity", cpu_list);
+    }
+    if (sched_setaffinity (0, sizeof (cpus), &cpus) < 0) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to set CPU affinity to \"%s\": %s",
+                cpu_list, strerror (errno));
+    }
+    if (sched_getaffinity (0, sizeof (cpus), &cpus) < 0) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to get CPU affinity: %s", strerror (errno));
+    }
+    n = CPU_COUNT (&cpus);
+    log_msg (LOG_INFO, "Set CPU affinity to %d CPU%s (%s)",
+            n, ((n == 1) ? "" : "s"), cpu_list);
+#endif /* HAVE_SCHED_SETAFFINITY */
+}
+
+
+#if HAVE_SCHED_SETAFFINITY
+static int
+parse_cpu_list (const char *cpu_list, cpu_set_t *cpus)
+{
+/*  Parse [cpu_list], a comma-separated list of CPU numbers and inclusive
+ *    ranges (e.g., "0-3,8,10-11"), into the CPU set [cpus].
+ *  Returns 0 on success, or -1 on error.
+ */
+    const char    *p;
+    char          *q;
+    unsigned long  lo;
+    unsigned long  hi;
+
+    assert (cpu_list != NULL);
+    assert (cpus != NULL);
+
+    CPU_ZERO (cpus);
+    p = cpu_list;
+    for (;;) {
+        if (!isdigit ((unsigned char) *p)) {
+            return (-1);
+        }
+        errno = 0;
+        lo = hi = strtoul (p, &q, 10);
+        if (errno != 0) {
+            return (-1);
+        }
+        if (*q == '-') {
+            p = q + 1;
+            if (!isdigit ((unsigned char) *p)) {
+                return (-1);
+            }
+            errno = 0;
+            hi = strtoul (p, &q, 10);
+            if ((errno != 0) || (hi < lo)) {
+                return (-1);
+            }
+        }
+        if (hi >= CPU_SETSIZE) {
+            return (-1);
+        }
+        while (lo <= hi) {
+            CPU_SET (lo, cpus);
+            lo++;
+        }
+        if (*q == '\0') {
+            break;
+        }
+        if (*q != ',') {
+            return (-1);
+        }
+        p = q + 1;
+    }
+    return (0);
+}
+#endif /* HAVE_SCHED_SETAFFINITY */
+
+
 static void
 sock_create (conf_t conf)
 {
@@ -33,10 +33,13 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <munge.h>
+#include <pthread.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include "chacha.h"
 #include "common.h"
 #include "conf.h"
 #include "crypto.h"
@@ -80,6 +83,37 @@
  */
 #define RANDOM_STIR_MAX_SECS            32768
 
+/*  Integer for the number of bytes of ChaCha20 keystream generated at a time
+ *    by each thread's DRBG for random_pseudo_bytes().  The first
+ *    CHACHA_KEY_LEN bytes of each refill replace the DRBG key.
+ */
+#define RANDOM_DRBG_BUF_LEN             (CHACHA_BLOCK_LEN * 16)
+
+/*  Integer for the number of bytes a thread's DRBG can output before it is
+ *    reseeded from the PRNG entropy pool.
+ */
+#define RANDOM_DRBG_RESEED_BYTES        (1024 * 1024)
+
+
+/*****************************************************************************
+ *  Private Data Types
+ *****************************************************************************/
+
+/*  A per-thread deterministic random bit generator using ChaCha20 with
+ *    "fast key erasure": each refill generates a buffer of keystream, the
+ *    start of which immediately replaces the key; output bytes are erased
+ *    from the buffer as they are consumed.
+ */
+struct random_drbg {
+    unsigned char   key [CHACHA_KEY_LEN];       /* current ChaCha20 key      */
+    unsigned char   buf [RANDOM_DRBG_BUF_LEN];  /* unconsumed keystream      */
+    int             buf_pos;            /* offset of next unconsumed byte    */
+    unsigned long   gen;                /* reseed generation of this DRBG    */
+    unsigned long   n_bytes;            /* bytes output since last reseed    */
+};
+
+typedef struct random_drbg * random_drbg_p;
+
 
 /*****************************************************************************
  *  Private Data
@@ -89,6 +123,16 @@ static long _random_timer_id = 0;       /* timer ID for entropy pool stir    */
 
 static int  _random_stir_secs;          /* secs between entropy pool stirs   */
 
+static int  _random_drbg_is_init = 0;   /* true if per-thread DRBGs in use   */
+
+static pthread_key_t _random_drbg_key;  /* key for per-thread DRBG state     */
+
+/*  The reseed generation is incremented whenever the entropy pool is stirred
+ *    and in the child after a fork() so every thread's DRBG is reseeded
+ *    before its next use.
+ */
+static unsigned long _random_drbg_gen = 0;
+
 
 /*****************************************************************************
  *  Private Prototypes
@@ -101,6 +145,16 @@ static int  _random_read_seed (const char *path, int num_bytes);
 static int  _random_write_seed (const char *path, int num_bytes);
 static int  _random_check_entropy (unsigned char *buf, int n);
 static void _random_stir_entropy (void *_arg_not_used_);
+static void _random_drbg_init (void);
+static void _random_drbg_fini (void);
+static random_drbg_p _random_drbg_get (void);
+static void _random_drbg_bytes (random_drbg_p d, unsigned char *buf, int n);
+static void _random_drbg_reseed (random_drbg_p d, unsigned long gen);
+static void _random_drbg_refill (random_drbg_p d);
+static void _random_drbg_destroy (void *arg);
+static void _random_drbg_atfork_child (void);
+static unsigned long _random_drbg_gen_load (void);
+static void _random_drbg_gen_incr (void);
 
 static void _random_cleanup (void);
 static void _random_add (const void *buf, int n);
@@ -168,6 +222,7 @@ random_init (const char *seed_path)
     if (_random_stir_secs > 0) {
         _random_stir_entropy (NULL);
     }
+    _random_drbg_init ();
 
     if (got_bad_seed) {
         return (-1);
@@ -187,6 +242,8 @@ random_fini (const char *seed_path)
     if (_random_timer_id > 0) {
         timer_cancel (_random_timer_id);
     }
+    _random_drbg_fini ();
+
     if (seed_path != NULL) {
         (void) _random_write_seed (seed_path, RANDOM_SEED_BYTES);
     }
@@ -223,13 +280,22 @@ random_bytes (void *buf, int n)
 
 /*  Places [n] bytes of pseudo-random data into [buf].
  *  This should not be used for purposes such as key generation.
+ *  Once the PRNG has been initialized, the data is generated by the calling
+ *    thread's own DRBG so salts, IVs, and nonces can be produced without
+ *    contending for the shared entropy pool.
  */
 void
 random_pseudo_bytes (void *buf, int n)
 {
+    random_drbg_p d;
+
     if (!buf || (n <= 0)) {
         return;
     }
+    if (_random_drbg_is_init && (d = _random_drbg_get ())) {
+        _random_drbg_bytes (d, buf, n);
+        return;
+    }
     _random_pseudo_bytes (buf, n);
     return;
 }
@@ -547,6 +613,8 @@ _random_stir_entropy (void *_arg_not_used_)
     if (entropy_read_uint (&buf) != -1) {
         _random_add (&buf, sizeof (buf));
     }
+    _random_drbg_gen_incr ();
+
     /*  Perform an exponential backoff up to the maximum timeout.  This allows
      *    for vigorous stirring of the entropy pool when the daemon is started.
      */
@@ -568,6 +636,217 @@ _random_stir_entropy (void *_arg_not_used_)
 }
 
 
+static void
+_random_drbg_init (void)
+{
+/*  Initializes per-thread DRBGs for random_pseudo_bytes().
+ */
+    static int got_atfork = 0;
+
+    if (_random_drbg_is_init) {
+        return;
+    }
+    if ((errno = pthread_key_create (&_random_drbg_key, _random_drbg_destroy))
+            != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to create PRNG DRBG key");
+    }
+    if (!got_atfork) {
+        if ((errno = pthread_atfork (NULL, NULL, _random_drbg_atfork_child))
+                != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to register PRNG DRBG fork handler");
+        }
+        got_atfork = 1;
+    }
+    _random_drbg_is_init = 1;
+    return;
+}
+
+
+static void
+_random_drbg_fini (void)
+{
+/*  Shuts down per-thread DRBGs.  Subsequent requests for pseudo-random data
+ *    are satisfied from the entropy pool.
+ *  The calling thread's DRBG is destroyed here since key destructors are
+ *    only invoked at thread exit.
+ */
+    random_drbg_p d;
+
+    if (!_random_drbg_is_init) {
+        return;
+    }
+    _random_drbg_is_init = 0;
+
+    if ((d = pthread_getspecific (_random_drbg_key)) != NULL) {
+        (void) pthread_setspecific (_random_drbg_key, NULL);
+        _random_drbg_destroy (d);
+    }
+    (void) pthread_key_delete (_random_drbg_key);
+    return;
+}
+
+
+static random_drbg_p
+_random_drbg_get (void)
+{
+/*  Returns the calling thread's DRBG, creating it on first use.
+ *  Returns NULL on error.
+ */
+    random_drbg_p d;
+
+    if ((d = pthread_getspecific (_random_drbg_key)) != NULL) {
+        return (d);
+    }
+    if (!(d = malloc (sizeof (*d)))) {
+        log_msg (LOG_WARNING, "Failed to allocate PRNG DRBG");
+        return (NULL);
+    }
+    memset (d->key, 0, sizeof (d->key));
+    _random_drbg_reseed (d, _random_drbg_gen_load ());
+
+    if ((errno = pthread_setspecific (_random_drbg_key, d)) != 0) {
+        log_msg (LOG_WARNING, "Failed to set PRNG DRBG: %s",
+                strerror (errno));
+        _random_drbg_destroy (d);
+        return (NULL);
+    }
+    return (d);
+}
+
+
+static void
+_random_drbg_bytes (random_drbg_p d, unsigned char *buf, int n)
+{
+/*  Places [n] bytes of keystream from the DRBG [d] into [buf], reseeding
+ *    [d] from the entropy pool if the reseed generation has changed or its
+ *    output limit has been reached.
+ */
+    unsigned long gen;
+    int           m;
+
+    assert (d != NULL);
+    assert (buf != NULL);
+    assert (n > 0);
+
+    gen = _random_drbg_gen_load ();
+    if ((d->gen != gen) || (d->n_bytes >= RANDOM_DRBG_RESEED_BYTES)) {
+        _random_drbg_reseed (d, gen);
+    }
+    d->n_bytes += n;
+
+    while (n > 0) {
+        if (d->buf_pos >= RANDOM_DRBG_BUF_LEN) {
+            _random_drbg_refill (d);
+        }
+        m = MIN(n, RANDOM_DRBG_BUF_LEN - d->buf_pos);
+        memcpy (buf, d->buf + d->buf_pos, m);
+        memset (d->buf + d->buf_pos, 0, m);
+        d->buf_pos += m;
+        buf += m;
+        n -= m;
+    }
+    return;
+}
+
+
+static void
+_random_drbg_reseed (random_drbg_p d, unsigned long gen)
+{
+/*  Reseeds the DRBG [d] with fresh key material from the entropy pool,
+ *    discarding any unconsumed keystream.
+ *  The new key is mixed into the old so a failure to read from the entropy
+ *    pool does not reset the key to a known value.
+ */
+    unsigned char seed [CHACHA_KEY_LEN];
+    int           i;
+
+    assert (d != NULL);
+
+    _random_bytes (seed, sizeof (seed));
+    for (i = 0; i < CHACHA_KEY_LEN; i++) {
+        d->key[i] ^= seed[i];
+    }
+    memset (seed, 0, sizeof (seed));
+    memset (d->buf, 0, sizeof (d->buf));
+    d->buf_pos = RANDOM_DRBG_BUF_LEN;
+    d->gen = gen;
+    d->n_bytes = 0;
+    return;
+}
+
+
+static void
+_random_drbg_refill (random_drbg_p d)
+{
+/*  Refills the DRBG [d] keystream buffer, replacing its key with the start
+ *    of the new keystream (fast key erasure).
+ *  The nonce is fixed at zero since each key is used for only one refill.
+ */
+    static const unsigned char nonce [CHACHA_NONCE_LEN] = { 0 };
+    uint32_t i;
+
+    assert (d != NULL);
+
+    for (i = 0; i < RANDOM_DRBG_BUF_LEN / CHACHA_BLOCK_LEN; i++) {
+        chacha20_block (d->buf + (i * CHACHA_BLOCK_LEN), d->key, i, nonce);
+    }
+    memcpy (d->key, d->buf, CHACHA_KEY_LEN);
+    memset (d->buf, 0, CHACHA_KEY_LEN);
+    d->buf_pos = CHACHA_KEY_LEN;
+    return;
+}
+
+
+static void
+_random_drbg_destroy (void *arg)
+{
+/*  Erases and de-allocates the DRBG [arg] when its thread exits.
+ */
+    random_drbg_p d = arg;
+
+    if (d != NULL) {
+        memset (d, 0, sizeof (*d));
+        free (d);
+    }
+    return;
+}
+
+
+static void
+_random_drbg_atfork_child (void)
+{
+/*  Forces the DRBG inherited by the child process to be reseeded so parent
+ *    and child do not produce the same output.
+ */
+    _random_drbg_gen_incr ();
+    return;
+}
+
+
+static unsigned long
+_random_drbg_gen_load (void)
+{
+#ifdef __ATOMIC_RELAXED
+    return (__atomic_load_n (&_random_drbg_gen, __ATOMIC_RELAXED));
+#else  /* !__ATOMIC_RELAXED */
+    return (* (volatile unsigned long *) &_random_drbg_gen);
+#endif /* !__ATOMIC_RELAXED */
+}
+
+
+static void
+_random_drbg_gen_incr (void)
+{
+#ifdef __ATOMIC_RELAXED
+    (void) __atomic_add_fetch (&_random_drbg_gen, 1, __ATOMIC_RELAXED);
+#else  /* !__ATOMIC_RELAXED */
+    _random_drbg_gen++;
+#endif /* !__ATOMIC_RELAXED */
+    return;
+}
+
+
 /*****************************************************************************
  *  Private Functions (Libgcrypt)
  *****************************************************************************/
@@ -52,6 +52,14 @@
 #define REPLAY_HASH_SIZE        65537
 #define REPLAY_NODE_ALLOC_NUM   1024
 
+/*  Expiration time of a replay_probe() key, which matches a cred with the
+ *    same MAC that has not expired by the decode time [t].  The decode time
+ *    is negated to distinguish a probe key from an inserted cred, whose
+ *    expiration time is its (positive) encode time plus its TTL.
+ */
+#define REPLAY_PROBE_T_EXPIRED(t)   (- (time_t) (t))
+#define REPLAY_IS_PROBE(r)          ((r)->data.t_expired <= 0)
+
 
 /*****************************************************************************
  *  Private Data Types
@@ -259,6 +267,33 @@ replay_remove (munge_cred_t c)
 }
 
 
+int
+replay_probe (munge_cred_t c)
+{
+/*  Checks whether the credential [c] is already in the replay hash without
+ *    inserting it.  Only the MAC and decode time are needed, so this can be
+ *    called as soon as the "outer" credential data has been unpacked.
+ *  A stored credential that has expired by the decode time (but has not yet
+ *    been purged) is ignored so the credential is instead reported as
+ *    expired once decoded, as it would be without the probe.
+ *  Returns 1 if the credential is present (ie, replay), or 0 if not.
+ */
+    union replay_node  rnode;
+
+    if (!replay_hash || (c == NULL)) {
+        return (0);
+    }
+    /*  The expiration time resides in the encrypted "inner" data and is not
+     *    yet known, so the probe matches on the MAC of any unexpired cred.
+     */
+    rnode.data.t_expired = REPLAY_PROBE_T_EXPIRED (c->msg->time1);
+    assert (c->mac_len >= sizeof (rnode.data.mac));
+    memcpy (rnode.data.mac, c->mac, sizeof (rnode.data.mac));
+
+    return (hash_find (replay_hash, &rnode) != NULL);
+}
+
+
 void
 replay_purge (void)
 {
@@ -287,6 +322,19 @@ replay_purge (void)
 }
 
 
+int
+replay_count (void)
+{
+/*  Returns the number of credentials in the replay hash,
+ *    or -1 if the replay hash is disabled.
+ */
+    if (!replay_hash) {
+        return (-1);
+    }
+    return (hash_count (replay_hash));
+}
+
+
 /*****************************************************************************
  *  Private Functions
  *****************************************************************************/
@@ -308,6 +356,9 @@ replay_cmp_f (const replay_t r1, const replay_t r2)
 /*  Returns an integer that is less than zero if [r1] is less than [r2],
  *    equal to zero if [r1] is equal to [r2], and greater than zero
  *    if [r1] is greater than [r2].
+ *  Since creds are ordered by MAC first and then by expiration time, a
+ *    probe key sorts after the expired creds with its MAC and equal to the
+ *    unexpired ones, which remains consistent with this ordering.
  */
     int cmpval;
 
@@ -315,6 +366,12 @@ replay_cmp_f (const replay_t r1, const replay_t r2)
     if (cmpval != 0) {
         return (cmpval);
     }
+    if (REPLAY_IS_PROBE (r2)) {
+        return ((r1->data.t_expired < -r2->data.t_expired) ? -1 : 0);
+    }
+    if (REPLAY_IS_PROBE (r1)) {
+        return ((-r1->data.t_expired > r2->data.t_expired) ? 1 : 0);
+    }
     if (r1->data.t_expired < r2->data.t_expired) {
         return (-1);
     }
@@ -44,7 +44,11 @@ int replay_insert (munge_cred_t c);
 
 int replay_remove (munge_cred_t c);
 
+int replay_probe (munge_cred_t c);
+
 void replay_purge (void);
 
+int replay_count (void);
+
 
 #endif /* !REPLAY_H */
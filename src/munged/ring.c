@@ -0,0 +1,251 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include "atom.h"
+#include "ring.h"
+
+
+/*****************************************************************************
+ *  Notes
+ *****************************************************************************/
+/*
+ *  A bounded multi-producer/multi-consumer ring of fixed-size elements.
+ *    Each slot's sequence number indicates whether it is ready to be written
+ *    (seq == pos) or read (seq == pos + 1), so producers and consumers only
+ *    contend on the CAS of their respective position counter, and neither
+ *    blocks.
+ *  An element is claimed at a position, accessed in place, and then handed
+ *    over by committing (after writing) or releasing (after reading) that
+ *    position.  A consumer may claim several elements before releasing them.
+ */
+
+
+/*****************************************************************************
+ *  Data Types
+ *****************************************************************************/
+
+struct ring {
+    unsigned long      *seq;            /* sequence number for slot's turn   */
+    unsigned char      *elems;          /* preallocated array of elements    */
+    size_t              elem_size;      /* size of each element              */
+    unsigned long       mask;           /* ring index mask (num slots - 1)   */
+    unsigned long       enqueue_pos;    /* next ring position to enqueue     */
+    unsigned long       dequeue_pos;    /* next ring position to dequeue     */
+};
+
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+/*  Creates a ring of [n_slots] elements of [elem_size] bytes each.
+ *    The number of slots must be a power of 2.  Elements are zeroed.
+ *  Returns the new ring, or NULL on error (with errno set).
+ */
+ring_p
+ring_create (unsigned long n_slots, size_t elem_size)
+{
+    ring_p        r;
+    unsigned long i;
+
+    if ((n_slots == 0) || ((n_slots & (n_slots - 1)) != 0)
+            || (elem_size == 0)) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    if (!(r = malloc (sizeof (*r)))) {
+        return (NULL);
+    }
+    r->seq = malloc (sizeof (*r->seq) * n_slots);
+    r->elems = calloc (n_slots, elem_size);
+    if (!r->seq || !r->elems) {
+        ring_destroy (r);
+        errno = ENOMEM;
+        return (NULL);
+    }
+    for (i = 0; i < n_slots; i++) {
+        r->seq[i] = i;
+    }
+    r->elem_size = elem_size;
+    r->mask = n_slots - 1;
+    r->enqueue_pos = 0;
+    r->dequeue_pos = 0;
+    return (r);
+}
+
+
+/*  Destroys the ring [r].
+ */
+void
+ring_destroy (ring_p r)
+{
+    if (!r) {
+        return;
+    }
+    free (r->seq);
+    free (r->elems);
+    free (r);
+    return;
+}
+
+
+/*  Claims the slot at the tail of the ring [r] for writing, storing its
+ *    position in [pos].
+ *  Returns a pointer to the slot's element, or NULL if the ring is full.
+ *    The element must then be written and handed over by
+ *    ring_enqueue_commit().
+ */
+void *
+ring_enqueue_claim (ring_p r, unsigned long *pos)
+{
+    unsigned long p;
+    unsigned long seq;
+    long          diff;
+
+    assert (r != NULL);
+    assert (pos != NULL);
+
+    p = atom_load (&r->enqueue_pos);
+    for (;;) {
+        seq = atom_load (&r->seq[p & r->mask]);
+        diff = (long) seq - (long) p;
+        if (diff == 0) {
+            if (atom_cas (&r->enqueue_pos, &p, p + 1)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return (NULL);
+        }
+        else {
+            p = atom_load (&r->enqueue_pos);
+        }
+    }
+    *pos = p;
+    return (r->elems + ((p & r->mask) * r->elem_size));
+}
+
+
+/*  Hands over the element written at position [pos] of the ring [r]
+ *    to consumers.
+ */
+void
+ring_enqueue_commit (ring_p r, unsigned long pos)
+{
+    assert (r != NULL);
+
+    atom_store (&r->seq[pos & r->mask], pos + 1);
+    return;
+}
+
+
+/*  Claims the slot at the head of the ring [r] for reading, storing its
+ *    position in [pos].
+ *  Returns a pointer to the slot's element, or NULL if the ring is empty.
+ *    The element must then be read and its slot handed back by
+ *    ring_dequeue_release().
+ */
+void *
+ring_dequeue_claim (ring_p r, unsigned long *pos)
+{
+    unsigned long p;
+    unsigned long seq;
+    long          diff;
+
+    assert (r != NULL);
+    assert (pos != NULL);
+
+    p = atom_load (&r->dequeue_pos);
+    for (;;) {
+        seq = atom_load (&r->seq[p & r->mask]);
+        diff = (long) seq - (long) (p + 1);
+        if (diff == 0) {
+            if (atom_cas (&r->dequeue_pos, &p, p + 1)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return (NULL);
+        }
+        else {
+            p = atom_load (&r->dequeue_pos);
+        }
+    }
+    *pos = p;
+    return (r->elems + ((p & r->mask) * r->elem_size));
+}
+
+
+/*  Hands the slot read at position [pos] of the ring [r] back to producers.
+ */
+void
+ring_dequeue_release (ring_p r, unsigned long pos)
+{
+    assert (r != NULL);
+
+    atom_store (&r->seq[pos & r->mask], pos + r->mask + 1);
+    return;
+}
+
+
+/*  Returns non-zero if no element of the ring [r] is ready to be dequeued.
+ */
+int
+ring_is_empty (ring_p r)
+{
+    unsigned long pos;
+
+    assert (r != NULL);
+
+    pos = atom_load (&r->dequeue_pos);
+    return (atom_load (&r->seq[pos & r->mask]) != pos + 1);
+}
+
+
+/*  Returns the number of elements claimed for enqueueing but not yet
+ *    claimed for dequeueing in the ring [r].  This is only an estimate
+ *    while other threads are accessing the ring.
+ */
+unsigned long
+ring_count (ring_p r)
+{
+    unsigned long head;
+    unsigned long tail;
+
+    assert (r != NULL);
+
+    head = atom_load (&r->dequeue_pos);
+    tail = atom_load (&r->enqueue_pos);
+    return ((tail > head) ? (tail - head) : 0);
+}
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#ifndef RING_H
+#define RING_H
+
+
+#include <stddef.h>
+
+
+/*****************************************************************************
+ *  Data Types
+ *****************************************************************************/
+
+typedef struct ring * ring_p;
+
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+ring_p ring_create (unsigned long n_slots, size_t elem_size);
+
+void ring_destroy (ring_p r);
+
+void * ring_enqueue_claim (ring_p r, unsigned long *pos);
+
+void ring_enqueue_commit (ring_p r, unsigned long pos);
+
+void * ring_dequeue_claim (ring_p r, unsigned long *pos);
+
+void ring_dequeue_release (ring_p r, unsigned long pos);
+
+int ring_is_empty (ring_p r);
+
+unsigned long ring_count (ring_p r);
+
+
+#endif /* !RING_H */
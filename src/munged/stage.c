@@ -0,0 +1,442 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <munge.h>
+#include "log.h"
+#include "stage.h"
+
+
+/*****************************************************************************
+ *  Private Data Types
+ *****************************************************************************/
+
+/*  Per-thread stage accumulator.  Each thread updates its own accumulator
+ *    without locking; the accumulators are summed on demand.
+ */
+struct stage_thread {
+    uint64_t             last;          /* time of previous mark (ns)        */
+    struct stage_stats   stats;         /* thread's accumulated stage times  */
+    struct stage_thread *next;          /* next accumulator in list          */
+};
+
+typedef struct stage_thread * stage_thread_p;
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static stage_thread_p _stage_get_thread (void);
+
+static void _stage_thread_destroy (void *arg);
+
+static uint64_t _stage_now (void);
+
+
+/*****************************************************************************
+ *  Private Variables
+ *****************************************************************************/
+
+static const char *_stage_names[STAGE_LAST] = {
+    "recv",
+    "enc-validate",
+    "enc-init",
+    "enc-auth",
+    "enc-retry",
+    "enc-timestamp",
+    "enc-pack-outer",
+    "enc-pack-inner",
+    "enc-compress",
+    "enc-mac",
+    "enc-encrypt",
+    "enc-armor",
+    "enc-fini",
+    "enc-send",
+    "dec-validate",
+    "dec-timestamp",
+    "dec-auth",
+    "dec-retry",
+    "dec-unarmor",
+    "dec-unpack-outer",
+    "dec-replay-probe",
+    "dec-decrypt",
+    "dec-mac",
+    "dec-decompress",
+    "dec-unpack-inner",
+    "dec-gids",
+    "dec-check-auth",
+    "dec-check-time",
+    "dec-replay",
+    "dec-send",
+};
+
+static pthread_key_t       _stage_key;
+static pthread_mutex_t     _stage_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int                 _stage_is_init = 0;
+static volatile int        _stage_enabled = 0;
+
+/*  The _stage_threads list contains the accumulators of running threads.
+ *    The _stage_retired stats contain the sums from threads that have exited.
+ */
+static stage_thread_p      _stage_threads = NULL;
+static struct stage_stats  _stage_retired;
+
+
+/*****************************************************************************
+ *  Public Functions
+ *****************************************************************************/
+
+/*  Initializes the stage timing subsystem.  Timing is initially disabled.
+ */
+void
+stage_init (void)
+{
+    if (_stage_is_init) {
+        return;
+    }
+    if ((errno = pthread_key_create (&_stage_key, _stage_thread_destroy))
+            != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to create stage key");
+    }
+    memset (&_stage_retired, 0, sizeof (_stage_retired));
+    _stage_is_init = 1;
+    return;
+}
+
+
+/*  Shuts down the stage timing subsystem.
+ *  All threads recording stage times must have exited (or ceased recording).
+ */
+void
+stage_fini (void)
+{
+    stage_thread_p t;
+
+    if (!_stage_is_init) {
+        return;
+    }
+    _stage_enabled = 0;
+    _stage_is_init = 0;
+
+    if ((errno = pthread_mutex_lock (&_stage_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock stage mutex");
+    }
+    while (_stage_threads) {
+        t = _stage_threads;
+        _stage_threads = _stage_threads->next;
+        free (t);
+    }
+    if ((errno = pthread_mutex_unlock (&_stage_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock stage mutex");
+    }
+    (void) pthread_key_delete (_stage_key);
+    return;
+}
+
+
+/*  Enables stage timing if [enable] is non-zero; o/w, disables it.
+ */
+void
+stage_set_enabled (int enable)
+{
+    _stage_enabled = (_stage_is_init && enable) ? 1 : 0;
+    return;
+}
+
+
+/*  Returns non-zero if stage timing is enabled.
+ */
+int
+stage_is_enabled (void)
+{
+    return (_stage_enabled);
+}
+
+
+/*  Marks the start of processing a new message by the calling thread.
+ */
+void
+stage_begin (void)
+{
+    stage_thread_p t;
+
+    if (!_stage_enabled) {
+        return;
+    }
+    if (!(t = _stage_get_thread ())) {
+        return;
+    }
+    t->last = _stage_now ();
+    return;
+}
+
+
+/*  Marks the completion of stage [s] by the calling thread, attributing
+ *    the time elapsed since the previous mark (or begin) to that stage.
+ */
+void
+stage_mark (stage_t s)
+{
+    stage_thread_p t;
+    uint64_t       now;
+
+    assert (s < STAGE_LAST);
+
+    if (!_stage_enabled) {
+        return;
+    }
+    if (!(t = _stage_get_thread ())) {
+        return;
+    }
+    now = _stage_now ();
+    if (t->last != 0) {
+        t->stats.count[s]++;
+        t->stats.nsecs[s] += now - t->last;
+    }
+    t->last = now;
+    return;
+}
+
+
+/*  Marks the completion of stage [s] as with stage_mark().
+ *  Returns [rc] so a stage's return code can be passed through.
+ */
+int
+stage_mark_rc (stage_t s, int rc)
+{
+    stage_mark (s);
+    return (rc);
+}
+
+
+/*  Sums the stage times of all threads into [stats].
+ *  Accumulators are read without being locked by their threads, so a sum
+ *    taken while messages are being processed is approximate.
+ */
+void
+stage_get_stats (stage_stats_t stats)
+{
+    stage_thread_p t;
+    int            i;
+
+    assert (stats != NULL);
+
+    memset (stats, 0, sizeof (*stats));
+
+    if (!_stage_is_init) {
+        return;
+    }
+    if ((errno = pthread_mutex_lock (&_stage_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock stage mutex");
+    }
+    *stats = _stage_retired;
+
+    for (t = _stage_threads; t != NULL; t = t->next) {
+        for (i = 0; i < STAGE_LAST; i++) {
+            stats->count[i] += t->stats.count[i];
+            stats->nsecs[i] += t->stats.nsecs[i];
+        }
+    }
+    if ((errno = pthread_mutex_unlock (&_stage_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock stage mutex");
+    }
+    return;
+}
+
+
+/*  Clears the stage times of all threads.
+ *  As with stage_get_stats(), threads are not locked out while their
+ *    accumulators are cleared, so this should be called with timing disabled.
+ */
+void
+stage_reset (void)
+{
+    stage_thread_p t;
+
+    if (!_stage_is_init) {
+        return;
+    }
+    if ((errno = pthread_mutex_lock (&_stage_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock stage mutex");
+    }
+    memset (&_stage_retired, 0, sizeof (_stage_retired));
+
+    for (t = _stage_threads; t != NULL; t = t->next) {
+        memset (&t->stats, 0, sizeof (t->stats));
+        t->last = 0;
+    }
+    if ((errno = pthread_mutex_unlock (&_stage_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock stage mutex");
+    }
+    return;
+}
+
+
+/*  Logs the summed stage times of all threads at the given [priority].
+ */
+void
+stage_log (int priority)
+{
+    struct stage_stats stats;
+    uint64_t           total = 0;
+    int                i;
+
+    stage_get_stats (&stats);
+
+    for (i = 0; i < STAGE_LAST; i++) {
+        total += stats.nsecs[i];
+    }
+    if (total == 0) {
+        log_msg (priority, "Stage timing: no requests recorded");
+        return;
+    }
+    for (i = 0; i < STAGE_LAST; i++) {
+        if (stats.count[i] == 0) {
+            continue;
+        }
+        log_msg (priority,
+            "Stage timing: %-16s count=%" PRIu64 " total=%.3fms"
+            " avg=%.3fus pct=%.2f%%",
+            _stage_names[i], stats.count[i],
+            stats.nsecs[i] / 1e6,
+            stats.nsecs[i] / 1e3 / stats.count[i],
+            100.0 * stats.nsecs[i] / total);
+    }
+    return;
+}
+
+
+/*  Returns a string describing the stage [s].
+ */
+const char *
+stage_name (stage_t s)
+{
+    if ((s < 0) || (s >= STAGE_LAST)) {
+        return (NULL);
+    }
+    return (_stage_names[s]);
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+/*  Returns the calling thread's accumulator, creating it if needed,
+ *    or NULL on error.
+ */
+static stage_thread_p
+_stage_get_thread (void)
+{
+    stage_thread_p t;
+
+    if ((t = pthread_getspecific (_stage_key)) != NULL) {
+        return (t);
+    }
+    if (!(t = calloc (1, sizeof (*t)))) {
+        log_msg (LOG_WARNING, "Failed to allocate stage accumulator");
+        return (NULL);
+    }
+    if ((errno = pthread_setspecific (_stage_key, t)) != 0) {
+        log_msg (LOG_WARNING, "Failed to set stage accumulator: %s",
+                strerror (errno));
+        free (t);
+        return (NULL);
+    }
+    if ((errno = pthread_mutex_lock (&_stage_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock stage mutex");
+    }
+    t->next = _stage_threads;
+    _stage_threads = t;
+
+    if ((errno = pthread_mutex_unlock (&_stage_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock stage mutex");
+    }
+    return (t);
+}
+
+
+/*  Folds the exiting thread's accumulator [arg] into the retired stats.
+ */
+static void
+_stage_thread_destroy (void *arg)
+{
+    stage_thread_p  t = arg;
+    stage_thread_p *t_prev_ptr;
+    int             i;
+
+    if ((errno = pthread_mutex_lock (&_stage_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock stage mutex");
+    }
+    for (t_prev_ptr = &_stage_threads; *t_prev_ptr != NULL;
+            t_prev_ptr = &(*t_prev_ptr)->next) {
+        if (*t_prev_ptr == t) {
+            *t_prev_ptr = t->next;
+            for (i = 0; i < STAGE_LAST; i++) {
+                _stage_retired.count[i] += t->stats.count[i];
+                _stage_retired.nsecs[i] += t->stats.nsecs[i];
+            }
+            free (t);
+            break;
+        }
+    }
+    if ((errno = pthread_mutex_unlock (&_stage_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock stage mutex");
+    }
+    return;
+}
+
+
+/*  Returns the current monotonic time in nanoseconds.
+ */
+static uint64_t
+_stage_now (void)
+{
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    if (clock_gettime (CLOCK_MONOTONIC, &ts) == 0) {
+        return (((uint64_t) ts.tv_sec * 1000000000) + ts.tv_nsec);
+    }
+#endif /* HAVE_CLOCK_GETTIME && CLOCK_MONOTONIC */
+    struct timeval tv;
+
+    (void) gettimeofday (&tv, NULL);
+    return (((uint64_t) tv.tv_sec * 1000000000) + (tv.tv_usec * 1000));
+}
@@ -0,0 +1,127 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#ifndef STAGE_H
+#define STAGE_H
+
+
+#include <inttypes.h>
+
+
+/*****************************************************************************
+ *  Data Types
+ *****************************************************************************/
+
+typedef enum stage {
+    STAGE_RECV,
+    STAGE_ENC_VALIDATE,
+    STAGE_ENC_INIT,
+    STAGE_ENC_AUTH,
+    STAGE_ENC_RETRY,
+    STAGE_ENC_TIMESTAMP,
+    STAGE_ENC_PACK_OUTER,
+    STAGE_ENC_PACK_INNER,
+    STAGE_ENC_COMPRESS,
+    STAGE_ENC_MAC,
+    STAGE_ENC_ENCRYPT,
+    STAGE_ENC_ARMOR,
+    STAGE_ENC_FINI,
+    STAGE_ENC_SEND,
+    STAGE_DEC_VALIDATE,
+    STAGE_DEC_TIMESTAMP,
+    STAGE_DEC_AUTH,
+    STAGE_DEC_RETRY,
+    STAGE_DEC_UNARMOR,
+    STAGE_DEC_UNPACK_OUTER,
+    STAGE_DEC_REPLAY_PROBE,
+    STAGE_DEC_DECRYPT,
+    STAGE_DEC_MAC,
+    STAGE_DEC_DECOMPRESS,
+    STAGE_DEC_UNPACK_INNER,
+    STAGE_DEC_GIDS,
+    STAGE_DEC_CHECK_AUTH,
+    STAGE_DEC_CHECK_TIME,
+    STAGE_DEC_REPLAY,
+    STAGE_DEC_SEND,
+    STAGE_LAST
+} stage_t;
+
+struct stage_stats {
+    uint64_t        count[STAGE_LAST];  /* number of times stage completed   */
+    uint64_t        nsecs[STAGE_LAST];  /* total time spent in stage (ns)    */
+};
+
+typedef struct stage_stats * stage_stats_t;
+
+
+/*****************************************************************************
+ *  Macros
+ *****************************************************************************/
+
+/*  The stage timing hooks compile away to nothing unless WITH_STAGE_TIMING
+ *    is defined.  STAGE_TIMED() evaluates to the result of [EXPR] so it can
+ *    wrap each step of a processing pipeline.
+ */
+#ifdef WITH_STAGE_TIMING
+#  define STAGE_BEGIN()         stage_begin ()
+#  define STAGE_MARK(S)         stage_mark (S)
+#  define STAGE_TIMED(S, EXPR)  stage_mark_rc ((S), (EXPR))
+#else  /* !WITH_STAGE_TIMING */
+#  define STAGE_BEGIN()         do { } while (0)
+#  define STAGE_MARK(S)         do { } while (0)
+#  define STAGE_TIMED(S, EXPR)  (EXPR)
+#endif /* !WITH_STAGE_TIMING */
+
+
+/*****************************************************************************
+ *  Prototypes
+ *****************************************************************************/
+
+void stage_init (void);
+
+void stage_fini (void);
+
+void stage_set_enabled (int enable);
+
+int stage_is_enabled (void);
+
+void stage_begin (void);
+
+void stage_mark (stage_t s);
+
+int stage_mark_rc (stage_t s, int rc);
+
+void stage_get_stats (stage_stats_t stats);
+
+void stage_reset (void);
+
+void stage_log (int priority);
+
+const char * stage_name (stage_t s);
+
+
+#endif /* !STAGE_H */
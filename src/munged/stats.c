@@ -0,0 +1,643 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <munge.h>
+#include "auth_recv.h"
+#include "conf.h"
+#include "gids.h"
+#include "log.h"
+#include "m_msg.h"
+#include "replay.h"
+#include "stats.h"
+#include "str.h"
+#include "work.h"
+
+
+/*****************************************************************************
+ *  Private Constants
+ *****************************************************************************/
+
+/*  Number of munge_err_t values tracked per request type.
+ *    This covers the full range of the m_msg error_num field.
+ */
+#define STATS_ERR_NUM           256
+
+/*  Number of latency histogram buckets.  Bucket [i] counts requests taking
+ *    less than 2^i microseconds (but at least 2^(i-1)); the last bucket
+ *    counts everything slower.
+ */
+#define STATS_HIST_NUM          24
+
+/*  Initial size of the buffer for formatting a stats response.
+ */
+#define STATS_BUF_LEN           4096
+
+
+/*****************************************************************************
+ *  Private Data Types
+ *****************************************************************************/
+
+/*  Per-thread stats accumulator.  Each thread updates its own accumulator
+ *    without locking; the accumulators are summed when stats are queried.
+ */
+struct stats_thread {
+    uint64_t             counters [STATS_COUNTER_LAST];
+    uint64_t             errors [STATS_REQ_LAST] [STATS_ERR_NUM];
+    uint64_t             hist [STATS_REQ_LAST] [STATS_HIST_NUM];
+    uint64_t             usecs [STATS_REQ_LAST];
+    struct stats_thread *next;          /* next accumulator in list          */
+};
+
+typedef struct stats_thread * stats_thread_p;
+
+struct stats_buf {
+    char                *str;           /* formatted stats string            */
+    int                  len;           /* length of string (without NUL)    */
+    int                  size;          /* size of string mem allocation     */
+};
+
+typedef struct stats_buf * stats_buf_p;
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static stats_thread_p _stats_get_thread (void);
+
+static void _stats_thread_destroy (void *arg);
+
+static void _stats_sum (struct stats_thread *sum);
+
+static void _stats_sum_thread (struct stats_thread *sum,
+        const struct stats_thread *t);
+
+static char * _stats_format (void);
+
+static void _stats_format_req (stats_buf_p b, const struct stats_thread *sum,
+        stats_req_t r);
+
+static void _stats_append (stats_buf_p b, const char *fmt, ...);
+
+static int _stats_hist_bucket (uint64_t usecs);
+
+
+/*****************************************************************************
+ *  Private Variables
+ *****************************************************************************/
+
+static const char *_stats_counter_names [STATS_COUNTER_LAST] = {
+    "accept",
+    "accept.errors",
+    "recv.errors",
+    "invalid.requests",
+    "encode.shed",
+    "decode.shed",
+    "log.dropped",
+    "zip.attempted",
+    "zip.discarded",
+    "zip.skipped.estimate",
+    "zip.skipped.client",
+    "replay.early",
+    "stats.requests",
+};
+
+static const char *_stats_req_names [STATS_REQ_LAST] = {
+    "encode",
+    "decode",
+};
+
+/*  Short names for munge_err_t values, indexed by error number.
+ */
+static const char *_stats_err_names[] = {
+    "success",
+    "snafu",
+    "bad_arg",
+    "bad_length",
+    "overflow",
+    "no_memory",
+    "socket",
+    "timeout",
+    "bad_cred",
+    "bad_version",
+    "bad_cipher",
+    "bad_mac",
+    "bad_zip",
+    "bad_realm",
+    "cred_invalid",
+    "cred_expired",
+    "cred_rewound",
+    "cred_replayed",
+    "cred_unauthorized",
+};
+
+static pthread_key_t       _stats_key;
+static pthread_mutex_t     _stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int                 _stats_is_init = 0;
+static work_p              _stats_workers = NULL;
+static time_t              _stats_t_start = 0;
+
+/*  The _stats_threads list contains the accumulators of running threads.
+ *    The _stats_retired accumulator contains sums from exited threads.
+ */
+static stats_thread_p      _stats_threads = NULL;
+static struct stats_thread _stats_retired;
+
+
+/*****************************************************************************
+ *  Public Functions
+ *****************************************************************************/
+
+/*  Initializes the stats subsystem.
+ *  The work crew [workers] is queried for its queue depth.
+ */
+void
+stats_init (work_p workers)
+{
+    if (_stats_is_init) {
+        return;
+    }
+    if ((errno = pthread_key_create (&_stats_key, _stats_thread_destroy))
+            != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to create stats key");
+    }
+    if (time (&_stats_t_start) == (time_t) -1) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to query current time");
+    }
+    memset (&_stats_retired, 0, sizeof (_stats_retired));
+    _stats_workers = workers;
+    _stats_is_init = 1;
+    return;
+}
+
+
+/*  Shuts down the stats subsystem.
+ *  All threads recording stats must have exited (or ceased recording).
+ */
+void
+stats_fini (void)
+{
+    stats_thread_p t;
+
+    if (!_stats_is_init) {
+        return;
+    }
+    _stats_is_init = 0;
+    _stats_workers = NULL;
+
+    if ((errno = pthread_mutex_lock (&_stats_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock stats mutex");
+    }
+    while (_stats_threads) {
+        t = _stats_threads;
+        _stats_threads = _stats_threads->next;
+        free (t);
+    }
+    if ((errno = pthread_mutex_unlock (&_stats_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock stats mutex");
+    }
+    (void) pthread_key_delete (_stats_key);
+    return;
+}
+
+
+/*  Returns the current monotonic time in microseconds.
+ */
+uint64_t
+stats_time (void)
+{
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    if (clock_gettime (CLOCK_MONOTONIC, &ts) == 0) {
+        return (((uint64_t) ts.tv_sec * 1000000) + (ts.tv_nsec / 1000));
+    }
+#endif /* HAVE_CLOCK_GETTIME && CLOCK_MONOTONIC */
+    struct timeval tv;
+
+    (void) gettimeofday (&tv, NULL);
+    return (((uint64_t) tv.tv_sec * 1000000) + tv.tv_usec);
+}
+
+
+/*  Increments the counter [c] for the calling thread.
+ */
+void
+stats_incr (stats_counter_t c)
+{
+    stats_thread_p t;
+
+    assert (c < STATS_COUNTER_LAST);
+
+    if (!_stats_is_init || !(t = _stats_get_thread ())) {
+        return;
+    }
+    t->counters[c]++;
+    return;
+}
+
+
+/*  Records the completion of a request of type [r] with result [e] for the
+ *    calling thread.  Its latency is measured from [t_start] as returned by
+ *    stats_time().
+ */
+void
+stats_request (stats_req_t r, munge_err_t e, uint64_t t_start)
+{
+    stats_thread_p t;
+    uint64_t       usecs;
+    uint64_t       t_now;
+
+    assert (r < STATS_REQ_LAST);
+
+    if (!_stats_is_init || !(t = _stats_get_thread ())) {
+        return;
+    }
+    t_now = stats_time ();
+    usecs = (t_now > t_start) ? t_now - t_start : 0;
+
+    t->errors[r][(unsigned) e % STATS_ERR_NUM]++;
+    t->hist[r][_stats_hist_bucket (usecs)]++;
+    t->usecs[r] += usecs;
+    return;
+}
+
+
+/*  Processes a stats request message [m], responding with the current stats
+ *    formatted as lines of "name value" pairs.
+ *  Only root and the user running the daemon are authorized.
+ *  Returns 0 on success, or -1 on error.
+ */
+int
+stats_process_msg (m_msg_t m)
+{
+    uid_t  uid;
+    gid_t  gid;
+    char  *s;
+    int    rc = -1;
+
+    stats_incr (STATS_STATS_REQ);
+
+    /*  Discard any request data since no arguments are currently defined.
+     */
+    if (m->data) {
+        if (!m->data_is_copy) {
+            free (m->data);
+        }
+        m->data = NULL;
+    }
+    m->data_len = 0;
+
+    if (auth_recv (m, &uid, &gid) != EMUNGE_SUCCESS) {
+        m_msg_set_err (m, EMUNGE_SNAFU,
+            strdup ("Failed to determine client identity"));
+    }
+    else if ((uid != 0) && (uid != geteuid ())) {
+        m_msg_set_err (m, EMUNGE_CRED_UNAUTHORIZED,
+            strdupf ("Unauthorized stats request for client UID=%u GID=%u",
+                (unsigned int) uid, (unsigned int) gid));
+    }
+    else if (!(s = _stats_format ())) {
+        m_msg_set_err (m, EMUNGE_NO_MEMORY,
+            strdup ("Failed to format stats"));
+    }
+    else {
+        m->data = s;
+        m->data_len = strlen (s) + 1;
+        m->data_is_copy = 0;
+        rc = 0;
+    }
+    m->retry = 0;                       /* non-zero marks a shed request */
+    if (m_msg_send (m, MUNGE_MSG_STATS_RSP, 0) != EMUNGE_SUCCESS) {
+        rc = -1;
+    }
+    return (rc);
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+/*  Returns the calling thread's accumulator, creating it if needed,
+ *    or NULL on error.
+ */
+static stats_thread_p
+_stats_get_thread (void)
+{
+    stats_thread_p t;
+
+    if ((t = pthread_getspecific (_stats_key)) != NULL) {
+        return (t);
+    }
+    if (!(t = calloc (1, sizeof (*t)))) {
+        log_msg (LOG_WARNING, "Failed to allocate stats accumulator");
+        return (NULL);
+    }
+    if ((errno = pthread_setspecific (_stats_key, t)) != 0) {
+        log_msg (LOG_WARNING, "Failed to set stats accumulator: %s",
+                strerror (errno));
+        free (t);
+        return (NULL);
+    }
+    if ((errno = pthread_mutex_lock (&_stats_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock stats mutex");
+    }
+    t->next = _stats_threads;
+    _stats_threads = t;
+
+    if ((errno = pthread_mutex_unlock (&_stats_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock stats mutex");
+    }
+    return (t);
+}
+
+
+/*  Folds the exiting thread's accumulator [arg] into the retired stats.
+ */
+static void
+_stats_thread_destroy (void *arg)
+{
+    stats_thread_p  t = arg;
+    stats_thread_p *t_prev_ptr;
+
+    if ((errno = pthread_mutex_lock (&_stats_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock stats mutex");
+    }
+    for (t_prev_ptr = &_stats_threads; *t_prev_ptr != NULL;
+            t_prev_ptr = &(*t_prev_ptr)->next) {
+        if (*t_prev_ptr == t) {
+            *t_prev_ptr = t->next;
+            _stats_sum_thread (&_stats_retired, t);
+            free (t);
+            break;
+        }
+    }
+    if ((errno = pthread_mutex_unlock (&_stats_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock stats mutex");
+    }
+    return;
+}
+
+
+/*  Sums the accumulators of all threads into [sum].
+ *  Accumulators are read without being locked by their threads, so the
+ *    result is approximate while requests are being processed.
+ */
+static void
+_stats_sum (struct stats_thread *sum)
+{
+    stats_thread_p t;
+
+    assert (sum != NULL);
+
+    if ((errno = pthread_mutex_lock (&_stats_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock stats mutex");
+    }
+    *sum = _stats_retired;
+
+    for (t = _stats_threads; t != NULL; t = t->next) {
+        _stats_sum_thread (sum, t);
+    }
+    if ((errno = pthread_mutex_unlock (&_stats_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock stats mutex");
+    }
+    sum->next = NULL;
+    return;
+}
+
+
+/*  Adds the accumulator [t] into [sum].
+ */
+static void
+_stats_sum_thread (struct stats_thread *sum, const struct stats_thread *t)
+{
+    int i, r;
+
+    for (i = 0; i < STATS_COUNTER_LAST; i++) {
+        sum->counters[i] += t->counters[i];
+    }
+    for (r = 0; r < STATS_REQ_LAST; r++) {
+        for (i = 0; i < STATS_ERR_NUM; i++) {
+            sum->errors[r][i] += t->errors[r][i];
+        }
+        for (i = 0; i < STATS_HIST_NUM; i++) {
+            sum->hist[r][i] += t->hist[r][i];
+        }
+        sum->usecs[r] += t->usecs[r];
+    }
+    return;
+}
+
+
+/*  Returns a new string containing the current stats, or NULL on error.
+ *  The caller is responsible for freeing this string.
+ */
+static char *
+_stats_format (void)
+{
+    struct stats_buf     buf;
+    struct stats_thread *sum;
+    time_t               t_now;
+    time_t               t_update;
+    int                  n_queued, n_working, n_workers;
+    int                  n_min, n_max;
+    int                  n;
+    int                  i;
+
+    if (!(sum = malloc (sizeof (*sum)))) {
+        return (NULL);
+    }
+    _stats_sum (sum);
+
+    buf.len = 0;
+    buf.size = STATS_BUF_LEN;
+    if (!(buf.str = malloc (buf.size))) {
+        free (sum);
+        return (NULL);
+    }
+    buf.str[0] = '\0';
+
+    if (time (&t_now) == (time_t) -1) {
+        t_now = _stats_t_start;
+    }
+    _stats_append (&buf, "pid %ld\n", (long) getpid ());
+    _stats_append (&buf, "uptime.secs %ld\n", (long) (t_now - _stats_t_start));
+
+    for (i = 0; i < STATS_COUNTER_LAST; i++) {
+        _stats_append (&buf, "%s %" PRIu64 "\n",
+            _stats_counter_names[i], sum->counters[i]);
+    }
+    for (i = 0; i < STATS_REQ_LAST; i++) {
+        _stats_format_req (&buf, sum, i);
+    }
+    if (_stats_workers) {
+        work_get_stats (_stats_workers, &n_queued, &n_working, &n_workers);
+        work_get_limits (_stats_workers, &n_min, &n_max);
+        _stats_append (&buf, "work.threads %d\n", n_workers);
+        _stats_append (&buf, "work.threads.min %d\n", n_min);
+        _stats_append (&buf, "work.threads.max %d\n", n_max);
+        _stats_append (&buf, "work.busy %d\n", n_working);
+        _stats_append (&buf, "work.queued %d\n", n_queued);
+    }
+    if ((n = replay_count ()) >= 0) {
+        _stats_append (&buf, "replay.entries %d\n", n);
+    }
+    if (gids_get_stats (conf->gids, &n, &t_update) == 0) {
+        _stats_append (&buf, "gids.uids %d\n", n);
+        if (t_update > 0) {
+            _stats_append (&buf, "gids.age.secs %ld\n",
+                (long) (t_now - t_update));
+        }
+    }
+    free (sum);
+
+    if (buf.len < 0) {
+        free (buf.str);
+        return (NULL);
+    }
+    return (buf.str);
+}
+
+
+/*  Appends the stats for requests of type [r] from [sum] to [b].
+ */
+static void
+_stats_format_req (stats_buf_p b, const struct stats_thread *sum,
+        stats_req_t r)
+{
+    const char *req = _stats_req_names[r];
+    uint64_t    total = 0;
+    int         n_errs = sizeof (_stats_err_names) / sizeof (*_stats_err_names);
+    int         i;
+
+    for (i = 0; i < STATS_ERR_NUM; i++) {
+        total += sum->errors[r][i];
+    }
+    _stats_append (b, "%s.requests %" PRIu64 "\n", req, total);
+    _stats_append (b, "%s.errors %" PRIu64 "\n",
+        req, total - sum->errors[r][EMUNGE_SUCCESS]);
+
+    for (i = 1; i < STATS_ERR_NUM; i++) {
+        if (sum->errors[r][i] == 0) {
+            continue;
+        }
+        if (i < n_errs) {
+            _stats_append (b, "%s.errors.%s %" PRIu64 "\n",
+                req, _stats_err_names[i], sum->errors[r][i]);
+        }
+        else {
+            _stats_append (b, "%s.errors.%d %" PRIu64 "\n",
+                req, i, sum->errors[r][i]);
+        }
+    }
+    _stats_append (b, "%s.latency.usecs.sum %" PRIu64 "\n",
+        req, sum->usecs[r]);
+
+    for (i = 0; i < STATS_HIST_NUM; i++) {
+        if (sum->hist[r][i] == 0) {
+            continue;
+        }
+        if (i < STATS_HIST_NUM - 1) {
+            _stats_append (b, "%s.latency.usecs.lt_%lu %" PRIu64 "\n",
+                req, 1UL << i, sum->hist[r][i]);
+        }
+        else {
+            _stats_append (b, "%s.latency.usecs.ge_%lu %" PRIu64 "\n",
+                req, 1UL << (i - 1), sum->hist[r][i]);
+        }
+    }
+    return;
+}
+
+
+/*  Appends the formatted string [fmt] to the buffer [b], growing it as
+ *    needed.  On error, the buffer length is set to -1.
+ */
+static void
+_stats_append (stats_buf_p b, const char *fmt, ...)
+{
+    va_list  vargs;
+    int      n;
+    char    *p;
+
+    if (b->len < 0) {
+        return;
+    }
+    for (;;) {
+        va_start (vargs, fmt);
+        n = vsnprintf (b->str + b->len, b->size - b->len, fmt, vargs);
+        va_end (vargs);
+
+        if (n < 0) {
+            b->len = -1;
+            return;
+        }
+        if (n < b->size - b->len) {
+            b->len += n;
+            return;
+        }
+        if (!(p = realloc (b->str, b->size * 2))) {
+            b->len = -1;
+            return;
+        }
+        b->str = p;
+        b->size *= 2;
+    }
+}
+
+
+/*  Returns the latency histogram bucket for a request taking [usecs].
+ */
+static int
+_stats_hist_bucket (uint64_t usecs)
+{
+    int i = 0;
+
+    while ((usecs > 0) && (i < STATS_HIST_NUM - 1)) {
+        usecs >>= 1;
+        i++;
+    }
+    return (i);
+}
@@ -0,0 +1,84 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+
+#ifndef STATS_H
+#define STATS_H
+
+
+#include <inttypes.h>
+#include <munge.h>
+#include "m_msg.h"
+#include "work.h"
+
+
+/*****************************************************************************
+ *  Data Types
+ *****************************************************************************/
+
+typedef enum stats_counter {
+    STATS_ACCEPT,                       /* client connections accepted       */
+    STATS_ACCEPT_ERR,                   /* failures accepting connections    */
+    STATS_RECV_ERR,                     /* failures receiving requests       */
+    STATS_BAD_REQ,                      /* requests of invalid message type  */
+    STATS_ENC_SHED,                     /* encode requests shed by overload  */
+    STATS_DEC_SHED,                     /* decode requests shed by overload  */
+    STATS_LOG_DROP,                     /* log records dropped by log queue  */
+    STATS_ZIP_ATTEMPT,                  /* compressions attempted            */
+    STATS_ZIP_DISCARD,                  /* compressions discarded as larger  */
+    STATS_ZIP_SKIP_EST,                 /* compressions skipped by estimate  */
+    STATS_ZIP_SKIP_CLIENT,              /* compressions skipped by client    */
+    STATS_REPLAY_EARLY,                 /* replays rejected before decrypt   */
+    STATS_STATS_REQ,                    /* stats requests                    */
+    STATS_COUNTER_LAST
+} stats_counter_t;
+
+typedef enum stats_req {
+    STATS_REQ_ENC,                      /* encode requests                   */
+    STATS_REQ_DEC,                      /* decode requests                   */
+    STATS_REQ_LAST
+} stats_req_t;
+
+
+/*****************************************************************************
+ *  Prototypes
+ *****************************************************************************/
+
+void stats_init (work_p workers);
+
+void stats_fini (void);
+
+uint64_t stats_time (void);
+
+void stats_incr (stats_counter_t c);
+
+void stats_request (stats_req_t r, munge_err_t e, uint64_t t_start);
+
+int stats_process_msg (m_msg_t m);
+
+
+#endif /* !STATS_H */
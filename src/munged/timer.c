@@ -29,6 +29,7 @@
  *****************************************************************************/
 
 
+
 #if HAVE_CONFIG_H
 #  include <config.h>
 #endif /* HAVE_CONFIG_H */
@@ -37,16 +38,34 @@
 #include <errno.h>
 #include <pthread.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
 #include <munge.h>
+#if HAVE_TIMERFD_CREATE
+#  include <sys/timerfd.h>
+#endif /* HAVE_TIMERFD_CREATE */
 #include "clock.h"
+#include "hash.h"
 #include "log.h"
 #include "thread.h"
 #include "timer.h"
 
 
+/*****************************************************************************
+ *  Constants
+ *****************************************************************************/
+
+/*  Number of buckets in the hash for locating active timers by ID.
+ */
+#define TIMER_HASH_SIZE         1021
+
+/*  Initial number of slots in the active timer heap.
+ */
+#define TIMER_HEAP_MIN_SIZE     16
+
+
 /*****************************************************************************
  *  Private Data Types
  *****************************************************************************/
@@ -56,6 +75,7 @@ struct timer {
     struct timespec    ts;              /* expiration time                   */
     callback_f         f;               /* callback function                 */
     void              *arg;             /* callback function arg             */
+    int                idx;             /* index in active heap, or -1       */
     struct timer      *next;            /* next timer in list                */
 };
 
@@ -70,8 +90,33 @@ static void * _timer_thread (void *arg);
 
 static void _timer_thread_cleanup (void *arg);
 
+static timer_p _timer_expire (void);
+
+static int _timer_get_timespec (struct timespec *tsp, long msec);
+
+static void _timer_fd_arm (void);
+
+#if HAVE_TIMERFD_CREATE
+static void _timer_rebase (struct timespec *tsp,
+        const struct timespec *ts_from, const struct timespec *ts_to);
+#endif /* HAVE_TIMERFD_CREATE */
+
 static timer_p _timer_alloc (void);
 
+static void _timer_heap_insert (timer_p t);
+
+static void _timer_heap_remove (timer_p t);
+
+static void _timer_heap_sift_up (int i);
+
+static void _timer_heap_sift_down (int i);
+
+static int _timer_is_before (timer_p t1, timer_p t2);
+
+static unsigned int _timer_key_f (const long *id);
+
+static int _timer_cmp_f (const long *id1, const long *id2);
+
 
 /*****************************************************************************
  *  Private Variables
@@ -81,14 +126,31 @@ static pthread_t       _timer_tid = 0;
 static pthread_cond_t  _timer_cond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t _timer_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/*  The _timer_fd is the timerfd used in place of the timer thread when
+ *    timers are dispatched from the caller's event loop, or -1.
+ *  It is armed to the expiration time of the heap root, and active timer
+ *    timespecs are measured against the monotonic clock.
+ */
+static int             _timer_fd = -1;
+
 /*  The _timer_id is the ID of the last timer that was set.
  */
 static long            _timer_id = 0;
 
-/*  The _timer_active list contains timers waiting to be dispatched, sorted in
- *    order of increasing timespecs; the list head is the next timer to expire.
+/*  The _timer_heap is a binary min-heap of [_timer_heap_len] timers waiting
+ *    to be dispatched, ordered by increasing timespecs (with ties broken by
+ *    timer ID); the heap root is the next timer to expire.  Each timer
+ *    records its heap index so it can be removed in O(log n).
+ *  The heap array is grown as needed to [_timer_heap_size] slots.
+ */
+static timer_p        *_timer_heap = NULL;
+static int             _timer_heap_len = 0;
+static int             _timer_heap_size = 0;
+
+/*  The _timer_hash maps the IDs of timers in the heap to their timers
+ *    so timer_cancel() does not need to search the heap.
  */
-static timer_p         _timer_active = NULL;
+static hash_t          _timer_hash = NULL;
 
 /*  The _timer_inactive list contains timers that have been dispatched and can
  *    be reused without allocating more memory.
@@ -109,7 +171,7 @@ timer_init (void)
     pthread_attr_t tattr;
     size_t         stacksize = 256 * 1024;
 
-    if (_timer_tid != 0) {
+    if ((_timer_tid != 0) || (_timer_fd >= 0)) {
         return;
     }
     if ((errno = pthread_attr_init (&tattr)) != 0) {
@@ -141,42 +203,176 @@ timer_init (void)
 }
 
 
+/*  Initialize timers to be driven by a timerfd instead of the timer thread.
+ *    The caller is responsible for polling the fd returned by timer_get_fd()
+ *    and invoking timer_dispatch() whenever it becomes readable; expired
+ *    timers are then dispatched from the calling thread.
+ *  Active timers are measured against the monotonic clock so changes to the
+ *    system time do not cause timers to fire early or late.  Timers set
+ *    before calling this routine are rebased onto the monotonic clock.
+ *  Returns 0 on success, or -1 on error (with errno set appropriately).
+ */
+int
+timer_init_fd (void)
+{
+#if ! HAVE_TIMERFD_CREATE
+    errno = ENOSYS;
+    return (-1);
+#else  /* HAVE_TIMERFD_CREATE */
+    struct timespec  ts_real;
+    struct timespec  ts_mono;
+    int              fd;
+    int              i;
+
+    if ((_timer_tid != 0) || (_timer_fd >= 0)) {
+        errno = EEXIST;
+        return (-1);
+    }
+    if (clock_get_monotonic_timespec (&ts_mono, 0) < 0) {
+        return (-1);
+    }
+    fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        return (-1);
+    }
+    if ((errno = pthread_mutex_lock (&_timer_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock timer mutex");
+    }
+    if (clock_get_timespec (&ts_real, 0) < 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to query current time");
+    }
+    /*  Shifting every timer by the same offset preserves heap order.
+     */
+    for (i = 0; i < _timer_heap_len; i++) {
+        _timer_rebase (&_timer_heap[i]->ts, &ts_real, &ts_mono);
+    }
+    _timer_fd = fd;
+    _timer_fd_arm ();
+
+    if ((errno = pthread_mutex_unlock (&_timer_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock timer mutex");
+    }
+    log_msg (LOG_INFO, "Enabled timerfd-based timer dispatch");
+    return (0);
+#endif /* HAVE_TIMERFD_CREATE */
+}
+
+
+/*  Returns the timerfd set up by timer_init_fd(), or -1 if timers are
+ *    being dispatched by the timer thread.
+ */
+int
+timer_get_fd (void)
+{
+    return (_timer_fd);
+}
+
+
+/*  Dispatches expired timers when the timerfd becomes readable.
+ *  Callback functions are invoked from the calling thread.
+ */
+void
+timer_dispatch (void)
+{
+#if HAVE_TIMERFD_CREATE
+    uint64_t  n;
+    timer_p   timer_expired;
+    timer_p   t;
+
+    if (_timer_fd < 0) {
+        return;
+    }
+    /*  Consume the expiration count.  The fd is non-blocking, so a spurious
+     *    wakeup (or a timer re-armed since the last poll) yields EAGAIN.
+     */
+    if (read (_timer_fd, &n, sizeof (n)) < 0) {
+        if ((errno != EAGAIN) && (errno != EINTR)) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to read timerfd");
+        }
+    }
+    if ((errno = pthread_mutex_lock (&_timer_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock timer mutex");
+    }
+    timer_expired = _timer_expire ();
+
+    if (timer_expired) {
+        if ((errno = pthread_mutex_unlock (&_timer_mutex)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock timer mutex");
+        }
+        for (t = timer_expired; t != NULL; t = t->next) {
+            t->f (t->arg);
+        }
+        if ((errno = pthread_mutex_lock (&_timer_mutex)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock timer mutex");
+        }
+        for (t = timer_expired; t->next != NULL; t = t->next) {
+            ;
+        }
+        t->next = _timer_inactive;
+        _timer_inactive = timer_expired;
+    }
+    /*  Re-arm for the (possibly new) heap root.
+     */
+    _timer_fd_arm ();
+
+    if ((errno = pthread_mutex_unlock (&_timer_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock timer mutex");
+    }
+#endif /* HAVE_TIMERFD_CREATE */
+    return;
+}
+
+
 /*  Cancels the timer thread and all pending timers.
  */
 void
 timer_fini (void)
 {
     void    *result;
-    timer_p *t_prev_ptr;
     timer_p  t;
+    int      i;
 
-    if (_timer_tid == 0) {
-        return;
-    }
-    if ((errno = pthread_cancel (_timer_tid)) != 0) {
-        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to cancel timer thread");
+    if (_timer_fd >= 0) {
+        (void) close (_timer_fd);
+        _timer_fd = -1;
     }
-    if ((errno = pthread_join (_timer_tid, &result)) != 0) {
-        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to join timer thread");
+    else if (_timer_tid != 0) {
+        if ((errno = pthread_cancel (_timer_tid)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to cancel timer thread");
+        }
+        if ((errno = pthread_join (_timer_tid, &result)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to join timer thread");
+        }
+        if (result != PTHREAD_CANCELED) {
+            log_err (EMUNGE_SNAFU, LOG_ERR, "Timer thread was not canceled");
+        }
+        _timer_tid = 0;
     }
-    if (result != PTHREAD_CANCELED) {
-        log_err (EMUNGE_SNAFU, LOG_ERR, "Timer thread was not canceled");
+    else {
+        return;
     }
-    _timer_tid = 0;
 
     if ((errno = pthread_mutex_lock (&_timer_mutex)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to lock timer mutex");
     }
     /*  Cancel pending timers by moving active timers to the inactive list.
      */
-    if (_timer_active) {
-        t_prev_ptr = &_timer_active;
-        while (*t_prev_ptr) {
-            t_prev_ptr = &(*t_prev_ptr)->next;
-        }
-        *t_prev_ptr = _timer_inactive;
-        _timer_inactive = _timer_active;
-        _timer_active = NULL;
+    for (i = 0; i < _timer_heap_len; i++) {
+        t = _timer_heap[i];
+        t->idx = -1;
+        t->next = _timer_inactive;
+        _timer_inactive = t;
+    }
+    free (_timer_heap);
+    _timer_heap = NULL;
+    _timer_heap_len = 0;
+    _timer_heap_size = 0;
+
+    if (_timer_hash) {
+        hash_destroy (_timer_hash);
+        _timer_hash = NULL;
     }
     /*  De-allocate timers.
      */
@@ -193,6 +389,8 @@ timer_fini (void)
 
 
 /*  Sets a timer to expire at the absolute time specified by [tsp].
+ *    This time is measured against the monotonic clock if timers are
+ *    driven by a timerfd (see timer_init_fd()).
  *    At expiration, the callback function [cb] will be invoked with [arg].
  *  Returns a timer ID > 0, or -1 on error (with errno set appropriately).
  */
@@ -200,7 +398,7 @@ long
 timer_set_absolute (callback_f cb, void *arg, const struct timespec *tsp)
 {
     timer_p  t;
-    timer_p *t_prev_ptr;
+    long     id;
     int      do_signal = 0;
 
     if (!cb || !tsp) {
@@ -224,21 +422,24 @@ timer_set_absolute (callback_f cb, void *arg, const struct timespec *tsp)
     t->arg = arg;
     t->ts = *tsp;
 
-    /*  Insert the timer into the active list.
+    /*  Insert the timer into the active heap.
      */
-    t_prev_ptr = &_timer_active;
-    while (*t_prev_ptr && clock_is_timespec_le (&(*t_prev_ptr)->ts, &t->ts)) {
-        t_prev_ptr = &(*t_prev_ptr)->next;
-    }
-    t->next = *t_prev_ptr;
-    *t_prev_ptr = t;
+    _timer_heap_insert (t);
 
     /*  Only signal the timer thread if the active timer has changed.
      *  Set a flag here so the signal can be done outside the monitor lock.
+     *  A timerfd is re-armed while locked so concurrent updates are ordered.
      */
-    if (t_prev_ptr == &_timer_active) {
-        do_signal = 1;
+    if (t->idx == 0) {
+        if (_timer_fd >= 0) {
+            _timer_fd_arm ();
+        }
+        else {
+            do_signal = 1;
+        }
     }
+    id = t->id;
+
     if ((errno = pthread_mutex_unlock (&_timer_mutex)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock timer mutex");
     }
@@ -248,8 +449,8 @@ timer_set_absolute (callback_f cb, void *arg, const struct timespec *tsp)
                     "Failed to signal timer condition");
         }
     }
-    assert (t->id > 0);
-    return (t->id);
+    assert (id > 0);
+    return (id);
 }
 
 
@@ -265,7 +466,7 @@ timer_set_relative (callback_f cb, void *arg, long msec)
 
     /*  Convert the relative time offset into an absolute timespec from now.
      */
-    rv = clock_get_timespec (&ts, msec);
+    rv = _timer_get_timespec (&ts, msec);
     if (rv < 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to query current time");
     }
@@ -280,7 +481,6 @@ timer_set_relative (callback_f cb, void *arg, long msec)
 int
 timer_cancel (long id)
 {
-    timer_p *t_prev_ptr;
     timer_p  t = NULL;
     int      do_signal = 0;
 
@@ -293,24 +493,25 @@ timer_cancel (long id)
     }
     /*  Locate the active timer specified by [id].
      */
-    t_prev_ptr = &_timer_active;
-    while (*t_prev_ptr && (id != (*t_prev_ptr)->id)) {
-        t_prev_ptr = &(*t_prev_ptr)->next;
+    if (_timer_hash) {
+        t = hash_find (_timer_hash, &id);
     }
-    /*  Remove the located timer from the active list.
+    /*  Remove the located timer from the active heap.
      */
-    if (*t_prev_ptr) {
-        t = *t_prev_ptr;
-        *t_prev_ptr = t->next;
-        t->next = _timer_inactive;
-        _timer_inactive = t;
+    if (t) {
         /*
          *  Only signal the timer thread if the active timer was canceled.
          *  Set a flag here so the signal can be done outside the monitor lock.
          */
-        if (t_prev_ptr == &_timer_active) {
+        if ((t->idx == 0) && (_timer_fd < 0)) {
             do_signal = 1;
         }
+        _timer_heap_remove (t);
+        t->next = _timer_inactive;
+        _timer_inactive = t;
+        if (_timer_fd >= 0) {
+            _timer_fd_arm ();
+        }
     }
     if ((errno = pthread_mutex_unlock (&_timer_mutex)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to unlock timer mutex");
@@ -337,10 +538,8 @@ _timer_thread (void *arg)
  */
     sigset_t         sigset;
     int              cancel_state;
-    struct timespec  ts_now;
-    timer_p         *t_prev_ptr;
     timer_p          timer_expired;
-    int              rv;
+    timer_p          t;
 
     if (sigfillset (&sigset)) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to init timer sigset");
@@ -355,9 +554,9 @@ _timer_thread (void *arg)
 
     for (;;) {
         /*
-         *  Wait until a timer has been added to the active list.
+         *  Wait until a timer has been added to the active heap.
          */
-        while (!_timer_active) {
+        while (_timer_heap_len == 0) {
             /*
              *  Cancellation point.
              */
@@ -375,29 +574,9 @@ _timer_thread (void *arg)
             log_errno (EMUNGE_SNAFU, LOG_ERR,
                     "Failed to disable timer thread cancellation");
         }
-        rv = clock_get_timespec (&ts_now, 0);
-        if (rv < 0) {
-            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to query current time");
-        }
-        /*  Select expired timers.
-         */
-        t_prev_ptr = &_timer_active;
-        while (*t_prev_ptr
-                && clock_is_timespec_le (&(*t_prev_ptr)->ts, &ts_now)) {
-            t_prev_ptr = &(*t_prev_ptr)->next;
-        }
-        if (t_prev_ptr != &_timer_active) {
-            /*
-             *  Move expired timers from the active list onto an expired list.
-             *  All expired timers are dispatched before the active list is
-             *    rescanned.  This protects against an erroneous ts_now set in
-             *    the future from causing recurring timers to be continually
-             *    dispatched since ts_now will be requeried once the expired
-             *    list is processed.  (Issue 15)
-             */
-            timer_expired = _timer_active;
-            _timer_active = *t_prev_ptr;
-            *t_prev_ptr = NULL;
+        timer_expired = _timer_expire ();
+
+        if (timer_expired) {
             /*
              *  Unlock the mutex while dispatching callback functions in case
              *    any need to set/cancel timers.
@@ -408,20 +587,21 @@ _timer_thread (void *arg)
             }
             /*  Dispatch expired timers.
              */
-            t_prev_ptr = &timer_expired;
-            while (*t_prev_ptr) {
-                (*t_prev_ptr)->f ((*t_prev_ptr)->arg);
-                t_prev_ptr = &(*t_prev_ptr)->next;
+            for (t = timer_expired; t != NULL; t = t->next) {
+                t->f (t->arg);
             }
             if ((errno = pthread_mutex_lock (&_timer_mutex)) != 0) {
                 log_errno (EMUNGE_SNAFU, LOG_ERR,
                         "Failed to lock timer mutex");
             }
             /*  Move the expired timers onto the inactive list.
-             *  At the end of the previous while-loop, t_prev_ptr is the
-             *    address of the terminating NULL of the timer_expired list.
+             *  At the end of the dispatch for-loop, t is NULL; walk to the
+             *    tail of the timer_expired list to splice it on.
              */
-            *t_prev_ptr = _timer_inactive;
+            for (t = timer_expired; t->next != NULL; t = t->next) {
+                ;
+            }
+            t->next = _timer_inactive;
             _timer_inactive = timer_expired;
         }
         /*  Enable the thread's cancellation state.
@@ -440,12 +620,12 @@ _timer_thread (void *arg)
         /*  Wait until the next active timer is set to expire,
          *    or until the active timer changes.
          */
-        while (_timer_active) {
+        while (_timer_heap_len > 0) {
             /*
              *  Cancellation point.
              */
             errno = pthread_cond_timedwait (
-                    &_timer_cond, &_timer_mutex, &(_timer_active->ts));
+                    &_timer_cond, &_timer_mutex, &(_timer_heap[0]->ts));
 
             if (errno == EINTR) {
                 continue;
@@ -476,6 +656,120 @@ _timer_thread_cleanup (void *arg)
 }
 
 
+static timer_p
+_timer_expire (void)
+{
+/*  Moves expired timers from the active heap onto an expired list
+ *    (in order of expiration), and returns the head of that list.
+ *  All expired timers are dispatched before the active heap is
+ *    rechecked.  This protects against an erroneous ts_now set in
+ *    the future from causing recurring timers to be continually
+ *    dispatched since ts_now will be requeried once the expired
+ *    list is processed.  (Issue 15)
+ *  The mutex must be locked before calling this routine.
+ */
+    struct timespec  ts_now;
+    timer_p          timer_expired = NULL;
+    timer_p         *t_prev_ptr = &timer_expired;
+    timer_p          t;
+
+    assert (lsd_mutex_is_locked (&_timer_mutex));
+
+    if (_timer_get_timespec (&ts_now, 0) < 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to query current time");
+    }
+    while ((_timer_heap_len > 0)
+            && clock_is_timespec_le (&_timer_heap[0]->ts, &ts_now)) {
+        t = _timer_heap[0];
+        _timer_heap_remove (t);
+        t->next = NULL;
+        *t_prev_ptr = t;
+        t_prev_ptr = &t->next;
+    }
+    return (timer_expired);
+}
+
+
+static int
+_timer_get_timespec (struct timespec *tsp, long msec)
+{
+/*  Sets timespec [tsp] to the current time of the clock against which
+ *    active timers are measured, adjusted forward by [msec] milliseconds.
+ *  Returns 0 on success, or -1 on error (with errno set).
+ */
+    if (_timer_fd >= 0) {
+        return (clock_get_monotonic_timespec (tsp, msec));
+    }
+    return (clock_get_timespec (tsp, msec));
+}
+
+
+static void
+_timer_fd_arm (void)
+{
+/*  Arms the timerfd to expire at the time of the heap root,
+ *    or disarms it if no timers are active.
+ *  The mutex must be locked before calling this routine.
+ */
+#if HAVE_TIMERFD_CREATE
+    struct itimerspec its;
+
+    assert (_timer_fd >= 0);
+    assert (lsd_mutex_is_locked (&_timer_mutex));
+
+    its.it_interval.tv_sec = 0;
+    its.it_interval.tv_nsec = 0;
+    if (_timer_heap_len > 0) {
+        its.it_value = _timer_heap[0]->ts;
+        /*
+         *  An all-zero it_value would disarm the timer.
+         */
+        if ((its.it_value.tv_sec <= 0) && (its.it_value.tv_nsec <= 0)) {
+            its.it_value.tv_sec = 0;
+            its.it_value.tv_nsec = 1;
+        }
+    }
+    else {
+        its.it_value.tv_sec = 0;
+        its.it_value.tv_nsec = 0;
+    }
+    if (timerfd_settime (_timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to arm timerfd");
+    }
+#endif /* HAVE_TIMERFD_CREATE */
+    return;
+}
+
+
+#if HAVE_TIMERFD_CREATE
+static void
+_timer_rebase (struct timespec *tsp,
+        const struct timespec *ts_from, const struct timespec *ts_to)
+{
+/*  Rebases timespec [tsp] from the clock whose current time is [ts_from]
+ *    onto the clock whose current time is [ts_to].
+ */
+    const long nsecs_per_sec = 1000 * 1000 * 1000;
+
+    tsp->tv_sec += ts_to->tv_sec - ts_from->tv_sec;
+    tsp->tv_nsec += ts_to->tv_nsec - ts_from->tv_nsec;
+    if (tsp->tv_nsec < 0) {
+        tsp->tv_sec--;
+        tsp->tv_nsec += nsecs_per_sec;
+    }
+    else if (tsp->tv_nsec >= nsecs_per_sec) {
+        tsp->tv_sec++;
+        tsp->tv_nsec -= nsecs_per_sec;
+    }
+    if (tsp->tv_sec < 0) {
+        tsp->tv_sec = 0;
+        tsp->tv_nsec = 0;
+    }
+    return;
+}
+#endif /* HAVE_TIMERFD_CREATE */
+
+
 static timer_p
 _timer_alloc (void)
 {
@@ -494,5 +788,201 @@ _timer_alloc (void)
     else {
         t = malloc (sizeof (struct timer));
     }
+    if (t) {
+        t->idx = -1;
+    }
     return (t);
 }
+
+
+static void
+_timer_heap_insert (timer_p t)
+{
+/*  Inserts the timer [t] into the active heap and the ID hash,
+ *    growing the heap as needed.
+ *  The mutex must be locked before calling this routine.
+ */
+    timer_p *heap;
+    int      n;
+
+    assert (t != NULL);
+    assert (t->idx < 0);
+    assert (lsd_mutex_is_locked (&_timer_mutex));
+
+    if (!_timer_hash) {
+        _timer_hash = hash_create (TIMER_HASH_SIZE,
+                (hash_key_f) _timer_key_f, (hash_cmp_f) _timer_cmp_f, NULL);
+        if (!_timer_hash) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to allocate timer hash");
+        }
+    }
+    if (_timer_heap_len >= _timer_heap_size) {
+        n = (_timer_heap_size > 0)
+            ? _timer_heap_size * 2
+            : TIMER_HEAP_MIN_SIZE;
+        if (!(heap = realloc (_timer_heap, sizeof (*heap) * n))) {
+            log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+                    "Failed to allocate timer heap");
+        }
+        _timer_heap = heap;
+        _timer_heap_size = n;
+    }
+    if (!hash_insert (_timer_hash, &t->id, t)) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to insert timer #%ld into hash", t->id);
+    }
+    t->idx = _timer_heap_len++;
+    _timer_heap[t->idx] = t;
+    _timer_heap_sift_up (t->idx);
+    return;
+}
+
+
+static void
+_timer_heap_remove (timer_p t)
+{
+/*  Removes the timer [t] from the active heap and the ID hash.
+ *  The mutex must be locked before calling this routine.
+ */
+    int i;
+
+    assert (t != NULL);
+    assert ((t->idx >= 0) && (t->idx < _timer_heap_len));
+    assert (_timer_heap[t->idx] == t);
+    assert (lsd_mutex_is_locked (&_timer_mutex));
+
+    if (!hash_remove (_timer_hash, &t->id)) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to remove timer #%ld from hash", t->id);
+    }
+    i = t->idx;
+    t->idx = -1;
+    _timer_heap_len--;
+    if (i == _timer_heap_len) {
+        return;
+    }
+    /*  Move the last timer into the vacated slot and restore heap order.
+     */
+    _timer_heap[i] = _timer_heap[_timer_heap_len];
+    _timer_heap[i]->idx = i;
+    if ((i > 0) && _timer_is_before (_timer_heap[i], _timer_heap[(i-1)/2])) {
+        _timer_heap_sift_up (i);
+    }
+    else {
+        _timer_heap_sift_down (i);
+    }
+    return;
+}
+
+
+static void
+_timer_heap_sift_up (int i)
+{
+/*  Moves the timer at heap index [i] toward the root until heap order
+ *    is restored.
+ */
+    timer_p t;
+    int     parent;
+
+    assert ((i >= 0) && (i < _timer_heap_len));
+
+    t = _timer_heap[i];
+    while (i > 0) {
+        parent = (i - 1) / 2;
+        if (!_timer_is_before (t, _timer_heap[parent])) {
+            break;
+        }
+        _timer_heap[i] = _timer_heap[parent];
+        _timer_heap[i]->idx = i;
+        i = parent;
+    }
+    _timer_heap[i] = t;
+    t->idx = i;
+    return;
+}
+
+
+static void
+_timer_heap_sift_down (int i)
+{
+/*  Moves the timer at heap index [i] toward the leaves until heap order
+ *    is restored.
+ */
+    timer_p t;
+    int     child;
+
+    assert ((i >= 0) && (i < _timer_heap_len));
+
+    t = _timer_heap[i];
+    for (;;) {
+        child = (2 * i) + 1;
+        if (child >= _timer_heap_len) {
+            break;
+        }
+        if ((child + 1 < _timer_heap_len)
+                && _timer_is_before (_timer_heap[child + 1],
+                    _timer_heap[child])) {
+            child++;
+        }
+        if (!_timer_is_before (_timer_heap[child], t)) {
+            break;
+        }
+        _timer_heap[i] = _timer_heap[child];
+        _timer_heap[i]->idx = i;
+        i = child;
+    }
+    _timer_heap[i] = t;
+    t->idx = i;
+    return;
+}
+
+
+static int
+_timer_is_before (timer_p t1, timer_p t2)
+{
+/*  Returns non-zero if timer [t1] is to be dispatched before timer [t2].
+ *  Timers with equal timespecs are dispatched in the order they were set
+ *    (barring timer ID wraparound).
+ */
+    assert (t1 != NULL);
+    assert (t2 != NULL);
+
+    if (t1->ts.tv_sec != t2->ts.tv_sec) {
+        return (t1->ts.tv_sec < t2->ts.tv_sec);
+    }
+    if (t1->ts.tv_nsec != t2->ts.tv_nsec) {
+        return (t1->ts.tv_nsec < t2->ts.tv_nsec);
+    }
+    return (t1->id < t2->id);
+}
+
+
+static unsigned int
+_timer_key_f (const long *id)
+{
+/*  Use the timer ID as the hash key.
+ */
+    assert (id != NULL);
+
+    return ((unsigned int) *id);
+}
+
+
+static int
+_timer_cmp_f (const long *id1, const long *id2)
+{
+/*  Returns an integer that is less than zero if [id1] is less than [id2],
+ *    equal to zero if [id1] is equal to [id2], and greater than zero
+ *    if [id1] is greater than [id2].
+ */
+    assert (id1 != NULL);
+    assert (id2 != NULL);
+
+    if (*id1 < *id2) {
+        return (-1);
+    }
+    if (*id1 > *id2) {
+        return (1);
+    }
+    return (0);
+}
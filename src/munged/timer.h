@@ -52,6 +52,12 @@ typedef void (*callback_f) (void *arg);
 
 void timer_init (void);
 
+int timer_init_fd (void);
+
+int timer_get_fd (void);
+
+void timer_dispatch (void);
+
 void timer_fini (void);
 
 long timer_set_absolute (callback_f cb, void *arg, const struct timespec *tsp);
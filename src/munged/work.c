@@ -33,34 +33,60 @@
 #include <errno.h>
 #include <pthread.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <munge.h>
+#include "atom.h"
+#include "clock.h"
 #include "log.h"
+#include "munge_defs.h"
+#include "ring.h"
+#include "stats.h"
 #include "work.h"
 
 
+/*****************************************************************************
+ *  Constants
+ *****************************************************************************/
+
+/*  Number of slots in the work queue ring (must be a power of 2).
+ *    When the ring is full, work_queue() fails so the caller can reject
+ *    the work instead of blocking.
+ */
+#define WORK_QUEUE_SIZE         4096
+
+
 /*****************************************************************************
  *  Private Data Types
  *****************************************************************************/
 
-typedef struct work_arg {
-    struct work_arg    *next;           /* next work element in queue        */
+typedef struct work_elem {
     void               *arg;            /* arg describing work to be done    */
-} work_arg_t, *work_arg_p;
+    uint64_t            t_queued;       /* usecs when work was queued        */
+} work_elem_t, *work_elem_p;
 
 typedef struct work {
-    pthread_mutex_t     lock;           /* mutex for accessing struct        */
+    pthread_mutex_t     lock;           /* mutex for parking/waking threads  */
     pthread_cond_t      received_work;  /* cond for when new work is recv'd  */
     pthread_cond_t      finished_work;  /* cond for when all work is done    */
-    pthread_t          *workers;        /* ptr to array of worker thread IDs */
+    pthread_cond_t      exited_worker;  /* cond for when worker has exited   */
+    pthread_attr_t      tattr;          /* attributes for new worker threads */
     work_func_t         work_func;      /* function to perform work in queue */
-    work_arg_p          work_head;      /* head of the work queue            */
-    work_arg_p          work_tail;      /* tail of the work queue            */
-    int                 n_workers;      /* number of worker threads (total)  */
-    int                 n_working;      /* number of worker threads working  */
-    int                 got_fini;       /* true prevents new work after fini */
+    ring_p              ring;           /* bounded ring of queued work       */
+    unsigned long       n_pending;      /* number of elements queued/working */
+    unsigned long       n_idle;         /* number of worker threads parked   */
+    unsigned long       n_waiters;      /* number of threads in work_wait()  */
+    unsigned long       n_working;      /* number of worker threads working  */
+    unsigned long       got_fini;       /* true prevents new work after fini */
+    unsigned long       got_exit;       /* true directs worker threads exit  */
+    unsigned long       got_spawn;      /* true if new worker is starting    */
+    unsigned long       n_workers;      /* number of worker threads (total)  */
+    int                 n_min;          /* min number of worker threads      */
+    int                 n_max;          /* max number of worker threads      */
+    uint64_t            grow_usecs;     /* queue wait before adding a worker */
+    int                 idle_msecs;     /* idle time before removing worker  */
 } work_t;
 
 
@@ -69,30 +95,39 @@ typedef struct work {
  *****************************************************************************/
 
 static void * _work_exec (void *arg);
-static void   _work_exec_cleanup (void *arg);
-static void * _work_enqueue (work_p wp, void *work);
-static void * _work_dequeue (work_p wp);
+static int    _work_spawn (work_p wp);
+static void   _work_grow (work_p wp, uint64_t t_queued);
+static int    _work_shrink (work_p wp);
+static int    _work_enqueue (work_p wp, void *work);
+static void * _work_dequeue (work_p wp, uint64_t *t_queued);
+static void   _work_broadcast (work_p wp, pthread_cond_t *cond,
+                  const char *desc);
 
 
 /*****************************************************************************
  *  Public Functions
  *****************************************************************************/
 
-/*  Initializes the work crew comprised of [n_threads] workers.
+/*  Initializes the work crew comprised of [n_min] workers.
  *    The work function [f] will be invoked to process each work element
  *    queued by work_queue().
+ *  If [n_max] exceeds [n_min], the crew is elastic: a worker is added
+ *    (up to [n_max]) when queued work has waited longer than
+ *    MUNGE_THREADS_GROW_MSECS with no idle worker, and a worker is removed
+ *    (down to [n_min]) after it has been idle for MUNGE_THREADS_IDLE_SECS.
  *  Returns a ptr to the work crew, or terminates on error.
  */
 work_p
-work_init (work_func_t f, int n_threads)
+work_init (work_func_t f, int n_min, int n_max)
 {
     work_p wp;
-    pthread_attr_t tattr;
     size_t stacksize = 256 * 1024;
     int i;
 
     assert (f != NULL);
-    assert (n_threads > 0);
+    assert (n_min > 0);
+    assert (n_max >= n_min);
+    assert ((WORK_QUEUE_SIZE & (WORK_QUEUE_SIZE - 1)) == 0);
 
     /*  Allocate memory.
      */
@@ -100,27 +135,32 @@ work_init (work_func_t f, int n_threads)
         log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
             "Failed to allocate work thread struct");
     }
-    if (!(wp->workers = malloc (sizeof (*wp->workers) * n_threads))) {
+    if (!(wp->ring = ring_create (WORK_QUEUE_SIZE, sizeof (work_elem_t)))) {
         log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
-            "Failed to allocate tid array for work thread struct");
+            "Failed to allocate queue for work thread struct");
     }
     /*  Initialize struct.
      */
-    if ((errno = pthread_attr_init (&tattr)) != 0) {
+    if ((errno = pthread_attr_init (&wp->tattr)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR,
             "Failed to init work thread attribute");
     }
 #ifdef _POSIX_THREAD_ATTR_STACKSIZE
-    if ((errno = pthread_attr_setstacksize (&tattr, stacksize)) != 0) {
+    if ((errno = pthread_attr_setstacksize (&wp->tattr, stacksize)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR,
             "Failed to set work thread stacksize");
     }
-    if ((errno = pthread_attr_getstacksize (&tattr, &stacksize)) != 0) {
+    if ((errno = pthread_attr_getstacksize (&wp->tattr, &stacksize)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR,
             "Failed to get work thread stacksize");
     }
     log_msg (LOG_DEBUG, "Set work thread stacksize to %d", (int) stacksize);
 #endif /* _POSIX_THREAD_ATTR_STACKSIZE */
+    if ((errno = pthread_attr_setdetachstate
+                (&wp->tattr, PTHREAD_CREATE_DETACHED)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to set work thread detach state");
+    }
 
     if ((errno = pthread_mutex_init (&wp->lock, NULL)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR,
@@ -134,100 +174,110 @@ work_init (work_func_t f, int n_threads)
         log_errno (EMUNGE_SNAFU, LOG_ERR,
             "Failed to init work thread condition for finished work");
     }
+    if ((errno = pthread_cond_init (&wp->exited_worker, NULL)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to init work thread condition for exited worker");
+    }
     wp->work_func = f;
-    wp->work_head = wp->work_tail = NULL;
-    wp->n_workers = n_threads;
+    wp->n_pending = 0;
+    wp->n_idle = 0;
+    wp->n_waiters = 0;
     wp->n_working = 0;
     wp->got_fini = 0;
+    wp->got_exit = 0;
+    wp->got_spawn = 0;
+    wp->n_workers = 0;
+    wp->n_min = n_min;
+    wp->n_max = n_max;
+    wp->grow_usecs = (uint64_t) MUNGE_THREADS_GROW_MSECS * 1000;
+    wp->idle_msecs = MUNGE_THREADS_IDLE_SECS * 1000;
     /*
      *  Start worker thread(s).
      */
-    for (i = 0; i < wp->n_workers; i++) {
-        if ((errno = pthread_create
-                    (&wp->workers[i], &tattr, _work_exec, wp)) != 0) {
+    for (i = 0; i < n_min; i++) {
+        (void) atom_add (&wp->n_workers, 1);
+        if (_work_spawn (wp) < 0) {
             log_errno (EMUNGE_SNAFU, LOG_ERR,
                 "Failed to create work thread #%d", i+1);
         }
     }
-    /*  Cleanup.
-     */
-    if ((errno = pthread_attr_destroy (&tattr)) != 0) {
-        log_errno (EMUNGE_SNAFU, LOG_ERR,
-            "Failed to destroy work thread attribute");
+    if (n_max > n_min) {
+        log_msg (LOG_INFO, "Created %d work thread%s (%d max)", n_min,
+                ((n_min > 1) ? "s" : ""), n_max);
+    }
+    else {
+        log_msg (LOG_INFO, "Created %d work thread%s", n_min,
+                ((n_min > 1) ? "s" : ""));
     }
-    log_msg (LOG_INFO, "Created %d work thread%s", n_threads,
-            ((n_threads > 1) ? "s" : ""));
     return (wp);
 }
 
 
-/*  Stops the work crew [wp], canceling all worker threads and releasing
+/*  Stops the work crew [wp], terminating all worker threads and releasing
  *    associated resources.  If [do_wait] is non-zero, all currently-queued
  *    work will be processed before the work crew is stopped; new work is
  *    prevented from being added to the queue during this time.
+ *  Worker threads finish the work element they are currently processing
+ *    before exiting; any remaining queued work is discarded.
  */
 void
 work_fini (work_p wp, int do_wait)
 {
-    int i;
-
     if (!wp) {
         errno = EINVAL;
         return;
     }
-    if ((errno = pthread_mutex_lock (&wp->lock)) != 0) {
-        log_errno (EMUNGE_SNAFU, LOG_ERR,
-            "Failed to lock work thread mutex");
-    }
     /*  Prevent new work from being queued.
      */
-    wp->got_fini = 1;
+    atom_store (&wp->got_fini, 1);
     /*
      *  Process remaining work if requested.
      */
     if (do_wait) {
-        /*
-         *  Calling work_wait() won't work here since the wait wouldn't
-         *    be atomic with the mutex being dropped between function calls.
-         */
-        while ((wp->n_working != 0) && (wp->work_head != NULL)) {
-            if ((errno = pthread_cond_wait
-                        (&wp->finished_work, &wp->lock)) != 0) {
-                log_errno (EMUNGE_SNAFU, LOG_ERR,
-                    "Failed to wait on work thread for finished work");
-            }
-        }
+        work_wait (wp);
     }
     /*  Stop worker thread(s).
-     *  The mutex must be unlocked in order to cancel the worker
-     *    thread(s) which may be blocked on pthread_cond_wait().
-     *    When a pthread_cond_wait() is canceled, the mutex is
-     *    re-acquired before the cleanup handlers are invoked.
+     *  The exit flag is set while holding the mutex so a worker cannot
+     *    test it and then park after the broadcast has been sent.
      */
-    if ((errno = pthread_mutex_unlock (&wp->lock)) != 0) {
+    if ((errno = pthread_mutex_lock (&wp->lock)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR,
-            "Failed to unlock work thread mutex");
+            "Failed to lock work thread mutex");
     }
-    for (i = 0; i < wp->n_workers; i++) {
-        if ((errno = pthread_cancel (wp->workers[i])) != 0) {
-            log_errno (EMUNGE_SNAFU, LOG_ERR,
-                "Failed to cancel work thread #%d", i+1);
-        }
+    atom_store (&wp->got_exit, 1);
+
+    if ((errno = pthread_cond_broadcast (&wp->received_work)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to broadcast work thread for exit");
     }
-    for (i = 0; i < wp->n_workers; i++) {
-        void *result;
-        if ((errno = pthread_join (wp->workers[i], &result)) != 0) {
+    /*  Wait for the worker thread(s) to exit.
+     *  Worker threads are detached since they come and go as the crew
+     *    grows and shrinks.  An exiting worker decrements [n_workers] and
+     *    signals while holding the mutex, and does not touch [wp] after
+     *    releasing it.
+     */
+    while (atom_load (&wp->n_workers) > 0) {
+        if ((errno = pthread_cond_wait
+                    (&wp->exited_worker, &wp->lock)) != 0) {
             log_errno (EMUNGE_SNAFU, LOG_ERR,
-                "Failed to join work thread #%d", i+1);
-        }
-        if (result != PTHREAD_CANCELED) {
-            log_err (EMUNGE_SNAFU, LOG_ERR,
-                "Work thread #%d was not canceled", i+1);
+                "Failed to wait on work thread for exited worker");
         }
-        wp->workers[i] = 0;
+    }
+    if ((errno = pthread_mutex_unlock (&wp->lock)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to unlock work thread mutex");
     }
     /*  Reclaim allocated resources.
      */
+    if ((errno = pthread_attr_destroy (&wp->tattr)) != 0) {
+        log_msg (LOG_ERR,
+            "Failed to destroy work thread attribute: %s", strerror (errno));
+    }
+    if ((errno = pthread_cond_destroy (&wp->exited_worker)) != 0) {
+        log_msg (LOG_ERR,
+            "Failed to destroy work thread condition for exited worker: %s",
+            strerror (errno));
+    }
     if ((errno = pthread_cond_destroy (&wp->finished_work)) != 0) {
         log_msg (LOG_ERR,
             "Failed to destroy work thread condition for finished work: %s",
@@ -242,7 +292,7 @@ work_fini (work_p wp, int do_wait)
         log_msg (LOG_ERR,
             "Failed to destroy work thread mutex: %s", strerror (errno));
     }
-    free (wp->workers);
+    ring_destroy (wp->ring);
     free (wp);
     return;
 }
@@ -250,48 +300,54 @@ work_fini (work_p wp, int do_wait)
 
 /*  Queues the [work] element for processing by the work crew [wp].
  *    The [work] will be passed to the function specified during work_init().
- *  Returns 0 on success, or -1 on error (with errno set).
+ *  The mutex is only acquired when a worker thread is parked waiting for
+ *    work (in order to wake it).
+ *  Returns 0 on success, or -1 on error (with errno set).  If the queue is
+ *    full, errno is set to EAGAIN and the [work] is not queued.
  */
 int
 work_queue (work_p wp, void *work)
 {
-    int rc = 0;
-    int do_signal = 0;
-
     if (!wp || !work) {
         errno = EINVAL;
         return (-1);
     }
-    if ((errno = pthread_mutex_lock (&wp->lock)) != 0) {
-        log_errno (EMUNGE_SNAFU, LOG_ERR,
-            "Failed to lock work thread mutex");
-    }
-    if (wp->got_fini) {
+    if (atom_load (&wp->got_fini)) {
         errno = EPERM;
-        rc = -1;
-    }
-    else if (_work_enqueue (wp, work) == NULL) {
-        errno = EINVAL;
-        rc = -1;
+        return (-1);
     }
-    else if ((wp->n_workers - wp->n_working) > 0) {
+    (void) atom_add (&wp->n_pending, 1);
+
+    if (!_work_enqueue (wp, work)) {
         /*
-         *  Awaken an idle worker if possible.
-         *  Set a flag here so the signal can be done outside the monitor lock.
+         *  The queue is full.  Fail rather than park the caller (typically
+         *    an accept thread) until a worker frees a slot.
          */
-        do_signal = 1;
-    }
-    if ((errno = pthread_mutex_unlock (&wp->lock)) != 0) {
-        log_errno (EMUNGE_SNAFU, LOG_ERR,
-            "Failed to unlock work thread mutex");
+        if ((atom_add (&wp->n_pending, -1) == 0)
+                && (atom_load (&wp->n_waiters) > 0)) {
+            _work_broadcast (wp, &wp->finished_work, "finished work");
+        }
+        errno = EAGAIN;
+        return (-1);
     }
-    if (do_signal) {
+    /*  Awaken an idle worker if one is parked.
+     *  Busy workers will find the work when they next poll the queue.
+     */
+    if (atom_load (&wp->n_idle) > 0) {
+        if ((errno = pthread_mutex_lock (&wp->lock)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to lock work thread mutex");
+        }
         if ((errno = pthread_cond_signal (&wp->received_work)) != 0) {
             log_errno (EMUNGE_SNAFU, LOG_ERR,
                 "Failed to signal work thread for received work");
         }
+        if ((errno = pthread_mutex_unlock (&wp->lock)) != 0) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to unlock work thread mutex");
+        }
     }
-    return (rc);
+    return (0);
 }
 
 
@@ -308,14 +364,18 @@ work_wait (work_p wp)
         log_errno (EMUNGE_SNAFU, LOG_ERR,
             "Failed to lock work thread mutex");
     }
-    /*  Wait until all the queued work is finished.
+    (void) atom_add (&wp->n_waiters, 1);
+    /*
+     *  Wait until all the queued work is finished.
      */
-    while ((wp->n_working != 0) && (wp->work_head != NULL)) {
+    while (atom_load (&wp->n_pending) != 0) {
         if ((errno = pthread_cond_wait (&wp->finished_work, &wp->lock)) != 0) {
             log_errno (EMUNGE_SNAFU, LOG_ERR,
                 "Failed to wait on work thread for finished work");
         }
     }
+    (void) atom_add (&wp->n_waiters, -1);
+
     if ((errno = pthread_mutex_unlock (&wp->lock)) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR,
             "Failed to unlock work thread mutex");
@@ -324,6 +384,51 @@ work_wait (work_p wp)
 }
 
 
+/*  Gets the number of elements queued for the work crew [wp] in [n_queued],
+ *    the number of worker threads currently processing work in [n_working],
+ *    and the total number of worker threads in [n_workers].
+ *  The counts are sampled without locking and may be momentarily skewed.
+ */
+void
+work_get_stats (work_p wp, int *n_queued, int *n_working, int *n_workers)
+{
+    if (!wp) {
+        errno = EINVAL;
+        return;
+    }
+    if (n_queued) {
+        *n_queued = (int) ring_count (wp->ring);
+    }
+    if (n_working) {
+        *n_working = (int) atom_load (&wp->n_working);
+    }
+    if (n_workers) {
+        *n_workers = (int) atom_load (&wp->n_workers);
+    }
+    return;
+}
+
+
+/*  Gets the minimum and maximum number of worker threads for the work crew
+ *    [wp] in [n_min] and [n_max], respectively.
+ */
+void
+work_get_limits (work_p wp, int *n_min, int *n_max)
+{
+    if (!wp) {
+        errno = EINVAL;
+        return;
+    }
+    if (n_min) {
+        *n_min = wp->n_min;
+    }
+    if (n_max) {
+        *n_max = wp->n_max;
+    }
+    return;
+}
+
+
 /*****************************************************************************
  *  Private Functions
  *****************************************************************************/
@@ -332,15 +437,24 @@ static void *
 _work_exec (void *arg)
 {
 /*  The worker thread.  It continually removes the next element
- *    from the work queue and processes it -- until it's canceled.
+ *    from the work queue and processes it -- until it's told to exit,
+ *    or until it's been idle long enough to be removed from an elastic crew.
+ *  A worker only parks on the condition variable when the queue is empty;
+ *    [n_idle] is incremented before re-testing the queue so a producer
+ *    enqueueing concurrently will see it and signal.
  */
-    work_p    wp;
-    sigset_t  sigset;
-    int       cancel_state;
-    void     *work;
+    work_p           wp;
+    sigset_t         sigset;
+    struct timespec  ts;
+    void            *work;
+    uint64_t         t_queued;
+    int              is_elastic;
+    int              is_expired;
+    int              is_removed = 0;
 
     assert (arg != NULL);
     wp = arg;
+    is_elastic = (wp->n_max > wp->n_min);
 
     if (sigfillset (&sigset)) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to init work thread sigset");
@@ -348,149 +462,275 @@ _work_exec (void *arg)
     if (pthread_sigmask (SIG_SETMASK, &sigset, NULL) != 0) {
         log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to set work thread sigset");
     }
-    if ((errno = pthread_mutex_lock (&wp->lock)) != 0) {
-        log_errno (EMUNGE_SNAFU, LOG_ERR,
-            "Failed to lock work thread mutex");
-    }
-    pthread_cleanup_push (_work_exec_cleanup, wp);
+    atom_store (&wp->got_spawn, 0);
 
     for (;;) {
 
-        pthread_testcancel ();
-        /*
-         *  Wait for new work if none is currently queued.
-         */
-        while (!wp->work_head) {
-            if ((errno = pthread_cond_wait
-                        (&wp->received_work, &wp->lock)) != 0) {
+        work = NULL;
+        if (!atom_load (&wp->got_exit)) {
+            work = _work_dequeue (wp, &t_queued);
+        }
+        if (!work) {
+            /*
+             *  Wait for new work since none is currently queued.
+             *  The mutex remains locked if this loop exits without work.
+             */
+            if ((errno = pthread_mutex_lock (&wp->lock)) != 0) {
                 log_errno (EMUNGE_SNAFU, LOG_ERR,
-                    "Failed to wait on work thread for received work");
+                    "Failed to lock work thread mutex");
+            }
+            (void) atom_add (&wp->n_idle, 1);
+            is_expired = 0;
+            if (is_elastic) {
+                if (clock_get_timespec (&ts, wp->idle_msecs) < 0) {
+                    log_errno (EMUNGE_SNAFU, LOG_ERR,
+                        "Failed to query current time");
+                }
+            }
+            for (;;) {
+                if (atom_load (&wp->got_exit)) {
+                    break;
+                }
+                if ((work = _work_dequeue (wp, &t_queued))) {
+                    break;
+                }
+                if (is_expired) {
+                    if (_work_shrink (wp)) {
+                        is_removed = 1;
+                        break;
+                    }
+                    /*  The crew is at its minimum, so restart the idle
+                     *    timeout rather than re-waiting on the expired
+                     *    deadline (which would return immediately).
+                     */
+                    is_expired = 0;
+                    if (clock_get_timespec (&ts, wp->idle_msecs) < 0) {
+                        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                            "Failed to query current time");
+                    }
+                }
+                if (!is_elastic) {
+                    errno = pthread_cond_wait (&wp->received_work, &wp->lock);
+                }
+                else {
+                    errno = pthread_cond_timedwait
+                        (&wp->received_work, &wp->lock, &ts);
+                    if (errno == ETIMEDOUT) {
+                        is_expired = 1;
+                        errno = 0;
+                    }
+                }
+                if (errno != 0) {
+                    log_errno (EMUNGE_SNAFU, LOG_ERR,
+                        "Failed to wait on work thread for received work");
+                }
+            }
+            (void) atom_add (&wp->n_idle, -1);
+
+            if (!work) {
+                break;
+            }
+            if ((errno = pthread_mutex_unlock (&wp->lock)) != 0) {
+                log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to unlock work thread mutex");
             }
         }
-        /*  Disable the thread's cancellation state.
+        /*  Add a worker if this work waited too long in the queue.
          */
-        if ((errno = pthread_setcancelstate
-                    (PTHREAD_CANCEL_DISABLE, &cancel_state)) != 0) {
-            log_errno (EMUNGE_SNAFU, LOG_ERR,
-                "Failed to disable work thread cancellation");
+        if (is_elastic) {
+            _work_grow (wp, t_queued);
         }
         /*  Process the work.
          */
-        work = _work_dequeue (wp);
-        assert (work != NULL);
-
-        wp->n_working++;
-
-        if ((errno = pthread_mutex_unlock (&wp->lock)) != 0) {
-            log_errno (EMUNGE_SNAFU, LOG_ERR,
-                "Failed to unlock work thread mutex");
-        }
+        (void) atom_add (&wp->n_working, 1);
         wp->work_func (work);
-
-        if ((errno = pthread_mutex_lock (&wp->lock)) != 0) {
-            log_errno (EMUNGE_SNAFU, LOG_ERR,
-                "Failed to lock work thread mutex");
-        }
-        wp->n_working--;
+        (void) atom_add (&wp->n_working, -1);
         /*
-         *  Enable the thread's cancellation state.
-         *    Since enabling cancellation is not a cancellation point,
-         *    a pending cancel request must be tested for.  Consequently,
-         *    pthread_testcancel() is called at the top of the for-loop
-         *    (in case work is queued and pthread_cond_wait() isn't invoked).
-         */
-        if ((errno = pthread_setcancelstate
-                    (cancel_state, &cancel_state)) != 0) {
-            log_errno (EMUNGE_SNAFU, LOG_ERR,
-                "Failed to enable work thread cancellation");
-        }
-        /*  Check to see if all the queued work is now finished.
+         *  Check to see if all the queued work is now finished.
          */
-        if ((wp->n_working == 0) && (!wp->work_head)) {
-            if ((errno = pthread_cond_signal (&wp->finished_work)) != 0) {
-                log_errno (EMUNGE_SNAFU, LOG_ERR,
-                    "Failed to signal work thread for finished work");
-            }
+        if ((atom_add (&wp->n_pending, -1) == 0)
+                && (atom_load (&wp->n_waiters) > 0)) {
+            _work_broadcast (wp, &wp->finished_work, "finished work");
         }
     }
-    assert (1);                         /* not reached */
-    pthread_cleanup_pop (1);
+    /*  Exit while holding the mutex.
+     *  [n_workers] was already decremented if this worker was removed.
+     *  Once the mutex is released, [wp] may be freed by work_fini().
+     */
+    if (!is_removed) {
+        (void) atom_add (&wp->n_workers, -1);
+    }
+    else {
+        log_msg (LOG_DEBUG, "Removed idle work thread (%lu remaining)",
+                atom_load (&wp->n_workers));
+    }
+    if ((errno = pthread_cond_broadcast (&wp->exited_worker)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to broadcast work thread for exited worker");
+    }
+    if ((errno = pthread_mutex_unlock (&wp->lock)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to unlock work thread mutex");
+    }
     return (NULL);
 }
 
 
+static int
+_work_spawn (work_p wp)
+{
+/*  Creates a detached worker thread for the [wp] work crew.
+ *    The caller must have already accounted for it in [n_workers].
+ *  Returns 0 on success, or -1 on error (with errno set).
+ */
+    pthread_t tid;
+
+    assert (wp != NULL);
+
+    if ((errno = pthread_create (&tid, &wp->tattr, _work_exec, wp)) != 0) {
+        return (-1);
+    }
+    return (0);
+}
+
+
 static void
-_work_exec_cleanup (void *arg)
+_work_grow (work_p wp, uint64_t t_queued)
 {
-/*  The cleanup routine for the _work_exec() thread(s).
- *    It ensures the mutex is released when the thread is canceled.
+/*  Adds a worker to the elastic [wp] work crew if no worker is idle and
+ *    the work element dequeued by the caller had been queued at [t_queued]
+ *    for longer than the grow threshold.
+ *  Only one new worker is started at a time; [got_spawn] is cleared by the
+ *    new worker once it is running, thereby rate-limiting growth to the
+ *    speed at which threads can be started.
  */
-    work_p wp;
+    unsigned long n;
+    unsigned long zero = 0;
 
-    assert (arg != NULL);
-    wp = arg;
+    assert (wp != NULL);
 
-    if ((errno = pthread_mutex_unlock (&wp->lock)) != 0) {
-        log_errno (EMUNGE_SNAFU, LOG_ERR,
-            "Failed to unlock work thread mutex");
+    if (atom_load (&wp->n_idle) > 0) {
+        return;
     }
+    if ((stats_time () - t_queued) < wp->grow_usecs) {
+        return;
+    }
+    if (!atom_cas (&wp->got_spawn, &zero, 1)) {
+        return;
+    }
+    n = atom_load (&wp->n_workers);
+    do {
+        if (n >= (unsigned long) wp->n_max) {
+            atom_store (&wp->got_spawn, 0);
+            return;
+        }
+    } while (!atom_cas (&wp->n_workers, &n, n + 1));
+
+    if (_work_spawn (wp) < 0) {
+        log_msg (LOG_WARNING, "Failed to create work thread: %s",
+                strerror (errno));
+        (void) atom_add (&wp->n_workers, -1);
+        atom_store (&wp->got_spawn, 0);
+        return;
+    }
+    log_msg (LOG_DEBUG, "Added work thread (%lu total)", n + 1);
     return;
 }
 
 
-static void *
+static int
+_work_shrink (work_p wp)
+{
+/*  Removes a worker from the elastic [wp] work crew if it has more than
+ *    the minimum number of workers.
+ *  Returns 1 if the calling worker should exit, or 0 if it should remain.
+ */
+    unsigned long n;
+
+    assert (wp != NULL);
+
+    n = atom_load (&wp->n_workers);
+    do {
+        if (n <= (unsigned long) wp->n_min) {
+            return (0);
+        }
+    } while (!atom_cas (&wp->n_workers, &n, n - 1));
+
+    return (1);
+}
+
+
+static int
 _work_enqueue (work_p wp, void *work)
 {
 /*  Enqueue the [work] element at the tail of the [wp] work queue.
- *
- *  LOCKING PROTOCOL:
- *    This routine requires the caller to have locked the [wp]'s mutex.
+ *  Returns 1 on success, or 0 if the queue is full.
  */
-    work_arg_p wap;
+    work_elem_p   elem;
+    unsigned long pos;
 
     assert (wp != NULL);
+    assert (work != NULL);
 
-    if (!work) {
-        return (NULL);
-    }
-    if (!(wap = malloc (sizeof (*wap)))) {
-        log_errno (EMUNGE_NO_MEMORY, LOG_ERR, "Failed to enqueue work");
+    if (!(elem = ring_enqueue_claim (wp->ring, &pos))) {
+        return (0);
     }
-    wap->next = NULL;
-    wap->arg = work;
-    if (!wp->work_tail) {
-        wp->work_tail = wp->work_head = wap;
+    elem->arg = work;
+    if (wp->n_max > wp->n_min) {
+        elem->t_queued = stats_time ();
     }
-    else {
-        wp->work_tail->next = wap;
-        wp->work_tail = wap;
-    }
-    return (work);
+    ring_enqueue_commit (wp->ring, pos);
+    return (1);
 }
 
 
 static void *
-_work_dequeue (work_p wp)
+_work_dequeue (work_p wp, uint64_t *t_queued)
 {
 /*  Dequeue the work element at the head of the [wp] work queue.
- *
- *  LOCKING PROTOCOL:
- *    This routine requires the caller to have locked the [wp]'s mutex.
+ *    The time at which it was queued is stored in [t_queued].
+ *  Returns the work element, or NULL if the queue is empty.
  */
-    work_arg_p  wap;
-    void       *work;
+    work_elem_p   elem;
+    unsigned long pos;
+    void         *work;
 
     assert (wp != NULL);
+    assert (t_queued != NULL);
 
-    wap = wp->work_head;
-    if (!wap) {
+    if (!(elem = ring_dequeue_claim (wp->ring, &pos))) {
         return (NULL);
     }
-    wp->work_head = wap->next;
-    work = wap->arg;
-    free (wap);
-    if (!wp->work_head) {
-        wp->work_tail = NULL;
-    }
+    work = elem->arg;
+    *t_queued = elem->t_queued;
+    elem->arg = NULL;
+    ring_dequeue_release (wp->ring, pos);
     return (work);
 }
+
+
+static void
+_work_broadcast (work_p wp, pthread_cond_t *cond, const char *desc)
+{
+/*  Broadcasts the condition [cond] while holding the [wp] mutex.
+ *    The mutex ensures a thread that has just tested the predicate
+ *    will be waiting on the condition before the broadcast is sent.
+ */
+    assert (wp != NULL);
+    assert (cond != NULL);
+
+    if ((errno = pthread_mutex_lock (&wp->lock)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to lock work thread mutex");
+    }
+    if ((errno = pthread_cond_broadcast (cond)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to broadcast work thread for %s", desc);
+    }
+    if ((errno = pthread_mutex_unlock (&wp->lock)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to unlock work thread mutex");
+    }
+    return;
+}
+
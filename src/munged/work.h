@@ -47,7 +47,7 @@ typedef void (*work_func_t) (void *);
  *  Functions
  *****************************************************************************/
 
-work_p work_init (work_func_t f, int n_threads);
+work_p work_init (work_func_t f, int n_min, int n_max);
 
 void work_fini (work_p wp, int do_wait);
 
@@ -55,5 +55,10 @@ int work_queue (work_p wp, void *work);
 
 void work_wait (work_p wp);
 
+void work_get_stats (work_p wp, int *n_queued, int *n_working,
+        int *n_workers);
+
+void work_get_limits (work_p wp, int *n_min, int *n_max);
+
 
 #endif /* WORK_H */
@@ -38,10 +38,24 @@
 #  include <zlib.h>
 #endif /* HAVE_ZLIB_H */
 
+#if HAVE_LZ4_H
+#  include <lz4.h>
+#endif /* HAVE_LZ4_H */
+
+#if HAVE_ZSTD_H
+#  include <zstd.h>
+#endif /* HAVE_ZSTD_H */
+
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
 #include <netinet/in.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <munge.h>
 #include "common.h"
 #include "zip.h"
@@ -58,6 +72,19 @@
  *    The first 4 bytes contain a sentinel to check if the metadata is valid.
  *    The next 4 bytes contain the original length of the uncompressed data.
  *    Both values are in MSBF (ie, big endian) format.
+ *  The same metadata is used for the lz4 and zstd types even though zstd
+ *    records the original length in its frame header.
+ *
+ *  Compressor and decompressor state is kept per-thread and reset between
+ *    credentials instead of being allocated and initialized for each one.
+ *    bzlib offers no means to reset a stream, so its block size is instead
+ *    scaled to the input length; its format records the block size used,
+ *    so the output remains decodable by any bzlib version.
+ *
+ *  A zstd dictionary trained on sample payloads (see mungekey) can be loaded
+ *    by zip_dict_init().  The dictionary's ID is carried in the credential's
+ *    "outer" data so a credential compressed with a dictionary is rejected by
+ *    a daemon that lacks it before any decompression is attempted.
  */
 
 
@@ -67,6 +94,17 @@
 
 #define ZIP_MAGIC                       0xCACACACA
 
+/*  Compression level for zstd.  Credential payloads are small enough that
+ *    higher levels cost latency without improving the ratio much.
+ */
+#define ZIP_ZSTD_LEVEL                  1
+
+/*  Maximum number of bytes sampled by zip_is_compressible(), and the minimum
+ *    number below which no estimate is made.
+ */
+#define ZIP_EST_SAMPLE_MAX              1024
+#define ZIP_EST_SAMPLE_MIN              32
+
 
 /*****************************************************************************
  *  Data Types
@@ -77,11 +115,194 @@ typedef struct {
     uint32_t length;
 } zip_meta_t;
 
+/*  Per-thread compression state.  Each member is created on first use by its
+ *    compression type.
+ */
+struct zip_ctx {
+#if HAVE_PKG_ZLIB
+    z_stream        deflate;            /* zlib compression stream           */
+    z_stream        inflate;            /* zlib decompression stream         */
+    unsigned        got_deflate:1;      /* true if deflate stream is init    */
+    unsigned        got_inflate:1;      /* true if inflate stream is init    */
+#endif /* HAVE_PKG_ZLIB */
+#if HAVE_PKG_LZ4
+    void           *lz4_state;          /* lz4 compression state             */
+#endif /* HAVE_PKG_LZ4 */
+#if HAVE_PKG_ZSTD
+    ZSTD_CCtx      *zstd_cctx;          /* zstd compression context          */
+    ZSTD_DCtx      *zstd_dctx;          /* zstd decompression context        */
+#endif /* HAVE_PKG_ZSTD */
+    int             dummy;              /* placeholder if no zip types       */
+};
+
+typedef struct zip_ctx * zip_ctx_p;
+
+
+/*****************************************************************************
+ *  Private Data
+ *****************************************************************************/
+
+static int _zip_is_init = 0;            /* true if per-thread state in use   */
+
+static pthread_key_t _zip_ctx_key;      /* key for per-thread zip state      */
+
+static uint32_t _zip_dict_id = 0;       /* ID of loaded dictionary, or 0     */
+
+#if HAVE_PKG_ZSTD
+static ZSTD_CDict *_zip_zstd_cdict = NULL;      /* digested zstd dict (enc)  */
+static ZSTD_DDict *_zip_zstd_ddict = NULL;      /* digested zstd dict (dec)  */
+#endif /* HAVE_PKG_ZSTD */
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static zip_ctx_p _zip_ctx_get (int *is_tmp);
+static void _zip_ctx_release (zip_ctx_p z, int is_tmp);
+static void _zip_ctx_destroy (void *arg);
+
 
 /*****************************************************************************
  *  Public Functions
  *****************************************************************************/
 
+/*  Initializes per-thread compression state for reuse across credentials.
+ *  Without this, state is created and destroyed for each call.
+ */
+void
+zip_init (void)
+{
+    if (_zip_is_init) {
+        return;
+    }
+    if ((errno = pthread_key_create (&_zip_ctx_key, _zip_ctx_destroy)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to create compression state key");
+    }
+    _zip_is_init = 1;
+    return;
+}
+
+
+/*  Shuts down per-thread compression state.
+ *  The calling thread's state is destroyed here since key destructors are
+ *    only invoked at thread exit.
+ */
+void
+zip_fini (void)
+{
+    zip_ctx_p z;
+
+    if (!_zip_is_init) {
+        return;
+    }
+    _zip_is_init = 0;
+
+    if ((z = pthread_getspecific (_zip_ctx_key)) != NULL) {
+        (void) pthread_setspecific (_zip_ctx_key, NULL);
+        _zip_ctx_destroy (z);
+    }
+    (void) pthread_key_delete (_zip_ctx_key);
+    return;
+}
+
+
+/*  Loads the zstd compression dictionary from the file [path] for use by all
+ *    threads.
+ *  Returns 0 on success, or -1 on error (with errno set).
+ */
+int
+zip_dict_init (const char *path)
+{
+#if HAVE_PKG_ZSTD
+    int            fd;
+    struct stat    st;
+    unsigned char *buf;
+    ssize_t        n;
+    uint32_t       id;
+
+    assert (path != NULL);
+
+    if ((fd = open (path, O_RDONLY)) < 0) {
+        return (-1);
+    }
+    if (fstat (fd, &st) < 0) {
+        (void) close (fd);
+        return (-1);
+    }
+    if ((st.st_size <= 0) || (st.st_size > MUNGE_DICT_LEN_MAX_BYTES)) {
+        (void) close (fd);
+        errno = EFBIG;
+        return (-1);
+    }
+    if (!(buf = malloc (st.st_size))) {
+        (void) close (fd);
+        return (-1);
+    }
+    n = fd_read_n (fd, buf, st.st_size);
+    (void) close (fd);
+    if (n != st.st_size) {
+        free (buf);
+        errno = (n < 0) ? errno : EIO;
+        return (-1);
+    }
+    /*  A raw content dictionary has no ID and cannot be identified in a cred.
+     */
+    id = ZSTD_getDictID_fromDict (buf, n);
+    if (id == 0) {
+        free (buf);
+        errno = EINVAL;
+        return (-1);
+    }
+    zip_dict_fini ();
+    _zip_zstd_cdict = ZSTD_createCDict (buf, n, ZIP_ZSTD_LEVEL);
+    _zip_zstd_ddict = ZSTD_createDDict (buf, n);
+    free (buf);
+    if (!_zip_zstd_cdict || !_zip_zstd_ddict) {
+        zip_dict_fini ();
+        errno = ENOMEM;
+        return (-1);
+    }
+    _zip_dict_id = id;
+    return (0);
+
+#else  /* !HAVE_PKG_ZSTD */
+    errno = ENOTSUP;
+    return (-1);
+#endif /* !HAVE_PKG_ZSTD */
+}
+
+
+/*  Unloads the compression dictionary.
+ */
+void
+zip_dict_fini (void)
+{
+#if HAVE_PKG_ZSTD
+    ZSTD_freeCDict (_zip_zstd_cdict);
+    _zip_zstd_cdict = NULL;
+    ZSTD_freeDDict (_zip_zstd_ddict);
+    _zip_zstd_ddict = NULL;
+#endif /* HAVE_PKG_ZSTD */
+    _zip_dict_id = 0;
+    return;
+}
+
+
+/*  Returns the ID of the loaded dictionary to use with compression [type],
+ *    or 0 if none.
+ */
+uint32_t
+zip_dict_get_id (munge_zip_t type)
+{
+    if (type == MUNGE_ZIP_ZSTD) {
+        return (_zip_dict_id);
+    }
+    return (0);
+}
+
+
 /*  Returns non-zero if the given [type] is a supported valid MUNGE compression
  *    type according to the current configuration.  The NONE and DEFAULT types
  *    are not considered valid types by this routine.
@@ -99,19 +320,70 @@ zip_is_valid_type (munge_zip_t type)
         return (1);
 #endif /* HAVE_PKG_ZLIB */
 
+#if HAVE_PKG_LZ4
+    if (type == MUNGE_ZIP_LZ4)
+        return (1);
+#endif /* HAVE_PKG_LZ4 */
+
+#if HAVE_PKG_ZSTD
+    if (type == MUNGE_ZIP_ZSTD)
+        return (1);
+#endif /* HAVE_PKG_ZSTD */
+
     return (0);
 }
 
 
+/*  Returns non-zero if the [src] buffer of length [len] appears compressible.
+ *  This is a cheap estimate made before running the compressor.  Up to
+ *    ZIP_EST_SAMPLE_MAX bytes are sampled at even intervals and the number of
+ *    ordered pairs of equal sampled bytes is counted.  Data whose byte values
+ *    are close to uniformly distributed (eg, data that is already compressed
+ *    or encrypted) has about n(n-1)/256 such pairs among n samples; anything
+ *    with fewer than twice that is considered incompressible.
+ *  Buffers too short to sample meaningfully are considered compressible.
+ */
+int
+zip_is_compressible (const void *src, int len)
+{
+    const unsigned char *p = src;
+    unsigned int         hist [256];
+    unsigned long        pairs;
+    unsigned long        n;
+    int                  step;
+    int                  i;
+
+    assert (src != NULL);
+
+    if (len < ZIP_EST_SAMPLE_MIN) {
+        return (1);
+    }
+    step = (len + ZIP_EST_SAMPLE_MAX - 1) / ZIP_EST_SAMPLE_MAX;
+    memset (hist, 0, sizeof (hist));
+    n = 0;
+    for (i = 0; i < len; i += step) {
+        hist [p [i]]++;
+        n++;
+    }
+    pairs = 0;
+    for (i = 0; i < 256; i++) {
+        if (hist [i] > 1) {
+            pairs += (unsigned long) hist [i] * (hist [i] - 1);
+        }
+    }
+    return (pairs * 128 >= n * (n - 1));
+}
+
+
 /*  Compresses the [src] buffer of length [srclen] in a single pass using the
- *    compression method [type].  The resulting compressed output is stored
- *    in the [dst] buffer.
+ *    compression method [type] and dictionary [dict_id] (or 0 for none).
+ *    The resulting compressed output is stored in the [dst] buffer.
  *  Upon entry, [*pdstlen] must be set to the size of the [dst] buffer.
  *  Upon exit, [*pdstlen] is set to the size of the compressed data.
  *  Returns 0 on success, or -1 or error.
  */
 int
-zip_compress_block (munge_zip_t type,
+zip_compress_block (munge_zip_t type, uint32_t dict_id,
                     void *dst, int *pdstlen, const void *src, int srclen)
 {
     unsigned char *xdst;
@@ -119,6 +391,9 @@ zip_compress_block (munge_zip_t type,
     unsigned char *xsrc;
     unsigned int   xsrclen;
     zip_meta_t    *pmeta;
+    zip_ctx_p      z;
+    int            is_tmp;
+    int            rc;
 
     assert (dst != NULL);
     assert (pdstlen != NULL);
@@ -127,6 +402,9 @@ zip_compress_block (munge_zip_t type,
     if (!zip_is_valid_type (type)) {
         return (-1);
     }
+    if ((dict_id != 0) && (dict_id != zip_dict_get_id (type))) {
+        return (-1);
+    }
     if (*pdstlen < sizeof (zip_meta_t)) {
         return (-1);
     }
@@ -138,46 +416,104 @@ zip_compress_block (munge_zip_t type,
     xsrc = (unsigned char *) src;
     xsrclen = srclen;
 
+    if (!(z = _zip_ctx_get (&is_tmp))) {
+        return (-1);
+    }
+    rc = -1;
+
 #if HAVE_PKG_BZLIB
+    /*  Scale the block size (in units of 100k) to the input length.  A block
+     *    larger than the input only adds allocation and initialization cost.
+     */
     if (type == MUNGE_ZIP_BZLIB) {
+        int block_size_100k = (xsrclen + 99999) / 100000;
+        if (block_size_100k > 9) {
+            block_size_100k = 9;
+        }
         if (BZ2_bzBuffToBuffCompress ((char *) xdst, &xdstlen,
-                (char *) xsrc, xsrclen, 9, 0, 0) != BZ_OK)
-            return (-1);
+                (char *) xsrc, xsrclen, block_size_100k, 0, 0) != BZ_OK)
+            goto end;
     }
 #endif /* HAVE_PKG_BZLIB */
 
 #if HAVE_PKG_ZLIB
-    /*
-     *  XXX: The use of the "xdstlen_ul" temporary variable is to avoid the
-     *       gcc3.3 compiler warning: "dereferencing type-punned pointer
-     *       will break strict-aliasing rules".  A mere cast doesn't suffice.
+    /*  The deflate stream is configured identically to compress().
      */
     if (type == MUNGE_ZIP_ZLIB) {
-        unsigned long xdstlen_ul = xdstlen;
-        if (compress (xdst, &xdstlen_ul,
-                xsrc, (unsigned long) xsrclen) != Z_OK)
-            return (-1);
-        xdstlen = xdstlen_ul;
+        z_stream *zs = &z->deflate;
+        if (!z->got_deflate) {
+            memset (zs, 0, sizeof (*zs));
+            if (deflateInit (zs, Z_DEFAULT_COMPRESSION) != Z_OK)
+                goto end;
+            z->got_deflate = 1;
+        }
+        else if (deflateReset (zs) != Z_OK) {
+            goto end;
+        }
+        zs->next_in = xsrc;
+        zs->avail_in = xsrclen;
+        zs->next_out = xdst;
+        zs->avail_out = xdstlen;
+        if (deflate (zs, Z_FINISH) != Z_STREAM_END)
+            goto end;
+        xdstlen = zs->total_out;
     }
 #endif /* HAVE_PKG_ZLIB */
 
+#if HAVE_PKG_LZ4
+    if (type == MUNGE_ZIP_LZ4) {
+        int n;
+        if (!z->lz4_state && !(z->lz4_state = malloc (LZ4_sizeofState ())))
+            goto end;
+        n = LZ4_compress_fast_extState (z->lz4_state, (char *) xsrc,
+                (char *) xdst, xsrclen, xdstlen, 1);
+        if (n <= 0)
+            goto end;
+        xdstlen = n;
+    }
+#endif /* HAVE_PKG_LZ4 */
+
+#if HAVE_PKG_ZSTD
+    if (type == MUNGE_ZIP_ZSTD) {
+        size_t n;
+        if (!z->zstd_cctx && !(z->zstd_cctx = ZSTD_createCCtx ()))
+            goto end;
+        if (dict_id != 0) {
+            n = ZSTD_compress_usingCDict (z->zstd_cctx, xdst, xdstlen,
+                    xsrc, xsrclen, _zip_zstd_cdict);
+        }
+        else {
+            n = ZSTD_compressCCtx (z->zstd_cctx, xdst, xdstlen,
+                    xsrc, xsrclen, ZIP_ZSTD_LEVEL);
+        }
+        if (ZSTD_isError (n))
+            goto end;
+        xdstlen = n;
+    }
+#endif /* HAVE_PKG_ZSTD */
+
     *pdstlen = xdstlen + sizeof (zip_meta_t);
     pmeta = dst;
     pmeta->magic = htonl (ZIP_MAGIC);
     pmeta->length = htonl (xsrclen);
-    return (0);
+    rc = 0;
+
+end:
+    _zip_ctx_release (z, is_tmp);
+    return (rc);
 }
 
 
 /*  Decompresses the [src] buffer of length [srclen] in a single pass using the
- *    compression method [type].  The resulting decompressed (original) output
- *    is stored in the [dst] buffer.
+ *    compression method [type] and dictionary [dict_id] (or 0 for none).
+ *    The resulting decompressed (original) output is stored in the [dst]
+ *    buffer.
  *  Upon entry, [*pdstlen] must be set to the size of the [dst] buffer.
  *  Upon exit, [*pdstlen] is set to the size of the decompressed data.
  *  Returns 0 on success, or -1 or error.
  */
 int
-zip_decompress_block (munge_zip_t type,
+zip_decompress_block (munge_zip_t type, uint32_t dict_id,
                       void *dst, int *pdstlen, const void *src, int srclen)
 {
     unsigned char *xdst;
@@ -185,6 +521,9 @@ zip_decompress_block (munge_zip_t type,
     unsigned char *xsrc;
     unsigned int   xsrclen;
     int            n;
+    zip_ctx_p      z;
+    int            is_tmp;
+    int            rc;
 
     assert (dst != NULL);
     assert (pdstlen != NULL);
@@ -193,6 +532,9 @@ zip_decompress_block (munge_zip_t type,
     if (!zip_is_valid_type (type)) {
         return (-1);
     }
+    if ((dict_id != 0) && (dict_id != zip_dict_get_id (type))) {
+        return (-1);
+    }
     n = zip_decompress_length (type, src, srclen);
     if (n < 0) {
         return (-1);
@@ -208,31 +550,76 @@ zip_decompress_block (munge_zip_t type,
     xsrc = (unsigned char *) src + sizeof (zip_meta_t);
     xsrclen = srclen - sizeof (zip_meta_t);
 
+    if (!(z = _zip_ctx_get (&is_tmp))) {
+        return (-1);
+    }
+    rc = -1;
+
 #if HAVE_PKG_BZLIB
     if (type == MUNGE_ZIP_BZLIB) {
         if (BZ2_bzBuffToBuffDecompress ((char *) xdst, &xdstlen,
                 (char *) xsrc, xsrclen, 0, 0) != BZ_OK)
-            return (-1);
+            goto end;
     }
 #endif /* HAVE_PKG_BZLIB */
 
 #if HAVE_PKG_ZLIB
-    /*
-     *  XXX: The use of the "xdstlen_ul" temporary variable is to avoid the
-     *       gcc3.3 compiler warning: "dereferencing type-punned pointer
-     *       will break strict-aliasing rules".  A mere cast doesn't suffice.
-     */
     if (type == MUNGE_ZIP_ZLIB) {
-        unsigned long xdstlen_ul = xdstlen;
-        if (uncompress (xdst, &xdstlen_ul,
-                xsrc, (unsigned long) xsrclen) != Z_OK)
-            return (-1);
-        xdstlen = xdstlen_ul;
+        z_stream *zs = &z->inflate;
+        if (!z->got_inflate) {
+            memset (zs, 0, sizeof (*zs));
+            if (inflateInit (zs) != Z_OK)
+                goto end;
+            z->got_inflate = 1;
+        }
+        else if (inflateReset (zs) != Z_OK) {
+            goto end;
+        }
+        zs->next_in = xsrc;
+        zs->avail_in = xsrclen;
+        zs->next_out = xdst;
+        zs->avail_out = xdstlen;
+        if (inflate (zs, Z_FINISH) != Z_STREAM_END)
+            goto end;
+        xdstlen = zs->total_out;
     }
 #endif /* HAVE_PKG_ZLIB */
 
+#if HAVE_PKG_LZ4
+    if (type == MUNGE_ZIP_LZ4) {
+        int m = LZ4_decompress_safe ((char *) xsrc, (char *) xdst,
+                xsrclen, xdstlen);
+        if (m < 0)
+            goto end;
+        xdstlen = m;
+    }
+#endif /* HAVE_PKG_LZ4 */
+
+#if HAVE_PKG_ZSTD
+    if (type == MUNGE_ZIP_ZSTD) {
+        size_t m;
+        if (!z->zstd_dctx && !(z->zstd_dctx = ZSTD_createDCtx ()))
+            goto end;
+        if (dict_id != 0) {
+            m = ZSTD_decompress_usingDDict (z->zstd_dctx, xdst, xdstlen,
+                    xsrc, xsrclen, _zip_zstd_ddict);
+        }
+        else {
+            m = ZSTD_decompressDCtx (z->zstd_dctx, xdst, xdstlen,
+                    xsrc, xsrclen);
+        }
+        if (ZSTD_isError (m))
+            goto end;
+        xdstlen = m;
+    }
+#endif /* HAVE_PKG_ZSTD */
+
     *pdstlen = xdstlen;
-    return (0);
+    rc = 0;
+
+end:
+    _zip_ctx_release (z, is_tmp);
+    return (rc);
 }
 
 
@@ -247,6 +634,7 @@ zip_compress_length (munge_zip_t type, const void *src, int len)
  *    larger than the uncompressed input, plus an additional 12 bytes.
  *  For bzlib compression, allocate an output buffer at least 1% larger than
  *    the uncompressed input, plus an additional 600 bytes.
+ *  For lz4 and zstd compression, use the bound provided by the library.
  *  Also reserve space for encoding the size of the uncompressed data.
  *  The "+1" is for the double-to-int conversion to perform a ceiling function.
  *
@@ -262,6 +650,16 @@ zip_compress_length (munge_zip_t type, const void *src, int len)
         return ((int) ((len * 1.001) + 12 + 1 + sizeof (zip_meta_t)));
 #endif /* HAVE_PKG_ZLIB */
 
+#if HAVE_PKG_LZ4
+    if (type == MUNGE_ZIP_LZ4)
+        return (LZ4_compressBound (len) + sizeof (zip_meta_t));
+#endif /* HAVE_PKG_LZ4 */
+
+#if HAVE_PKG_ZSTD
+    if (type == MUNGE_ZIP_ZSTD)
+        return ((int) (ZSTD_compressBound (len) + sizeof (zip_meta_t)));
+#endif /* HAVE_PKG_ZSTD */
+
     return (-1);
 }
 
@@ -297,7 +695,8 @@ zip_select_default_type (munge_zip_t type)
 {
 /*  Selects an available compression type (assuming compression is requested
  *    by the specified [type]) with a preference towards zlib since it's fast
- *    with low overhead.
+ *    with low overhead.  The lz4 and zstd types are never selected as the
+ *    default since older peers cannot decode them.
  */
     munge_zip_t z;
     munge_zip_t z_def;
@@ -312,6 +711,18 @@ zip_select_default_type (munge_zip_t type)
     }
 #endif /* HAVE_PKG_BZLIB */
 
+#if HAVE_PKG_LZ4
+    if (type == MUNGE_ZIP_LZ4) {
+        z = MUNGE_ZIP_LZ4;
+    }
+#endif /* HAVE_PKG_LZ4 */
+
+#if HAVE_PKG_ZSTD
+    if (type == MUNGE_ZIP_ZSTD) {
+        z = MUNGE_ZIP_ZSTD;
+    }
+#endif /* HAVE_PKG_ZSTD */
+
 #if HAVE_PKG_ZLIB
     z_def = MUNGE_ZIP_ZLIB;
     if (type == MUNGE_ZIP_ZLIB) {
@@ -327,3 +738,76 @@ zip_select_default_type (munge_zip_t type)
     }
     return (z);
 }
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+static zip_ctx_p
+_zip_ctx_get (int *is_tmp)
+{
+/*  Returns the calling thread's compression state, creating it on first use.
+ *  If per-thread state is not in use, a temporary state is returned instead
+ *    and [*is_tmp] is set; it must be passed to _zip_ctx_release().
+ *  Returns NULL on error.
+ */
+    zip_ctx_p z;
+
+    assert (is_tmp != NULL);
+
+    *is_tmp = !_zip_is_init;
+
+    if (!*is_tmp && (z = pthread_getspecific (_zip_ctx_key)) != NULL) {
+        return (z);
+    }
+    if (!(z = calloc (1, sizeof (*z)))) {
+        return (NULL);
+    }
+    if (!*is_tmp && (pthread_setspecific (_zip_ctx_key, z) != 0)) {
+        *is_tmp = 1;
+    }
+    return (z);
+}
+
+
+static void
+_zip_ctx_release (zip_ctx_p z, int is_tmp)
+{
+/*  Releases the compression state [z] obtained from _zip_ctx_get().
+ */
+    if (is_tmp) {
+        _zip_ctx_destroy (z);
+    }
+    return;
+}
+
+
+static void
+_zip_ctx_destroy (void *arg)
+{
+/*  De-allocates the compression state [arg] when its thread exits.
+ */
+    zip_ctx_p z = arg;
+
+    if (z == NULL) {
+        return;
+    }
+#if HAVE_PKG_ZLIB
+    if (z->got_deflate) {
+        (void) deflateEnd (&z->deflate);
+    }
+    if (z->got_inflate) {
+        (void) inflateEnd (&z->inflate);
+    }
+#endif /* HAVE_PKG_ZLIB */
+#if HAVE_PKG_LZ4
+    free (z->lz4_state);
+#endif /* HAVE_PKG_LZ4 */
+#if HAVE_PKG_ZSTD
+    ZSTD_freeCCtx (z->zstd_cctx);
+    ZSTD_freeDCtx (z->zstd_dctx);
+#endif /* HAVE_PKG_ZSTD */
+    free (z);
+    return;
+}
@@ -33,20 +33,33 @@
 #  include <config.h>
 #endif /* HAVE_CONFIG_H */
 
+#include <inttypes.h>
 #include <munge.h>
-#include "common.h"                     /* HAVE_PKG_BZLIB, HAVE_PKG_ZLIB */
+#include "common.h"                     /* HAVE_PKG_* */
 
 
 /*****************************************************************************
  *  Prototypes
  *****************************************************************************/
 
+void zip_init (void);
+
+void zip_fini (void);
+
+int zip_dict_init (const char *path);
+
+void zip_dict_fini (void);
+
+uint32_t zip_dict_get_id (munge_zip_t type);
+
 int zip_is_valid_type (munge_zip_t type);
 
-int zip_compress_block (munge_zip_t type,
+int zip_is_compressible (const void *src, int len);
+
+int zip_compress_block (munge_zip_t type, uint32_t dict_id,
     void *dst, int *pdstlen, const void *src, int srclen);
 
-int zip_decompress_block (munge_zip_t type,
+int zip_decompress_block (munge_zip_t type, uint32_t dict_id,
     void *dst, int *pdstlen, const void *src, int srclen);
 
 int zip_compress_length (munge_zip_t type, const void *src, int len);
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <munge.h>
+#include "log.h"
+#include "zipadapt.h"
+
+
+/*****************************************************************************
+ *  Notes
+ *****************************************************************************/
+/*
+ *  Tracks per-client compressibility in order to skip compression for
+ *    clients whose payloads consistently fail to shrink.  Since the same
+ *    client may send both small and large payloads (which compress very
+ *    differently), clients are tracked separately for each power-of-two
+ *    payload size class.
+ *  After ZIPADAPT_FAIL_MIN consecutive failures, the next ZIPADAPT_SKIP_MIN
+ *    credentials for that client are encoded without attempting compression.
+ *    The credential after those is compressed as a probe; each further
+ *    failure doubles the number skipped (up to ZIPADAPT_SKIP_MAX), and any
+ *    success clears the client's history.
+ *  Clients are kept in a direct-mapped table indexed by UID and size class.
+ *    A collision replaces the previous occupant, so the table needs no
+ *    expiry.
+ */
+
+
+/*****************************************************************************
+ *  Private Constants
+ *****************************************************************************/
+
+#define ZIPADAPT_TABLE_SIZE     1024
+#define ZIPADAPT_FAIL_MIN       3
+#define ZIPADAPT_SKIP_MIN       8
+#define ZIPADAPT_SKIP_MAX       1024    /* ZIPADAPT_SKIP_MIN << 7 */
+
+
+/*****************************************************************************
+ *  Private Data Types
+ *****************************************************************************/
+
+struct zipadapt_entry {
+    uint32_t            uid;            /* UID of client process             */
+    unsigned            size_class:5;   /* log2 of payload length            */
+    unsigned            is_used:1;      /* true if entry is occupied         */
+    unsigned int        n_fail;         /* consecutive compression failures  */
+    unsigned int        n_skip;         /* creds remaining to skip           */
+};
+
+
+/*****************************************************************************
+ *  Private Prototypes
+ *****************************************************************************/
+
+static struct zipadapt_entry * _zipadapt_lookup (uint32_t uid, int len,
+        unsigned int *size_class);
+
+
+/*****************************************************************************
+ *  Private Variables
+ *****************************************************************************/
+
+static struct zipadapt_entry _zipadapt_table [ZIPADAPT_TABLE_SIZE];
+static int                   _zipadapt_is_init = 0;
+static pthread_mutex_t       _zipadapt_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*****************************************************************************
+ *  Public Functions
+ *****************************************************************************/
+
+void
+zipadapt_init (void)
+{
+/*  Initializes tracking of per-client compressibility.
+ */
+    memset (_zipadapt_table, 0, sizeof (_zipadapt_table));
+    _zipadapt_is_init = 1;
+    return;
+}
+
+
+void
+zipadapt_fini (void)
+{
+/*  Shuts down tracking of per-client compressibility.
+ */
+    _zipadapt_is_init = 0;
+    return;
+}
+
+
+int
+zipadapt_is_skipped (uint32_t uid, int len)
+{
+/*  Returns non-zero if compression should be skipped for a payload of [len]
+ *    bytes encoded by the client [uid].
+ */
+    struct zipadapt_entry *x;
+    unsigned int           size_class;
+    int                    is_skipped = 0;
+
+    if (!_zipadapt_is_init) {
+        return (0);
+    }
+    x = _zipadapt_lookup (uid, len, &size_class);
+
+    if ((errno = pthread_mutex_lock (&_zipadapt_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to lock compressibility mutex");
+    }
+    if (x->is_used && (x->uid == uid) && (x->size_class == size_class)
+            && (x->n_skip > 0)) {
+        x->n_skip--;
+        is_skipped = 1;
+    }
+    if ((errno = pthread_mutex_unlock (&_zipadapt_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to unlock compressibility mutex");
+    }
+    return (is_skipped);
+}
+
+
+void
+zipadapt_update (uint32_t uid, int len, int is_smaller)
+{
+/*  Records whether compression attempted for a payload of [len] bytes
+ *    encoded by the client [uid] resulted in smaller data.
+ */
+    struct zipadapt_entry *x;
+    unsigned int           size_class;
+    unsigned int           n;
+
+    if (!_zipadapt_is_init) {
+        return;
+    }
+    x = _zipadapt_lookup (uid, len, &size_class);
+
+    if ((errno = pthread_mutex_lock (&_zipadapt_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to lock compressibility mutex");
+    }
+    if (!x->is_used || (x->uid != uid) || (x->size_class != size_class)) {
+        if (is_smaller) {
+            goto end;                   /* no need to displace occupant */
+        }
+        x->uid = uid;
+        x->size_class = size_class;
+        x->is_used = 1;
+        x->n_fail = 0;
+        x->n_skip = 0;
+    }
+    if (is_smaller) {
+        x->n_fail = 0;
+        x->n_skip = 0;
+    }
+    else if (++x->n_fail >= ZIPADAPT_FAIL_MIN) {
+        n = x->n_fail - ZIPADAPT_FAIL_MIN;
+        x->n_skip = (n < 7) ? (ZIPADAPT_SKIP_MIN << n) : ZIPADAPT_SKIP_MAX;
+    }
+
+end:
+    if ((errno = pthread_mutex_unlock (&_zipadapt_mutex)) != 0) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to unlock compressibility mutex");
+    }
+    return;
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+static struct zipadapt_entry *
+_zipadapt_lookup (uint32_t uid, int len, unsigned int *size_class)
+{
+/*  Returns the table entry for the client [uid] sending a payload of [len]
+ *    bytes, setting [*size_class] to the payload's size class.
+ *  The entry may be unused or occupied by a different client.
+ */
+    unsigned int k = 0;
+
+    while ((len >>= 1) > 0) {
+        k++;
+    }
+    *size_class = k;
+    return (&_zipadapt_table [((uid * 32) + k) % ZIPADAPT_TABLE_SIZE]);
+}
@@ -57,16 +57,18 @@
 #define GETOPT_DEBUG_SHORT_OPTS "8"
 #endif /* !NDEBUG */
 
-const char * const short_opts = ":b:cfhk:LvV" GETOPT_DEBUG_SHORT_OPTS ;
+const char * const short_opts = ":b:cd:fhk:LtvV" GETOPT_DEBUG_SHORT_OPTS ;
 
 #include <getopt.h>
 struct option long_opts[] = {
     { "bits",     required_argument, NULL, 'b' },
     { "create",   no_argument,       NULL, 'c' },
+    { "dictfile", required_argument, NULL, 'd' },
     { "force",    no_argument,       NULL, 'f' },
     { "help",     no_argument,       NULL, 'h' },
     { "keyfile",  required_argument, NULL, 'k' },
     { "license",  no_argument,       NULL, 'L' },
+    { "train",    no_argument,       NULL, 't' },
     { "verbose",  no_argument,       NULL, 'v' },
     { "version",  no_argument,       NULL, 'V' },
     {  NULL,      0,                 NULL,  0  }
@@ -80,7 +82,7 @@ struct option long_opts[] = {
 static void _conf_parse_bits_opt (int *dstp, const char *src, int sopt,
         const char *lopt);
 
-static void _conf_parse_keyfile_opt (char **dstp, const char *src, int sopt,
+static void _conf_parse_path_opt (char **dstp, const char *src, int sopt,
         const char *lopt);
 
 static void _conf_display_help (const char *prog);
@@ -117,6 +119,11 @@ create_conf (void)
                 "Failed to dup key_path string");
     }
     confp->key_num_bytes = MUNGE_KEY_LEN_DFL_BYTES;
+    confp->dict_path = strdup (MUNGE_DICTFILE_PATH);
+    if (confp->dict_path == NULL) {
+        log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+                "Failed to dup dict_path string");
+    }
 
     _conf_validate (confp);
     return confp;
@@ -137,6 +144,10 @@ destroy_conf (conf_t *confp)
         free (confp->key_path);
         confp->key_path = NULL;
     }
+    if (confp->dict_path != NULL) {
+        free (confp->dict_path);
+        confp->dict_path = NULL;
+    }
     free (confp);
 }
 
@@ -177,6 +188,10 @@ parse_cmdline (conf_t *confp, int argc, char **argv)
             case 'c':
                 confp->do_create = 1;
                 break;
+            case 'd':
+                _conf_parse_path_opt (&confp->dict_path, optarg, c,
+                        long_opt);
+                break;
             case 'f':
                 confp->do_force = 1;
                 break;
@@ -185,13 +200,16 @@ parse_cmdline (conf_t *confp, int argc, char **argv)
                 exit (EXIT_SUCCESS);
                 break;
             case 'k':
-                _conf_parse_keyfile_opt (&confp->key_path, optarg, c,
+                _conf_parse_path_opt (&confp->key_path, optarg, c,
                         long_opt);
                 break;
             case 'L':
                 display_license ();
                 exit (EXIT_SUCCESS);
                 break;
+            case 't':
+                confp->do_train = 1;
+                break;
             case 'v':
                 confp->do_verbose = 1;
                 break;
@@ -222,13 +240,23 @@ parse_cmdline (conf_t *confp, int argc, char **argv)
                 break;
         }
     }
-    if (optind < argc) {
+    /*  Remaining args are training sample files when training a dictionary.
+     */
+    if (confp->do_train) {
+        if (optind >= argc) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                    "Option \"--train\" requires one or more sample files");
+        }
+        confp->sample_paths = &argv[optind];
+        confp->num_samples = argc - optind;
+    }
+    else if (optind < argc) {
         log_err (EMUNGE_SNAFU, LOG_ERR, "Option \"%s\" is unrecognized",
                 (optind > 0) ? argv[optind] : "???");
     }
     /*  Default to creating a key if no operation is specified.
      */
-    if (!confp->do_create) {
+    if (!confp->do_create && !confp->do_train) {
         confp->do_create = 1;
     }
     _conf_validate (confp);
@@ -271,13 +299,13 @@ _conf_parse_bits_opt (int *dstp, const char *src, int sopt, const char *lopt)
 }
 
 
-/*  Parse the --keyfile command-line option arising from short-option [sopt]
- *    or long-option [lopt].
+/*  Parse the --dictfile or --keyfile command-line option arising from
+ *    short-option [sopt] or long-option [lopt].
  *  The [dstp] arg is passed by reference for storing the result of the
  *    required argument specified in the [src] string.
  */
 static void
-_conf_parse_keyfile_opt (char **dstp, const char *src, int sopt,
+_conf_parse_path_opt (char **dstp, const char *src, int sopt,
         const char *lopt)
 {
     int rv;
@@ -309,13 +337,19 @@ _conf_display_help (const char *prog)
     printf ("  %*s %s\n", w, "-c, --create",
             "Create keyfile");
 
+    printf ("  %*s %s\n", w, "-t, --train FILE...",
+            "Train zstd compression dictionary from samples");
+
     printf ("\n");
 
     printf ("  %*s %s\n", w, "-b, --bits=INT",
             "Specify number of bits in key being created");
 
+    printf ("  %*s %s [%s]\n", w, "-d, --dictfile=PATH",
+            "Specify dictfile pathname", MUNGE_DICTFILE_PATH);
+
     printf ("  %*s %s\n", w, "-f, --force",
-            "Force keyfile to be overwritten if it exists");
+            "Force file to be overwritten if it exists");
 
     printf ("  %*s %s [%s]\n", w, "-k, --keyfile=PATH",
             "Specify keyfile pathname", MUNGE_KEYFILE_PATH);
@@ -455,6 +489,10 @@ _conf_validate (conf_t *confp)
         log_err (EMUNGE_SNAFU, LOG_ERR,
                 "Failed to validate conf: key_path undefined");
     }
+    if (confp->dict_path == NULL) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to validate conf: dict_path undefined");
+    }
     if (confp->key_num_bytes > MUNGE_KEY_LEN_MAX_BYTES) {
         log_err (EMUNGE_SNAFU, LOG_ERR,
                 "Failed to validate conf: key_num_bytes above maximum");
@@ -35,10 +35,14 @@
 
 typedef struct conf {
     unsigned    do_create:1;            /* flag to create new key            */
-    unsigned    do_force:1;             /* flag to force overwriting key     */
+    unsigned    do_force:1;             /* flag to force overwriting file    */
+    unsigned    do_train:1;             /* flag to train new zip dictionary  */
     unsigned    do_verbose:1;           /* flag to be verbose                */
     char       *key_path;               /* pathname of keyfile               */
     int         key_num_bytes;          /* number of bytes for key creation  */
+    char       *dict_path;              /* pathname of dictfile              */
+    char      **sample_paths;           /* pathnames of dict training files  */
+    int         num_samples;            /* number of dict training files     */
 } conf_t;
 
 
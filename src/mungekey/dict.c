@@ -0,0 +1,209 @@
+/*****************************************************************************
+ *  Copyright (C) 2007-2026 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2002-2007 The Regents of the University of California.
+ *  UCRL-CODE-155910.
+ *
+ *  This file is part of the MUNGE Uid 'N' Gid Emporium (MUNGE).
+ *  For details, see <https://github.com/dun/munge>.
+ *
+ *  MUNGE is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.  Additionally for the MUNGE library (libmunge), you
+ *  can redistribute it and/or modify it under the terms of the GNU Lesser
+ *  General Public License as published by the Free Software Foundation,
+ *  either version 3 of the License, or (at your option) any later version.
+ *
+ *  MUNGE is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  and GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  and GNU Lesser General Public License along with MUNGE.  If not, see
+ *  <https://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#if HAVE_ZSTD_H
+#  include <zdict.h>
+#endif /* HAVE_ZSTD_H */
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "common.h"
+#include "conf.h"
+#include "dict.h"
+#include "fd.h"
+#include "log.h"
+#include "munge_defs.h"
+#include "str.h"
+
+
+/*****************************************************************************
+ *  Prototypes
+ *****************************************************************************/
+
+#if HAVE_PKG_ZSTD
+static void _train_dict_read_samples (conf_t *confp, unsigned char **bufp,
+        size_t *sizes);
+#endif /* HAVE_PKG_ZSTD */
+
+
+/*****************************************************************************
+ *  Public Functions
+ *****************************************************************************/
+
+/*  Train a zstd compression dictionary from the sample payload files in
+ *    [confp], writing it to the dictfile.
+ *  Each sample file should contain a single payload representative of those
+ *    being encoded into credentials.
+ */
+void
+train_dict (conf_t *confp)
+{
+#if HAVE_PKG_ZSTD
+    unsigned char *samples;
+    size_t        *sizes;
+    unsigned char *buf;
+    size_t         len;
+    unsigned       id;
+    int            fd;
+    int            n;
+    int            rv;
+
+    assert (confp != NULL);
+    assert (confp->num_samples > 0);
+
+    sizes = calloc (confp->num_samples, sizeof (*sizes));
+    buf = malloc (MUNGE_DICT_LEN_DFL_BYTES);
+    if ((sizes == NULL) || (buf == NULL)) {
+        log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+                "Failed to allocate dictionary training buffers");
+    }
+    _train_dict_read_samples (confp, &samples, sizes);
+
+    len = ZDICT_trainFromBuffer (buf, MUNGE_DICT_LEN_DFL_BYTES,
+            samples, sizes, confp->num_samples);
+    if (ZDICT_isError (len)) {
+        log_err (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to train dictionary from %d sample%s: %s",
+                confp->num_samples, (confp->num_samples == 1) ? "" : "s",
+                ZDICT_getErrorName (len));
+    }
+    id = ZDICT_getDictID (buf, len);
+
+    if (confp->do_force) {
+        do {
+            rv = unlink (confp->dict_path);
+        } while ((rv == -1) && (errno == EINTR));
+
+        if ((rv == -1) && (errno != ENOENT)) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to remove \"%s\"",
+                    confp->dict_path);
+        }
+    }
+    /*  The dictionary is derived from payload contents, so protect it as such.
+     */
+    fd = open (confp->dict_path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to create \"%s\"",
+                confp->dict_path);
+    }
+    n = fd_write_n (fd, buf, len);
+    if (n != len) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR,
+                "Failed to write %zu bytes to \"%s\"",
+                len, confp->dict_path);
+    }
+    rv = close (fd);
+    if (rv == -1) {
+        log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to close \"%s\"",
+                confp->dict_path);
+    }
+    free (samples);
+    free (sizes);
+    free (buf);
+    if (confp->do_verbose) {
+        log_msg (LOG_INFO, "Created \"%s\" with %zu-byte dictionary (id=%u)",
+                confp->dict_path, len, id);
+    }
+
+#else  /* !HAVE_PKG_ZSTD */
+    log_err (EMUNGE_SNAFU, LOG_ERR,
+            "Failed to train dictionary: zstd support not available");
+#endif /* !HAVE_PKG_ZSTD */
+}
+
+
+/*****************************************************************************
+ *  Private Functions
+ *****************************************************************************/
+
+#if HAVE_PKG_ZSTD
+
+/*  Read the sample files in [confp] into a single newly-allocated buffer
+ *    returned via [bufp], storing the length of each sample in the
+ *    corresponding element of the [sizes] array.
+ *  Exit on error.
+ */
+static void
+_train_dict_read_samples (conf_t *confp, unsigned char **bufp, size_t *sizes)
+{
+    unsigned char *buf = NULL;
+    size_t         len = 0;
+    unsigned char *p;
+    struct stat    st;
+    const char    *path;
+    int            fd;
+    ssize_t        n;
+    int            i;
+
+    for (i = 0; i < confp->num_samples; i++) {
+        path = confp->sample_paths[i];
+        fd = open (path, O_RDONLY);
+        if (fd == -1) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to open \"%s\"", path);
+        }
+        if (fstat (fd, &st) == -1) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR, "Failed to stat \"%s\"", path);
+        }
+        if (!S_ISREG (st.st_mode)) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to read \"%s\": not a regular file", path);
+        }
+        if (st.st_size > MUNGE_MAXIMUM_PAYLOAD_LEN) {
+            log_err (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to read \"%s\": exceeded maximum of %d bytes",
+                    path, MUNGE_MAXIMUM_PAYLOAD_LEN);
+        }
+        p = realloc (buf, len + st.st_size + 1);
+        if (p == NULL) {
+            log_errno (EMUNGE_NO_MEMORY, LOG_ERR,
+                    "Failed to allocate memory for \"%s\"", path);
+        }
+        buf = p;
+        n = fd_read_n (fd, buf + len, st.st_size);
+        if (n != st.st_size) {
+            log_errno (EMUNGE_SNAFU, LOG_ERR,
+                    "Failed to read %jd bytes from \"%s\"",
+                    (intmax_t) st.st_size, path);
+        }
+        (void) close (fd);
+        sizes[i] = n;
+        len += n;
+    }
+    *bufp = buf;
+}
+
+#endif /* HAVE_PKG_ZSTD */
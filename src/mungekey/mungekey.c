@@ -35,6 +35,7 @@
 #include <munge.h>
 #include "conf.h"
 #include "crypto.h"
+#include "dict.h"
 #include "key.h"
 #include "log.h"
 #include "md.h"
@@ -68,6 +69,9 @@ main (int argc, char *argv[])
     if (confp->do_create) {
         create_key (confp);
     }
+    if (confp->do_train) {
+        train_dict (confp);
+    }
     crypto_fini ();
     destroy_conf (confp);
     exit (EXIT_SUCCESS);
@@ -97,6 +97,225 @@ test_expect_success 'munged socket cleanup with relative pathname' '
     test ! -S "${socket}"
 '
 
+# Check if the max-threads option properly fails when set below num-threads.
+#
+test_expect_success 'munged --max-threads less than --num-threads' '
+    test_must_fail "${MUNGED}" --num-threads=4 --max-threads=2
+'
+
+# Check if the work crew thread limits are reported by the stats query.
+#
+test_expect_success 'munged --max-threads' '
+    munged_start --num-threads=2 --max-threads=6 &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --stats >out.$$ &&
+    munged_stop &&
+    grep -q "^work.threads.min 2$" out.$$ &&
+    grep -q "^work.threads.max 6$" out.$$
+'
+
+# Check if the cpu-affinity option properly fails for an invalid CPU list.
+#
+test_expect_success 'munged --cpu-affinity with invalid list' '
+    test_must_fail "${MUNGED}" --cpu-affinity=1-0 &&
+    test_must_fail "${MUNGED}" --cpu-affinity=0,
+'
+
+# Check if /proc provides per-thread CPU affinity.
+#
+if test -r /proc/$$/task/$$/status \
+        && grep -q "^Cpus_allowed_list:" /proc/$$/status; then
+    test_set_prereq PROC
+fi
+
+# Check if the cpu-affinity option pins every daemon thread, including the
+#   asynchronous log writer thread.
+#
+test_expect_success PROC 'munged --cpu-affinity with --log-async' '
+    local pid &&
+    munged_start --cpu-affinity=0 --log-async &&
+    pid=$(cat "${MUNGE_PIDFILE}") &&
+    grep -h "^Cpus_allowed_list:" /proc/${pid}/task/*/status >out.$$ &&
+    munged_stop &&
+    test "$(wc -l <out.$$)" -gt 1 &&
+    ! grep -qv "^Cpus_allowed_list:[[:space:]]*0$" out.$$
+'
+
+# Check if credentials can be processed with multiple accept threads.
+#
+test_expect_success 'munged --accept-threads' '
+    munged_start --accept-threads=4 &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input |
+    "${UNMUNGE}" --socket="${MUNGE_SOCKET}" >/dev/null &&
+    munged_stop
+'
+
+# Check if the queue limit options properly fail for negative values.
+#
+test_expect_success 'munged --enc-queue-limit and --dec-queue-limit' '
+    test_must_fail "${MUNGED}" --enc-queue-limit=-1 &&
+    test_must_fail "${MUNGED}" --dec-queue-limit=-1
+'
+
+# Check if perl can connect to a Unix domain socket.
+#
+if perl -MIO::Socket::UNIX -e 1 >/dev/null 2>&1; then
+    test_set_prereq PERL
+fi
+
+# Check if an encode request shed due to the enc-queue-limit option is retried
+#   and then succeeds once the backlog clears.  The single worker thread is
+#   held by an idle connection while 39 more are queued behind it, so the
+#   retry hint (about 400ms) outlasts the idle connections being closed.
+#
+test_expect_success PERL 'munged --enc-queue-limit shed and retried' '
+    munged_start --num-threads=1 --max-threads=1 --enc-queue-limit=1 &&
+    rm -f ready.$$ &&
+    perl -MIO::Socket::UNIX -e "
+        my (\$sock, \$ready) = @ARGV;
+        my @s = map { IO::Socket::UNIX->new (Peer => \$sock) or die } 1 .. 40;
+        select (undef, undef, undef, 0.2);
+        open (my \$fh, q(>), \$ready) or die; close (\$fh);
+        select (undef, undef, undef, 0.7);
+    " "${MUNGE_SOCKET}" ready.$$ &
+    wait_for "test -f ready.$$" &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input --output=/dev/null &&
+    wait &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --stats >out.$$ &&
+    munged_stop &&
+    grep -q "^encode.shed [1-9]" out.$$
+'
+
+# Check if credentials can be processed with timers dispatched from the
+#   accept loop via a timerfd (with an additional accept thread contending
+#   for connections on the non-blocking listening socket).
+#
+test_expect_success 'munged --timerfd' '
+    munged_start --timerfd --accept-threads=2 &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input |
+    "${UNMUNGE}" --socket="${MUNGE_SOCKET}" >/dev/null &&
+    munged_stop
+'
+
+# Check if messages logged by request-processing threads reach the logfile
+#   when written by the asynchronous log writer thread.
+#
+test_expect_success 'munged --log-async' '
+    munged_start --log-async &&
+    echo garbage | test_must_fail "${UNMUNGE}" --socket="${MUNGE_SOCKET}" &&
+    munged_stop &&
+    grep -q "Enabled asynchronous logging" "${MUNGE_LOGFILE}" &&
+    grep -q "Failed to match armor prefix" "${MUNGE_LOGFILE}" &&
+    grep -q "Stopping" "${MUNGE_LOGFILE}"
+'
+
+# Check if repeated request errors are logged once, and then summarized
+#   when the daemon exits.
+#
+test_expect_success 'munged --log-aggregate' '
+    munged_start --log-aggregate=3600 &&
+    for i in 1 2 3; do
+        echo garbage |
+        test_must_fail "${UNMUNGE}" --socket="${MUNGE_SOCKET}" || return 1
+    done &&
+    munged_stop &&
+    test "$(grep -c "Failed to match armor prefix$" "${MUNGE_LOGFILE}")" = 1 &&
+    grep -q "Failed to match armor prefix: repeated 2 times" "${MUNGE_LOGFILE}"
+'
+
+# Check if different request errors with the same error number are counted
+#   separately by message text.
+#
+test_expect_success 'munged --log-aggregate with distinct messages' '
+    munged_start --log-aggregate=3600 &&
+    for i in 1 2; do
+        echo garbage |
+        test_must_fail "${UNMUNGE}" --socket="${MUNGE_SOCKET}" || return 1
+        echo "MUNGE:@@@:" |
+        test_must_fail "${UNMUNGE}" --socket="${MUNGE_SOCKET}" || return 1
+    done &&
+    munged_stop &&
+    grep -q "Failed to match armor prefix: repeated 1 time " \
+            "${MUNGE_LOGFILE}" &&
+    grep -q "Failed to base64-decode credential: repeated 1 time " \
+            "${MUNGE_LOGFILE}"
+'
+
+# Check if the log-aggregate option properly fails for negative values.
+#
+test_expect_success 'munged --log-aggregate with negative value' '
+    test_must_fail "${MUNGED}" --log-aggregate=-1
+'
+
+# Check if the dict-file option fails for a missing dictionary.
+#
+test_expect_success 'munged --dict-file with missing file' '
+    test_must_fail munged_start --dict-file=missing.dict.$$ &&
+    grep -q "Failed to load compression dictionary" "${MUNGE_LOGFILE}"
+'
+
+# Check if zstd was found.
+#
+if grep -q '^#define.* HAVE_LIBZSTD .*1' \
+        "${MUNGE_BUILD_DIR}/config.h" >/dev/null 2>&1; then
+    test_set_prereq ZSTD
+fi
+
+# Check if a credential compressed with a dictionary loaded by the dict-file
+#   option can be decoded.
+#
+test_expect_success ZSTD 'munged --dict-file' '
+    local i &&
+    mkdir -p samples.$$ &&
+    for i in $(seq 1 200); do
+        printf "{\"job\":%d,\"user\":\"u%d\",\"state\":\"RUNNING\"}" \
+                "${i}" "$((i % 13))" >"samples.$$/${i}" || return 1
+    done &&
+    "${MUNGEKEY}" --train --dictfile=dict.$$ samples.$$/* &&
+    munged_start --dict-file=dict.$$ &&
+    grep -q "Loaded compression dictionary" "${MUNGE_LOGFILE}" &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --zip=zstd \
+            --string="{\"job\":1000,\"user\":\"u12\",\"state\":\"RUNNING\"}" |
+    "${UNMUNGE}" --socket="${MUNGE_SOCKET}" >out.$$ &&
+    munged_stop &&
+    grep -q "^ZIP: *zstd" out.$$
+'
+
+# Check if a replayed credential is rejected before being decrypted when the
+#   early-replay-reject option is specified.  The response to such a replay
+#   lacks the credential metadata, so the UID is unknown.
+#
+test_expect_success 'munged --early-replay-reject' '
+    munged_start --early-replay-reject &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input >cred.$$ &&
+    "${UNMUNGE}" --socket="${MUNGE_SOCKET}" <cred.$$ >/dev/null &&
+    test_expect_code 17 \
+            "${UNMUNGE}" --socket="${MUNGE_SOCKET}" <cred.$$ >out.$$ &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --stats >stats.$$ &&
+    munged_stop &&
+    test_debug "cat out.$$ stats.$$" &&
+    grep -q "^STATUS: *Replayed credential" out.$$ &&
+    grep -q "^UID: *??? " out.$$ &&
+    grep -q "^replay\.early 1$" stats.$$
+'
+
+# Check if an expired credential still in the replay hash is reported as
+#   expired rather than replayed when the early-replay-reject option is
+#   specified, as it is when that option is not specified.
+#
+test_expect_success 'munged --early-replay-reject with expired credential' '
+    munged_start --early-replay-reject &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input --ttl=1 >cred.$$ &&
+    "${UNMUNGE}" --socket="${MUNGE_SOCKET}" <cred.$$ >/dev/null &&
+    sleep 3 &&
+    test_expect_code 15 \
+            "${UNMUNGE}" --socket="${MUNGE_SOCKET}" <cred.$$ >out.$$ &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --stats >stats.$$ &&
+    munged_stop &&
+    test_debug "cat out.$$ stats.$$" &&
+    grep -q "^STATUS: *Expired credential" out.$$ &&
+    grep -q "^replay\.early 0$" stats.$$
+'
+
 test_expect_failure 'finish writing tests' '
     false
 '
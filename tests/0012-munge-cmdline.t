@@ -239,6 +239,29 @@ test_expect_success 'munge --cipher for each cipher by number' '
     test ! -s fail.$$
 '
 
+# Check if an AEAD cipher is available.
+#
+if "${MUNGE}" --list-ciphers | grep -q "^ *aes128-gcm "; then
+    test_set_prereq AEAD
+fi
+
+# Check if a credential encrypted with an AEAD cipher is rejected as invalid
+#   when its ciphertext has been altered.  The 100th character resides within
+#   the base64-encoded ciphertext.
+#
+test_expect_success AEAD 'munge --cipher for altered aes128-gcm cred' '
+    local c &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --string=xyzzy-$$ \
+            --cipher=aes128-gcm --zip=none >cred.$$ &&
+    c=$(cut -c 100 cred.$$) &&
+    if test "${c}" = A; then c=B; else c=A; fi &&
+    sed "s/^\(.\{99\}\)./\1${c}/" cred.$$ >cred2.$$ &&
+    ! cmp -s cred.$$ cred2.$$ &&
+    test_expect_code 14 "${UNMUNGE}" --socket="${MUNGE_SOCKET}" \
+            --input=cred2.$$ --no-output &&
+    "${UNMUNGE}" --socket="${MUNGE_SOCKET}" --input=cred.$$ --no-output
+'
+
 for OPT_LIST_MACS in '-M' '--list-macs'; do
     test_expect_success "munge ${OPT_LIST_MACS}" '
         "${MUNGE}" "${OPT_LIST_MACS}" |
@@ -319,6 +342,51 @@ test_expect_success 'munge --mac for each mac by number' '
     test ! -s fail.$$
 '
 
+# Check if the aes256 cipher is available.
+#
+if "${MUNGE}" --list-ciphers | grep -q "^ *aes256 "; then
+    test_set_prereq AES256
+fi
+
+# Check if a MAC whose digest is too short to derive the cipher key is rejected.
+#
+test_expect_success AES256 'munge --mac for mac too short for cipher' '
+    test_must_fail "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input \
+            --cipher=aes256 --mac=sha1 2>err.$$ &&
+    grep -q "Invalid MAC type [0-9]* with cipher type" err.$$
+'
+
+# Check if each combination of cipher and mac accepted by munged decodes with
+#   the same cipher and mac types.
+#
+test_expect_success 'munge --cipher and --mac for each combination' '
+    local cnum cname mnum mname extra meta &&
+    >fail.$$ &&
+    "${MUNGE}" --list-ciphers |
+    awk "/([0-9]+)/ { gsub(/[()]/, \"\"); print \$2, \$1 }" |
+    grep -v " default$" >ciphers.$$ &&
+    "${MUNGE}" --list-macs |
+    awk "/([0-9]+)/ { gsub(/[()]/, \"\"); print \$2, \$1 }" |
+    grep -v " default$" >macs.$$ &&
+    while read cnum cname extra; do
+        while read mnum mname extra; do
+            "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input \
+                    --cipher="${cname}" --mac="${mname}" >cred.$$ ||
+                continue
+            "${UNMUNGE}" --socket="${MUNGE_SOCKET}" <cred.$$ |
+            awk "/^(CIPHER|MAC):/ { print \$2 }" | tr "\n" " " >meta.$$ &&
+            meta=$(cat meta.$$) &&
+            if test "${meta}" = "${cname} ${mname} "; then
+                test_debug "echo \"Decoded [${cname}/${mname}]\""
+            else
+                echo "Error: munge --cipher=${cname} --mac=${mname} failed"
+                echo "${cname} ${mname} ${meta}" >>fail.$$;
+            fi
+        done <macs.$$
+    done <ciphers.$$ &&
+    test ! -s fail.$$
+'
+
 for OPT_LIST_ZIPS in '-Z' '--list-zips'; do
     test_expect_success "munge ${OPT_LIST_ZIPS}" '
         "${MUNGE}" "${OPT_LIST_ZIPS}" |
@@ -639,6 +707,63 @@ test_expect_success 'munge --ttl for invalid negative number' '
     test_must_fail "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input --ttl=-2
 '
 
+test_expect_success 'munge --stats' '
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --stats >stats.$$ &&
+    test_debug "cat stats.$$" &&
+    grep "^encode\.requests [1-9]" stats.$$ &&
+    grep "^decode\.requests [1-9]" stats.$$ &&
+    grep "^work\.threads [1-9]" stats.$$
+'
+
+test_expect_success 'munge --stats counts decode errors' '
+    local n0 n1 &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --stats >stats.$$ &&
+    n0=$(awk "/^decode\.errors / { print \$2 }" stats.$$) &&
+    echo invalid | test_must_fail "${UNMUNGE}" --socket="${MUNGE_SOCKET}" \
+            --no-output &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --stats >stats.$$ &&
+    n1=$(awk "/^decode\.errors / { print \$2 }" stats.$$) &&
+    test "$((n0 + 1))" -eq "${n1}" &&
+    grep "^decode\.errors\.bad_cred [1-9]" stats.$$
+'
+
+# Check if zlib was found.
+#
+if grep -q '^#define.* HAVE_LIBZ .*1' \
+        "${MUNGE_BUILD_DIR}/config.h" >/dev/null 2>&1; then
+    test_set_prereq ZLIB
+fi
+
+# Check if compression of a random (and thus incompressible) payload is
+#   skipped without being attempted.
+#
+test_expect_success ZLIB 'munge --stats counts compression skipped by estimate' '
+    local n0 n1 &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --stats >stats.$$ &&
+    n0=$(awk "/^zip\.skipped\.estimate / { print \$2 }" stats.$$) &&
+    dd if=/dev/urandom bs=4096 count=1 2>/dev/null >rnd.$$ &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --zip=zlib --input=rnd.$$ |
+    "${UNMUNGE}" --socket="${MUNGE_SOCKET}" --output=out.$$ >meta.$$ &&
+    cmp rnd.$$ out.$$ &&
+    grep "^ZIP: *none" meta.$$ &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --stats >stats.$$ &&
+    n1=$(awk "/^zip\.skipped\.estimate / { print \$2 }" stats.$$) &&
+    test "$((n0 + 1))" -eq "${n1}"
+'
+
+# Check if a binary credential omits the armor and is smaller than its
+#   armored counterpart.
+#
+test_expect_success 'munge --binary' '
+    local armored binary &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input >cred.$$ &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input --binary >bin.$$ &&
+    ! grep -q "^MUNGE:" bin.$$ &&
+    armored=$(wc -c <cred.$$) &&
+    binary=$(wc -c <bin.$$) &&
+    test "${binary}" -lt "${armored}"
+'
+
 test_expect_success 'stop munged' '
     munged_stop
 '
@@ -241,6 +241,49 @@ for OPT_NUMERIC in '-N' '--numeric'; do
     '
 done
 
+test_expect_success 'unmunge --binary' '
+    dd if=/dev/urandom bs=1024 count=1 2>/dev/null >in.$$ &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --binary --input=in.$$ |
+    "${UNMUNGE}" --socket="${MUNGE_SOCKET}" --binary --output=out.$$ &&
+    cmp in.$$ out.$$
+'
+
+test_expect_success 'unmunge --binary for armored credential' '
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input |
+    test_must_fail "${UNMUNGE}" --socket="${MUNGE_SOCKET}" --binary
+'
+
+test_expect_success 'unmunge for binary credential without --binary' '
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --no-input --binary |
+    test_must_fail "${UNMUNGE}" --socket="${MUNGE_SOCKET}" 2>err.$$ &&
+    grep "Failed to match armor prefix" err.$$
+'
+
+test_expect_success 'unmunge --validate-only' '
+    dd if=/dev/urandom bs=1024 count=1 2>/dev/null >in.$$ &&
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --input=in.$$ \
+            --restrict-uid="$(id -u)" |
+    "${UNMUNGE}" --socket="${MUNGE_SOCKET}" --validate-only \
+            --metadata=meta.$$ --output=out.$$ &&
+    test ! -s out.$$ &&
+    grep "^STATUS: *Success" meta.$$ &&
+    grep "^UID_RESTRICTION: .*($(id -u))" meta.$$ &&
+    ! grep -q "^LENGTH:" meta.$$
+'
+
+test_expect_success 'unmunge --validate-only with --binary' '
+    "${MUNGE}" --socket="${MUNGE_SOCKET}" --binary --string=xyzzy |
+    "${UNMUNGE}" --socket="${MUNGE_SOCKET}" --binary --validate-only \
+            --metadata=meta.$$ --output=out.$$ &&
+    test ! -s out.$$ &&
+    grep "^STATUS: *Success" meta.$$
+'
+
+test_expect_success 'unmunge --validate-only for invalid credential' '
+    echo invalid |
+    test_must_fail "${UNMUNGE}" --socket="${MUNGE_SOCKET}" --validate-only
+'
+
 test_expect_success 'stop munged' '
     munged_stop
 '
@@ -410,4 +410,34 @@ test_expect_success 'mungekey defaults to create key' '
     test -f "${MUNGE_KEYFILE}"
 '
 
+# Check if zstd was found.
+#
+if grep -q '^#define.* HAVE_LIBZSTD .*1' \
+        "${MUNGE_BUILD_DIR}/config.h" >/dev/null 2>&1; then
+    test_set_prereq ZSTD
+fi
+
+# Check if --train requires one or more sample files.
+#
+test_expect_success 'mungekey --train without sample files' '
+    test_must_fail "${MUNGEKEY}" --train --dictfile=dict.$$ 2>err.$$ &&
+    grep -q "requires one or more sample files" err.$$ &&
+    test ! -f dict.$$
+'
+
+# Check if a dictionary can be trained from sample files.
+#
+test_expect_success ZSTD 'mungekey --train' '
+    local i &&
+    mkdir -p samples.$$ &&
+    for i in $(seq 1 200); do
+        printf "{\"job\":%d,\"user\":\"u%d\",\"state\":\"RUNNING\"}" \
+                "${i}" "$((i % 13))" >"samples.$$/${i}" || return 1
+    done &&
+    "${MUNGEKEY}" --train --dictfile=dict.$$ --verbose samples.$$/* \
+            2>err.$$ &&
+    test -s dict.$$ &&
+    grep -q "Created \"dict.$$\" with [0-9]*-byte dictionary" err.$$
+'
+
 test_done